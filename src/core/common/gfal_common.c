@@ -26,6 +26,8 @@
 #include <common/gfal_plugin.h>
 #include <gfal_api.h>
 #include "gfal_file_handler_container.h"
+#include "gfal_metadata_cache.h"
+#include "gfal_metrics_internal.h"
 
 // initialization
 __attribute__((constructor))
@@ -135,18 +137,26 @@ gfal2_context_t gfal2_context_new(GError **err)
         return NULL;
     }
     context->initiated = TRUE;
-    context->config = gfal2_init_config(&tmp_err);
-    if (!context->config) {
+    context->config_snapshot = gfal_config_snapshot_get(&tmp_err);
+    if (!context->config_snapshot) {
         gfal2_propagate_prefixed_error(err, tmp_err, __func__);
         g_free(context);
         return NULL;
     }
+    context->config = g_key_file_new();
+    context->opt_cache = gfal_opt_cache_new();
     gfal_initCredentialLocation(context);
     context->plugin_opt.plugin_number = 0;
+    pthread_mutex_init(&context->plugin_opt.lock, NULL);
     int ret = gfal_plugins_instance(context, &tmp_err);
     if (ret <= 0 && tmp_err) {
         gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        gfal_plugins_delete(context, NULL);
+        gfal_plugin_registry_unref(context->plugin_registry);
+        pthread_mutex_destroy(&context->plugin_opt.lock);
+        gfal_config_snapshot_unref(context->config_snapshot);
         g_key_file_free(context->config);
+        gfal_opt_cache_free(context->opt_cache);
         g_free(context);
         return NULL;
     }
@@ -154,11 +164,56 @@ gfal2_context_t gfal2_context_new(GError **err)
     context->mux_cancel = g_mutex_new();
     g_hook_list_init(&context->cancel_hooks, sizeof(GHook));
     context->fdescs = gfal_file_descriptor_handle_create(NULL);
+    context->metadata_cache = gfal_metadata_cache_new(context);
+    context->metrics = gfal_metrics_new();
 
     G_RETURN_ERR(context, tmp_err, err);
 }
 
 
+gfal2_context_t gfal2_context_clone(gfal2_context_t context, GError **err)
+{
+    GError *tmp_err = NULL;
+    if (context == NULL) {
+        gfal2_set_error(err, gfal2_get_core_quark(), EFAULT, __func__, "context is NULL");
+        return NULL;
+    }
+
+    gfal2_context_t clone = g_new0(struct gfal_handle_, 1);
+    clone->initiated = TRUE;
+    gfal_config_clone(clone, context);
+
+    // The plugins keep state of their own context, so the clone instantiates them on first use
+    // The ones registered by the application are shared
+    clone->plugin_registry = gfal_plugin_registry_ref(context->plugin_registry);
+    pthread_mutex_init(&clone->plugin_opt.lock, NULL);
+    gfal_plugins_copy_registered(clone, context);
+
+    clone->agent_name = g_strdup(context->agent_name);
+    clone->agent_version = g_strdup(context->agent_version);
+    clone->client_info = g_ptr_array_new();
+    guint i;
+    for (i = 0; i < context->client_info->len; ++i) {
+        const char *key, *value;
+        gfal2_get_client_info_pair(context, i, &key, &value, NULL);
+        gfal2_add_client_info(clone, key, value, NULL);
+    }
+
+    clone->mux_cancel = g_mutex_new();
+    g_hook_list_init(&clone->cancel_hooks, sizeof(GHook));
+    clone->fdescs = gfal_file_descriptor_handle_create(NULL);
+    clone->metadata_cache = gfal_metadata_cache_new(clone);
+    clone->metrics = gfal_metrics_new();
+
+    if (gfal2_cred_copy(clone, context, &tmp_err) < 0) {
+        gfal2_context_free(clone);
+        clone = NULL;
+    }
+
+    G_RETURN_ERR(clone, tmp_err, err);
+}
+
+
 void gfal2_context_free(gfal2_context_t context)
 {
     if (context == NULL) {
@@ -166,10 +221,16 @@ void gfal2_context_free(gfal2_context_t context)
         return;
     }
 
+    gfal_async_executor_free(context->async);
     gfal_plugins_delete(context, NULL);
+    gfal_plugin_registry_unref(context->plugin_registry);
+    pthread_mutex_destroy(&context->plugin_opt.lock);
     gfal_file_descriptor_handle_destroy(context->fdescs);
+    gfal_metadata_cache_free(context->metadata_cache);
+    gfal_metrics_free(context->metrics);
     g_key_file_free(context->config);
-    g_list_free(context->plugin_opt.sorted_plugin);
+    gfal_config_snapshot_unref(context->config_snapshot);
+    gfal_opt_cache_free(context->opt_cache);
     g_mutex_free(context->mux_cancel);
     g_hook_list_clear(&context->cancel_hooks);
     g_free(context->agent_name);
@@ -183,10 +244,11 @@ void gfal2_context_free(gfal2_context_t context)
 
 gchar **gfal2_get_plugin_names(gfal2_context_t context)
 {
-    gchar **array = g_new0(gchar*, context->plugin_opt.plugin_number + 1);
+    const int n = g_atomic_int_get(&context->plugin_opt.plugin_number);
+    gchar **array = g_new0(gchar*, MAX(n, 0) + 1);
     int i;
 
-    for (i = 0; i < context->plugin_opt.plugin_number; ++i) {
+    for (i = 0; i < n; ++i) {
         array[i] = g_strdup(context->plugin_opt.plugin_list[i].getName());
     }
     array[i] = NULL;
@@ -53,6 +53,23 @@ typedef struct gfal_handle_* gfal2_context_t;
  */
 gfal2_context_t gfal2_context_new(GError ** err);
 
+/**
+ * @brief Create a gfal2 context with the same configuration as another one
+ *
+ * The clone gets a copy of the parameters, credentials and client information of context,
+ * and shares with it the configuration files and plugin libraries already loaded.
+ * The plugins of the clone are only instantiated on its first operation, so cloning
+ * is much cheaper than \ref gfal2_context_new.
+ * The plugins added to context with \ref gfal2_register_plugin are added to the clone too.
+ * They keep their plugin_data, only deleted with context, so context must outlive the clone.
+ * Later changes of either context do not affect the other one.
+ *
+ * @param context : context to copy
+ * @param err : GError error report system
+ * @return a context if success, NULL if error
+ */
+gfal2_context_t gfal2_context_clone(gfal2_context_t context, GError ** err);
+
 /**
  *  Free a gfal2 context
  *  It is safe to delete a NULL context
@@ -65,6 +82,14 @@ void gfal2_context_free(gfal2_context_t context);
  */
 gchar** gfal2_get_plugin_names(gfal2_context_t context);
 
+/**
+ * Get list of the plugins installed but not loaded yet
+ * Plugins installed with a manifest are only loaded by the first URL using one of their schemes,
+ * unless PLUGIN_LAZY_LOADING is disabled in the CORE group of the configuration
+ * The returned list must be freed using g_strfreev
+ */
+gchar** gfal2_get_available_plugin_names(gfal2_context_t context);
+
 /** For errors, gfal2 core quark */
 #define GFAL2_QUARK_CORE "GFAL2::CORE"
 /** For errors, gfal2 configuration quark */
@@ -19,7 +19,9 @@
  */
 
 #include "gfal_handle.h"
+#include "gfal_config_internal.h"
 #include <gfal_api.h>
+#include <pthread.h>
 #include <string.h>
 
 #ifndef GFAL_CONFIG_DIR_DEFAULT
@@ -35,6 +37,60 @@ typedef struct _gfal_key_value {
 } *gfal_key_value_t;
 
 
+// Identity of a configuration file, or of the configuration directory
+typedef struct {
+    gchar *path;
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    struct timespec mtime;
+} gfal_config_stamp;
+
+struct gfal_config_snapshot_s {
+    volatile gint refcount;
+    gchar *dir;
+    // The directory first, then each file loaded
+    GArray *stamps;
+    GKeyFile *config;
+};
+
+// Snapshot given to the new contexts while the files are unchanged
+static gfal_config_snapshot *gfal_config_current = NULL;
+static pthread_mutex_t gfal_config_current_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Option declared with gfal2_register_opt, never freed
+typedef struct {
+    gchar *group_name;
+    gchar *key;
+    gfal2_opt_type_t type;
+} gfal_opt_decl;
+
+// Declarations by handle, and handles by type, group and key
+static GPtrArray *gfal_opt_decls = NULL;
+static GHashTable *gfal_opt_handles = NULL;
+static pthread_mutex_t gfal_opt_decls_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Value of a declared option for a context
+typedef struct {
+    // config_generation of the context when parsed, -1 if never
+    gint generation;
+    gboolean found;
+    gsize length;
+    union {
+        gboolean boolean;
+        gint integer;
+        gchar *string;
+        gchar **list;
+    } value;
+    gfal2_opt_type_t type;
+} gfal_opt_value;
+
+struct gfal_opt_cache_s {
+    pthread_mutex_t lock;
+    GArray *values;
+};
+
+
 void gfal_free_keyvalue(gpointer data, gpointer user_data)
 {
     gfal_key_value_t keyval = (gfal_key_value_t) data;
@@ -76,33 +132,24 @@ static gchar *check_configuration_dir(GError **err)
 }
 
 
-int gfal_load_configuration_to_conf_manager(GKeyFile *dest,
-    const gchar *path, GError **err)
+// Copy every value of src into dest, replacing the existing ones
+static void gfal_config_merge(GKeyFile *dest, GKeyFile *src)
 {
-    GError *tmp_err = NULL;
-    GKeyFile *new_conf = g_key_file_new();
     int groupIndex, keyIndex;
-
-    if (g_key_file_load_from_file(new_conf, path, G_KEY_FILE_NONE, &tmp_err) == FALSE) {
-        gfal2_propagate_prefixed_error_extended(err, tmp_err, __func__,
-            "Error while loading configuration file %s: ", path);
-        return -1;
-    }
-
     gsize nGroups = 0;
-    gchar **groups = g_key_file_get_groups(new_conf, &nGroups);
+    gchar **groups = g_key_file_get_groups(src, &nGroups);
     for (groupIndex = 0; groupIndex < nGroups; ++groupIndex) {
         gsize nKeys = 0;
         GError *tmp_err = NULL;
 
-        gchar **keys = g_key_file_get_keys(new_conf, groups[groupIndex], &nKeys, &tmp_err);
+        gchar **keys = g_key_file_get_keys(src, groups[groupIndex], &nKeys, &tmp_err);
         if (keys == NULL) {
             g_clear_error(&tmp_err);
             continue;
         }
 
         for (keyIndex = 0; keyIndex < nKeys; ++keyIndex) {
-            gchar *value = g_key_file_get_value(new_conf, groups[groupIndex], keys[keyIndex], &tmp_err);
+            gchar *value = g_key_file_get_value(src, groups[groupIndex], keys[keyIndex], &tmp_err);
             if (value == NULL) {
                 g_clear_error(&tmp_err);
                 continue;
@@ -115,6 +162,23 @@ int gfal_load_configuration_to_conf_manager(GKeyFile *dest,
     }
 
     g_strfreev(groups);
+}
+
+
+int gfal_load_configuration_to_conf_manager(GKeyFile *dest,
+    const gchar *path, GError **err)
+{
+    GError *tmp_err = NULL;
+    GKeyFile *new_conf = g_key_file_new();
+
+    if (g_key_file_load_from_file(new_conf, path, G_KEY_FILE_NONE, &tmp_err) == FALSE) {
+        gfal2_propagate_prefixed_error_extended(err, tmp_err, __func__,
+            "Error while loading configuration file %s: ", path);
+        g_key_file_free(new_conf);
+        return -1;
+    }
+
+    gfal_config_merge(dest, new_conf);
     g_key_file_free(new_conf);
     return 0;
 }
@@ -132,49 +196,227 @@ gboolean is_config_dir(const char *conffile)
 }
 
 
-GKeyFile* gfal2_init_config(GError **err)
+static void gfal_config_stamp_set(gfal_config_stamp *stamp, const gchar *path, const struct stat *st)
+{
+    stamp->path = g_strdup(path);
+    stamp->dev = st->st_dev;
+    stamp->ino = st->st_ino;
+    stamp->size = st->st_size;
+#ifdef __APPLE__
+    stamp->mtime = st->st_mtimespec;
+#else
+    stamp->mtime = st->st_mtim;
+#endif
+}
+
+
+static gboolean gfal_config_stamp_changed(const gfal_config_stamp *stamp)
+{
+    struct stat st;
+    gfal_config_stamp current;
+    if (stat(stamp->path, &st) != 0) {
+        return TRUE;
+    }
+    gfal_config_stamp_set(&current, NULL, &st);
+    return current.dev != stamp->dev || current.ino != stamp->ino || current.size != stamp->size ||
+        current.mtime.tv_sec != stamp->mtime.tv_sec || current.mtime.tv_nsec != stamp->mtime.tv_nsec;
+}
+
+
+// Load every .conf file of dir_config, recording their stamps if stamps is not NULL
+static GKeyFile *gfal_load_configuration_dir(const gchar *dir_config, GArray *stamps, GError **err)
 {
     GError *tmp_err = NULL;
-    gchar *dir_config = NULL;
     GKeyFile *res = g_key_file_new();
+    struct stat st;
 
-    if ((dir_config = check_configuration_dir(&tmp_err)) != NULL) {
-        DIR *d = opendir(dir_config);
-        struct dirent *dirinfo;
-        if (d != NULL) {
-            while ((dirinfo = readdir(d)) != NULL) {
-                if (is_config_dir(dirinfo->d_name)) {
-                    char *config_file = g_strdup_printf("%s/%s", dir_config, dirinfo->d_name);
-                    gfal2_log(G_LOG_LEVEL_DEBUG, " try to load configuration file %s ...", config_file);
-                    int rc = gfal_load_configuration_to_conf_manager(res, config_file, &tmp_err);
-                    g_free(config_file);
-                    if (rc != 0) {
-                        break;
-                    }
+    if (stamps && stat(dir_config, &st) == 0) {
+        gfal_config_stamp stamp;
+        gfal_config_stamp_set(&stamp, dir_config, &st);
+        g_array_append_val(stamps, stamp);
+    }
+
+    DIR *d = opendir(dir_config);
+    struct dirent *dirinfo;
+    if (d != NULL) {
+        while ((dirinfo = readdir(d)) != NULL) {
+            if (is_config_dir(dirinfo->d_name)) {
+                char *config_file = g_strdup_printf("%s/%s", dir_config, dirinfo->d_name);
+                gfal2_log(G_LOG_LEVEL_DEBUG, " try to load configuration file %s ...", config_file);
+                if (stamps && stat(config_file, &st) == 0) {
+                    gfal_config_stamp stamp;
+                    gfal_config_stamp_set(&stamp, config_file, &st);
+                    g_array_append_val(stamps, stamp);
+                }
+                int rc = gfal_load_configuration_to_conf_manager(res, config_file, &tmp_err);
+                g_free(config_file);
+                if (rc != 0) {
+                    break;
                 }
             }
-            closedir(d);
-        }
-        else {
-            g_set_error(&tmp_err, gfal2_get_config_quark(), ENOENT, "Unable to open configuration directory %s",
-                dir_config);
         }
-        g_free(dir_config);
+        closedir(d);
+    }
+    else {
+        g_set_error(&tmp_err, gfal2_get_config_quark(), ENOENT, "Unable to open configuration directory %s",
+            dir_config);
     }
+
     if (tmp_err) {
         g_key_file_free(res);
         res = NULL;
     }
+    G_RETURN_ERR(res, tmp_err, err);
+}
+
+
+GKeyFile* gfal2_init_config(GError **err)
+{
+    GError *tmp_err = NULL;
+    gchar *dir_config = NULL;
+    GKeyFile *res = NULL;
+
+    if ((dir_config = check_configuration_dir(&tmp_err)) != NULL) {
+        res = gfal_load_configuration_dir(dir_config, NULL, &tmp_err);
+        g_free(dir_config);
+    }
 
     G_RETURN_ERR(res, tmp_err, err);
 }
 
 
+static void gfal_config_snapshot_free(gfal_config_snapshot *snapshot)
+{
+    guint i;
+    for (i = 0; i < snapshot->stamps->len; ++i) {
+        g_free(g_array_index(snapshot->stamps, gfal_config_stamp, i).path);
+    }
+    g_array_free(snapshot->stamps, TRUE);
+    if (snapshot->config) {
+        g_key_file_free(snapshot->config);
+    }
+    g_free(snapshot->dir);
+    g_free(snapshot);
+}
+
+
+static gboolean gfal_config_snapshot_is_current(const gfal_config_snapshot *snapshot, const gchar *dir_config)
+{
+    guint i;
+    if (strcmp(snapshot->dir, dir_config) != 0) {
+        return FALSE;
+    }
+    for (i = 0; i < snapshot->stamps->len; ++i) {
+        if (gfal_config_stamp_changed(&g_array_index(snapshot->stamps, gfal_config_stamp, i))) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+
+gfal_config_snapshot *gfal_config_snapshot_get(GError **err)
+{
+    GError *tmp_err = NULL;
+    gfal_config_snapshot *snapshot = NULL;
+
+    gchar *dir_config = check_configuration_dir(&tmp_err);
+    if (dir_config == NULL) {
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&gfal_config_current_lock);
+    if (gfal_config_current && gfal_config_snapshot_is_current(gfal_config_current, dir_config)) {
+        snapshot = gfal_config_snapshot_ref(gfal_config_current);
+    }
+    else {
+        snapshot = g_new0(gfal_config_snapshot, 1);
+        snapshot->refcount = 1;
+        snapshot->dir = g_strdup(dir_config);
+        snapshot->stamps = g_array_new(FALSE, TRUE, sizeof(gfal_config_stamp));
+        snapshot->config = gfal_load_configuration_dir(dir_config, snapshot->stamps, &tmp_err);
+        if (snapshot->config == NULL) {
+            gfal_config_snapshot_free(snapshot);
+            snapshot = NULL;
+        }
+        else {
+            gfal2_log(G_LOG_LEVEL_DEBUG, "Configuration snapshot of %s loaded", dir_config);
+            gfal_config_snapshot_unref(gfal_config_current);
+            gfal_config_current = gfal_config_snapshot_ref(snapshot);
+        }
+    }
+    pthread_mutex_unlock(&gfal_config_current_lock);
+
+    g_free(dir_config);
+    G_RETURN_ERR(snapshot, tmp_err, err);
+}
+
+
+gfal_config_snapshot *gfal_config_snapshot_ref(gfal_config_snapshot *snapshot)
+{
+    if (snapshot) {
+        g_atomic_int_inc(&snapshot->refcount);
+    }
+    return snapshot;
+}
+
+
+void gfal_config_snapshot_unref(gfal_config_snapshot *snapshot)
+{
+    if (snapshot && g_atomic_int_dec_and_test(&snapshot->refcount)) {
+        gfal_config_snapshot_free(snapshot);
+    }
+}
+
+
+void gfal_config_clone(gfal2_context_t dest, gfal2_context_t src)
+{
+    dest->config_snapshot = gfal_config_snapshot_ref(src->config_snapshot);
+    dest->config = g_key_file_new();
+    gfal_config_merge(dest->config, src->config);
+    dest->opt_cache = gfal_opt_cache_new();
+}
+
+
+// Layer holding the value of a key: the context overrides, else the snapshot
+static GKeyFile *gfal_config_layer(gfal2_context_t context, const gchar *group_name, const gchar *key)
+{
+    if (context->config_snapshot == NULL || g_key_file_has_key(context->config, group_name, key, NULL)) {
+        return context->config;
+    }
+    return context->config_snapshot->config;
+}
+
+
+// Stop sharing the snapshot, the context gets a full copy of its configuration
+static void gfal_config_detach(gfal2_context_t context)
+{
+    if (context->config_snapshot == NULL) {
+        return;
+    }
+    GKeyFile *flat = g_key_file_new();
+    gfal_config_merge(flat, context->config_snapshot->config);
+    gfal_config_merge(flat, context->config);
+    g_key_file_free(context->config);
+    context->config = flat;
+    gfal_config_snapshot_unref(context->config_snapshot);
+    context->config_snapshot = NULL;
+}
+
+
+// The values parsed for the previous generation are not used anymore
+static void gfal_config_changed(gfal2_context_t context)
+{
+    g_atomic_int_inc(&context->config_generation);
+}
+
+
 gchar *gfal2_get_opt_string(gfal2_context_t context, const gchar *group_name,
     const gchar *key, GError **error)
 {
     g_assert(context != NULL);
-    return g_key_file_get_string(context->config, group_name, key, error);
+    return g_key_file_get_string(gfal_config_layer(context, group_name, key), group_name, key, error);
 }
 
 
@@ -201,6 +443,7 @@ gint gfal2_set_opt_string(gfal2_context_t context, const gchar *group_name,
 {
     g_assert(context != NULL);
     g_key_file_set_string(context->config, group_name, key, value);
+    gfal_config_changed(context);
     return 0;
 }
 
@@ -209,7 +452,7 @@ gint gfal2_get_opt_integer(gfal2_context_t context, const gchar *group_name,
     const gchar *key, GError **error)
 {
     g_assert(context != NULL);
-    return g_key_file_get_integer(context->config, group_name, key, error);
+    return g_key_file_get_integer(gfal_config_layer(context, group_name, key), group_name, key, error);
 }
 
 
@@ -235,6 +478,7 @@ gint gfal2_set_opt_integer(gfal2_context_t context, const gchar *group_name,
 {
     g_assert(context != NULL);
     g_key_file_set_integer(context->config, group_name, key, value);
+    gfal_config_changed(context);
     return 0;
 }
 
@@ -243,7 +487,7 @@ gboolean gfal2_get_opt_boolean(gfal2_context_t context, const gchar *group_name,
     const gchar *key, GError **error)
 {
     g_assert(context != NULL);
-    return g_key_file_get_boolean(context->config, group_name, key, error);
+    return g_key_file_get_boolean(gfal_config_layer(context, group_name, key), group_name, key, error);
 }
 
 
@@ -270,6 +514,7 @@ gint gfal2_set_opt_boolean(gfal2_context_t context, const gchar *group_name,
 {
     g_assert(context != NULL);
     g_key_file_set_boolean(context->config, group_name, key, value);
+    gfal_config_changed(context);
     return 0;
 }
 
@@ -279,7 +524,7 @@ gchar **gfal2_get_opt_string_list(gfal2_context_t context,
     GError **error)
 {
     g_assert(context != NULL);
-    return g_key_file_get_string_list(context->config, group_name, key, length, error);
+    return g_key_file_get_string_list(gfal_config_layer(context, group_name, key), group_name, key, length, error);
 }
 
 
@@ -289,6 +534,7 @@ gint gfal2_set_opt_string_list(gfal2_context_t context, const gchar *group_name,
 {
     g_assert(context != NULL);
     g_key_file_set_string_list(context->config, group_name, key, list, length);
+    gfal_config_changed(context);
     return 0;
 }
 
@@ -319,20 +565,265 @@ gchar **gfal2_get_opt_string_list_with_default(gfal2_context_t context,
 gint gfal2_load_opts_from_file(gfal2_context_t context, const char *path,
     GError **error)
 {
-    return gfal_load_configuration_to_conf_manager(context->config, path, error);
+    int ret = gfal_load_configuration_to_conf_manager(context->config, path, error);
+    gfal_config_changed(context);
+    return ret;
 }
 
 
 gchar **gfal2_get_opt_keys(gfal2_context_t context, const gchar *group_name, gsize *length, GError **error)
 {
-    return g_key_file_get_keys(context->config, group_name, length, error);
+    GKeyFile *snapshot = context->config_snapshot ? context->config_snapshot->config : NULL;
+    if (snapshot == NULL || !g_key_file_has_group(snapshot, group_name)) {
+        return g_key_file_get_keys(context->config, group_name, length, error);
+    }
+    if (!g_key_file_has_group(context->config, group_name)) {
+        return g_key_file_get_keys(snapshot, group_name, length, error);
+    }
+
+    // Keys of the snapshot, followed by the ones only set on the context
+    gsize i, n_keys = 0, n_overrides = 0;
+    gchar **keys = g_key_file_get_keys(snapshot, group_name, &n_keys, error);
+    gchar **overrides = g_key_file_get_keys(context->config, group_name, &n_overrides, NULL);
+    GPtrArray *merged = g_ptr_array_new();
+    for (i = 0; i < n_keys; ++i) {
+        g_ptr_array_add(merged, keys[i]);
+    }
+    for (i = 0; i < n_overrides; ++i) {
+        if (g_key_file_has_key(snapshot, group_name, overrides[i], NULL)) {
+            g_free(overrides[i]);
+        }
+        else {
+            g_ptr_array_add(merged, overrides[i]);
+        }
+    }
+    g_ptr_array_add(merged, NULL);
+    g_free(keys);
+    g_free(overrides);
+
+    if (length) {
+        *length = merged->len - 1;
+    }
+    return (gchar **) g_ptr_array_free(merged, FALSE);
 }
 
 
 gboolean gfal2_remove_opt(gfal2_context_t context, const gchar *group_name,
     const gchar *key, GError **error)
 {
-    return g_key_file_remove_key(context->config, group_name, key, error);
+    // A key of the snapshot can not be hidden by the overrides
+    if (context->config_snapshot && g_key_file_has_key(context->config_snapshot->config, group_name, key, NULL)) {
+        gfal_config_detach(context);
+    }
+    gboolean removed = g_key_file_remove_key(context->config, group_name, key, error);
+    gfal_config_changed(context);
+    return removed;
+}
+
+
+gfal2_opt_t gfal2_register_opt(const gchar *group_name, const gchar *key, gfal2_opt_type_t type)
+{
+    g_assert(group_name != NULL && key != NULL);
+    gfal2_opt_t opt;
+    gpointer value = NULL;
+    // Neither group names nor keys can contain a line break
+    gchar *id = g_strdup_printf("%d\n%s\n%s", type, group_name, key);
+
+    pthread_mutex_lock(&gfal_opt_decls_lock);
+    if (gfal_opt_decls == NULL) {
+        gfal_opt_decls = g_ptr_array_new();
+        gfal_opt_handles = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    }
+    if (g_hash_table_lookup_extended(gfal_opt_handles, id, NULL, &value)) {
+        opt = GPOINTER_TO_INT(value);
+        g_free(id);
+    }
+    else {
+        gfal_opt_decl *decl = g_new0(gfal_opt_decl, 1);
+        decl->group_name = g_strdup(group_name);
+        decl->key = g_strdup(key);
+        decl->type = type;
+        opt = gfal_opt_decls->len;
+        g_ptr_array_add(gfal_opt_decls, decl);
+        g_hash_table_insert(gfal_opt_handles, id, GINT_TO_POINTER(opt));
+    }
+    pthread_mutex_unlock(&gfal_opt_decls_lock);
+    return opt;
+}
+
+
+static const gfal_opt_decl *gfal_opt_get_decl(gfal2_opt_t opt)
+{
+    const gfal_opt_decl *decl = NULL;
+    pthread_mutex_lock(&gfal_opt_decls_lock);
+    if (gfal_opt_decls != NULL && opt >= 0 && opt < (gfal2_opt_t) gfal_opt_decls->len) {
+        decl = g_ptr_array_index(gfal_opt_decls, opt);
+    }
+    pthread_mutex_unlock(&gfal_opt_decls_lock);
+    return decl;
+}
+
+
+static void gfal_opt_value_clear(gfal_opt_value *slot)
+{
+    if (slot->type == GFAL_OPT_STRING) {
+        g_free(slot->value.string);
+    }
+    else if (slot->type == GFAL_OPT_STRING_LIST) {
+        g_strfreev(slot->value.list);
+    }
+    memset(&slot->value, 0, sizeof(slot->value));
+    slot->length = 0;
+}
+
+
+struct gfal_opt_cache_s *gfal_opt_cache_new(void)
+{
+    struct gfal_opt_cache_s *cache = g_new0(struct gfal_opt_cache_s, 1);
+    pthread_mutex_init(&cache->lock, NULL);
+    cache->values = g_array_new(FALSE, TRUE, sizeof(gfal_opt_value));
+    return cache;
+}
+
+
+void gfal_opt_cache_free(struct gfal_opt_cache_s *cache)
+{
+    guint i;
+    if (cache == NULL) {
+        return;
+    }
+    for (i = 0; i < cache->values->len; ++i) {
+        gfal_opt_value_clear(&g_array_index(cache->values, gfal_opt_value, i));
+    }
+    g_array_free(cache->values, TRUE);
+    pthread_mutex_destroy(&cache->lock);
+    g_free(cache);
+}
+
+
+// Value of opt for the current generation of the context, parsed if needed
+// Must be called with the lock of the cache held, NULL if opt was not declared with this type
+static const gfal_opt_value *gfal_opt_lookup(gfal2_context_t context, gfal2_opt_t opt, gfal2_opt_type_t type)
+{
+    struct gfal_opt_cache_s *cache = context->opt_cache;
+    const gint generation = g_atomic_int_get(&context->config_generation);
+    guint i;
+
+    if (opt >= 0 && opt < (gfal2_opt_t) cache->values->len) {
+        gfal_opt_value *slot = &g_array_index(cache->values, gfal_opt_value, opt);
+        if (slot->generation == generation && slot->type == type) {
+            return slot;
+        }
+    }
+
+    const gfal_opt_decl *decl = gfal_opt_get_decl(opt);
+    if (decl == NULL || decl->type != type) {
+        gfal2_log(G_LOG_LEVEL_WARNING, "The option %d was not declared with the type %d", opt, type);
+        return NULL;
+    }
+
+    if (opt >= (gfal2_opt_t) cache->values->len) {
+        i = cache->values->len;
+        g_array_set_size(cache->values, opt + 1);
+        for (; i < cache->values->len; ++i) {
+            g_array_index(cache->values, gfal_opt_value, i).generation = -1;
+        }
+    }
+
+    gfal_opt_value *slot = &g_array_index(cache->values, gfal_opt_value, opt);
+    gfal_opt_value_clear(slot);
+    slot->type = type;
+
+    // The layers of the configuration are read the same way as by gfal2_get_opt_*
+    GError *tmp_err = NULL;
+    switch (type) {
+        case GFAL_OPT_BOOLEAN:
+            slot->value.boolean = gfal2_get_opt_boolean(context, decl->group_name, decl->key, &tmp_err);
+            break;
+        case GFAL_OPT_INTEGER:
+            slot->value.integer = gfal2_get_opt_integer(context, decl->group_name, decl->key, &tmp_err);
+            break;
+        case GFAL_OPT_STRING:
+            slot->value.string = gfal2_get_opt_string(context, decl->group_name, decl->key, &tmp_err);
+            break;
+        case GFAL_OPT_STRING_LIST:
+            slot->value.list = gfal2_get_opt_string_list(context, decl->group_name, decl->key,
+                &slot->length, &tmp_err);
+            break;
+    }
+
+    slot->found = (tmp_err == NULL);
+    if (tmp_err) {
+        gfal2_log(G_LOG_LEVEL_DEBUG, "Impossible to get parameter %s:%s, the default value is used, err %s",
+            decl->group_name, decl->key, tmp_err->message);
+        g_error_free(tmp_err);
+        gfal_opt_value_clear(slot);
+    }
+    slot->generation = generation;
+    return slot;
+}
+
+
+gboolean gfal2_opt_get_boolean(gfal2_context_t context, gfal2_opt_t opt, gboolean default_value)
+{
+    g_assert(context != NULL);
+    pthread_mutex_lock(&context->opt_cache->lock);
+    const gfal_opt_value *slot = gfal_opt_lookup(context, opt, GFAL_OPT_BOOLEAN);
+    gboolean value = (slot && slot->found) ? slot->value.boolean : default_value;
+    pthread_mutex_unlock(&context->opt_cache->lock);
+    return value;
+}
+
+
+gint gfal2_opt_get_integer(gfal2_context_t context, gfal2_opt_t opt, gint default_value)
+{
+    g_assert(context != NULL);
+    pthread_mutex_lock(&context->opt_cache->lock);
+    const gfal_opt_value *slot = gfal_opt_lookup(context, opt, GFAL_OPT_INTEGER);
+    gint value = (slot && slot->found) ? slot->value.integer : default_value;
+    pthread_mutex_unlock(&context->opt_cache->lock);
+    return value;
+}
+
+
+gchar *gfal2_opt_get_string(gfal2_context_t context, gfal2_opt_t opt, const gchar *default_value)
+{
+    g_assert(context != NULL);
+    pthread_mutex_lock(&context->opt_cache->lock);
+    const gfal_opt_value *slot = gfal_opt_lookup(context, opt, GFAL_OPT_STRING);
+    gchar *value = g_strdup((slot && slot->found) ? slot->value.string : default_value);
+    pthread_mutex_unlock(&context->opt_cache->lock);
+    return value;
+}
+
+
+gchar **gfal2_opt_get_string_list(gfal2_context_t context, gfal2_opt_t opt, gsize *length, char **default_value)
+{
+    g_assert(context != NULL);
+    gchar **value;
+    pthread_mutex_lock(&context->opt_cache->lock);
+    const gfal_opt_value *slot = gfal_opt_lookup(context, opt, GFAL_OPT_STRING_LIST);
+    if (slot && slot->found) {
+        value = g_strdupv(slot->value.list);
+        if (length) {
+            *length = slot->length;
+        }
+    }
+    else {
+        value = g_strdupv(default_value);
+        if (length) {
+            *length = default_value ? g_strv_length(default_value) : 0;
+        }
+    }
+    pthread_mutex_unlock(&context->opt_cache->lock);
+    return value;
+}
+
+
+guint gfal2_get_opt_generation(gfal2_context_t context)
+{
+    g_assert(context != NULL);
+    return (guint) g_atomic_int_get(&context->config_generation);
 }
 
 
@@ -343,6 +834,7 @@ gint gfal2_set_user_agent(gfal2_context_t handle, const char *user_agent,
     handle->agent_name = g_strdup(user_agent);
     g_free(handle->agent_version);
     handle->agent_version = g_strdup(version);
+    gfal_config_changed(handle);
     return 0;
 }
 
@@ -364,6 +856,7 @@ gint gfal2_add_client_info(gfal2_context_t handle, const char *key, const char *
     keyval->key = g_strdup(key);
     keyval->value = g_strdup(value);
     g_ptr_array_add(handle->client_info, keyval);
+    gfal_config_changed(handle);
     return 0;
 }
 
@@ -379,6 +872,7 @@ gint gfal2_remove_client_info(gfal2_context_t handle, const char *key, GError **
     gfal_key_value_t keyval = (gfal_key_value_t) g_ptr_array_index(handle->client_info, i);
     gfal_free_keyvalue(keyval, NULL);
     g_ptr_array_remove_index_fast(handle->client_info, i);
+    gfal_config_changed(handle);
 
     return 0;
 }
@@ -389,6 +883,7 @@ gint gfal2_clear_client_info(gfal2_context_t handle, GError **error)
     g_ptr_array_foreach(handle->client_info, gfal_free_keyvalue, NULL);
     g_ptr_array_free(handle->client_info, FALSE);
     handle->client_info = g_ptr_array_new();
+    gfal_config_changed(handle);
     return 0;
 }
 
@@ -259,6 +259,81 @@ gchar **gfal2_get_opt_keys(gfal2_context_t context, const gchar *group_name, gsi
 gboolean gfal2_remove_opt(gfal2_context_t context, const gchar *group_name,
     const gchar *key, GError **error);
 
+/**
+ * Type of a parameter declared with \ref gfal2_register_opt
+ */
+typedef enum {
+    GFAL_OPT_BOOLEAN,
+    GFAL_OPT_INTEGER,
+    GFAL_OPT_STRING,
+    GFAL_OPT_STRING_LIST
+} gfal2_opt_type_t;
+
+/**
+ * Handle of a parameter declared with \ref gfal2_register_opt
+ */
+typedef gint gfal2_opt_t;
+
+/**
+ * @brief declare a parameter read often, typically on every operation
+ *
+ * Declaring the same group, key and type again returns the same handle, for any context.
+ * The value of the parameter is then parsed once by each context, and again only
+ * after a parameter of the context is set or removed.
+ * @param group_name : group name of the parameter
+ * @param key : key of the parameter
+ * @param type : type of the value
+ * @return handle to give to gfal2_opt_get_*
+ */
+gfal2_opt_t gfal2_register_opt(const gchar *group_name, const gchar *key, gfal2_opt_type_t type);
+
+/**
+ * @brief similar to \ref gfal2_get_opt_boolean_with_default for a declared parameter
+ * @param context : context of gfal2
+ * @param opt : handle returned by \ref gfal2_register_opt with GFAL_OPT_BOOLEAN
+ * @param default_value : default value returned if not present
+ * @return parameter value
+ */
+gboolean gfal2_opt_get_boolean(gfal2_context_t context, gfal2_opt_t opt, gboolean default_value);
+
+/**
+ * @brief similar to \ref gfal2_get_opt_integer_with_default for a declared parameter
+ * @param context : context of gfal2
+ * @param opt : handle returned by \ref gfal2_register_opt with GFAL_OPT_INTEGER
+ * @param default_value : default value returned if not present
+ * @return parameter value
+ */
+gint gfal2_opt_get_integer(gfal2_context_t context, gfal2_opt_t opt, gint default_value);
+
+/**
+ * @brief similar to \ref gfal2_get_opt_string_with_default for a declared parameter
+ * @param context : context of gfal2
+ * @param opt : handle returned by \ref gfal2_register_opt with GFAL_OPT_STRING
+ * @param default_value : default value returned if not present
+ * @return parameter value. Must be freed using g_free
+ */
+gchar *gfal2_opt_get_string(gfal2_context_t context, gfal2_opt_t opt, const gchar *default_value);
+
+/**
+ * @brief similar to \ref gfal2_get_opt_string_list_with_default for a declared parameter
+ * @param context : context of gfal2
+ * @param opt : handle returned by \ref gfal2_register_opt with GFAL_OPT_STRING_LIST
+ * @param length : the length of the list is stored here
+ * @param default_value : default list returned if not present
+ * @return parameter value. Must be freed using g_strfreev
+ */
+gchar **gfal2_opt_get_string_list(gfal2_context_t context, gfal2_opt_t opt, gsize *length, char **default_value);
+
+/**
+ * @brief get the generation of the parameters of a context
+ *
+ * The generation changes each time a parameter, the user agent or the client information
+ * of the context is set or removed, so values derived from them can be kept until it does.
+ * @param context : context of gfal2
+ * @return the current generation
+ */
+guint gfal2_get_opt_generation(gfal2_context_t context);
+
 /**
  * Set the user agent for those protocols that support this
  */
@@ -23,10 +23,30 @@
 #define GFAL_CONFIG_INTERNAL_H_
 
 #include <glib.h>
+#include "gfal_common.h"
 
 // create or delete configuration manager for gfal2, internal
 GKeyFile* gfal2_init_config(GError **err);
 
 void gfal_free_keyvalue(gpointer data, gpointer user_data);
 
+// Configuration files parsed once and shared, read only, by the contexts
+// The contexts keep their own changes on top of it
+typedef struct gfal_config_snapshot_s gfal_config_snapshot;
+
+// Reference to the current snapshot, parsed again only if the files changed
+gfal_config_snapshot* gfal_config_snapshot_get(GError **err);
+
+gfal_config_snapshot* gfal_config_snapshot_ref(gfal_config_snapshot *snapshot);
+
+void gfal_config_snapshot_unref(gfal_config_snapshot *snapshot);
+
+// Give to dest the same configuration as src
+void gfal_config_clone(gfal2_context_t dest, gfal2_context_t src);
+
+// Values of the options declared with gfal2_register_opt, parsed once per generation
+struct gfal_opt_cache_s* gfal_opt_cache_new(void);
+
+void gfal_opt_cache_free(struct gfal_opt_cache_s* cache);
+
 #endif /* GFAL_CONFIG_INTERNAL_H_ */
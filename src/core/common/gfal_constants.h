@@ -52,6 +52,8 @@ extern "C"
 #define GFAL_PLUGIN_DIR_SUFFIX "gfal2-plugins"
 /** plugin entry point */
 #define GFAL_PLUGIN_INIT_SYM "gfal_plugin_init"
+/** suffix of the manifest installed next to a plugin, listing its schemes */
+#define GFAL_PLUGIN_MANIFEST_SUFFIX ".manifest"
 
 /**  environment variable for personalized configuration directory */
 #define GFAL_CONFIG_DIR_ENV "GFAL_CONFIG_DIR"
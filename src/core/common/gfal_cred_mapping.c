@@ -19,40 +19,167 @@
 #include "gfal_handle.h"
 
 
-typedef struct {
-    size_t prefix_len;
+// The credentials of a type are kept in a trie of URL components.
+// Each '/' is a component on its own, and so is each run of characters between them,
+// so a prefix matches at a directory boundary of an URL if and only if
+// its components are the first ones of the URL
+typedef struct gfal2_cred_node_s gfal2_cred_node_t;
+
+struct gfal2_cred_node_s {
+    // key in the children of the parent
+    char *component;
+    gfal2_cred_node_t *parent;
+    // component => gfal2_cred_node_t, NULL until the first child
+    GHashTable *children;
+    // NULL unless a credential is set for this prefix
     char *url_prefix;
     gfal2_cred_t *cred;
-} gfal2_cred_node_t ;
+};
 
 
-static gint node_compare(gconstpointer a, gconstpointer b)
+static void node_free(gpointer ptr)
 {
-    const gfal2_cred_node_t *node_a, *node_b;
-    node_a = a;
-    node_b = b;
-    int comp = -strcmp(node_a->url_prefix, node_b->url_prefix);
-    if (comp == 0) {
-        return strcmp(node_a->cred->type, node_b->cred->type);
+    gfal2_cred_node_t *node = ptr;
+    if (node->children) {
+        g_hash_table_destroy(node->children);
     }
-    return comp;
+    g_free(node->component);
+    g_free(node->url_prefix);
+    gfal2_cred_free(node->cred);
+    g_free(node);
 }
 
 
-static void node_copy(gpointer src, gpointer user_data)
+static gfal2_cred_node_t *node_new(gfal2_cred_node_t *parent, const char *component)
 {
-    gfal2_context_t dest = user_data;
-    const gfal2_cred_node_t *node = src;
-    gfal2_cred_set(dest, node->url_prefix, node->cred, NULL);
+    gfal2_cred_node_t *node = g_malloc0(sizeof(gfal2_cred_node_t));
+    node->component = g_strdup(component);
+    node->parent = parent;
+    if (parent) {
+        if (parent->children == NULL) {
+            parent->children = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, node_free);
+        }
+        g_hash_table_insert(parent->children, node->component, node);
+    }
+    return node;
 }
 
 
-static void node_free(gpointer ptr)
+// Copy the next component of the url into component, which must be as long as the url
+static gboolean next_component(const char **url, char *component)
 {
-    gfal2_cred_node_t *node = ptr;
-    g_free(node->url_prefix);
+    const char *start = *url;
+    size_t len;
+
+    if (*start == '\0') {
+        return FALSE;
+    }
+    len = (*start == '/') ? 1 : strcspn(start, "/");
+    memcpy(component, start, len);
+    component[len] = '\0';
+    *url = start + len;
+    return TRUE;
+}
+
+
+// Walk down the trie following url
+// Returns the deepest node holding a credential, and in exact the node of url itself, if it exists
+static gfal2_cred_node_t *trie_lookup(gfal2_cred_node_t *root, const char *url, gfal2_cred_node_t **exact)
+{
+    char buffer[256];
+    size_t url_len = strlen(url);
+    char *component = (url_len < sizeof(buffer)) ? buffer : g_malloc(url_len + 1);
+    gfal2_cred_node_t *node = root, *match = root->cred ? root : NULL;
+
+    while (node && next_component(&url, component)) {
+        node = node->children ? g_hash_table_lookup(node->children, component) : NULL;
+        if (node && node->cred) {
+            match = node;
+        }
+    }
+
+    if (component != buffer) {
+        g_free(component);
+    }
+    if (exact) {
+        *exact = node;
+    }
+    return match;
+}
+
+
+// Drop the nodes left without credential nor children
+static void trie_prune(gfal2_cred_node_t *node)
+{
+    while (node->parent && node->cred == NULL &&
+           (node->children == NULL || g_hash_table_size(node->children) == 0)) {
+        gfal2_cred_node_t *parent = node->parent;
+        g_hash_table_remove(parent->children, node->component);
+        node = parent;
+    }
+}
+
+
+static int trie_del(gfal2_cred_node_t *root, const char *url)
+{
+    gfal2_cred_node_t *node = NULL;
+    trie_lookup(root, url, &node);
+    if (node == NULL || node->cred == NULL) {
+        return -1;
+    }
     gfal2_cred_free(node->cred);
-    g_free(node);
+    g_free(node->url_prefix);
+    node->cred = NULL;
+    node->url_prefix = NULL;
+    trie_prune(node);
+    return 0;
+}
+
+
+static gint component_compare_desc(gconstpointer a, gconstpointer b)
+{
+    return -strcmp(a, b);
+}
+
+
+// Visit the credentials below node, node included, the descendants first
+// Returns TRUE if the callback stopped the walk
+static gboolean trie_walk(gfal2_cred_node_t *node, gfal_cred_match_func_t callback, void *user_data)
+{
+    if (node->children) {
+        GList *components = g_list_sort(g_hash_table_get_keys(node->children), component_compare_desc);
+        GList *item;
+        gboolean stop = FALSE;
+
+        for (item = components; item != NULL && !stop; item = g_list_next(item)) {
+            stop = trie_walk(g_hash_table_lookup(node->children, item->data), callback, user_data);
+        }
+        g_list_free(components);
+        if (stop) {
+            return TRUE;
+        }
+    }
+    return node->cred && callback(node->url_prefix, node->cred, user_data);
+}
+
+
+static gfal2_cred_node_t *cred_trie(gfal2_context_t handle, const char *type, gboolean create)
+{
+    gfal2_cred_node_t *root;
+
+    if (handle->cred_mapping == NULL) {
+        if (!create) {
+            return NULL;
+        }
+        handle->cred_mapping = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, node_free);
+    }
+    root = g_hash_table_lookup(handle->cred_mapping, type);
+    if (root == NULL && create) {
+        // The component of a root is its credential type
+        root = node_new(NULL, type);
+        g_hash_table_insert(handle->cred_mapping, root->component, root);
+    }
+    return root;
 }
 
 
@@ -86,48 +213,52 @@ gfal2_cred_t* gfal2_cred_dup(const gfal2_cred_t *cred)
 
 int gfal2_cred_set(gfal2_context_t handle, const char *url_prefix, const gfal2_cred_t *cred, GError **error)
 {
-    gfal2_cred_node_t *node = g_malloc0(sizeof(gfal2_cred_node_t));
-    node->prefix_len = strlen(url_prefix);
-    node->url_prefix = g_strdup(url_prefix);
-    node->cred = gfal2_cred_dup(cred);
-
-    // Remove existing value
-    GList *item = g_list_find_custom(handle->cred_mapping, node, node_compare);
-    if (item) {
-        gfal2_cred_node_t *match = item->data;
-        node_free(match);
-        handle->cred_mapping = g_list_delete_link(handle->cred_mapping, item);
-    }
-
-    // If cred is NULL, done
+    // If cred is NULL, remove the credentials of any type for this prefix
     if (cred == NULL) {
-        node_free(node);
+        if (handle->cred_mapping) {
+            GHashTableIter iter;
+            gpointer root;
+            g_hash_table_iter_init(&iter, handle->cred_mapping);
+            while (g_hash_table_iter_next(&iter, NULL, &root)) {
+                if (trie_del(root, url_prefix) == 0) {
+                    g_atomic_int_inc(&handle->cred_generation);
+                }
+            }
+        }
         return 0;
     }
 
-    handle->cred_mapping = g_list_insert_sorted(handle->cred_mapping, node, node_compare);
+    gfal2_cred_node_t *node = cred_trie(handle, cred->type, TRUE);
+    char *component = g_malloc(strlen(url_prefix) + 1);
+    const char *remaining = url_prefix;
+
+    while (next_component(&remaining, component)) {
+        gfal2_cred_node_t *child = node->children ? g_hash_table_lookup(node->children, component) : NULL;
+        node = child ? child : node_new(node, component);
+    }
+    g_free(component);
+
+    // Replace existing value
+    gfal2_cred_free(node->cred);
+    g_free(node->url_prefix);
+    node->url_prefix = g_strdup(url_prefix);
+    node->cred = gfal2_cred_dup(cred);
+    g_atomic_int_inc(&handle->cred_generation);
     return 0;
 }
 
 
 char *gfal2_cred_get(gfal2_context_t handle, const char *type, const char *url, char const** baseurl, GError **error)
 {
-    // Pick the first, which is the longest match, since the list is sorted
-    GList *item;
-    for (item = g_list_first(handle->cred_mapping); item != NULL; item = g_list_next(item)) {
-        gfal2_cred_node_t *node = item->data;
-        if (strcmp(node->cred->type, type) == 0 && strncmp(node->url_prefix, url, node->prefix_len) == 0) {
-            // Prefix must match a directory in the target URL
-            if (node->prefix_len < strlen(url) &&
-                (url[node->prefix_len - 1] != '/' && url[node->prefix_len] != '/')) {
-                continue;
-            }
+    // The deepest node on the way is the longest prefix
+    gfal2_cred_node_t *root = cred_trie(handle, type, FALSE);
+    gfal2_cred_node_t *node = root ? trie_lookup(root, url, NULL) : NULL;
 
-            if (baseurl) {
-                *baseurl = (char const*)(node->url_prefix);
-            }
-            return g_strdup(node->cred->value);
+    if (node) {
+        if (baseurl) {
+            *baseurl = (char const*)(node->url_prefix);
         }
+        return g_strdup(node->cred->value);
     }
     if (baseurl) {
         *baseurl = "";
@@ -148,35 +279,47 @@ char *gfal2_cred_get(gfal2_context_t handle, const char *type, const char *url,
 
 int gfal2_cred_del(gfal2_context_t handle, const char *type, const char *url, GError **error)
 {
-    GList *item;
+    gfal2_cred_node_t *root = cred_trie(handle, type, FALSE);
 
-    for (item = g_list_first(handle->cred_mapping); item != NULL; item = g_list_next(item)) {
-        gfal2_cred_node_t *node = item->data;
-        if ((strcmp(node->cred->type, type) == 0) && (node->prefix_len == strlen(url)) &&
-            (strcmp(node->url_prefix, url) == 0)) {
-            node_free(node);
-            handle->cred_mapping = g_list_delete_link(handle->cred_mapping, item);
-            return 0;
-        }
+    if (root == NULL || trie_del(root, url) < 0) {
+        return -1;
     }
-
-    return -1;
+    g_atomic_int_inc(&handle->cred_generation);
+    return 0;
 }
 
 int gfal2_cred_clean(gfal2_context_t handle, GError **error)
 {
-    g_list_free_full(handle->cred_mapping, node_free);
-    handle->cred_mapping = NULL;
+    if (handle->cred_mapping) {
+        g_hash_table_destroy(handle->cred_mapping);
+        handle->cred_mapping = NULL;
+    }
+    g_atomic_int_inc(&handle->cred_generation);
     return 0;
 }
 
 
+static gboolean node_copy(const char *url_prefix, const gfal2_cred_t *cred, void *user_data)
+{
+    gfal2_context_t dest = user_data;
+    gfal2_cred_set(dest, url_prefix, cred, NULL);
+    return FALSE;
+}
+
+
 int gfal2_cred_copy(gfal2_context_t dest, const gfal2_context_t src, GError **error)
 {
     if (gfal2_cred_clean(dest, error) != 0) {
         return -1;
     }
-    g_list_foreach(src->cred_mapping, node_copy, dest);
+    if (src->cred_mapping) {
+        GHashTableIter iter;
+        gpointer root;
+        g_hash_table_iter_init(&iter, src->cred_mapping);
+        while (g_hash_table_iter_next(&iter, NULL, &root)) {
+            trie_walk(root, node_copy, dest);
+        }
+    }
     return 0;
 }
 
@@ -187,16 +330,60 @@ typedef struct {
 } callback_data;
 
 
-static void foreach_callback_wrapper(gpointer item, gpointer user_data)
+static gboolean foreach_callback_wrapper(const char *url_prefix, const gfal2_cred_t *cred, void *user_data)
 {
     callback_data *data = user_data;
-    gfal2_cred_node_t *node = item;
-    data->callback(node->url_prefix, node->cred, data->user_data);
+    data->callback(url_prefix, cred, data->user_data);
+    return FALSE;
 }
 
 
 void gfal2_cred_foreach(gfal2_context_t handle, gfal_cred_func_t callback, void *user_data)
 {
     callback_data data = {callback, user_data};
-    g_list_foreach(handle->cred_mapping, foreach_callback_wrapper, &data);
+
+    if (handle->cred_mapping) {
+        GHashTableIter iter;
+        gpointer root;
+        g_hash_table_iter_init(&iter, handle->cred_mapping);
+        while (g_hash_table_iter_next(&iter, NULL, &root)) {
+            trie_walk(root, foreach_callback_wrapper, &data);
+        }
+    }
+}
+
+
+void gfal2_cred_foreach_match(gfal2_context_t handle, const char *type, const char *url, gboolean subpaths,
+    gfal_cred_match_func_t callback, void *user_data)
+{
+    gfal2_cred_node_t *root = cred_trie(handle, type, FALSE);
+    gfal2_cred_node_t *node = NULL, *exact = NULL;
+
+    if (root == NULL) {
+        return;
+    }
+    node = trie_lookup(root, url, &exact);
+
+    // The sub-paths, then the url itself
+    if (subpaths && exact) {
+        if (trie_walk(exact, callback, user_data)) {
+            return;
+        }
+        if (node == exact) {
+            node = node->parent;
+        }
+    }
+
+    // Then the prefixes, the longest first
+    for (; node != NULL; node = node->parent) {
+        if (node->cred && callback(node->url_prefix, node->cred, user_data)) {
+            return;
+        }
+    }
+}
+
+
+guint gfal2_cred_get_generation(gfal2_context_t handle)
+{
+    return (guint) g_atomic_int_get(&handle->cred_generation);
 }
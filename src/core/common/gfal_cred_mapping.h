@@ -56,6 +56,12 @@ typedef struct {
  */
 typedef void (*gfal_cred_func_t)(const char *url_prefix, const gfal2_cred_t *cred, void *user_data);
 
+/**
+ * Callback type for gfal2_cred_foreach_match
+ * @return TRUE to stop the iteration
+ */
+typedef gboolean (*gfal_cred_match_func_t)(const char *url_prefix, const gfal2_cred_t *cred, void *user_data);
+
 /**
  * Create a new gfal2_cred_t
  * @return An initialized gfal2_cred_t
@@ -131,6 +137,29 @@ int gfal2_cred_copy(gfal2_context_t dest, const gfal2_context_t src, GError **er
  */
 void gfal2_cred_foreach(gfal2_context_t handle, gfal_cred_func_t callback, void *user_data);
 
+/**
+ * Iterate over the credentials of a type that apply to a url, the longest prefix first
+ * A prefix applies if it matches the url up to a directory boundary, as for gfal2_cred_get
+ * @param handle        The gfal2 context
+ * @param type          Credential type
+ * @param url           Full URL
+ * @param subpaths      If TRUE, the credentials set for the url itself and the URLs below it are visited first
+ * @param callback      Callback for each item, returning TRUE stops the iteration
+ * @param user_data     To be passed to the callback
+ * @note                The credentials must not be changed from the callback
+ */
+void gfal2_cred_foreach_match(gfal2_context_t handle, const char *type, const char *url, gboolean subpaths,
+    gfal_cred_match_func_t callback, void *user_data);
+
+/**
+ * Get the generation of the credentials of a context
+ * It changes each time a credential is set or removed, so values derived from the credentials
+ * can be kept until it does
+ * @param handle        The gfal2 context
+ * @return              The current generation
+ */
+guint gfal2_cred_get_generation(gfal2_context_t handle);
+
 #ifdef __cplusplus
 }
 #endif
@@ -31,6 +31,7 @@ gfal_file_handle gfal_file_handle_new(const char* module_name, gpointer fdesc)
     f->fdesc = fdesc;
     f->ext_data = NULL;
     f->path = NULL;
+    f->written_url = NULL;
     return f;
 }
 
@@ -89,6 +90,7 @@ void gfal_file_handle_delete(gfal_file_handle fh)
     if (fh) {
         g_mutex_free(fh->lock);
         g_free(fh->path);
+        g_free(fh->written_url);
         g_free(fh);
     }
 }
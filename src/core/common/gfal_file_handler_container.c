@@ -28,46 +28,85 @@
 #include "gfal_file_handler_container.h"
 
 
-// generate a new unique key
-static int gfal_file_key_generatorG(gfal_file_handle_container fhandle, GError** err)
+// Pick the oldest released slot, or a new one while only a few are free
+// must be called with m_container locked
+static gint gfal_file_slot_allocG(gfal_file_handle_container fhandle, GError** err)
 {
-    g_return_val_err_if_fail(fhandle, 0, err,
-            "[gfal_file_descriptor_generatorG] Invalid  arg file handle");
-    int ret = rand();
-    GHashTable* c = fhandle->container;
-    if (g_hash_table_size(c) > G_MAXINT / 2) {
+    gint index = fhandle->n_slots;
+    const gint n_chunk = index >> GFAL_FDESC_CHUNK_BITS;
+    const gboolean full = (n_chunk >= GFAL_FDESC_MAX_CHUNKS);
+
+    if (fhandle->n_free > 0 && (fhandle->n_free >= GFAL_FDESC_MIN_FREE || full)) {
+        index = fhandle->free_head;
+        struct _gfal_file_handle_slot* slot =
+                &fhandle->chunks[index >> GFAL_FDESC_CHUNK_BITS][index & (GFAL_FDESC_CHUNK_SIZE - 1)];
+        fhandle->free_head = slot->next_free;
+        if (fhandle->free_head < 0)
+            fhandle->free_tail = -1;
+        fhandle->n_free--;
+        return index;
+    }
+
+    if (full) {
         gfal2_set_error(err, gfal2_get_plugins_quark(), EMFILE, __func__,
                 "Too many files open");
-        ret = 0;
+        return -1;
     }
-    else {
-        while (ret == 0 || g_hash_table_lookup(c, GINT_TO_POINTER(ret)) != NULL) {
-            ret = rand();
-        }
+    if (fhandle->chunks[n_chunk] == NULL) {
+        struct _gfal_file_handle_slot* chunk = g_new0(struct _gfal_file_handle_slot, GFAL_FDESC_CHUNK_SIZE);
+        g_atomic_pointer_set(&fhandle->chunks[n_chunk], chunk);
     }
-    return ret;
+    fhandle->n_slots++;
+    return index;
 }
 
-/*
- * Add the given file handle to the and return a file descriptor
- * return the associated key if success else 0 and set err
- */
+
+static struct _gfal_file_handle_slot* gfal_file_slot_get(gfal_file_handle_container fhandle, int key)
+{
+    if (key <= 0 || (key & GFAL_FDESC_SLOT_MASK) == 0)
+        return NULL;
+    const gint index = (key & GFAL_FDESC_SLOT_MASK) - 1;
+    const gint n_chunk = index >> GFAL_FDESC_CHUNK_BITS;
+    if (n_chunk >= GFAL_FDESC_MAX_CHUNKS)
+        return NULL;
+    struct _gfal_file_handle_slot* chunk = g_atomic_pointer_get(&fhandle->chunks[n_chunk]);
+    if (chunk == NULL)
+        return NULL;
+    return &chunk[index & (GFAL_FDESC_CHUNK_SIZE - 1)];
+}
+
+
+// Tag a used slot must hold to match the given key
+static gint gfal_file_slot_expected_tag(int key)
+{
+    return (((guint) key >> GFAL_FDESC_SLOT_BITS) << 1) | 1;
+}
+
+
 int gfal_add_new_file_desc(gfal_file_handle_container fhandle, gpointer pfile,
         GError** err)
 {
     g_return_val_err_if_fail(fhandle && pfile, 0, err,
             "[gfal_add_new_file_desc] Invalid  arg fhandle and/or pfile");
-    pthread_mutex_lock(&(fhandle->m_container));
     GError* tmp_err = NULL;
-    GHashTable* c = fhandle->container;
-    int key = gfal_file_key_generatorG(fhandle, &tmp_err);
-    if (key != 0) {
-        g_hash_table_insert(c, GINT_TO_POINTER(key), pfile);
+    int key = 0;
+
+    pthread_mutex_lock(&(fhandle->m_container));
+    gint index = gfal_file_slot_allocG(fhandle, &tmp_err);
+    if (index >= 0) {
+        struct _gfal_file_handle_slot* slot =
+                &fhandle->chunks[index >> GFAL_FDESC_CHUNK_BITS][index & (GFAL_FDESC_CHUNK_SIZE - 1)];
+        const gint generation = (slot->tag >> 1) & GFAL_FDESC_GENERATION_MASK;
+        g_atomic_pointer_set(&slot->data, pfile);
+        g_atomic_int_set(&slot->tag, (generation << 1) | 1);
+        fhandle->n_used++;
+        key = (generation << GFAL_FDESC_SLOT_BITS) | (index + 1);
     }
+    pthread_mutex_unlock(&(fhandle->m_container));
+
     if (tmp_err) {
         gfal2_propagate_prefixed_error(err, tmp_err, __func__);
     }
-    pthread_mutex_unlock(&(fhandle->m_container));
     return key;
 }
 
@@ -76,13 +115,39 @@ int gfal_add_new_file_desc(gfal_file_handle_container fhandle, gpointer pfile,
 gboolean gfal_remove_file_desc(gfal_file_handle_container fhandle, int key,
         GError** err)
 {
+    gboolean p = FALSE;
+    gpointer data = NULL;
+
     pthread_mutex_lock(&(fhandle->m_container));
-    GHashTable* c = fhandle->container;
-    gboolean p = g_hash_table_remove(c, GINT_TO_POINTER(key));
+    struct _gfal_file_handle_slot* slot = gfal_file_slot_get(fhandle, key);
+    if (slot != NULL && slot->tag == gfal_file_slot_expected_tag(key)) {
+        // bump the generation first, so concurrent lookups of this key fail
+        const gint generation = ((slot->tag >> 1) + 1) & GFAL_FDESC_GENERATION_MASK;
+        g_atomic_int_set(&slot->tag, generation << 1);
+        data = slot->data;
+        g_atomic_pointer_set(&slot->data, NULL);
+        // queued last, so it is the last one to be reused
+        const gint index = (key & GFAL_FDESC_SLOT_MASK) - 1;
+        slot->next_free = -1;
+        if (fhandle->free_tail >= 0) {
+            fhandle->chunks[fhandle->free_tail >> GFAL_FDESC_CHUNK_BITS]
+                    [fhandle->free_tail & (GFAL_FDESC_CHUNK_SIZE - 1)].next_free = index;
+        }
+        else {
+            fhandle->free_head = index;
+        }
+        fhandle->free_tail = index;
+        fhandle->n_free++;
+        fhandle->n_used--;
+        p = TRUE;
+    }
+    pthread_mutex_unlock(&(fhandle->m_container));
+
     if (!p)
         gfal2_set_error(err, gfal2_get_plugins_quark(), EBADF, __func__,
                 "bad file descriptor");
-    pthread_mutex_unlock(&(fhandle->m_container));
+    else if (fhandle->destroyer && data)
+        fhandle->destroyer(data);
     return p;
 }
 
@@ -91,7 +156,9 @@ gboolean gfal_remove_file_desc(gfal_file_handle_container fhandle, int key,
 gfal_file_handle_container gfal_file_descriptor_handle_create(GDestroyNotify destroyer)
 {
     gfal_file_handle_container d = g_malloc0(sizeof(struct _gfal_file_handle_container));
-    d->container = g_hash_table_new_full(NULL, NULL, NULL, destroyer);
+    d->destroyer = destroyer;
+    d->free_head = -1;
+    d->free_tail = -1;
     pthread_mutex_init(&(d->m_container), NULL);
     return d;
 }
@@ -99,8 +166,15 @@ gfal_file_handle_container gfal_file_descriptor_handle_create(GDestroyNotify des
 
 void gfal_file_descriptor_handle_destroy(gfal_file_handle_container fhandle)
 {
-    if (fhandle->container) {
-        g_hash_table_destroy(fhandle->container);
+    int i, j;
+    for (i = 0; i < GFAL_FDESC_MAX_CHUNKS && fhandle->chunks[i] != NULL; ++i) {
+        if (fhandle->destroyer) {
+            for (j = 0; j < GFAL_FDESC_CHUNK_SIZE; ++j) {
+                if ((fhandle->chunks[i][j].tag & 1) && fhandle->chunks[i][j].data)
+                    fhandle->destroyer(fhandle->chunks[i][j].data);
+            }
+        }
+        g_free(fhandle->chunks[i]);
     }
     pthread_mutex_destroy(&fhandle->m_container);
     g_free(fhandle);
@@ -111,6 +185,8 @@ void gfal_file_descriptor_handle_destroy(gfal_file_handle_container fhandle)
  *
  * return the file handle associated with the file_desc
  * @warning does not free the handle
+ * Lookups do not lock: the slot tag is checked before and after reading the data,
+ * so a descriptor closed concurrently is reported as invalid
  *
  * */
 gfal_file_handle gfal_file_handle_bind(gfal_file_handle_container h,
@@ -118,13 +194,19 @@ gfal_file_handle gfal_file_handle_bind(gfal_file_handle_container h,
 {
     g_return_val_err_if_fail(fd, 0, err, "invalid dir descriptor");
 
-
-    pthread_mutex_lock(&(h->m_container));
-    gpointer p = g_hash_table_lookup(h->container, GINT_TO_POINTER(fd));
+    gpointer p = NULL;
+    struct _gfal_file_handle_slot* slot = gfal_file_slot_get(h, fd);
+    if (slot != NULL) {
+        const gint expected = gfal_file_slot_expected_tag(fd);
+        if (g_atomic_int_get(&slot->tag) == expected) {
+            p = g_atomic_pointer_get(&slot->data);
+            if (g_atomic_int_get(&slot->tag) != expected)
+                p = NULL;
+        }
+    }
     if (!p) {
         gfal2_set_error(err, gfal2_get_plugins_quark(), EBADF, __func__,
             "bad file descriptor");
     }
-    pthread_mutex_unlock(&(h->m_container));
     return (gfal_file_handle)p;
 }
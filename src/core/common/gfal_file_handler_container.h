@@ -34,9 +34,35 @@ extern "C"
 {
 #endif
 
+// Descriptors are encoded as generation << GFAL_FDESC_SLOT_BITS | (slot + 1)
+#define GFAL_FDESC_SLOT_BITS 20
+#define GFAL_FDESC_SLOT_MASK ((1 << GFAL_FDESC_SLOT_BITS) - 1)
+#define GFAL_FDESC_GENERATION_MASK ((1 << (31 - GFAL_FDESC_SLOT_BITS)) - 1)
+// Slots are allocated by chunks, that are never moved nor released before the container
+#define GFAL_FDESC_CHUNK_BITS 10
+#define GFAL_FDESC_CHUNK_SIZE (1 << GFAL_FDESC_CHUNK_BITS)
+#define GFAL_FDESC_MAX_CHUNKS (GFAL_FDESC_SLOT_MASK / GFAL_FDESC_CHUNK_SIZE)
+// Released slots are reused in FIFO order, and only once that many are free,
+// so a stale descriptor matches again only after GFAL_FDESC_MIN_FREE * 2^generation bits releases
+#define GFAL_FDESC_MIN_FREE 1024
+
+struct _gfal_file_handle_slot {
+	volatile gint tag;          // generation << 1 | used bit
+	volatile gpointer data;
+	gint next_free;
+};
+
 struct _gfal_file_handle_container {
-	GHashTable* container;
+	struct _gfal_file_handle_slot* volatile chunks[GFAL_FDESC_MAX_CHUNKS];
+	GDestroyNotify destroyer;
+	// protects allocation and release, lookups do not take it
 	pthread_mutex_t m_container;
+	// queue of the released slots, oldest first
+	gint free_head;
+	gint free_tail;
+	gint n_free;
+	gint n_slots;
+	gint n_used;
 };
 
 struct _gfal_file_handle {
@@ -46,6 +72,8 @@ struct _gfal_file_handle {
 	gpointer ext_data;
 	gpointer fdesc;
     gchar* path;
+    // url of a file opened for writing, its cached metadata is dropped on close
+    gchar* written_url;
 };
 
 
@@ -26,6 +26,7 @@
 #   warning "Direct inclusion of gfal2 headers is deprecated. Please, include only gfal_api.h or gfal_plugins_api.h"
 #endif
 
+#include <pthread.h>
 #include "gfal_plugin_interface.h"
 
 /* enforce proper calling convention */
@@ -37,8 +38,18 @@ extern "C"
 
 struct _gfal_plugin_opts {
     gfal_plugin_interface plugin_list[MAX_PLUGIN_LIST];
-    GList* sorted_plugin;
     int plugin_number;
+    // per plugin of plugin_list, TRUE if added with gfal2_register_plugin
+    gboolean registered[MAX_PLUGIN_LIST];
+    // dispatch tables, replaced as a whole when a plugin is added, see gfal_plugin.c
+    struct gfal_plugin_index_s* volatile index;
+    // per module of the registry, TRUE once handled by this context, even if it failed
+    gboolean* modules_loaded;
+    // modules with a manifest are only instantiated for the first URL that needs them
+    gboolean lazy;
+    // set once the modules of the registry are instantiated
+    volatile gint instantiated;
+    pthread_mutex_t lock;
 };
 typedef struct _gfal_plugin_opts gfal_plugin_opts;
 
@@ -49,22 +60,59 @@ struct gfal_handle_ {
     gfal_plugin_opts plugin_opt;
 	//struct for the file descriptors
 	gfal_file_handle_container fdescs;
+	// values set on this context, see gfal_config_internal.h
 	GKeyFile *config;
+	// shared configuration files, NULL once the context has its own copy
+	struct gfal_config_snapshot_s* config_snapshot;
+	// parsed values of the declared options, see gfal2_register_opt
+	struct gfal_opt_cache_s* opt_cache;
+	// incremented each time a value is set on this context
+	volatile gint config_generation;
+	// shared plugin modules
+	struct gfal_plugin_registry_s* plugin_registry;
     // cancel logic
     volatile gint running_ops;
     gboolean cancel;
     GMutex* mux_cancel;
     GHookList cancel_hooks;
 
-	// Credential mapping
-    GList *cred_mapping;
+	// Credential mapping, type => trie of URL components, see gfal_cred_mapping.c
+    GHashTable *cred_mapping;
+    // incremented each time the credential mapping changes
+    volatile gint cred_generation;
 
     // client information
     char* agent_name;
     char* agent_version;
     GPtrArray* client_info;
+
+    // asynchronous operations, created on first use
+    struct gfal_async_executor_s* async;
+
+    // stat results, see gfal_metadata_cache.h
+    struct gfal_metadata_cache_s* metadata_cache;
+
+    // counters of the plugin operations, see gfal_metrics_internal.h
+    struct gfal_metrics_s* metrics;
 };
 
+// Stop the workers of the asynchronous operations, the pending ones complete with ECANCELED
+void gfal_async_executor_free(struct gfal_async_executor_s* executor);
+
+// Plugin modules opened once for the whole process, see gfal_plugin.c
+struct gfal_plugin_registry_s* gfal_plugin_registry_ref(struct gfal_plugin_registry_s* registry);
+
+void gfal_plugin_registry_unref(struct gfal_plugin_registry_s* registry);
+
+// Plugins of the context sorted by priority
+GList* gfal_plugins_sorted(gfal2_context_t handle);
+
+// Instantiate the modules whose manifest declares the scheme of url, if not done yet
+int gfal_plugins_load_url(gfal2_context_t handle, const char* url, GError** err);
+
+// Add the plugins registered in src to a new context, before its plugins are instantiated
+void gfal_plugins_copy_registered(gfal2_context_t dest, gfal2_context_t src);
+
 
 #ifdef __cplusplus
 }
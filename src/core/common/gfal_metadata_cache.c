@@ -0,0 +1,296 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+
+#include <gfal_api.h>
+#include <logger/gfal_logger.h>
+#include <uri/gfal2_uri.h>
+#include <gsimplecache/gcachemain.h>
+#include "gfal_error.h"
+#include "gfal_handle.h"
+#include "gfal_metadata_cache.h"
+
+
+typedef struct {
+    // 0, or the errno of the operation (only ENOENT is kept)
+    int errcode;
+    struct stat st;
+} gfal_metadata_entry;
+
+struct gfal_metadata_cache_s {
+    GSimpleCache* stat;
+    GSimpleCache* lstat;
+};
+
+// The time to live is checked by every operation
+static gfal2_opt_t opt_ttl, opt_negative_ttl;
+static pthread_once_t opts_once = PTHREAD_ONCE_INIT;
+
+static void gfal_metadata_cache_register_opts(void)
+{
+    opt_ttl = gfal2_register_opt(CORE_CONFIG_GROUP, "METADATA_CACHE_TTL", GFAL_OPT_INTEGER);
+    opt_negative_ttl = gfal2_register_opt(CORE_CONFIG_GROUP, "METADATA_CACHE_NEGATIVE_TTL", GFAL_OPT_INTEGER);
+}
+
+
+static void gfal_metadata_entry_copy(gpointer original, gpointer copy)
+{
+    memcpy(copy, original, sizeof(gfal_metadata_entry));
+}
+
+
+gfal_metadata_cache* gfal_metadata_cache_new(gfal2_context_t context)
+{
+    int max_entries = gfal2_get_opt_integer_with_default(context, CORE_CONFIG_GROUP,
+        "METADATA_CACHE_MAX_ENTRIES", 10000);
+    if (max_entries <= 0) {
+        max_entries = 1;
+    }
+
+    gfal_metadata_cache* cache = g_new0(gfal_metadata_cache, 1);
+    cache->stat = gsimplecache_new(max_entries, gfal_metadata_entry_copy, sizeof(gfal_metadata_entry));
+    cache->lstat = gsimplecache_new(max_entries, gfal_metadata_entry_copy, sizeof(gfal_metadata_entry));
+    return cache;
+}
+
+
+void gfal_metadata_cache_free(gfal_metadata_cache* cache)
+{
+    if (cache == NULL) {
+        return;
+    }
+    gsimplecache_delete(cache->stat);
+    gsimplecache_delete(cache->lstat);
+    g_free(cache);
+}
+
+
+static int gfal_metadata_cache_ttl(gfal2_context_t context)
+{
+    pthread_once(&opts_once, gfal_metadata_cache_register_opts);
+    return gfal2_opt_get_integer(context, opt_ttl, 0);
+}
+
+
+// Lower case scheme and host, no repeated nor trailing slashes in the path, no fragment
+static char* gfal_metadata_cache_key(const char* url)
+{
+    GError* tmp_err = NULL;
+    gfal2_uri* parsed = gfal2_parse_uri(url, &tmp_err);
+    if (parsed == NULL) {
+        g_clear_error(&tmp_err);
+        return g_strdup(url);
+    }
+
+    char* p;
+    for (p = parsed->scheme; p && *p; ++p) {
+        *p = g_ascii_tolower(*p);
+    }
+    for (p = parsed->host; p && *p; ++p) {
+        *p = g_ascii_tolower(*p);
+    }
+
+    if (parsed->path) {
+        char* out = parsed->path;
+        for (p = parsed->path; *p; ++p) {
+            if (*p == '/' && out > parsed->path && out[-1] == '/') {
+                continue;
+            }
+            *out++ = *p;
+        }
+        if (out > parsed->path + 1 && out[-1] == '/') {
+            --out;
+        }
+        *out = '\0';
+    }
+
+    gfal2_uri_replace(parsed, &parsed->fragment, NULL);
+
+    char* key = gfal2_join_uri(parsed);
+    gfal2_free_uri(parsed);
+    return key;
+}
+
+
+// Key of the parent directory, NULL for the root
+static char* gfal_metadata_cache_parent_key(const char* key)
+{
+    const char* path = strstr(key, "://");
+    path = path ? strchr(path + 3, '/') : strchr(key, '/');
+    if (path == NULL) {
+        return NULL;
+    }
+
+    const char* last = strrchr(path, '/');
+    if (last == path) {
+        // Child of the root, which keeps its slash
+        return (last[1] != '\0') ? g_strndup(key, last - key + 1) : NULL;
+    }
+    return g_strndup(key, last - key);
+}
+
+
+int gfal_metadata_cache_lookup(gfal2_context_t context, const char* url, gboolean lstat,
+    struct stat* st, GError** err)
+{
+    if (context->metadata_cache == NULL || gfal_metadata_cache_ttl(context) <= 0) {
+        return 0;
+    }
+
+    GSimpleCache* cache = lstat ? context->metadata_cache->lstat : context->metadata_cache->stat;
+    gfal_metadata_entry entry;
+    char* key = gfal_metadata_cache_key(url);
+    int found = gsimplecache_get_kstr(cache, key, &entry);
+    g_free(key);
+
+    if (found < 0) {
+        return 0;
+    }
+
+    gfal2_log(G_LOG_LEVEL_DEBUG, "Metadata of %s taken from the cache", url);
+    if (entry.errcode != 0) {
+        gfal2_set_error(err, gfal2_get_core_quark(), entry.errcode, __func__,
+            "%s (cached): %s", strerror(entry.errcode), url);
+        return -1;
+    }
+    memcpy(st, &entry.st, sizeof(struct stat));
+    return 1;
+}
+
+
+static void gfal_metadata_cache_add_key(gfal2_context_t context, GSimpleCache* cache, const char* key,
+    const struct stat* st, const GError* error)
+{
+    int ttl = gfal_metadata_cache_ttl(context);
+    if (ttl <= 0) {
+        return;
+    }
+
+    gfal_metadata_entry entry;
+    memset(&entry, 0, sizeof(entry));
+
+    if (error != NULL) {
+        if (error->code != ENOENT) {
+            return;
+        }
+        ttl = gfal2_opt_get_integer(context, opt_negative_ttl, 0);
+        if (ttl <= 0) {
+            return;
+        }
+        entry.errcode = ENOENT;
+    }
+    else {
+        memcpy(&entry.st, st, sizeof(struct stat));
+    }
+
+    // A newer stat replaces the cached one
+    gsimplecache_replace_item_kstr_ttl(cache, key, &entry, ttl);
+}
+
+
+void gfal_metadata_cache_add(gfal2_context_t context, const char* url, gboolean lstat,
+    const struct stat* st, const GError* error)
+{
+    if (context->metadata_cache == NULL || gfal_metadata_cache_ttl(context) <= 0) {
+        return;
+    }
+
+    GSimpleCache* cache = lstat ? context->metadata_cache->lstat : context->metadata_cache->stat;
+    char* key = gfal_metadata_cache_key(url);
+    gfal_metadata_cache_add_key(context, cache, key, st, error);
+    g_free(key);
+}
+
+
+void gfal_metadata_cache_add_entry(gfal2_context_t context, const char* dir_url, const char* name,
+    const struct stat* st)
+{
+    // Whether readdirpp follows the links depends on the plugin, so links are left out
+    if (context->metadata_cache == NULL || S_ISLNK(st->st_mode) || gfal_metadata_cache_ttl(context) <= 0) {
+        return;
+    }
+
+    char* url;
+    if (name[0] == '/') {
+        // Some plugins return the full path of the entries
+        const char* root = strstr(dir_url, "://");
+        root = root ? strchr(root + 3, '/') : NULL;
+        int root_len = root ? (int) (root - dir_url) : (int) strlen(dir_url);
+        url = g_strdup_printf("%.*s%s", root_len, dir_url, name);
+    }
+    else {
+        url = g_strconcat(dir_url, "/", name, NULL);
+    }
+
+    char* key = gfal_metadata_cache_key(url);
+    gfal_metadata_cache_add_key(context, context->metadata_cache->stat, key, st, NULL);
+    g_free(key);
+    g_free(url);
+}
+
+
+static void gfal_metadata_cache_remove(gfal_metadata_cache* cache, const char* key)
+{
+    gsimplecache_remove_kstr(cache->stat, key);
+    gsimplecache_remove_kstr(cache->lstat, key);
+}
+
+
+void gfal_metadata_cache_invalidate(gfal2_context_t context, const char* url, gboolean recursive)
+{
+    gfal_metadata_cache* cache = context->metadata_cache;
+    if (cache == NULL || url == NULL) {
+        return;
+    }
+
+    char* key = gfal_metadata_cache_key(url);
+    gfal_metadata_cache_remove(cache, key);
+
+    char* parent = gfal_metadata_cache_parent_key(key);
+    if (parent) {
+        gfal_metadata_cache_remove(cache, parent);
+        g_free(parent);
+    }
+
+    if (recursive) {
+        const char* separator = g_str_has_suffix(key, "/") ? "" : "/";
+        char* prefix = g_strconcat(key, separator, NULL);
+        gsimplecache_remove_prefix_kstr(cache->stat, prefix);
+        gsimplecache_remove_prefix_kstr(cache->lstat, prefix);
+        g_free(prefix);
+    }
+    g_free(key);
+}
+
+
+void gfal_metadata_cache_invalidate_parents(gfal2_context_t context, const char* url)
+{
+    gfal_metadata_cache* cache = context->metadata_cache;
+    if (cache == NULL || url == NULL) {
+        return;
+    }
+
+    char* key = gfal_metadata_cache_key(url);
+    while (key != NULL) {
+        gfal_metadata_cache_remove(cache, key);
+        char* parent = gfal_metadata_cache_parent_key(key);
+        g_free(key);
+        key = parent;
+    }
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifndef GFAL_METADATA_CACHE_H_
+#define GFAL_METADATA_CACHE_H_
+
+#include <glib.h>
+#include <sys/stat.h>
+
+#include <common/gfal_common.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Cache of the stat and lstat results of a context, keyed by normalized url
+// Disabled unless CORE:METADATA_CACHE_TTL is set. Failures with ENOENT are kept
+// for CORE:METADATA_CACHE_NEGATIVE_TTL seconds, other failures are never kept.
+
+typedef struct gfal_metadata_cache_s gfal_metadata_cache;
+
+gfal_metadata_cache* gfal_metadata_cache_new(gfal2_context_t context);
+
+void gfal_metadata_cache_free(gfal_metadata_cache* cache);
+
+// Lookup the result of a stat (or lstat if lstat is TRUE) of url
+// Returns 1 and fills st if found, -1 and sets err to ENOENT if known not to exist, 0 if unknown
+int gfal_metadata_cache_lookup(gfal2_context_t context, const char* url, gboolean lstat,
+    struct stat* st, GError** err);
+
+// Keep the result of a stat (or lstat) of url. error is the failure of the operation, or NULL
+void gfal_metadata_cache_add(gfal2_context_t context, const char* url, gboolean lstat,
+    const struct stat* st, const GError* error);
+
+// Keep the stat of an entry of the directory dir_url, as returned by readdirpp
+void gfal_metadata_cache_add_entry(gfal2_context_t context, const char* dir_url, const char* name,
+    const struct stat* st);
+
+// Forget url and its parent directory, and everything below url if recursive is TRUE
+void gfal_metadata_cache_invalidate(gfal2_context_t context, const char* url, gboolean recursive);
+
+// Forget url and all its parent directories, up to the root
+void gfal_metadata_cache_invalidate_parents(gfal2_context_t context, const char* url);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GFAL_METADATA_CACHE_H_ */
@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <string.h>
+
+#include <gfal_api.h>
+#include "gfal_error.h"
+#include "gfal_handle.h"
+#include "gfal_metrics.h"
+#include "gfal_metrics_internal.h"
+
+
+static const char* gfal_metric_op_names[GFAL_METRIC_OP_COUNT] = {
+    "access", "stat", "lstat", "readlink", "chmod", "rename", "symlink", "mkdir", "rmdir",
+    "opendir", "readdir", "closedir", "open", "read", "write", "pread", "pwrite", "preadv", "close",
+    "unlink", "getxattr", "setxattr", "listxattr", "checksum", "bring_online", "stat_list",
+    "unlink_list", "copy"
+};
+
+// Counters are only updated with atomic additions
+typedef struct {
+    guint64 count;
+    guint64 errors;
+    guint64 bytes;
+    guint64 latency_sum;
+    guint64 latency_buckets[GFAL2_METRICS_BUCKETS];
+} gfal_metric_slot;
+
+struct gfal_metrics_s {
+    gfal_metric_slot* volatile slots[MAX_PLUGIN_LIST][GFAL_METRIC_OP_COUNT];
+};
+
+
+gfal_metrics* gfal_metrics_new(void)
+{
+    return g_new0(gfal_metrics, 1);
+}
+
+
+void gfal_metrics_free(gfal_metrics* metrics)
+{
+    if (metrics == NULL) {
+        return;
+    }
+    int i, op;
+    for (i = 0; i < MAX_PLUGIN_LIST; ++i) {
+        for (op = 0; op < GFAL_METRIC_OP_COUNT; ++op) {
+            g_free(metrics->slots[i][op]);
+        }
+    }
+    g_free(metrics);
+}
+
+
+// 4 exact buckets, then 4 buckets per power of two
+static int gfal_metrics_bucket(guint64 latency)
+{
+    if (latency < 4) {
+        return (int) latency;
+    }
+    int octave = 63 - __builtin_clzll(latency);
+    int bucket = 4 + (octave - 2) * 4 + (int) ((latency >> (octave - 2)) & 3);
+    return MIN(bucket, GFAL2_METRICS_BUCKETS - 1);
+}
+
+
+guint64 gfal2_metrics_bucket_bound(int bucket)
+{
+    if (bucket < 0) {
+        return 0;
+    }
+    if (bucket >= GFAL2_METRICS_BUCKETS - 1) {
+        return G_MAXUINT64;
+    }
+    if (bucket < 4) {
+        return bucket + 1;
+    }
+    int octave = (bucket - 4) / 4 + 2;
+    int sub = (bucket - 4) % 4;
+    return (guint64) (4 + sub + 1) << (octave - 2);
+}
+
+
+void gfal_metrics_record(gfal2_context_t handle, const gfal_plugin_interface* p, gfal_metric_op op,
+    gint64 start, gboolean failed, gint64 bytes)
+{
+    gfal_metrics* metrics = handle->metrics;
+    if (metrics == NULL || p == NULL) {
+        return;
+    }
+    ptrdiff_t index = p - handle->plugin_opt.plugin_list;
+    if (index < 0 || index >= MAX_PLUGIN_LIST) {
+        return;
+    }
+
+    gfal_metric_slot* slot = g_atomic_pointer_get(&metrics->slots[index][op]);
+    if (slot == NULL) {
+        gfal_metric_slot* new_slot = g_new0(gfal_metric_slot, 1);
+        if (g_atomic_pointer_compare_and_exchange(&metrics->slots[index][op], NULL, new_slot)) {
+            slot = new_slot;
+        }
+        else {
+            g_free(new_slot);
+            slot = g_atomic_pointer_get(&metrics->slots[index][op]);
+        }
+    }
+
+    gint64 latency = gfal_metrics_now() - start;
+    if (latency < 0) {
+        latency = 0;
+    }
+
+    __sync_fetch_and_add(&slot->count, 1);
+    if (failed) {
+        __sync_fetch_and_add(&slot->errors, 1);
+    }
+    if (bytes > 0) {
+        __sync_fetch_and_add(&slot->bytes, (guint64) bytes);
+    }
+    __sync_fetch_and_add(&slot->latency_sum, (guint64) latency);
+    __sync_fetch_and_add(&slot->latency_buckets[gfal_metrics_bucket(latency)], 1);
+}
+
+
+gfal2_metric_t* gfal2_get_metrics(gfal2_context_t context, size_t* n_metrics, GError** err)
+{
+    if (context == NULL || n_metrics == NULL) {
+        gfal2_set_error(err, gfal2_get_core_quark(), EFAULT, __func__, "context or n_metrics are NULL");
+        return NULL;
+    }
+
+    GArray* result = g_array_new(FALSE, TRUE, sizeof(gfal2_metric_t));
+    gfal_metrics* metrics = context->metrics;
+    int n_plugins = g_atomic_int_get(&context->plugin_opt.plugin_number);
+    int i, op, bucket;
+
+    for (i = 0; metrics != NULL && i < n_plugins; ++i) {
+        for (op = 0; op < GFAL_METRIC_OP_COUNT; ++op) {
+            gfal_metric_slot* slot = g_atomic_pointer_get(&metrics->slots[i][op]);
+            if (slot == NULL) {
+                continue;
+            }
+
+            gfal2_metric_t metric;
+            metric.plugin = context->plugin_opt.plugin_list[i].getName();
+            metric.operation = gfal_metric_op_names[op];
+            metric.count = __sync_fetch_and_add(&slot->count, 0);
+            metric.errors = __sync_fetch_and_add(&slot->errors, 0);
+            metric.bytes = __sync_fetch_and_add(&slot->bytes, 0);
+            metric.latency_sum = __sync_fetch_and_add(&slot->latency_sum, 0);
+            for (bucket = 0; bucket < GFAL2_METRICS_BUCKETS; ++bucket) {
+                metric.latency_buckets[bucket] = __sync_fetch_and_add(&slot->latency_buckets[bucket], 0);
+            }
+            g_array_append_val(result, metric);
+        }
+    }
+
+    *n_metrics = result->len;
+    return (gfal2_metric_t*) g_array_free(result, FALSE);
+}
+
+
+static void gfal_metrics_prometheus_counter(GString* out, const char* name, const char* help,
+    const gfal2_metric_t* metrics, size_t n_metrics, size_t field)
+{
+    size_t i;
+    g_string_append_printf(out, "# HELP %s %s\n# TYPE %s counter\n", name, help, name);
+    for (i = 0; i < n_metrics; ++i) {
+        guint64 value = *(const guint64*) ((const char*) &metrics[i] + field);
+        g_string_append_printf(out, "%s{plugin=\"%s\",operation=\"%s\"} %" G_GUINT64_FORMAT "\n",
+            name, metrics[i].plugin, metrics[i].operation, value);
+    }
+}
+
+
+char* gfal2_get_metrics_prometheus(gfal2_context_t context, GError** err)
+{
+    GError* tmp_err = NULL;
+    size_t n_metrics = 0, i;
+    int bucket;
+
+    gfal2_metric_t* metrics = gfal2_get_metrics(context, &n_metrics, &tmp_err);
+    if (metrics == NULL) {
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        return NULL;
+    }
+
+    GString* out = g_string_new(NULL);
+    gfal_metrics_prometheus_counter(out, "gfal2_plugin_operations_total",
+        "Operations run by the plugins", metrics, n_metrics, G_STRUCT_OFFSET(gfal2_metric_t, count));
+    gfal_metrics_prometheus_counter(out, "gfal2_plugin_operation_errors_total",
+        "Failed operations", metrics, n_metrics, G_STRUCT_OFFSET(gfal2_metric_t, errors));
+    gfal_metrics_prometheus_counter(out, "gfal2_plugin_operation_bytes_total",
+        "Bytes read or written", metrics, n_metrics, G_STRUCT_OFFSET(gfal2_metric_t, bytes));
+
+    // Only the powers of two are exposed as histogram bounds.
+    // Latencies are whole microseconds and le is inclusive, so the last value of the bucket is used
+    const char* name = "gfal2_plugin_operation_duration_seconds";
+    g_string_append_printf(out, "# HELP %s Latency of the operations\n# TYPE %s histogram\n", name, name);
+    for (i = 0; i < n_metrics; ++i) {
+        const char* plugin = metrics[i].plugin;
+        const char* operation = metrics[i].operation;
+        guint64 cumulative = 0;
+
+        for (bucket = 0; bucket < GFAL2_METRICS_BUCKETS - 1; ++bucket) {
+            cumulative += metrics[i].latency_buckets[bucket];
+            guint64 bound = gfal2_metrics_bucket_bound(bucket);
+            if ((bound & (bound - 1)) == 0) {
+                g_string_append_printf(out, "%s_bucket{plugin=\"%s\",operation=\"%s\",le=\"%g\"} %" G_GUINT64_FORMAT "\n",
+                    name, plugin, operation, (bound - 1) / 1e6, cumulative);
+            }
+        }
+        // The buckets were read after the count, so they are the reference
+        cumulative += metrics[i].latency_buckets[GFAL2_METRICS_BUCKETS - 1];
+        g_string_append_printf(out, "%s_bucket{plugin=\"%s\",operation=\"%s\",le=\"+Inf\"} %" G_GUINT64_FORMAT "\n",
+            name, plugin, operation, cumulative);
+        g_string_append_printf(out, "%s_sum{plugin=\"%s\",operation=\"%s\"} %g\n",
+            name, plugin, operation, metrics[i].latency_sum / 1e6);
+        g_string_append_printf(out, "%s_count{plugin=\"%s\",operation=\"%s\"} %" G_GUINT64_FORMAT "\n",
+            name, plugin, operation, cumulative);
+    }
+
+    g_free(metrics);
+    return g_string_free(out, FALSE);
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifndef GFAL_METRICS_H_
+#define GFAL_METRICS_H_
+
+#if !defined(__GFAL2_H_INSIDE__) && !defined(__GFAL2_BUILD__)
+#   warning "Direct inclusion of gfal2 headers is deprecated. Please, include only gfal_api.h or gfal_plugins_api.h"
+#endif
+
+#include <stddef.h>
+#include <glib.h>
+
+#include "gfal_common.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * @file gfal_metrics.h
+ * @brief metrics of the operations run by the plugins of a context
+ *
+ * Each context counts the operations dispatched to each plugin, with their failures,
+ * the bytes they transferred and the distribution of their latencies.
+ */
+
+/**
+    \defgroup metrics_group Metrics
+    @{
+*/
+
+/// Number of latency buckets, see \ref gfal2_metrics_bucket_bound
+#define GFAL2_METRICS_BUCKETS 104
+
+/// Metrics of one operation on one plugin
+typedef struct {
+    /// Name of the plugin
+    const char* plugin;
+    /// Name of the operation (stat, open, read, checksum...)
+    const char* operation;
+    /// Number of calls
+    guint64 count;
+    /// Number of failed calls
+    guint64 errors;
+    /// Bytes read or written
+    guint64 bytes;
+    /// Sum of the latencies, in microseconds
+    guint64 latency_sum;
+    /// Number of calls per latency bucket
+    guint64 latency_buckets[GFAL2_METRICS_BUCKETS];
+} gfal2_metric_t;
+
+/**
+ * @brief exclusive upper bound, in microseconds, of a latency bucket
+ *
+ * Buckets are exact up to 4 microseconds, then each power of two is split in 4 buckets
+ * of equal width. The last bucket has no upper bound (G_MAXUINT64)
+ */
+guint64 gfal2_metrics_bucket_bound(int bucket);
+
+/**
+ * @brief snapshot of the metrics of a context
+ *
+ * Only the operations called at least once are returned. The counters are read without
+ * stopping the running operations, so they may be slightly behind each other.
+ *
+ * @param context : gfal2 handle, see \ref gfal2_context_new
+ * @param n_metrics : set to the number of metrics returned
+ * @param err : GError error report
+ * @return array of n_metrics metrics, to be freed with g_free. The names it points to
+ *         are valid as long as the context
+ */
+gfal2_metric_t* gfal2_get_metrics(gfal2_context_t context, size_t* n_metrics, GError** err);
+
+/**
+ * @brief metrics of a context in the Prometheus text exposition format
+ *
+ * @return a string to be freed with g_free, NULL on error
+ */
+char* gfal2_get_metrics_prometheus(gfal2_context_t context, GError** err);
+
+/**
+    @}
+    End of the METRICS group
+*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GFAL_METRICS_H_ */
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifndef GFAL_METRICS_INTERNAL_H_
+#define GFAL_METRICS_INTERNAL_H_
+
+#include <glib.h>
+
+#include "gfal_plugin_interface.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Operations measured at the plugin dispatch points
+typedef enum {
+    GFAL_METRIC_ACCESS = 0,
+    GFAL_METRIC_STAT,
+    GFAL_METRIC_LSTAT,
+    GFAL_METRIC_READLINK,
+    GFAL_METRIC_CHMOD,
+    GFAL_METRIC_RENAME,
+    GFAL_METRIC_SYMLINK,
+    GFAL_METRIC_MKDIR,
+    GFAL_METRIC_RMDIR,
+    GFAL_METRIC_OPENDIR,
+    GFAL_METRIC_READDIR,
+    GFAL_METRIC_CLOSEDIR,
+    GFAL_METRIC_OPEN,
+    GFAL_METRIC_READ,
+    GFAL_METRIC_WRITE,
+    GFAL_METRIC_PREAD,
+    GFAL_METRIC_PWRITE,
+    GFAL_METRIC_PREADV,
+    GFAL_METRIC_CLOSE,
+    GFAL_METRIC_UNLINK,
+    GFAL_METRIC_GETXATTR,
+    GFAL_METRIC_SETXATTR,
+    GFAL_METRIC_LISTXATTR,
+    GFAL_METRIC_CHECKSUM,
+    GFAL_METRIC_BRING_ONLINE,
+    GFAL_METRIC_STAT_LIST,
+    GFAL_METRIC_UNLINK_LIST,
+    GFAL_METRIC_COPY,
+    GFAL_METRIC_OP_COUNT
+} gfal_metric_op;
+
+// Counters of a context, one set per plugin and operation, allocated on first use
+typedef struct gfal_metrics_s gfal_metrics;
+
+gfal_metrics* gfal_metrics_new(void);
+
+void gfal_metrics_free(gfal_metrics* metrics);
+
+// Start time to give to gfal_metrics_record
+#define gfal_metrics_now() g_get_monotonic_time()
+
+// Account a call of op on the plugin p, started at start, that transferred bytes
+// Lock free, so it can be called from any thread
+void gfal_metrics_record(gfal2_context_t handle, const gfal_plugin_interface* p, gfal_metric_op op,
+    gint64 start, gboolean failed, gint64 bytes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GFAL_METRICS_INTERNAL_H_ */
@@ -22,6 +22,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <dlfcn.h>
+#include <pthread.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <fcntl.h>
@@ -31,12 +32,85 @@
 #include "gfal_constants.h"
 #include "gfal_error.h"
 #include "gfal_file_handler_container.h"
+#include "gfal_metadata_cache.h"
+#include "gfal_metrics_internal.h"
 #include <future/glib.h>
 
 #ifndef GFAL_PLUGIN_DIR_DEFAULT
 #error "GFAL_PLUGIN_DIR_DEFAULT should be define at compile time"
 #endif
 
+// Longest URL scheme considered by the dispatch index
+#define GFAL_PLUGIN_SCHEME_MAX_LEN 32
+
+// Group and keys of a plugin manifest
+#define GFAL_MANIFEST_GROUP "PLUGIN"
+#define GFAL_MANIFEST_NAME "NAME"
+#define GFAL_MANIFEST_SCHEMES "SCHEMES"
+#define GFAL_MANIFEST_PRIORITY "PRIORITY"
+#define GFAL_MANIFEST_CAPABILITIES "CAPABILITIES"
+
+typedef gfal_plugin_interface (*gfal_plugin_constructor)(gfal2_context_t, GError**);
+
+// State of a plugin library
+enum {
+    GFAL_MODULE_CLOSED = 0,
+    GFAL_MODULE_OPEN,
+    GFAL_MODULE_BROKEN
+};
+
+// Plugin library of the plugin directory
+// The libraries with a manifest are only opened when a context needs one of their schemes
+typedef struct {
+    gchar* path;
+    void* dlhandle;
+    gfal_plugin_constructor constructor;
+    // content of the manifest, schemes is NULL if the library has none
+    gchar* name;
+    gchar** schemes;
+    gchar** capabilities;
+    // overrides the priority set by the plugin when has_priority
+    gboolean has_priority;
+    int priority;
+    // GFAL_MODULE_*, changed under gfal_plugin_registry_lock
+    volatile gint state;
+} gfal_plugin_module;
+
+// Modules of the plugin directory, shared by the contexts
+// Each context still instantiates its own plugins out of them
+// As before the registry, the libraries are never closed
+struct gfal_plugin_registry_s {
+    volatile gint refcount;
+    gchar* dir;
+    time_t mtime;
+    GArray* modules;
+};
+
+// Registry given to the new contexts while the plugin directory is unchanged
+static struct gfal_plugin_registry_s* gfal_plugin_registry_current = NULL;
+static pthread_mutex_t gfal_plugin_registry_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Candidate plugins for the URLs of a scheme, by priority
+typedef struct {
+    GPtrArray* plugins;
+    // some modules declaring the scheme are not instantiated yet
+    gboolean pending;
+} gfal_plugin_scheme_entry;
+
+// Dispatch tables of a context, read without locking
+// They are never modified once published: adding a plugin publishes new ones,
+// and the previous ones are only released with the plugins
+struct gfal_plugin_index_s {
+    GList* sorted_plugin;
+    // scheme -> gfal_plugin_scheme_entry
+    GHashTable* schemes;
+    // plugins that do not declare their schemes, by priority
+    GPtrArray* legacy_plugins;
+    // some modules with a manifest are not instantiated yet
+    gboolean pending;
+    struct gfal_plugin_index_s* previous;
+};
+
 
 /*
  * function to use in order to create a new plugin interface
@@ -81,37 +155,178 @@ gboolean gfal_plugin_checker_safe(gfal_plugin_interface* cata_list,
 
 //
 // Resolve entry point in a plugin and add it to the current plugin list
+// The slot is only counted once filled, since the plugin list is read without locking
 //
-static int gfal_module_init(gfal2_context_t handle, void* dlhandle,
-        const char* module_name, GError** err)
+static int gfal_module_init(gfal2_context_t handle, const gfal_plugin_module* module, GError** err)
 {
     GError* tmp_err = NULL;
-    static gfal_plugin_interface (*constructor)(gfal2_context_t, GError**);
-    int* n = &handle->plugin_opt.plugin_number;
+    int n = handle->plugin_opt.plugin_number;
     int res = -1;
-    constructor = (gfal_plugin_interface (*)(gfal2_context_t, GError**)) dlsym(dlhandle, GFAL_PLUGIN_INIT_SYM);
-    if (constructor == NULL) {
-        g_set_error(&tmp_err, gfal2_get_plugins_quark(), EINVAL,
-                "No symbol %s found in the plugin %s, failure",
-                GFAL_PLUGIN_INIT_SYM, module_name);
-        *n = 0;
+
+    if (n >= MAX_PLUGIN_LIST) {
+        g_set_error(&tmp_err, gfal2_get_plugins_quark(), ENOMEM,
+                "Not enough space to load the plugin %s", module->path);
     }
     else {
-        handle->plugin_opt.plugin_list[*n] = constructor(handle, &tmp_err);
-        handle->plugin_opt.plugin_list[*n].gfal_data = dlhandle;
+        handle->plugin_opt.plugin_list[n] = module->constructor(handle, &tmp_err);
+        handle->plugin_opt.plugin_list[n].gfal_data = module->dlhandle;
+        handle->plugin_opt.registered[n] = FALSE;
         if (tmp_err) {
-            g_prefix_error(&tmp_err, "Unable to load plugin %s : ", module_name);
-            *n = 0;
+            g_prefix_error(&tmp_err, "Unable to load plugin %s : ", module->path);
         }
         else {
-            *n += 1;
-            gfal2_log(G_LOG_LEVEL_MESSAGE, "[gfal_module_load] plugin %s loaded with success ", module_name);
+            // The manifest decides the dispatch order
+            if (module->schemes != NULL && module->has_priority)
+                handle->plugin_opt.plugin_list[n].priority = module->priority;
+            g_atomic_int_inc(&handle->plugin_opt.plugin_number);
+            gfal2_log(G_LOG_LEVEL_MESSAGE, "[gfal_module_load] plugin %s loaded with success ", module->path);
             res = 0;
         }
     }
     G_RETURN_ERR(res, tmp_err, err);
 }
 
+
+static void gfal_plugin_scheme_entry_free(gpointer data)
+{
+    gfal_plugin_scheme_entry* entry = (gfal_plugin_scheme_entry*) data;
+    g_ptr_array_free(entry->plugins, TRUE);
+    g_free(entry);
+}
+
+
+static void gfal_plugin_scheme_entry_append(gpointer key, gpointer value, gpointer user_data)
+{
+    g_ptr_array_add(((gfal_plugin_scheme_entry*) value)->plugins, user_data);
+}
+
+
+static gfal_plugin_scheme_entry* gfal_plugin_index_entry(struct gfal_plugin_index_s* index, const char* scheme)
+{
+    gchar* key = g_ascii_strdown(scheme, -1);
+    gfal_plugin_scheme_entry* entry = g_hash_table_lookup(index->schemes, key);
+    if (entry == NULL) {
+        entry = g_new0(gfal_plugin_scheme_entry, 1);
+        entry->plugins = g_ptr_array_new();
+        g_hash_table_insert(index->schemes, key, entry);
+    }
+    else {
+        g_free(key);
+    }
+    return entry;
+}
+
+//
+// Release the dispatch tables, with the ones they replaced
+//
+static void gfal_plugin_index_free(struct gfal_plugin_index_s* index)
+{
+    while (index != NULL) {
+        struct gfal_plugin_index_s* previous = index->previous;
+        g_list_free(index->sorted_plugin);
+        g_hash_table_destroy(index->schemes);
+        g_ptr_array_free(index->legacy_plugins, TRUE);
+        g_free(index);
+        index = previous;
+    }
+}
+
+//
+// Build the scheme -> candidate plugins index
+// Each candidate list keeps the priority order, and includes the plugins
+// that do not declare any scheme, since those may accept anything
+// The schemes of the modules not instantiated yet are flagged as pending
+//
+static struct gfal_plugin_index_s* gfal_plugins_build_index(gfal2_context_t handle, GList* sorted_plugin)
+{
+    gfal_plugin_opts* opts = &handle->plugin_opt;
+    struct gfal_plugin_index_s* index = g_new0(struct gfal_plugin_index_s, 1);
+    GList* l;
+    const char* const* scheme;
+    guint i;
+
+    index->sorted_plugin = sorted_plugin;
+    index->schemes = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, gfal_plugin_scheme_entry_free);
+    index->legacy_plugins = g_ptr_array_new();
+
+    for (l = sorted_plugin; l != NULL; l = g_list_next(l)) {
+        gfal_plugin_interface* p = (gfal_plugin_interface*) l->data;
+        for (scheme = p->url_schemes; scheme != NULL && *scheme != NULL; ++scheme) {
+            gfal_plugin_index_entry(index, *scheme);
+        }
+    }
+
+    GArray* modules = handle->plugin_registry ? handle->plugin_registry->modules : NULL;
+    for (i = 0; modules != NULL && opts->modules_loaded != NULL && i < modules->len; ++i) {
+        gfal_plugin_module* module = &g_array_index(modules, gfal_plugin_module, i);
+        if (opts->modules_loaded[i] || module->schemes == NULL ||
+            g_atomic_int_get(&module->state) == GFAL_MODULE_BROKEN) {
+            continue;
+        }
+        for (scheme = (const char* const*) module->schemes; *scheme != NULL; ++scheme) {
+            gfal_plugin_index_entry(index, *scheme)->pending = TRUE;
+        }
+        index->pending = TRUE;
+    }
+
+    for (l = sorted_plugin; l != NULL; l = g_list_next(l)) {
+        gfal_plugin_interface* p = (gfal_plugin_interface*) l->data;
+        if (p->url_schemes == NULL) {
+            g_ptr_array_add(index->legacy_plugins, p);
+            g_hash_table_foreach(index->schemes, gfal_plugin_scheme_entry_append, p);
+            continue;
+        }
+        for (scheme = p->url_schemes; *scheme != NULL; ++scheme) {
+            GPtrArray* candidates = gfal_plugin_index_entry(index, *scheme)->plugins;
+            if (candidates->len == 0 || g_ptr_array_index(candidates, candidates->len - 1) != p) {
+                g_ptr_array_add(candidates, p);
+            }
+        }
+    }
+    return index;
+}
+
+//
+// Extract the lower case scheme of url into buffer
+// return FALSE if the url has no valid scheme
+//
+static gboolean gfal_plugin_url_scheme(const char* url, char* buffer, size_t s_buff)
+{
+    size_t i;
+    if (!g_ascii_isalpha(url[0])) {
+        return FALSE;
+    }
+    for (i = 0; i < s_buff - 1 && url[i] != '\0'; ++i) {
+        if (url[i] == ':') {
+            buffer[i] = '\0';
+            return TRUE;
+        }
+        if (!g_ascii_isalnum(url[i]) && url[i] != '+' && url[i] != '-' && url[i] != '.') {
+            return FALSE;
+        }
+        buffer[i] = g_ascii_tolower(url[i]);
+    }
+    return FALSE;
+}
+
+//
+// Index entry of the scheme, NULL if no plugin declares it
+//
+static gfal_plugin_scheme_entry* gfal_plugin_lookup(struct gfal_plugin_index_s* index, const char* scheme)
+{
+    if (index == NULL || scheme == NULL) {
+        return NULL;
+    }
+    return g_hash_table_lookup(index->schemes, scheme);
+}
+
+
+GList* gfal_plugins_sorted(gfal2_context_t handle)
+{
+    struct gfal_plugin_index_s* index = g_atomic_pointer_get(&handle->plugin_opt.index);
+    return index ? index->sorted_plugin : NULL;
+}
+
 // unload each loaded plugin
 int gfal_plugins_delete(gfal2_context_t handle, GError** err)
 {
@@ -127,6 +342,11 @@ int gfal_plugins_delete(gfal2_context_t handle, GError** err)
 
         handle->plugin_opt.plugin_number = 0;
     }
+    g_atomic_int_set(&handle->plugin_opt.instantiated, FALSE);
+    gfal_plugin_index_free(handle->plugin_opt.index);
+    handle->plugin_opt.index = NULL;
+    g_free(handle->plugin_opt.modules_loaded);
+    handle->plugin_opt.modules_loaded = NULL;
     return 0;
 }
 
@@ -154,72 +374,156 @@ gfal_plugin_interface* gfal_plugin_map_file_handle(gfal2_context_t handle, gfal_
     return cata_list;
 }
 
-// external function to get the list of the plugins loaded
-char** gfal_plugins_get_list(gfal2_context_t handle, GError** err)
+//
+// Names of the modules with a manifest that are not instantiated in this context
+//
+static GPtrArray* gfal_plugins_available(gfal2_context_t handle)
 {
-    GError* tmp_err = NULL;
-    char** resu = NULL;
-    int n = gfal_plugins_instance(handle, &tmp_err);
-    if (n > 0) {
-        resu = g_new0(char*, n + 1);
-        int i;
-        gfal_plugin_interface* cata_list = handle->plugin_opt.plugin_list;
-        for (i = 0; i < n; ++i, ++cata_list) {
-            resu[i] = strndup(cata_list->getName(), GFAL_URL_MAX_LEN);
+    GPtrArray* names = g_ptr_array_new();
+    gfal_plugin_opts* opts = &handle->plugin_opt;
+    guint i;
+
+    pthread_mutex_lock(&opts->lock);
+    GArray* modules = handle->plugin_registry ? handle->plugin_registry->modules : NULL;
+    for (i = 0; modules != NULL && opts->modules_loaded != NULL && i < modules->len; ++i) {
+        gfal_plugin_module* module = &g_array_index(modules, gfal_plugin_module, i);
+        if (!opts->modules_loaded[i] && module->schemes != NULL &&
+            g_atomic_int_get(&module->state) != GFAL_MODULE_BROKEN) {
+            g_ptr_array_add(names, g_strdup(module->name));
         }
     }
-    if (tmp_err)
-        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
-    return resu;
+    pthread_mutex_unlock(&opts->lock);
+    return names;
 }
 
-// external function to return a gfal_plugin_interface from a given plugin name
-gfal_plugin_interface* gfal_search_plugin_with_name(gfal2_context_t handle,
-        const char* name, GError** err)
+// external function to get the list of the plugins
+// the loaded ones come first, followed by the ones only known from their manifest
+char** gfal_plugins_get_list(gfal2_context_t handle, GError** err)
 {
-    g_return_val_err_if_fail(name && handle, NULL, err, "must be non NULL value");
     GError* tmp_err = NULL;
-    gfal_plugin_interface* resu = NULL;
+    char** resu = NULL;
     int n = gfal_plugins_instance(handle, &tmp_err);
-    if (n > 0) {
-        int i;
-        gfal_plugin_interface* cata_list = handle->plugin_opt.plugin_list;
-        for (i = 0; i < n; ++i, ++cata_list) {
-            const char* plugin_name = cata_list->getName();
-            if (plugin_name != NULL && strcmp(plugin_name, name) == 0) {
-                resu = cata_list;
-                break;
+    if (n >= 0) {
+        GPtrArray* available = gfal_plugins_available(handle);
+        if (n > 0 || available->len > 0) {
+            resu = g_new0(char*, n + available->len + 1);
+            int i;
+            gfal_plugin_interface* cata_list = handle->plugin_opt.plugin_list;
+            for (i = 0; i < n; ++i, ++cata_list) {
+                resu[i] = strndup(cata_list->getName(), GFAL_URL_MAX_LEN);
             }
+            memcpy(resu + n, available->pdata, available->len * sizeof(char*));
         }
-        if (resu == NULL)
-            g_set_error(&tmp_err, gfal2_get_plugins_quark(), ENOENT,
-                    " No plugin loaded with this name %s", name);
+        g_ptr_array_free(available, TRUE);
     }
-
     if (tmp_err)
         gfal2_propagate_prefixed_error(err, tmp_err, __func__);
     return resu;
 }
 
-//  load the gfal_plugins in the listed library
-static int gfal_module_load(gfal2_context_t handle, char* module_name, GError** err)
+
+gchar** gfal2_get_available_plugin_names(gfal2_context_t context)
 {
-    void* dlhandle = dlopen(module_name, RTLD_NOW);
-    GError * tmp_err = NULL;
+    GPtrArray* available = gfal_plugins_available(context);
+    g_ptr_array_add(available, NULL);
+    return (gchar**) g_ptr_array_free(available, FALSE);
+}
+
+//  open the library of a module and resolve its entry point
+//  if the library can not be opened, the module is flagged as broken and 0 is returned
+static int gfal_module_load(gfal_plugin_module* module, GError** err)
+{
+    void* dlhandle = dlopen(module->path, RTLD_NOW);
     int res = 0;
     if (dlhandle == NULL) {
         gfal2_log(G_LOG_LEVEL_WARNING, "Unable to open the %s plugin specified in the plugin directory: %s",
-            module_name, dlerror());
+            module->path, dlerror());
+        module->state = GFAL_MODULE_BROKEN;
     }
     else {
-        res = gfal_module_init(handle, dlhandle, module_name, &tmp_err);
-    }
-    if (tmp_err) {
-        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        module->constructor = (gfal_plugin_constructor) dlsym(dlhandle, GFAL_PLUGIN_INIT_SYM);
+        if (module->constructor == NULL) {
+            gfal2_set_error(err, gfal2_get_plugins_quark(), EINVAL, __func__,
+                    "No symbol %s found in the plugin %s, failure",
+                    GFAL_PLUGIN_INIT_SYM, module->path);
+            module->state = GFAL_MODULE_BROKEN;
+            res = -1;
+        }
+        else {
+            module->dlhandle = dlhandle;
+            g_atomic_int_set(&module->state, GFAL_MODULE_OPEN);
+        }
     }
     return res;
 }
 
+//
+// Open the library of a module with a manifest, once for the whole process
+// return FALSE if it can not be used
+//
+static gboolean gfal_module_open(gfal_plugin_module* module)
+{
+    if (g_atomic_int_get(&module->state) == GFAL_MODULE_CLOSED) {
+        pthread_mutex_lock(&gfal_plugin_registry_lock);
+        if (module->state == GFAL_MODULE_CLOSED) {
+            GError* tmp_err = NULL;
+            gfal2_log(G_LOG_LEVEL_DEBUG, "Opening the plugin %s on demand", module->path);
+            if (gfal_module_load(module, &tmp_err) != 0) {
+                gfal2_log(G_LOG_LEVEL_WARNING, "%s", tmp_err->message);
+                g_error_free(tmp_err);
+            }
+        }
+        pthread_mutex_unlock(&gfal_plugin_registry_lock);
+    }
+    return g_atomic_int_get(&module->state) == GFAL_MODULE_OPEN;
+}
+
+//
+// Read the manifest installed next to the library of a module, if any
+//
+static void gfal_module_read_manifest(gfal_plugin_module* module)
+{
+    GError* tmp_err = NULL;
+    gchar* manifest = g_strconcat(module->path, GFAL_PLUGIN_MANIFEST_SUFFIX, NULL);
+    GKeyFile* key_file = g_key_file_new();
+
+    if (!g_file_test(manifest, G_FILE_TEST_IS_REGULAR)) {
+        // Not an error, the library is opened with the registry
+    }
+    else if (!g_key_file_load_from_file(key_file, manifest, G_KEY_FILE_NONE, &tmp_err)) {
+        gfal2_log(G_LOG_LEVEL_WARNING, "Ignoring the plugin manifest %s: %s", manifest, tmp_err->message);
+        g_error_free(tmp_err);
+    }
+    else {
+        module->schemes = g_key_file_get_string_list(key_file, GFAL_MANIFEST_GROUP, GFAL_MANIFEST_SCHEMES,
+                NULL, NULL);
+        if (module->schemes == NULL || module->schemes[0] == NULL) {
+            gfal2_log(G_LOG_LEVEL_WARNING, "Ignoring the plugin manifest %s: it declares no scheme", manifest);
+            g_strfreev(module->schemes);
+            module->schemes = NULL;
+        }
+        else {
+            gchar** scheme;
+            for (scheme = module->schemes; *scheme != NULL; ++scheme) {
+                gchar* lower = g_ascii_strdown(g_strstrip(*scheme), -1);
+                g_free(*scheme);
+                *scheme = lower;
+            }
+            module->name = g_key_file_get_string(key_file, GFAL_MANIFEST_GROUP, GFAL_MANIFEST_NAME, NULL);
+            module->has_priority = g_key_file_has_key(key_file, GFAL_MANIFEST_GROUP, GFAL_MANIFEST_PRIORITY, NULL);
+            module->priority = g_key_file_get_integer(key_file, GFAL_MANIFEST_GROUP, GFAL_MANIFEST_PRIORITY, NULL);
+            module->capabilities = g_key_file_get_string_list(key_file, GFAL_MANIFEST_GROUP,
+                    GFAL_MANIFEST_CAPABILITIES, NULL, NULL);
+        }
+    }
+    if (module->schemes != NULL && module->name == NULL) {
+        module->name = g_path_get_basename(module->path);
+    }
+
+    g_key_file_free(key_file);
+    g_free(manifest);
+}
+
 
 /*
  * Provide a list of the gfal2 plugins path
@@ -235,7 +539,7 @@ char ** gfal_list_directory_plugins(const char * dir, GError ** err)
     if (d) {
         gchar * d_name = NULL;
         while ((d_name = (char*) g_dir_read_name(d)) != NULL) {
-            if (strstr(d_name, G_MODULE_SUFFIX) != NULL) {
+            if (strstr(d_name, G_MODULE_SUFFIX) != NULL && !g_str_has_suffix(d_name, GFAL_PLUGIN_MANIFEST_SUFFIX)) {
                 GString * strbuff = g_string_new(dir);
                 n++;
                 if (n == 1) {
@@ -274,11 +578,9 @@ char ** gfal_list_directory_plugins(const char * dir, GError ** err)
 }
 
 
-char ** gfal_localize_plugins(GError** err)
+static const char* gfal_plugin_directory(void)
 {
-    GError * tmp_err = NULL;
-    char** res = NULL;
-    char * gfal_plugin_dir = (char*) g_getenv(GFAL_PLUGIN_DIR_ENV);
+    const char* gfal_plugin_dir = g_getenv(GFAL_PLUGIN_DIR_ENV);
     if (gfal_plugin_dir != NULL) {
         gfal2_log(G_LOG_LEVEL_DEBUG,
                 "... %s environment variable specified, try to load the plugins in given dir : %s",
@@ -292,31 +594,169 @@ char ** gfal_localize_plugins(GError** err)
                 GFAL_PLUGIN_DIR_ENV, gfal_plugin_dir);
 
     }
-    res = gfal_list_directory_plugins(gfal_plugin_dir, &tmp_err);
+    return gfal_plugin_dir;
+}
+
+
+char ** gfal_localize_plugins(GError** err)
+{
+    GError * tmp_err = NULL;
+    char** res = gfal_list_directory_plugins(gfal_plugin_directory(), &tmp_err);
     G_RETURN_ERR(res, tmp_err, err);
 }
 
 
+static void gfal_plugin_registry_free(struct gfal_plugin_registry_s* registry)
+{
+    guint i;
+    for (i = 0; i < registry->modules->len; ++i) {
+        gfal_plugin_module* module = &g_array_index(registry->modules, gfal_plugin_module, i);
+        g_free(module->path);
+        g_free(module->name);
+        g_strfreev(module->schemes);
+        g_strfreev(module->capabilities);
+    }
+    g_array_free(registry->modules, TRUE);
+    g_free(registry->dir);
+    g_free(registry);
+}
+
+
+struct gfal_plugin_registry_s* gfal_plugin_registry_ref(struct gfal_plugin_registry_s* registry)
+{
+    if (registry)
+        g_atomic_int_inc(&registry->refcount);
+    return registry;
+}
+
+
+void gfal_plugin_registry_unref(struct gfal_plugin_registry_s* registry)
+{
+    if (registry && g_atomic_int_dec_and_test(&registry->refcount))
+        gfal_plugin_registry_free(registry);
+}
+
+
+static time_t gfal_plugin_directory_mtime(const char* dir)
+{
+    struct stat st;
+    if (stat(dir, &st) != 0)
+        return 0;
+    return st.st_mtime;
+}
+
+
+// List the modules of the plugin directory, and open the ones without a manifest
+static struct gfal_plugin_registry_s* gfal_plugin_registry_new(const char* dir, GError** err)
+{
+    GError* tmp_err = NULL;
+    struct gfal_plugin_registry_s* registry = g_new0(struct gfal_plugin_registry_s, 1);
+    registry->refcount = 1;
+    registry->dir = g_strdup(dir);
+    registry->mtime = gfal_plugin_directory_mtime(dir);
+    registry->modules = g_array_new(FALSE, TRUE, sizeof(gfal_plugin_module));
+
+    char** tab_args = gfal_list_directory_plugins(dir, &tmp_err);
+    char** p;
+    for (p = tab_args; p != NULL && *p != NULL && **p != '\0'; ++p) {
+        gfal_plugin_module module;
+        memset(&module, 0, sizeof(module));
+        module.path = g_strdup(*p);
+        gfal_module_read_manifest(&module);
+
+        if (module.schemes == NULL && gfal_module_load(&module, &tmp_err) != 0) {
+            g_free(module.path);
+            break;
+        }
+        if (module.state != GFAL_MODULE_BROKEN) {
+            g_array_append_val(registry->modules, module);
+            gfal2_log(G_LOG_LEVEL_DEBUG, " gfal_plugin %s successfully : %s",
+                    module.schemes ? "registered" : "loaded", *p);
+        }
+        else {
+            g_free(module.path);
+        }
+    }
+    g_strfreev(tab_args);
+
+    if (tmp_err) {
+        gfal_plugin_registry_free(registry);
+        registry = NULL;
+    }
+    G_RETURN_ERR(registry, tmp_err, err);
+}
+
+
+// Reference to the current registry, built again only if the plugin directory changed
+static struct gfal_plugin_registry_s* gfal_plugin_registry_get(GError** err)
+{
+    GError* tmp_err = NULL;
+    struct gfal_plugin_registry_s* registry = NULL;
+    const char* dir = gfal_plugin_directory();
+
+    pthread_mutex_lock(&gfal_plugin_registry_lock);
+    registry = gfal_plugin_registry_current;
+    if (registry && strcmp(registry->dir, dir) == 0 && registry->mtime == gfal_plugin_directory_mtime(dir)) {
+        gfal_plugin_registry_ref(registry);
+    }
+    else {
+        registry = gfal_plugin_registry_new(dir, &tmp_err);
+        if (registry) {
+            gfal_plugin_registry_unref(gfal_plugin_registry_current);
+            gfal_plugin_registry_current = gfal_plugin_registry_ref(registry);
+        }
+    }
+    pthread_mutex_unlock(&gfal_plugin_registry_lock);
+
+    if (tmp_err)
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+    return registry;
+}
+
+//
+// Instantiate a module of the registry in this context, if not done yet
+// A module that fails is not tried again by this context
+// Must be called with the plugin lock of the context
+//
+static int gfal_module_instance(gfal2_context_t handle, guint i, GError** err)
+{
+    gfal_plugin_module* module = &g_array_index(handle->plugin_registry->modules, gfal_plugin_module, i);
+    int res = 0;
+
+    if (!handle->plugin_opt.modules_loaded[i]) {
+        if (gfal_module_open(module)) {
+            res = gfal_module_init(handle, module, err);
+        }
+        handle->plugin_opt.modules_loaded[i] = TRUE;
+    }
+    return res;
+}
+
+
 int gfal_modules_resolve(gfal2_context_t handle, GError** err)
 {
     GError* tmp_err = NULL;
     int res = -1;
-    char** tab_args;
 
-    if ((tab_args = gfal_localize_plugins(&tmp_err)) != NULL) {
-        char** p = tab_args;
-        while (*p != NULL) {
-            if (**p == '\0')
-                break;
-            if (gfal_module_load(handle, *p, &tmp_err) != 0) {
+    if (handle->plugin_registry == NULL)
+        handle->plugin_registry = gfal_plugin_registry_get(&tmp_err);
+
+    if (handle->plugin_registry) {
+        GArray* modules = handle->plugin_registry->modules;
+        guint i;
+        g_free(handle->plugin_opt.modules_loaded);
+        handle->plugin_opt.modules_loaded = g_new0(gboolean, modules->len + 1);
+        res = 0;
+        for (i = 0; i < modules->len; ++i) {
+            gfal_plugin_module* module = &g_array_index(modules, gfal_plugin_module, i);
+            if (handle->plugin_opt.lazy && module->schemes != NULL) {
+                continue;
+            }
+            if (gfal_module_instance(handle, i, &tmp_err) != 0) {
                 res = -1;
                 break;
             }
-            gfal2_log(G_LOG_LEVEL_DEBUG, " gfal_plugin loaded successfully : %s", *p);
-            res = 0;
-            p++;
         }
-        g_strfreev(tab_args);
     }
 
     if (tmp_err)
@@ -335,33 +775,30 @@ gint gfal_plugin_compare(gconstpointer a, gconstpointer b)
 }
 
 //
-// Sort plugins by priority
+// Sort plugins by priority, and publish the new dispatch tables
+// Must be called with the plugin lock of the context
 //
 int gfal_plugins_sort(gfal2_context_t handle, GError ** err)
 {
-    if (handle->plugin_opt.sorted_plugin) {
-        g_list_free(handle->plugin_opt.sorted_plugin);
-        handle->plugin_opt.sorted_plugin = NULL;
-    }
-
+    GList* sorted_plugin = NULL;
     int i;
     for (i = 0; i < handle->plugin_opt.plugin_number; ++i) {
-        handle->plugin_opt.sorted_plugin = g_list_append(
-                handle->plugin_opt.sorted_plugin,
-                &(handle->plugin_opt.plugin_list[i]));
+        sorted_plugin = g_list_append(sorted_plugin, &(handle->plugin_opt.plugin_list[i]));
     }
-    handle->plugin_opt.sorted_plugin = g_list_sort(
-            handle->plugin_opt.sorted_plugin, &gfal_plugin_compare);
+    sorted_plugin = g_list_sort(sorted_plugin, &gfal_plugin_compare);
+
+    struct gfal_plugin_index_s* index = gfal_plugins_build_index(handle, sorted_plugin);
+    index->previous = handle->plugin_opt.index;
+    g_atomic_pointer_set(&handle->plugin_opt.index, index);
 
     if (gfal2_log_get_level() >= G_LOG_LEVEL_DEBUG) { // print plugin order
         GString* strbuff = g_string_new(" plugin priority order: ");
-        GList* l = handle->plugin_opt.sorted_plugin;
+        GList* l;
 
-        for (i = 0; i < handle->plugin_opt.plugin_number; ++i) {
+        for (l = sorted_plugin; l != NULL; l = g_list_next(l)) {
             strbuff = g_string_append(strbuff,
                     ((gfal_plugin_interface*) l->data)->getName());
             strbuff = g_string_append(strbuff, " -> ");
-            l = g_list_next(l);
         }
         gfal2_log(G_LOG_LEVEL_DEBUG, "%s", strbuff->str);
         g_string_free(strbuff, TRUE);
@@ -371,30 +808,161 @@ int gfal_plugins_sort(gfal2_context_t handle, GError ** err)
 
 //
 // Instantiate all plugins for use if it's not the case
+// The modules with a manifest are left for gfal_plugins_load, unless PLUGIN_LAZY_LOADING is disabled
 // return the number of plugins available
+// Cloned contexts get here on their first operation, maybe from several threads
 //
 int gfal_plugins_instance(gfal2_context_t handle, GError** err)
 {
     g_return_val_err_if_fail(handle, -1, err,
             "[gfal_plugins_instance]  invalid value of handle");
-    const int plugin_number = handle->plugin_opt.plugin_number;
-    if (plugin_number <= 0) {
+    if (g_atomic_int_get(&handle->plugin_opt.instantiated))
+        return g_atomic_int_get(&handle->plugin_opt.plugin_number);
+
+    pthread_mutex_lock(&handle->plugin_opt.lock);
+    if (!handle->plugin_opt.instantiated) {
         GError* tmp_err = NULL;
+        if (handle->plugin_opt.plugin_number < 0)
+            handle->plugin_opt.plugin_number = 0;
+        handle->plugin_opt.lazy = gfal2_get_opt_boolean_with_default(handle, CORE_CONFIG_GROUP,
+                "PLUGIN_LAZY_LOADING", TRUE);
         gfal_modules_resolve(handle, &tmp_err);
+        if (!tmp_err)
+            gfal_plugins_sort(handle, &tmp_err);
         if (tmp_err) {
             gfal2_propagate_prefixed_error(err, tmp_err, __func__);
             handle->plugin_opt.plugin_number = -1;
         }
-        else if (handle->plugin_opt.plugin_number > 0) {
-            gfal_plugins_sort(handle, &tmp_err);
-            if (tmp_err) {
-                gfal2_propagate_prefixed_error(err, tmp_err, __func__);
-                return -1;
-            }
+        else {
+            g_atomic_int_set(&handle->plugin_opt.instantiated, TRUE);
         }
-        return handle->plugin_opt.plugin_number;
     }
-    return plugin_number;
+    pthread_mutex_unlock(&handle->plugin_opt.lock);
+    return g_atomic_int_get(&handle->plugin_opt.plugin_number);
+}
+
+static gboolean gfal_module_has_scheme(const gfal_plugin_module* module, const char* scheme)
+{
+    gchar** p;
+    for (p = module->schemes; *p != NULL; ++p) {
+        if (strcmp(*p, scheme) == 0)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+//
+// Instantiate the modules with a manifest not handled yet by this context
+// Only the ones declaring scheme or called name if given, all of them otherwise
+// A module that fails does not stop the next ones. Its error is only reported when
+// scheme or name selected it, and no other module could be instantiated
+// return the number of modules instantiated, -1 on error
+//
+static int gfal_plugins_load(gfal2_context_t handle, const char* scheme, const char* name, GError** err)
+{
+    GError* tmp_err = NULL;
+    gfal_plugin_opts* opts = &handle->plugin_opt;
+    int loaded = 0, failed = 0;
+    guint i;
+
+    pthread_mutex_lock(&opts->lock);
+    GArray* modules = handle->plugin_registry ? handle->plugin_registry->modules : NULL;
+    for (i = 0; modules != NULL && opts->modules_loaded != NULL && i < modules->len; ++i) {
+        gfal_plugin_module* module = &g_array_index(modules, gfal_plugin_module, i);
+        if (opts->modules_loaded[i] || module->schemes == NULL) {
+            continue;
+        }
+        if (scheme && !gfal_module_has_scheme(module, scheme)) {
+            continue;
+        }
+        if (name && g_strcmp0(module->name, name) != 0) {
+            continue;
+        }
+        if (gfal2_log_get_level() >= G_LOG_LEVEL_DEBUG) {
+            gchar* capabilities = module->capabilities ? g_strjoinv(",", module->capabilities) : NULL;
+            gfal2_log(G_LOG_LEVEL_DEBUG, "Loading the plugin %s (priority %d, capabilities %s) for %s",
+                    module->name, module->priority, capabilities ? capabilities : "none",
+                    scheme ? scheme : (name ? name : "any URL"));
+            g_free(capabilities);
+        }
+        GError* module_err = NULL;
+        if (gfal_module_instance(handle, i, &module_err) == 0) {
+            ++loaded;
+        }
+        else {
+            gfal2_log(G_LOG_LEVEL_WARNING, "%s", module_err->message);
+            if ((scheme || name) && tmp_err == NULL)
+                tmp_err = module_err;
+            else
+                g_error_free(module_err);
+            ++failed;
+        }
+    }
+    // Published even on failure, the broken modules are not pending anymore
+    if (loaded + failed > 0) {
+        gfal_plugins_sort(handle, NULL);
+    }
+    pthread_mutex_unlock(&opts->lock);
+
+    int res = loaded;
+    if (loaded > 0)
+        g_clear_error(&tmp_err);
+    else if (tmp_err)
+        res = -1;
+    G_RETURN_ERR(res, tmp_err, err);
+}
+
+
+int gfal_plugins_load_url(gfal2_context_t handle, const char* url, GError** err)
+{
+    char scheme[GFAL_PLUGIN_SCHEME_MAX_LEN];
+    if (gfal_plugins_instance(handle, err) < 0) {
+        return -1;
+    }
+    if (url == NULL || !gfal_plugin_url_scheme(url, scheme, sizeof(scheme))) {
+        return 0;
+    }
+    gfal_plugin_scheme_entry* entry = gfal_plugin_lookup(g_atomic_pointer_get(&handle->plugin_opt.index), scheme);
+    if (entry == NULL || !entry->pending) {
+        return 0;
+    }
+    return gfal_plugins_load(handle, scheme, NULL, err);
+}
+
+//
+// First plugin accepting url among the ones that may, by priority
+// The modules declaring the scheme of url are instantiated first, if needed
+//
+static gfal_plugin_interface* gfal_plugin_dispatch(gfal2_context_t handle, const char* url,
+        plugin_mode acc_mode, GError** err)
+{
+    char scheme[GFAL_PLUGIN_SCHEME_MAX_LEN];
+    const char* url_scheme = gfal_plugin_url_scheme(url, scheme, sizeof(scheme)) ? scheme : NULL;
+    struct gfal_plugin_index_s* index = g_atomic_pointer_get(&handle->plugin_opt.index);
+    gfal_plugin_scheme_entry* entry = gfal_plugin_lookup(index, url_scheme);
+
+    if (entry && entry->pending) {
+        if (gfal_plugins_load(handle, url_scheme, NULL, err) < 0) {
+            return NULL;
+        }
+        index = g_atomic_pointer_get(&handle->plugin_opt.index);
+        entry = gfal_plugin_lookup(index, url_scheme);
+    }
+
+    GPtrArray* candidates = entry ? entry->plugins : (index ? index->legacy_plugins : NULL);
+    guint i;
+    for (i = 0; candidates != NULL && i < candidates->len; ++i) {
+        gfal_plugin_interface* plugin_ifce = g_ptr_array_index(candidates, i);
+        GError* tmp_err = NULL;
+        gboolean compatible = gfal_plugin_checker_safe(plugin_ifce, url, acc_mode, &tmp_err);
+        if (tmp_err) {
+            g_propagate_error(err, tmp_err);
+            return NULL;
+        }
+        if (compatible)
+            return plugin_ifce;
+    }
+    return NULL;
 }
 
 
@@ -402,19 +970,18 @@ gfal_plugin_interface* gfal_find_plugin(gfal2_context_t handle, const char * url
         plugin_mode acc_mode, GError** err)
 {
     GError* tmp_err = NULL;
-    gboolean compatible = FALSE;
+    gfal_plugin_interface* plugin_ifce = NULL;
     const int n_plugins = gfal_plugins_instance(handle, &tmp_err);
-    if (n_plugins > 0) {
-        GList * plugin_list = g_list_first(handle->plugin_opt.sorted_plugin);
-        while (plugin_list != NULL) {
-            gfal_plugin_interface* plugin_ifce = plugin_list->data;
-            compatible = gfal_plugin_checker_safe(plugin_ifce, url, acc_mode, &tmp_err);
-            if (tmp_err)
-                break;
-            if (compatible)
-                return plugin_ifce;
-            plugin_list = g_list_next(plugin_list);
+    if (n_plugins >= 0 && url != NULL) {
+        plugin_ifce = gfal_plugin_dispatch(handle, url, acc_mode, &tmp_err);
+        // A manifest may be missing a scheme, so try again with everything before giving up
+        if (plugin_ifce == NULL && tmp_err == NULL) {
+            struct gfal_plugin_index_s* index = g_atomic_pointer_get(&handle->plugin_opt.index);
+            if (index && index->pending && gfal_plugins_load(handle, NULL, NULL, &tmp_err) > 0)
+                plugin_ifce = gfal_plugin_dispatch(handle, url, acc_mode, &tmp_err);
         }
+        if (plugin_ifce)
+            return plugin_ifce;
     }
     if (tmp_err) {
         gfal2_propagate_prefixed_error(err, tmp_err, __func__);
@@ -426,21 +993,80 @@ gfal_plugin_interface* gfal_find_plugin(gfal2_context_t handle, const char * url
     return NULL;
 }
 
+static gfal_plugin_interface* gfal_plugin_with_name(gfal2_context_t handle, int n, const char* name)
+{
+    int i;
+    for (i = 0; i < n; ++i) {
+        const char* plugin_name = handle->plugin_opt.plugin_list[i].getName();
+        if (plugin_name != NULL && strcmp(plugin_name, name) == 0)
+            return &handle->plugin_opt.plugin_list[i];
+    }
+    return NULL;
+}
+
+// external function to return a gfal_plugin_interface from a given plugin name
+gfal_plugin_interface* gfal_search_plugin_with_name(gfal2_context_t handle,
+        const char* name, GError** err)
+{
+    g_return_val_err_if_fail(name && handle, NULL, err, "must be non NULL value");
+    GError* tmp_err = NULL;
+    gfal_plugin_interface* resu = NULL;
+    int n = gfal_plugins_instance(handle, &tmp_err);
+    if (n >= 0) {
+        resu = gfal_plugin_with_name(handle, n, name);
+        // Maybe not loaded yet
+        if (resu == NULL && gfal_plugins_load(handle, NULL, name, &tmp_err) > 0)
+            resu = gfal_plugin_with_name(handle, g_atomic_int_get(&handle->plugin_opt.plugin_number), name);
+        if (resu == NULL && tmp_err == NULL)
+            g_set_error(&tmp_err, gfal2_get_plugins_quark(), ENOENT,
+                    " No plugin loaded with this name %s", name);
+    }
+
+    if (tmp_err)
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+    return resu;
+}
+
 
 int gfal2_register_plugin(gfal2_context_t handle, const gfal_plugin_interface* ifce,
         GError** error)
 {
+    int res;
+    pthread_mutex_lock(&handle->plugin_opt.lock);
     if (handle->plugin_opt.plugin_number >= MAX_PLUGIN_LIST) {
         gfal2_set_error(error, gfal2_get_plugins_quark(), ENOMEM,
                 __func__, "Not enough space to allocate a new plugin");
-        return -1;
+        res = -1;
+    }
+    else {
+        if (handle->plugin_opt.plugin_number < 0)
+            handle->plugin_opt.plugin_number = 0;
+        int i = handle->plugin_opt.plugin_number;
+        handle->plugin_opt.plugin_list[i] = *ifce;
+        handle->plugin_opt.registered[i] = TRUE;
+        g_atomic_int_inc(&handle->plugin_opt.plugin_number);
+        res = gfal_plugins_sort(handle, error);
     }
+    pthread_mutex_unlock(&handle->plugin_opt.lock);
+    return res;
+}
 
-    int i = handle->plugin_opt.plugin_number;
-    handle->plugin_opt.plugin_number++;
-    handle->plugin_opt.plugin_list[i] = *ifce;
 
-    return gfal_plugins_sort(handle, error);
+void gfal_plugins_copy_registered(gfal2_context_t dest, gfal2_context_t src)
+{
+    int i, n = 0;
+    pthread_mutex_lock(&src->plugin_opt.lock);
+    for (i = 0; i < src->plugin_opt.plugin_number; ++i) {
+        if (src->plugin_opt.registered[i]) {
+            dest->plugin_opt.plugin_list[n] = src->plugin_opt.plugin_list[i];
+            // plugin_data still belongs to the context it was registered with
+            dest->plugin_opt.plugin_list[n].plugin_delete = NULL;
+            dest->plugin_opt.registered[n] = TRUE;
+            ++n;
+        }
+    }
+    pthread_mutex_unlock(&src->plugin_opt.lock);
+    dest->plugin_opt.plugin_number = n;
 }
 
 
@@ -454,11 +1080,24 @@ int gfal_plugins_accessG(gfal2_context_t handle, const char* path, int mode,
     g_return_val_err_if_fail(handle && path, EINVAL, err, "[gfal_plugins_accessG] Invalid arguments");
     int res = -1;
     GError * tmp_err = NULL;
+    struct stat st;
+
+    // Only the existence can be told from the cache
+    int cached = gfal_metadata_cache_lookup(handle, path, FALSE, &st, &tmp_err);
+    if (cached < 0 || (cached > 0 && mode == F_OK)) {
+        G_RETURN_ERR(cached > 0 ? 0 : -1, tmp_err, err);
+    }
+
     gfal_plugin_interface* p = gfal_find_plugin(handle, path,
             GFAL_PLUGIN_ACCESS, &tmp_err);
 
-    if (p)
+    if (p) {
+        gint64 start = gfal_metrics_now();
         res = p->accessG(gfal_get_plugin_handle(p), path, mode, &tmp_err);
+        gfal_metrics_record(handle, p, GFAL_METRIC_ACCESS, start, res < 0, 0);
+        if (res < 0 && tmp_err)
+            gfal_metadata_cache_add(handle, path, FALSE, NULL, tmp_err);
+    }
 
     G_RETURN_ERR(res, tmp_err, err);
 }
@@ -467,14 +1106,31 @@ int gfal_plugins_accessG(gfal2_context_t handle, const char* path, int mode,
 int gfal_plugin_statG(gfal2_context_t handle, const char* path, struct stat* st, GError** err)
 {
     g_return_val_err_if_fail(handle && path, EINVAL, err, "[gfal_plugin_statG] Invalid arguments");
+    GError* tmp_err = NULL;
+
+    int cached = gfal_metadata_cache_lookup(handle, path, FALSE, st, &tmp_err);
+    if (cached != 0) {
+        G_RETURN_ERR(cached > 0 ? 0 : -1, tmp_err, err);
+    }
+    return gfal_plugin_stat_uncachedG(handle, path, st, err);
+}
+
+
+int gfal_plugin_stat_uncachedG(gfal2_context_t handle, const char* path, struct stat* st, GError** err)
+{
+    g_return_val_err_if_fail(handle && path, EINVAL, err, "[gfal_plugin_stat_uncachedG] Invalid arguments");
     int res = -1;
     GError* tmp_err = NULL;
 
     gfal_plugin_interface* p = gfal_find_plugin(handle, path, GFAL_PLUGIN_STAT,
             &tmp_err);
 
-    if (p)
+    if (p) {
+        gint64 start = gfal_metrics_now();
         res = p->statG(gfal_get_plugin_handle(p), path, st, &tmp_err);
+        gfal_metrics_record(handle, p, GFAL_METRIC_STAT, start, res < 0, 0);
+        gfal_metadata_cache_add(handle, path, FALSE, st, res < 0 ? tmp_err : NULL);
+    }
 
     G_RETURN_ERR(res, tmp_err, err);
 }
@@ -487,11 +1143,20 @@ int gfal_plugin_lstatG(gfal2_context_t handle, const char* path, struct stat* st
     int res = -1;
     GError* tmp_err = NULL;
 
+    int cached = gfal_metadata_cache_lookup(handle, path, TRUE, st, &tmp_err);
+    if (cached != 0) {
+        G_RETURN_ERR(cached > 0 ? 0 : -1, tmp_err, err);
+    }
+
     gfal_plugin_interface* p = gfal_find_plugin(handle, path, GFAL_PLUGIN_LSTAT,
             &tmp_err);
 
-    if (p)
+    if (p) {
+        gint64 start = gfal_metrics_now();
         res = p->lstatG(gfal_get_plugin_handle(p), path, st, &tmp_err);
+        gfal_metrics_record(handle, p, GFAL_METRIC_LSTAT, start, res < 0, 0);
+        gfal_metadata_cache_add(handle, path, TRUE, st, res < 0 ? tmp_err : NULL);
+    }
 
     G_RETURN_ERR(res, tmp_err, err);
 }
@@ -508,9 +1173,12 @@ ssize_t gfal_plugin_readlinkG(gfal2_context_t handle, const char* path, char* bu
     gfal_plugin_interface* p = gfal_find_plugin(handle, path,
             GFAL_PLUGIN_READLINK, &tmp_err);
 
-    if (p)
+    if (p) {
+        gint64 start = gfal_metrics_now();
         resu = p->readlinkG(gfal_get_plugin_handle(p), path, buff, buffsiz,
                 &tmp_err);
+        gfal_metrics_record(handle, p, GFAL_METRIC_READLINK, start, resu < 0, 0);
+    }
 
     G_RETURN_ERR(resu, tmp_err, err);
 }
@@ -526,8 +1194,12 @@ int gfal_plugin_chmodG(gfal2_context_t handle, const char* path, mode_t mode, GE
 
     gfal_plugin_interface* p = gfal_find_plugin(handle, path, GFAL_PLUGIN_CHMOD, &tmp_err);
 
-    if (p)
+    if (p) {
+        gint64 start = gfal_metrics_now();
         res = p->chmodG(gfal_get_plugin_handle(p), path, mode, &tmp_err);
+        gfal_metrics_record(handle, p, GFAL_METRIC_CHMOD, start, res < 0, 0);
+    }
+    gfal_metadata_cache_invalidate(handle, path, FALSE);
 
     G_RETURN_ERR(res, tmp_err, err);
 }
@@ -544,9 +1216,14 @@ int gfal_plugin_renameG(gfal2_context_t handle, const char* oldpath, const char*
     src_p = gfal_find_plugin(handle, oldpath, GFAL_PLUGIN_RENAME, &tmp_err);
     if (src_p) {
         dst_p = gfal_find_plugin(handle, newpath, GFAL_PLUGIN_RENAME, &tmp_err);
-        if (src_p == dst_p)
+        if (src_p == dst_p) {
+            gint64 start = gfal_metrics_now();
             res = dst_p->renameG(gfal_get_plugin_handle(dst_p), oldpath, newpath, &tmp_err);
+            gfal_metrics_record(handle, dst_p, GFAL_METRIC_RENAME, start, res < 0, 0);
+        }
     }
+    gfal_metadata_cache_invalidate(handle, oldpath, TRUE);
+    gfal_metadata_cache_invalidate(handle, newpath, TRUE);
 
     G_RETURN_ERR(res, tmp_err, err);
 }
@@ -562,9 +1239,13 @@ int gfal_plugin_symlinkG(gfal2_context_t handle, const char* oldpath, const char
     src_p = gfal_find_plugin(handle, oldpath, GFAL_PLUGIN_SYMLINK, &tmp_err);
     if (src_p) {
         dst_p = gfal_find_plugin(handle, newpath, GFAL_PLUGIN_SYMLINK, &tmp_err);
-        if (src_p == dst_p)
+        if (src_p == dst_p) {
+            gint64 start = gfal_metrics_now();
             res = dst_p->symlinkG(gfal_get_plugin_handle(dst_p), oldpath, newpath, &tmp_err);
+            gfal_metrics_record(handle, dst_p, GFAL_METRIC_SYMLINK, start, res < 0, 0);
+        }
     }
+    gfal_metadata_cache_invalidate(handle, newpath, FALSE);
 
     G_RETURN_ERR(res, tmp_err, err);
 }
@@ -578,8 +1259,16 @@ int gfal_plugin_mkdirp(gfal2_context_t handle, const char* path, mode_t mode, gb
 
     gfal_plugin_interface* p = gfal_find_plugin(handle, path, GFAL_PLUGIN_MKDIR, &tmp_err);
 
-    if (p)
+    if (p) {
+        gint64 start = gfal_metrics_now();
         res = p->mkdirpG(gfal_get_plugin_handle(p), path, mode, pflag, &tmp_err);
+        gfal_metrics_record(handle, p, GFAL_METRIC_MKDIR, start, res < 0, 0);
+    }
+    // with pflag, any missing parent may have been created as well
+    if (pflag)
+        gfal_metadata_cache_invalidate_parents(handle, path);
+    else
+        gfal_metadata_cache_invalidate(handle, path, FALSE);
 
     if (pflag && res < 0 && tmp_err->code == EEXIST) {
         g_error_free(tmp_err);
@@ -598,8 +1287,12 @@ int gfal_plugin_rmdirG(gfal2_context_t handle, const char* path, GError** err)
     int res = -1;
     gfal_plugin_interface* p = gfal_find_plugin(handle, path, GFAL_PLUGIN_RMDIR, &tmp_err);
 
-    if (p)
+    if (p) {
+        gint64 start = gfal_metrics_now();
         res = p->rmdirG(gfal_get_plugin_handle(p), path, &tmp_err);
+        gfal_metrics_record(handle, p, GFAL_METRIC_RMDIR, start, res < 0, 0);
+    }
+    gfal_metadata_cache_invalidate(handle, path, TRUE);
 
     G_RETURN_ERR(res, tmp_err, err);
 }
@@ -613,8 +1306,11 @@ gfal_file_handle gfal_plugin_opendirG(gfal2_context_t handle, const char* name,
 
     gfal_plugin_interface* p = gfal_find_plugin(handle, name, GFAL_PLUGIN_OPENDIR, &tmp_err);
 
-    if (p)
+    if (p) {
+        gint64 start = gfal_metrics_now();
         resu = p->opendirG(gfal_get_plugin_handle(p), name, &tmp_err);
+        gfal_metrics_record(handle, p, GFAL_METRIC_OPENDIR, start, resu == NULL, 0);
+    }
 
     G_RETURN_ERR(resu, tmp_err, err);
 }
@@ -626,8 +1322,11 @@ int gfal_plugin_closedirG(gfal2_context_t handle, gfal_file_handle fh, GError**
     GError* tmp_err = NULL;
     int res = -1;
     gfal_plugin_interface* if_cata = gfal_plugin_map_file_handle(handle, fh, &tmp_err);
-    if (!tmp_err)
+    if (!tmp_err) {
+        gint64 start = gfal_metrics_now();
         res = if_cata->closedirG(if_cata->plugin_data, fh, &tmp_err);
+        gfal_metrics_record(handle, if_cata, GFAL_METRIC_CLOSEDIR, start, res < 0, 0);
+    }
     G_RETURN_ERR(res, tmp_err, err);
 }
 
@@ -640,8 +1339,17 @@ gfal_file_handle gfal_plugin_openG(gfal2_context_t handle, const char * path, in
 
     gfal_plugin_interface* p = gfal_find_plugin(handle, path, GFAL_PLUGIN_OPEN, &tmp_err);
 
-    if (p)
+    if (p) {
+        gint64 start = gfal_metrics_now();
         resu = p->openG(gfal_get_plugin_handle(p), path, flag, mode, &tmp_err);
+        gfal_metrics_record(handle, p, GFAL_METRIC_OPEN, start, resu == NULL, 0);
+    }
+    if (flag & (O_WRONLY | O_RDWR | O_CREAT | O_TRUNC)) {
+        gfal_metadata_cache_invalidate(handle, path, FALSE);
+        // the size changes with the writes, so it is forgotten again on close
+        if (resu)
+            resu->written_url = g_strdup(path);
+    }
 
     G_RETURN_ERR(resu, tmp_err, err);
 }
@@ -655,9 +1363,20 @@ int gfal_plugin_closeG(gfal2_context_t handle, gfal_file_handle fh, GError** err
 
     gfal2_log(G_LOG_LEVEL_DEBUG, " <- %s", __func__);
 
+    // the plugin releases the handle on close
+    gchar* written_url = fh->written_url;
+    fh->written_url = NULL;
+
     gfal_plugin_interface* if_cata = gfal_plugin_map_file_handle(handle, fh, &tmp_err);
-    if (!tmp_err)
+    if (!tmp_err) {
+        gint64 start = gfal_metrics_now();
         res = if_cata->closeG(if_cata->plugin_data, fh, &tmp_err);
+        gfal_metrics_record(handle, if_cata, GFAL_METRIC_CLOSE, start, res < 0, 0);
+    }
+    if (written_url) {
+        gfal_metadata_cache_invalidate(handle, written_url, FALSE);
+        g_free(written_url);
+    }
 
     G_RETURN_ERR(res, tmp_err, err);
 }
@@ -669,8 +1388,11 @@ struct dirent* gfal_plugin_readdirG(gfal2_context_t handle, gfal_file_handle fh,
     GError* tmp_err = NULL;
     struct dirent* res = NULL;
     gfal_plugin_interface* if_cata = gfal_plugin_map_file_handle(handle, fh, &tmp_err);
-    if (!tmp_err)
+    if (!tmp_err) {
+        gint64 start = gfal_metrics_now();
         res = if_cata->readdirG(if_cata->plugin_data, fh, &tmp_err);
+        gfal_metrics_record(handle, if_cata, GFAL_METRIC_READDIR, start, tmp_err != NULL, 0);
+    }
 
     G_RETURN_ERR(res, tmp_err, err);
 }
@@ -686,8 +1408,13 @@ struct dirent* gfal_plugin_readdirppG(gfal2_context_t handle, gfal_file_handle f
 
     if (!tmp_err) {
         if (gfal_feature_is_supported(if_cata->readdirppG, g_quark_from_string(GFAL2_PLUGIN_SCOPE), __func__,
-            fh->path, &tmp_err))
+            fh->path, &tmp_err)) {
+            gint64 start = gfal_metrics_now();
             res = if_cata->readdirppG(if_cata->plugin_data, fh, st, &tmp_err);
+            gfal_metrics_record(handle, if_cata, GFAL_METRIC_READDIR, start, tmp_err != NULL, 0);
+        }
+        if (res && fh->path)
+            gfal_metadata_cache_add_entry(handle, fh->path, res->d_name, st);
     }
 
     G_RETURN_ERR(res, tmp_err, err);
@@ -701,8 +1428,11 @@ ssize_t gfal_plugin_getxattrG(gfal2_context_t handle, const char* path, const ch
 
     gfal_plugin_interface* p = gfal_find_plugin(handle, path, GFAL_PLUGIN_GETXATTR, &tmp_err);
 
-    if (p)
+    if (p) {
+        gint64 start = gfal_metrics_now();
         resu = p->getxattrG(gfal_get_plugin_handle(p), path, name, buff, s_buff, &tmp_err);
+        gfal_metrics_record(handle, p, GFAL_METRIC_GETXATTR, start, resu < 0, 0);
+    }
 
     // If asking for checksum, and got an error, try ourselves
     if (resu < 0 && tmp_err) {
@@ -730,8 +1460,11 @@ ssize_t gfal_plugin_listxattrG(gfal2_context_t handle, const char* path, char* l
 
     gfal_plugin_interface* p = gfal_find_plugin(handle, path, GFAL_PLUGIN_LISTXATTR, &tmp_err);
 
-    if (p)
+    if (p) {
+        gint64 start = gfal_metrics_now();
         resu = p->listxattrG(gfal_get_plugin_handle(p), path, list, s_list, &tmp_err);
+        gfal_metrics_record(handle, p, GFAL_METRIC_LISTXATTR, start, resu < 0, 0);
+    }
 
     G_RETURN_ERR(resu, tmp_err, err);
 }
@@ -744,8 +1477,12 @@ int gfal_plugin_setxattrG(gfal2_context_t handle, const char* path, const char*
 
     gfal_plugin_interface* p = gfal_find_plugin(handle, path, GFAL_PLUGIN_SETXATTR, &tmp_err);
 
-    if (p)
+    if (p) {
+        gint64 start = gfal_metrics_now();
         resu = p->setxattrG(gfal_get_plugin_handle(p), path, name, value, size, flags, &tmp_err);
+        gfal_metrics_record(handle, p, GFAL_METRIC_SETXATTR, start, resu < 0, 0);
+    }
+    gfal_metadata_cache_invalidate(handle, path, FALSE);
     G_RETURN_ERR(resu, tmp_err, err);
 }
 
@@ -756,8 +1493,11 @@ int gfal_plugin_readG(gfal2_context_t handle, gfal_file_handle fh, void* buff, s
     GError* tmp_err = NULL;
     int res = -1;
     gfal_plugin_interface* if_cata = gfal_plugin_map_file_handle(handle, fh, &tmp_err);
-    if (!tmp_err)
+    if (!tmp_err) {
+        gint64 start = gfal_metrics_now();
         res = if_cata->readG(if_cata->plugin_data, fh, buff, s_buff, &tmp_err);
+        gfal_metrics_record(handle, if_cata, GFAL_METRIC_READ, start, res < 0, res);
+    }
     G_RETURN_ERR(res, tmp_err, err);
 }
 
@@ -791,11 +1531,13 @@ ssize_t gfal_plugin_preadG(gfal2_context_t handle, gfal_file_handle fh, void* bu
     ssize_t res = -1;
     gfal_plugin_interface* if_cata = gfal_plugin_map_file_handle(handle, fh, &tmp_err);
     if (!tmp_err) {
+        gint64 start = gfal_metrics_now();
         if (if_cata->preadG)
             res = if_cata->preadG(if_cata->plugin_data, fh, buff, s_buff, offset, &tmp_err);
         else {
             res = gfal_plugin_simulate_preadG(handle, if_cata, fh, buff, s_buff, offset, &tmp_err);
         }
+        gfal_metrics_record(handle, if_cata, GFAL_METRIC_PREAD, start, res < 0, res);
     }
     G_RETURN_ERR(res, tmp_err, err);
 }
@@ -830,11 +1572,143 @@ ssize_t gfal_plugin_pwriteG(gfal2_context_t handle, gfal_file_handle fh, void* b
     ssize_t res = -1;
     gfal_plugin_interface* if_cata = gfal_plugin_map_file_handle(handle, fh, &tmp_err);
     if (!tmp_err) {
+        gint64 start = gfal_metrics_now();
         if (if_cata->pwriteG)
             res = if_cata->pwriteG(if_cata->plugin_data, fh, buff, s_buff, offset, &tmp_err);
         else {
             res = gfal_plugin_simulate_pwriteG(handle, if_cata, fh, buff, s_buff, offset, &tmp_err);
         }
+        gfal_metrics_record(handle, if_cata, GFAL_METRIC_PWRITE, start, res < 0, res);
+    }
+    G_RETURN_ERR(res, tmp_err, err);
+}
+
+// Ranges of a simulated preadv, shared by the workers
+typedef struct {
+    gfal2_context_t handle;
+    gfal_plugin_interface* if_cata;
+    gfal_file_handle fh;
+    const struct iovec* iov;
+    const off_t* offsets;
+    int count;
+    // bytes read for each range
+    ssize_t* results;
+
+    volatile gint next;
+    volatile gint failed;
+    pthread_mutex_t lock;
+    GError* error;
+} gfal_preadv_job_t;
+
+// Fill one range, the plugins may return less than requested before the end of file
+static ssize_t gfal_plugin_simulate_preadv_range(gfal_preadv_job_t* job, int i, GError** err)
+{
+    char* buff = (char*) job->iov[i].iov_base;
+    size_t done = 0;
+
+    while (done < job->iov[i].iov_len) {
+        ssize_t res;
+        if (job->if_cata->preadG)
+            res = job->if_cata->preadG(job->if_cata->plugin_data, job->fh, buff + done,
+                    job->iov[i].iov_len - done, job->offsets[i] + done, err);
+        else
+            res = gfal_plugin_simulate_preadG(job->handle, job->if_cata, job->fh, buff + done,
+                    job->iov[i].iov_len - done, job->offsets[i] + done, err);
+        if (res < 0)
+            return -1;
+        if (res == 0)
+            break;
+        done += res;
+    }
+    return done;
+}
+
+static void* gfal_plugin_simulate_preadv_worker(void* data)
+{
+    gfal_preadv_job_t* job = (gfal_preadv_job_t*) data;
+    GError* tmp_err = NULL;
+
+    while (!g_atomic_int_get(&job->failed)) {
+        int i = g_atomic_int_add(&job->next, 1);
+        if (i >= job->count)
+            break;
+        job->results[i] = gfal_plugin_simulate_preadv_range(job, i, &tmp_err);
+        if (job->results[i] < 0) {
+            g_atomic_int_set(&job->failed, 1);
+            pthread_mutex_lock(&job->lock);
+            if (job->error == NULL)
+                job->error = tmp_err;
+            else
+                g_error_free(tmp_err);
+            pthread_mutex_unlock(&job->lock);
+            tmp_err = NULL;
+        }
+    }
+    return NULL;
+}
+
+// Simulate a preadv with concurrent preads
+// The calling thread is one of the CORE:PREADV_THREADS workers
+static ssize_t gfal_plugin_simulate_preadvG(gfal2_context_t handle, gfal_plugin_interface* if_cata, gfal_file_handle fh,
+        const struct iovec* iov, const off_t* offsets, int count, GError** err)
+{
+    gfal_preadv_job_t job;
+    memset(&job, 0, sizeof(job));
+    job.handle = handle;
+    job.if_cata = if_cata;
+    job.fh = fh;
+    job.iov = iov;
+    job.offsets = offsets;
+    job.count = count;
+    job.results = g_new0(ssize_t, count);
+    pthread_mutex_init(&job.lock, NULL);
+
+    // Without preadG, the reads are serialized on the handle lock anyway
+    int n_threads = 1;
+    if (if_cata->preadG)
+        n_threads = MIN(gfal2_get_opt_integer_with_default(handle, CORE_CONFIG_GROUP, "PREADV_THREADS", 8), count);
+
+    pthread_t* threads = g_new0(pthread_t, MAX(n_threads, 1));
+    int started = 0;
+    for (started = 0; started < n_threads - 1; ++started) {
+        if (pthread_create(&threads[started], NULL, gfal_plugin_simulate_preadv_worker, &job) != 0)
+            break;
+    }
+    gfal_plugin_simulate_preadv_worker(&job);
+    int i;
+    for (i = 0; i < started; ++i)
+        pthread_join(threads[i], NULL);
+    g_free(threads);
+
+    ssize_t res = -1;
+    if (job.error == NULL) {
+        res = 0;
+        for (i = 0; i < count; ++i)
+            res += job.results[i];
+    }
+    g_free(job.results);
+    pthread_mutex_destroy(&job.lock);
+
+    G_RETURN_ERR(res, job.error, err);
+}
+
+// Execute a preadv function on the appropriate plugin
+ssize_t gfal_plugin_preadvG(gfal2_context_t handle, gfal_file_handle fh, const struct iovec* iov, const off_t* offsets,
+        int count, GError** err)
+{
+    g_return_val_err_if_fail(handle && fh, -1, err, "[gfal_plugin_preadvG] Invalid args ");
+    GError* tmp_err = NULL;
+    ssize_t res = -1;
+    if (count == 0)
+        return 0;
+    gfal_plugin_interface* if_cata = gfal_plugin_map_file_handle(handle, fh, &tmp_err);
+    if (!tmp_err) {
+        gint64 start = gfal_metrics_now();
+        if (if_cata->preadvG)
+            res = if_cata->preadvG(if_cata->plugin_data, fh, iov, offsets, count, &tmp_err);
+        else
+            res = gfal_plugin_simulate_preadvG(handle, if_cata, fh, iov, offsets, count, &tmp_err);
+        gfal_metrics_record(handle, if_cata, GFAL_METRIC_PREADV, start, res < 0, res);
     }
     G_RETURN_ERR(res, tmp_err, err);
 }
@@ -859,8 +1733,11 @@ int gfal_plugin_writeG(gfal2_context_t handle, gfal_file_handle fh, void* buff,
     GError* tmp_err = NULL;
     int res = -1;
     gfal_plugin_interface* if_cata = gfal_plugin_map_file_handle(handle, fh, &tmp_err);
-    if (!tmp_err)
+    if (!tmp_err) {
+        gint64 start = gfal_metrics_now();
         res = if_cata->writeG(if_cata->plugin_data, fh, buff, s_buff, &tmp_err);
+        gfal_metrics_record(handle, if_cata, GFAL_METRIC_WRITE, start, res < 0, res);
+    }
     G_RETURN_ERR(res, tmp_err, err);
 }
 
@@ -871,8 +1748,12 @@ int gfal_plugin_unlinkG(gfal2_context_t handle, const char* path, GError** err)
     int resu = -1;
     gfal_plugin_interface* p = gfal_find_plugin(handle, path, GFAL_PLUGIN_UNLINK, &tmp_err);
 
-    if (p)
+    if (p) {
+        gint64 start = gfal_metrics_now();
         resu = p->unlinkG(gfal_get_plugin_handle(p), path, &tmp_err);
+        gfal_metrics_record(handle, p, GFAL_METRIC_UNLINK, start, resu < 0, 0);
+    }
+    gfal_metadata_cache_invalidate(handle, path, FALSE);
     G_RETURN_ERR(resu, tmp_err, err);
 
 }
@@ -885,9 +1766,12 @@ int gfal_plugin_bring_onlineG(gfal2_context_t handle, const char* uri, time_t pi
     int resu = -1;
     gfal_plugin_interface* p = gfal_find_plugin(handle, uri, GFAL_PLUGIN_BRING_ONLINE, &tmp_err);
 
-    if (p)
+    if (p) {
+        gint64 start = gfal_metrics_now();
         resu = p->bring_online(gfal_get_plugin_handle(p), uri, pintime, timeout, token, tsize,
                 async, &tmp_err);
+        gfal_metrics_record(handle, p, GFAL_METRIC_BRING_ONLINE, start, resu < 0, 0);
+    }
     G_RETURN_ERR(resu, tmp_err, err);
 }
 
@@ -899,9 +1783,12 @@ int gfal_plugin_bring_online_v2G(gfal2_context_t handle, const char* uri, const
     int resu = -1;
     gfal_plugin_interface* p = gfal_find_plugin(handle, uri, GFAL_PLUGIN_BRING_ONLINE, &tmp_err);
 
-    if (p)
+    if (p) {
+        gint64 start = gfal_metrics_now();
         resu = p->bring_online_v2(gfal_get_plugin_handle(p), uri, metadata, pintime, timeout, token, tsize,
                 async, &tmp_err);
+        gfal_metrics_record(handle, p, GFAL_METRIC_BRING_ONLINE, start, resu < 0, 0);
+    }
     G_RETURN_ERR(resu, tmp_err, err);
 }
 
@@ -1098,18 +1985,122 @@ int gfal_plugin_unlink_listG(gfal2_context_t handle, int nbfiles, const char* co
     gfal_plugin_interface* p = gfal_find_plugin(handle, *uris, GFAL_PLUGIN_UNLINK, &tmp_err);
 
     if (p) {
-        plugin_handle handle = gfal_get_plugin_handle(p);
+        plugin_handle plugin_data = gfal_get_plugin_handle(p);
+        gint64 start = gfal_metrics_now();
         if (p->unlink_listG) {
-            resu = p->unlink_listG(handle, nbfiles, uris, errors);
+            resu = p->unlink_listG(plugin_data, nbfiles, uris, errors);
         }
         // Fallback
         else {
             int i;
             resu = 0;
             for (i = 0; i < nbfiles; ++i) {
-                resu += p->unlinkG(handle, uris[i], &(errors[i]));
+                resu += p->unlinkG(plugin_data, uris[i], &(errors[i]));
             }
         }
+        gfal_metrics_record(handle, p, GFAL_METRIC_UNLINK_LIST, start, resu < 0, 0);
+
+        int i;
+        for (i = 0; i < nbfiles; ++i) {
+            gfal_metadata_cache_invalidate(handle, uris[i], FALSE);
+        }
+    }
+    else {
+        int i;
+        for (i = 0; i < nbfiles; ++i) {
+            errors[i] = g_error_copy(tmp_err);
+        }
+        g_error_free(tmp_err);
+    }
+
+    return resu;
+}
+
+
+// Files of a simulated stat_list, shared by the workers
+typedef struct {
+    gfal2_context_t handle;
+    int nbfiles;
+    const char* const* uris;
+    struct stat* buffs;
+    GError** errors;
+
+    volatile gint next;
+    volatile gint failed;
+} gfal_stat_list_job_t;
+
+static void* gfal_plugin_simulate_stat_list_worker(void* data)
+{
+    gfal_stat_list_job_t* job = (gfal_stat_list_job_t*) data;
+
+    while (!gfal2_is_canceled(job->handle)) {
+        int i = g_atomic_int_add(&job->next, 1);
+        if (i >= job->nbfiles)
+            break;
+        if (gfal_plugin_statG(job->handle, job->uris[i], &job->buffs[i], &job->errors[i]) < 0)
+            g_atomic_int_set(&job->failed, 1);
+    }
+    return NULL;
+}
+
+// Simulate a stat_list with concurrent stats
+// The calling thread is one of the CORE:STAT_LIST_THREADS workers
+static int gfal_plugin_simulate_stat_listG(gfal2_context_t handle, int nbfiles, const char* const* uris,
+        struct stat* buffs, GError** errors)
+{
+    gfal_stat_list_job_t job;
+    memset(&job, 0, sizeof(job));
+    job.handle = handle;
+    job.nbfiles = nbfiles;
+    job.uris = uris;
+    job.buffs = buffs;
+    job.errors = errors;
+
+    int n_threads = MIN(gfal2_get_opt_integer_with_default(handle, CORE_CONFIG_GROUP, "STAT_LIST_THREADS", 8), nbfiles);
+
+    pthread_t* threads = g_new0(pthread_t, MAX(n_threads, 1));
+    int started = 0;
+    for (started = 0; started < n_threads - 1; ++started) {
+        if (pthread_create(&threads[started], NULL, gfal_plugin_simulate_stat_list_worker, &job) != 0)
+            break;
+    }
+    gfal_plugin_simulate_stat_list_worker(&job);
+    int i;
+    for (i = 0; i < started; ++i)
+        pthread_join(threads[i], NULL);
+    g_free(threads);
+
+    // Files never started because of a cancellation
+    for (i = job.next; i < nbfiles; ++i) {
+        gfal2_set_error(&errors[i], gfal_cancel_quark(), ECANCELED, __func__, "Operation canceled");
+        job.failed = 1;
+    }
+    return job.failed ? -1 : 0;
+}
+
+
+int gfal_plugin_stat_listG(gfal2_context_t handle, int nbfiles, const char* const* uris, struct stat* buffs, GError ** errors)
+{
+    GError* tmp_err = NULL;
+    int resu = -1;
+    gfal_plugin_interface* p = gfal_find_plugin(handle, *uris, GFAL_PLUGIN_STAT, &tmp_err);
+
+    if (p) {
+        if (p->stat_listG) {
+            gint64 start = gfal_metrics_now();
+            resu = p->stat_listG(gfal_get_plugin_handle(p), nbfiles, uris, buffs, errors);
+            gfal_metrics_record(handle, p, GFAL_METRIC_STAT_LIST, start, resu < 0, 0);
+            // On a failure, the entries without an error may not have been filled
+            int i;
+            for (i = 0; i < nbfiles; ++i) {
+                if (errors[i] ? errors[i]->code == ENOENT : resu == 0)
+                    gfal_metadata_cache_add(handle, uris[i], FALSE, &buffs[i], errors[i]);
+            }
+        }
+        // Fallback, each url goes to its own plugin
+        else {
+            resu = gfal_plugin_simulate_stat_listG(handle, nbfiles, uris, buffs, errors);
+        }
     }
     else {
         int i;
@@ -81,6 +81,11 @@ gfal_plugin_interface* gfal_find_plugin(gfal2_context_t handle,
 
 gfal_plugin_interface* gfal_plugin_map_file_handle(gfal2_context_t handle, gfal_file_handle fh, GError** err);
 
+/**
+ * Same as gfal_plugin_statG, but always asks the plugin. The metadata cache gets the result
+ */
+int gfal_plugin_stat_uncachedG(gfal2_context_t handle, const char* path, struct stat* st, GError** err);
+
 #ifdef __cplusplus
 }
 #endif // __cplusplus
@@ -34,6 +34,7 @@
 #include <glib.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 
 #ifdef __cplusplus
 extern "C"
@@ -742,9 +743,46 @@ struct _gfal_plugin_interface {
                             gboolean write_access, unsigned validity, const char* const* activities,
                             char* buff, size_t s_buff, GError** err);
 
+    // DISPATCH
+
+  /**
+   * OPTIONAL: NULL terminated list of the URL schemes handled by this plugin ( ex : {"root", "xroot", NULL} )
+   *
+   * When set, the core indexes the plugin by scheme and only calls check_plugin_url for URLs
+   * using one of these schemes. Plugins without this list are checked for every URL.
+   * The list must stay valid for the whole lifetime of the plugin.
+   */
+  const char* const* url_schemes;
+
+    // VECTOR IO
+
+  /**
+   * OPTIONAL: read count ranges of iov[i].iov_len bytes at offsets[i] in one go
+   *
+   * Each range is filled completely unless it goes past the end of the file.
+   * If not implemented, the ranges are read concurrently with preadG by GFAL 2.0
+   *
+   * @return total number of bytes read, -1 on failure
+   */
+  ssize_t (*preadvG)(plugin_handle plugin_data, gfal_file_handle fd, const struct iovec* iov,
+                     const off_t* offsets, int count, GError** err);
+
+    // BULK NAMESPACE
+
+  /**
+   * OPTIONAL: stat a list of files in one go
+   *
+   * buffs[i] is filled, or errors[i] set, for each urls[i]. The plugin is the one handling urls[0].
+   * If not implemented, the files are checked concurrently with statG by GFAL 2.0
+   *
+   * @return 0 if all the files could be checked, -1 otherwise
+   */
+  int (*stat_listG)(plugin_handle plugin_data, int nbfiles, const char* const* urls,
+                    struct stat* buffs, GError** errors);
+
       // reserved for future usage
 	 //! @cond
-     void* future[4];
+     void* future[1];
 	 //! @endcond
 };
 
@@ -755,6 +793,17 @@ struct _gfal_plugin_interface {
 int gfal2_register_plugin(gfal2_context_t handle, const gfal_plugin_interface* ifce,
         GError** error);
 
+/**
+ * Helper for plugins implementing checksum_calcG on top of preadG
+ * Reads the file with gfal2_pread and computes ADLER32, CRC32, CRC32C or MD5.
+ * If CORE:CHECKSUM_THREADS is greater than 1, the file is split in ranges read in parallel,
+ * except for MD5, which can not be combined and is always computed in a single pass.
+ * The arguments have the same meaning as for gfal2_checksum.
+ */
+int gfal2_checksum_compute(gfal2_context_t context, const char* url, const char* check_type,
+        off_t start_offset, size_t data_length,
+        char* checksum_buffer, size_t buffer_length, GError** err);
+
 
 // internal API for inter plugin communication
 //! @cond
@@ -785,6 +834,7 @@ int gfal_plugin_readG(gfal2_context_t handle, gfal_file_handle fh, void* buff, s
 
 ssize_t gfal_plugin_preadG(gfal2_context_t handle, gfal_file_handle fh, void* buff, size_t s_buff, off_t offset, GError** err);
 ssize_t gfal_plugin_pwriteG(gfal2_context_t handle, gfal_file_handle fh, void* buff, size_t s_buff, off_t offset, GError** err);
+ssize_t gfal_plugin_preadvG(gfal2_context_t handle, gfal_file_handle fh, const struct iovec* iov, const off_t* offsets, int count, GError** err);
 
 
 int gfal_plugin_unlinkG(gfal2_context_t handle, const char* path, GError** err);
@@ -834,6 +884,8 @@ int gfal_plugin_release_file_listG(gfal2_context_t handle, int nbfiles, const ch
 
 int gfal_plugin_unlink_listG(gfal2_context_t handle, int nbfiles, const char* const* uris, GError ** errors);
 
+int gfal_plugin_stat_listG(gfal2_context_t handle, int nbfiles, const char* const* uris, struct stat* buffs, GError ** errors);
+
 int gfal_plugin_abort_filesG(gfal2_context_t handle, int nbfiles, const char* const* uris, const char* token, GError ** err);
 
 ssize_t gfal_plugin_qos_check_classes(gfal2_context_t handle, const char* url, const char* type,
@@ -0,0 +1,554 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+#include <gfal_plugins_api.h>
+#include <file/gfal_async_api.h>
+#include <common/gfal_handle.h>
+#include <common/gfal_error.h>
+#include <common/gfal_file_handler_container.h>
+#include <common/gfal_plugin.h>
+
+
+// Asynchronous operations
+// Each plugin has a lane with its queue of pending requests and its number of running ones.
+// Lanes with pending requests and free slots are in the ready queue, served round-robin by the workers.
+
+
+typedef enum {
+    GFAL_ASYNC_STAT,
+    GFAL_ASYNC_OPEN,
+    GFAL_ASYNC_PREAD,
+    GFAL_ASYNC_CHECKSUM
+} gfal_async_op_t;
+
+typedef enum {
+    GFAL_REQUEST_PENDING,
+    GFAL_REQUEST_RUNNING,
+    GFAL_REQUEST_DONE
+} gfal_request_state_t;
+
+typedef struct gfal_async_lane_s gfal_async_lane_t;
+
+struct gfal2_request_s {
+    gfal2_context_t context;
+    gfal_async_op_t op;
+
+    char* url;
+    struct stat* st;
+    int flag;
+    int fd;
+    void* buffer;
+    size_t count;
+    off_t offset;
+    char* check_type;
+    size_t buffer_length;
+
+    gfal2_request_cb callback;
+    void* user_data;
+
+    // Protected by the executor lock while pending
+    gfal_async_lane_t* lane;
+    GList* link;
+
+    // Protected by lock
+    pthread_mutex_t lock;
+    pthread_cond_t done;
+    gfal_request_state_t state;
+    ssize_t result;
+    GError* error;
+
+    // One reference for the caller, one for the executor
+    volatile gint refcount;
+};
+
+struct gfal_async_lane_s {
+    char* name;
+    GQueue pending;
+    int running;
+    gboolean ready;
+};
+
+struct gfal_async_executor_s {
+    gfal2_context_t context;
+    pthread_mutex_t lock;
+    pthread_cond_t wakeup;
+
+    // plugin name => lane
+    GHashTable* lanes;
+    GQueue ready;
+    // canceled requests, completed by the workers
+    GQueue canceled;
+    int max_per_plugin;
+    gboolean shutdown;
+
+    int n_threads;
+    pthread_t* threads;
+    gfal_cancel_token_t cancel_token;
+};
+
+// Protects the lazy creation of the executors
+static pthread_mutex_t gfal_async_init_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+static void gfal_async_request_unref(gfal2_request_t request)
+{
+    if (!g_atomic_int_dec_and_test(&request->refcount)) {
+        return;
+    }
+    pthread_mutex_destroy(&request->lock);
+    pthread_cond_destroy(&request->done);
+    if (request->error) {
+        g_error_free(request->error);
+    }
+    g_free(request->url);
+    g_free(request->check_type);
+    g_free(request);
+}
+
+
+static void gfal_async_request_complete(gfal2_request_t request, ssize_t result, GError* error)
+{
+    pthread_mutex_lock(&request->lock);
+    request->result = result;
+    request->error = error;
+    request->state = GFAL_REQUEST_DONE;
+    pthread_cond_broadcast(&request->done);
+    pthread_mutex_unlock(&request->lock);
+
+    if (request->callback) {
+        request->callback(request, request->user_data);
+    }
+    gfal_async_request_unref(request);
+}
+
+
+static void gfal_async_request_cancel_complete(gfal2_request_t request)
+{
+    GError* error = NULL;
+    g_set_error(&error, gfal_cancel_quark(), ECANCELED, "[%s] operation canceled", __func__);
+    gfal_async_request_complete(request, -1, error);
+}
+
+
+static ssize_t gfal_async_request_run(gfal2_request_t request, GError** err)
+{
+    switch (request->op) {
+        case GFAL_ASYNC_STAT:
+            return gfal2_stat(request->context, request->url, request->st, err);
+        case GFAL_ASYNC_OPEN:
+            return gfal2_open(request->context, request->url, request->flag, err);
+        case GFAL_ASYNC_PREAD:
+            return gfal2_pread(request->context, request->fd, request->buffer, request->count,
+                    request->offset, err);
+        case GFAL_ASYNC_CHECKSUM:
+            return gfal2_checksum(request->context, request->url, request->check_type,
+                    request->offset, request->count, request->buffer, request->buffer_length, err);
+    }
+    return -1;
+}
+
+
+// Must be called with the executor lock held
+static void gfal_async_lane_update(struct gfal_async_executor_s* executor, gfal_async_lane_t* lane)
+{
+    if (!lane->ready && !g_queue_is_empty(&lane->pending) && lane->running < executor->max_per_plugin) {
+        lane->ready = TRUE;
+        g_queue_push_tail(&executor->ready, lane);
+        pthread_cond_signal(&executor->wakeup);
+    }
+}
+
+
+// Must be called with the executor lock held
+static void gfal_async_cancel_pending(struct gfal_async_executor_s* executor)
+{
+    GHashTableIter iter;
+    gpointer key, value;
+
+    g_hash_table_iter_init(&iter, executor->lanes);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        gfal_async_lane_t* lane = (gfal_async_lane_t*) value;
+        gfal2_request_t request;
+        while ((request = g_queue_pop_head(&lane->pending)) != NULL) {
+            request->link = NULL;
+            g_queue_push_tail(&executor->canceled, request);
+        }
+    }
+    pthread_cond_broadcast(&executor->wakeup);
+}
+
+
+static void* gfal_async_worker(void* data)
+{
+    struct gfal_async_executor_s* executor = (struct gfal_async_executor_s*) data;
+
+    pthread_mutex_lock(&executor->lock);
+    while (TRUE) {
+        gfal2_request_t request = g_queue_pop_head(&executor->canceled);
+        if (request) {
+            pthread_mutex_unlock(&executor->lock);
+            gfal_async_request_cancel_complete(request);
+            pthread_mutex_lock(&executor->lock);
+            continue;
+        }
+
+        gfal_async_lane_t* lane = g_queue_pop_head(&executor->ready);
+        if (lane == NULL) {
+            if (executor->shutdown) {
+                break;
+            }
+            pthread_cond_wait(&executor->wakeup, &executor->lock);
+            continue;
+        }
+
+        lane->ready = FALSE;
+        request = g_queue_pop_head(&lane->pending);
+        if (request == NULL) {
+            // Its pending requests were canceled
+            continue;
+        }
+        request->link = NULL;
+        lane->running++;
+        gfal_async_lane_update(executor, lane);
+
+        pthread_mutex_lock(&request->lock);
+        request->state = GFAL_REQUEST_RUNNING;
+        pthread_mutex_unlock(&request->lock);
+        pthread_mutex_unlock(&executor->lock);
+
+        GError* error = NULL;
+        ssize_t result = gfal_async_request_run(request, &error);
+        gfal_async_request_complete(request, result, error);
+
+        pthread_mutex_lock(&executor->lock);
+        lane->running--;
+        gfal_async_lane_update(executor, lane);
+    }
+    pthread_mutex_unlock(&executor->lock);
+    return NULL;
+}
+
+
+static void gfal_async_cancel_hook(gfal2_context_t context, void* userdata)
+{
+    struct gfal_async_executor_s* executor = (struct gfal_async_executor_s*) userdata;
+    pthread_mutex_lock(&executor->lock);
+    gfal_async_cancel_pending(executor);
+    pthread_mutex_unlock(&executor->lock);
+}
+
+
+static void gfal_async_lane_free(gpointer data)
+{
+    gfal_async_lane_t* lane = (gfal_async_lane_t*) data;
+    g_free(lane->name);
+    g_free(lane);
+}
+
+
+static struct gfal_async_executor_s* gfal_async_executor_new(gfal2_context_t context, GError** err)
+{
+    struct gfal_async_executor_s* executor = g_new0(struct gfal_async_executor_s, 1);
+    executor->context = context;
+    pthread_mutex_init(&executor->lock, NULL);
+    pthread_cond_init(&executor->wakeup, NULL);
+    executor->lanes = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, gfal_async_lane_free);
+    g_queue_init(&executor->ready);
+    g_queue_init(&executor->canceled);
+
+    executor->n_threads = gfal2_get_opt_integer_with_default(context, CORE_CONFIG_GROUP, "ASYNC_THREADS", 32);
+    executor->max_per_plugin = gfal2_get_opt_integer_with_default(context, CORE_CONFIG_GROUP,
+            "ASYNC_MAX_PER_PLUGIN", 16);
+    if (executor->n_threads < 1) {
+        executor->n_threads = 1;
+    }
+    if (executor->max_per_plugin < 1) {
+        executor->max_per_plugin = executor->n_threads;
+    }
+
+    executor->threads = g_new0(pthread_t, executor->n_threads);
+    int i;
+    for (i = 0; i < executor->n_threads; ++i) {
+        int ret = pthread_create(&executor->threads[i], NULL, gfal_async_worker, executor);
+        if (ret != 0) {
+            if (i == 0) {
+                gfal2_set_error(err, gfal2_get_core_quark(), ret, __func__,
+                        "Could not start the asynchronous workers: %s", strerror(ret));
+                g_free(executor->threads);
+                g_hash_table_destroy(executor->lanes);
+                pthread_cond_destroy(&executor->wakeup);
+                pthread_mutex_destroy(&executor->lock);
+                g_free(executor);
+                return NULL;
+            }
+            gfal2_log(G_LOG_LEVEL_WARNING, "Only %d asynchronous workers could be started", i);
+            executor->n_threads = i;
+            break;
+        }
+    }
+
+    executor->cancel_token = gfal2_register_cancel_callback(context, gfal_async_cancel_hook, executor);
+    return executor;
+}
+
+
+void gfal_async_executor_free(struct gfal_async_executor_s* executor)
+{
+    if (executor == NULL) {
+        return;
+    }
+    gfal2_remove_cancel_callback(executor->context, executor->cancel_token);
+
+    pthread_mutex_lock(&executor->lock);
+    executor->shutdown = TRUE;
+    gfal_async_cancel_pending(executor);
+    pthread_mutex_unlock(&executor->lock);
+
+    int i;
+    for (i = 0; i < executor->n_threads; ++i) {
+        pthread_join(executor->threads[i], NULL);
+    }
+    g_free(executor->threads);
+    g_hash_table_destroy(executor->lanes);
+    pthread_cond_destroy(&executor->wakeup);
+    pthread_mutex_destroy(&executor->lock);
+    g_free(executor);
+}
+
+
+static struct gfal_async_executor_s* gfal_async_get_executor(gfal2_context_t context, GError** err)
+{
+    struct gfal_async_executor_s* executor = g_atomic_pointer_get(&context->async);
+    if (executor) {
+        return executor;
+    }
+    pthread_mutex_lock(&gfal_async_init_lock);
+    executor = context->async;
+    if (executor == NULL) {
+        executor = gfal_async_executor_new(context, err);
+        g_atomic_pointer_set(&context->async, executor);
+    }
+    pthread_mutex_unlock(&gfal_async_init_lock);
+    return executor;
+}
+
+
+static gfal2_request_t gfal_async_request_new(gfal2_context_t context, gfal_async_op_t op,
+        gfal2_request_cb callback, void* user_data)
+{
+    gfal2_request_t request = g_new0(struct gfal2_request_s, 1);
+    request->context = context;
+    request->op = op;
+    request->callback = callback;
+    request->user_data = user_data;
+    request->state = GFAL_REQUEST_PENDING;
+    request->refcount = 2;
+    pthread_mutex_init(&request->lock, NULL);
+    pthread_cond_init(&request->done, NULL);
+    return request;
+}
+
+
+// Queue the request in the lane of the plugin
+// On failure the request is freed
+static gfal2_request_t gfal_async_submit(gfal2_request_t request, const char* plugin_name, GError** err)
+{
+    GError* tmp_err = NULL;
+    struct gfal_async_executor_s* executor = gfal_async_get_executor(request->context, &tmp_err);
+    if (executor == NULL) {
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        g_atomic_int_set(&request->refcount, 1);
+        gfal_async_request_unref(request);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&executor->lock);
+    gfal_async_lane_t* lane = g_hash_table_lookup(executor->lanes, plugin_name);
+    if (lane == NULL) {
+        lane = g_new0(gfal_async_lane_t, 1);
+        lane->name = g_strdup(plugin_name);
+        g_queue_init(&lane->pending);
+        g_hash_table_insert(executor->lanes, lane->name, lane);
+    }
+    request->lane = lane;
+    g_queue_push_tail(&lane->pending, request);
+    request->link = g_queue_peek_tail_link(&lane->pending);
+    gfal_async_lane_update(executor, lane);
+    pthread_mutex_unlock(&executor->lock);
+
+    return request;
+}
+
+
+// Lane of the plugin handling the url
+static gfal2_request_t gfal_async_submit_url(gfal2_request_t request, plugin_mode mode, GError** err)
+{
+    GError* tmp_err = NULL;
+    gfal_plugin_interface* plugin = gfal_find_plugin(request->context, request->url, mode, &tmp_err);
+    if (plugin == NULL) {
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        g_atomic_int_set(&request->refcount, 1);
+        gfal_async_request_unref(request);
+        return NULL;
+    }
+    return gfal_async_submit(request, plugin->getName(), err);
+}
+
+
+gfal2_request_t gfal2_stat_async(gfal2_context_t context, const char* url, struct stat* buff,
+        gfal2_request_cb callback, void* user_data, GError** err)
+{
+    g_return_val_err_if_fail(context && url && buff, NULL, err, "[gfal2_stat_async] Invalid arguments");
+    gfal2_request_t request = gfal_async_request_new(context, GFAL_ASYNC_STAT, callback, user_data);
+    request->url = g_strdup(url);
+    request->st = buff;
+    return gfal_async_submit_url(request, GFAL_PLUGIN_STAT, err);
+}
+
+
+gfal2_request_t gfal2_open_async(gfal2_context_t context, const char* url, int flag,
+        gfal2_request_cb callback, void* user_data, GError** err)
+{
+    g_return_val_err_if_fail(context && url, NULL, err, "[gfal2_open_async] Invalid arguments");
+    gfal2_request_t request = gfal_async_request_new(context, GFAL_ASYNC_OPEN, callback, user_data);
+    request->url = g_strdup(url);
+    request->flag = flag;
+    return gfal_async_submit_url(request, GFAL_PLUGIN_OPEN, err);
+}
+
+
+gfal2_request_t gfal2_pread_async(gfal2_context_t context, int fd, void* buffer, size_t count, off_t offset,
+        gfal2_request_cb callback, void* user_data, GError** err)
+{
+    g_return_val_err_if_fail(context && buffer, NULL, err, "[gfal2_pread_async] Invalid arguments");
+    GError* tmp_err = NULL;
+    gfal_file_handle fh = gfal_file_handle_bind(context->fdescs, fd, &tmp_err);
+    if (fh == NULL) {
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        return NULL;
+    }
+
+    gfal2_request_t request = gfal_async_request_new(context, GFAL_ASYNC_PREAD, callback, user_data);
+    request->fd = fd;
+    request->buffer = buffer;
+    request->count = count;
+    request->offset = offset;
+    return gfal_async_submit(request, fh->module_name, err);
+}
+
+
+gfal2_request_t gfal2_checksum_async(gfal2_context_t context, const char* url, const char* check_type,
+        off_t start_offset, size_t data_length, char* checksum_buffer, size_t buffer_length,
+        gfal2_request_cb callback, void* user_data, GError** err)
+{
+    g_return_val_err_if_fail(context && url && check_type && checksum_buffer, NULL, err,
+            "[gfal2_checksum_async] Invalid arguments");
+    gfal2_request_t request = gfal_async_request_new(context, GFAL_ASYNC_CHECKSUM, callback, user_data);
+    request->url = g_strdup(url);
+    request->check_type = g_strdup(check_type);
+    request->offset = start_offset;
+    request->count = data_length;
+    request->buffer = checksum_buffer;
+    request->buffer_length = buffer_length;
+    return gfal_async_submit_url(request, GFAL_PLUGIN_CHECKSUM, err);
+}
+
+
+gboolean gfal2_request_is_done(gfal2_request_t request)
+{
+    pthread_mutex_lock(&request->lock);
+    gboolean done = (request->state == GFAL_REQUEST_DONE);
+    pthread_mutex_unlock(&request->lock);
+    return done;
+}
+
+
+ssize_t gfal2_request_wait(gfal2_request_t request, int timeout_ms, GError** err)
+{
+    if (request == NULL) {
+        gfal2_set_error(err, gfal2_get_core_quark(), EFAULT, __func__, "request is NULL");
+        return -1;
+    }
+
+    struct timespec deadline;
+    if (timeout_ms >= 0) {
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec += 1;
+            deadline.tv_nsec -= 1000000000L;
+        }
+    }
+
+    pthread_mutex_lock(&request->lock);
+    while (request->state != GFAL_REQUEST_DONE) {
+        if (timeout_ms < 0) {
+            pthread_cond_wait(&request->done, &request->lock);
+        }
+        else if (pthread_cond_timedwait(&request->done, &request->lock, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+
+    ssize_t result = -1;
+    if (request->state != GFAL_REQUEST_DONE) {
+        gfal2_set_error(err, gfal2_get_core_quark(), ETIMEDOUT, __func__,
+                "The request did not complete in %d ms", timeout_ms);
+    }
+    else {
+        result = request->result;
+        if (request->error) {
+            g_propagate_error(err, g_error_copy(request->error));
+        }
+    }
+    pthread_mutex_unlock(&request->lock);
+    return result;
+}
+
+
+int gfal2_request_cancel(gfal2_request_t request)
+{
+    if (request == NULL) {
+        return -1;
+    }
+    struct gfal_async_executor_s* executor = g_atomic_pointer_get(&request->context->async);
+    int ret = -1;
+
+    pthread_mutex_lock(&executor->lock);
+    if (request->link) {
+        g_queue_delete_link(&request->lane->pending, request->link);
+        request->link = NULL;
+        g_queue_push_tail(&executor->canceled, request);
+        pthread_cond_signal(&executor->wakeup);
+        ret = 0;
+    }
+    pthread_mutex_unlock(&executor->lock);
+    return ret;
+}
+
+
+void gfal2_request_free(gfal2_request_t request)
+{
+    if (request) {
+        gfal_async_request_unref(request);
+    }
+}
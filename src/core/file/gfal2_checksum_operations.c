@@ -0,0 +1,281 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <gfal_plugins_api.h>
+#include <common/gfal_error.h>
+#include <common/gfal_plugin.h>
+#include <checksums/checksums.h>
+
+
+// Checksum computed by reading the file with gfal2_pread
+// The file is split in ranges checksummed by CORE:CHECKSUM_THREADS workers, and the partial
+// results are combined in order. Algorithms that can not be combined (MD5) are computed in one pass.
+
+#define CHECKSUM_CHUNK_SIZE (2 << 20)
+#define CHECKSUM_RANGE_SIZE (64 << 20)
+
+
+typedef struct {
+    gfal2_context_t context;
+    const char *url;
+    unsigned algorithm;
+    off_t start_offset;
+    size_t length;
+    size_t range_size;
+    guint n_ranges;
+    // per range states, in file order
+    gfal2_checksum_ctx **states;
+
+    volatile gint next_range;
+    volatile gint failed;
+} checksum_job_t;
+
+
+typedef struct {
+    checksum_job_t *job;
+    pthread_t thread;
+    GError *error;
+} checksum_worker_t;
+
+
+// Read [offset, offset + size) into ctx, or until the end of file if size is 0
+// Returns the number of bytes read, or -1 on error
+static ssize_t checksum_range(gfal2_context_t context, int fd, gfal2_checksum_ctx *ctx,
+    char *buffer, off_t offset, size_t size, volatile gint *stop, GError **err)
+{
+    size_t total = 0;
+
+    while (size == 0 || total < size) {
+        if (stop && g_atomic_int_get(stop)) {
+            return total;
+        }
+        size_t to_read = CHECKSUM_CHUNK_SIZE;
+        if (size > 0 && size - total < to_read) {
+            to_read = size - total;
+        }
+        ssize_t ret = gfal2_pread(context, fd, buffer, to_read, offset + total, err);
+        if (ret < 0) {
+            return -1;
+        }
+        if (ret == 0) {
+            break;
+        }
+        gfal2_checksum_ctx_update(ctx, buffer, ret);
+        total += ret;
+    }
+    return total;
+}
+
+
+static void* checksum_worker(void *data)
+{
+    checksum_worker_t *worker = (checksum_worker_t*) data;
+    checksum_job_t *job = worker->job;
+    GError *tmp_err = NULL;
+
+    int fd = gfal2_open(job->context, job->url, O_RDONLY, &tmp_err);
+    if (fd < 0) {
+        gfal2_propagate_prefixed_error(&worker->error, tmp_err, "open");
+        g_atomic_int_set(&job->failed, 1);
+        return NULL;
+    }
+
+    char *buffer = g_malloc(CHECKSUM_CHUNK_SIZE);
+    while (!g_atomic_int_get(&job->failed)) {
+        guint range = (guint) g_atomic_int_add(&job->next_range, 1);
+        if (range >= job->n_ranges) {
+            break;
+        }
+
+        size_t range_offset = (size_t) range * job->range_size;
+        size_t range_size = MIN(job->range_size, job->length - range_offset);
+
+        ssize_t ret = checksum_range(job->context, fd, job->states[range], buffer,
+            job->start_offset + range_offset, range_size, &job->failed, &tmp_err);
+        if (ret < 0) {
+            gfal2_propagate_prefixed_error(&worker->error, tmp_err, "read");
+            g_atomic_int_set(&job->failed, 1);
+        }
+        else if ((size_t) ret != range_size && !g_atomic_int_get(&job->failed)) {
+            gfal2_set_error(&worker->error, gfal2_get_core_quark(), EIO, __func__,
+                "Unexpected end of file at offset %lld, was the file modified?",
+                (long long) (job->start_offset + range_offset + ret));
+            g_atomic_int_set(&job->failed, 1);
+        }
+    }
+    g_free(buffer);
+
+    gfal2_close(job->context, fd, NULL);
+    return NULL;
+}
+
+
+static int checksum_parallel(gfal2_context_t context, const char *url, unsigned algorithm,
+    off_t start_offset, size_t length, int n_threads, gfal2_checksum_ctx *result, GError **err)
+{
+    checksum_job_t job;
+    memset(&job, 0, sizeof(job));
+    job.context = context;
+    job.url = url;
+    job.algorithm = algorithm;
+    job.start_offset = start_offset;
+    job.length = length;
+
+    // Ranges big enough to amortize the open, but at least one per thread
+    job.range_size = CHECKSUM_RANGE_SIZE;
+    if (length / n_threads < job.range_size) {
+        job.range_size = MAX(CHECKSUM_CHUNK_SIZE, (length + n_threads - 1) / n_threads);
+    }
+    job.n_ranges = (length + job.range_size - 1) / job.range_size;
+    n_threads = MIN(n_threads, job.n_ranges);
+
+    guint i;
+    job.states = g_new0(gfal2_checksum_ctx*, job.n_ranges);
+    for (i = 0; i < job.n_ranges; ++i) {
+        job.states[i] = gfal2_checksum_ctx_new_multi(algorithm);
+    }
+
+    gfal2_log(G_LOG_LEVEL_DEBUG, "Checksum of %s with %d threads, %u ranges of %zu bytes",
+        url, n_threads, job.n_ranges, job.range_size);
+
+    checksum_worker_t *workers = g_new0(checksum_worker_t, n_threads);
+    int started, ret;
+    for (started = 0; started < n_threads; ++started) {
+        workers[started].job = &job;
+        if ((ret = pthread_create(&workers[started].thread, NULL, checksum_worker, &workers[started])) != 0) {
+            gfal2_log(G_LOG_LEVEL_WARNING, "Could only start %d checksum workers out of %d: %s",
+                started, n_threads, strerror(ret));
+            break;
+        }
+    }
+    // The calling thread takes the ranges left over by the missing workers
+    if (started < n_threads) {
+        checksum_worker(&workers[started]);
+    }
+
+    GError *tmp_err = NULL;
+    for (i = 0; i < (guint) n_threads; ++i) {
+        if (i < (guint) started) {
+            pthread_join(workers[i].thread, NULL);
+        }
+        if (workers[i].error) {
+            if (tmp_err == NULL) {
+                tmp_err = workers[i].error;
+            }
+            else {
+                g_error_free(workers[i].error);
+            }
+        }
+    }
+    g_free(workers);
+
+    for (i = 0; i < job.n_ranges; ++i) {
+        if (tmp_err == NULL) {
+            gfal2_checksum_ctx_combine(result, job.states[i]);
+        }
+        gfal2_checksum_ctx_free(job.states[i]);
+    }
+    g_free(job.states);
+
+    if (tmp_err) {
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        return -1;
+    }
+    return 0;
+}
+
+
+static int checksum_serial(gfal2_context_t context, const char *url,
+    off_t start_offset, size_t data_length, gfal2_checksum_ctx *result, GError **err)
+{
+    GError *tmp_err = NULL;
+
+    int fd = gfal2_open(context, url, O_RDONLY, &tmp_err);
+    if (fd < 0) {
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        return -1;
+    }
+
+    char *buffer = g_malloc(CHECKSUM_CHUNK_SIZE);
+    ssize_t ret = checksum_range(context, fd, result, buffer, start_offset, data_length, NULL, &tmp_err);
+    g_free(buffer);
+    gfal2_close(context, fd, NULL);
+
+    if (ret < 0) {
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+        return -1;
+    }
+    return 0;
+}
+
+
+int gfal2_checksum_compute(gfal2_context_t context, const char *url, const char *check_type,
+    off_t start_offset, size_t data_length,
+    char *checksum_buffer, size_t buffer_length, GError **err)
+{
+    GError *tmp_err = NULL;
+    unsigned algorithm = gfal2_checksum_algorithm_from_name(check_type);
+    if (algorithm == 0) {
+        gfal2_set_error(err, gfal2_get_core_quark(), ENOSYS, __func__,
+            "Checksum type %s not supported", check_type);
+        return -1;
+    }
+
+    int n_threads = gfal2_get_opt_integer_with_default(context, "CORE", "CHECKSUM_THREADS", 1);
+    size_t length = data_length;
+
+    // The ranges need the size of the file, a cached one may be outdated
+    gboolean parallel = (n_threads > 1 && (algorithm & ~GFAL2_CHECKSUM_COMBINABLE) == 0);
+    if (parallel) {
+        struct stat st;
+        if (gfal_plugin_stat_uncachedG(context, url, &st, &tmp_err) < 0) {
+            gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+            return -1;
+        }
+        size_t available = (st.st_size > start_offset) ? (st.st_size - start_offset) : 0;
+        if (length == 0 || length > available) {
+            length = available;
+        }
+        parallel = (length > CHECKSUM_CHUNK_SIZE);
+    }
+
+    gfal2_checksum_ctx *result = gfal2_checksum_ctx_new_multi(algorithm);
+    int ret;
+    if (parallel) {
+        ret = checksum_parallel(context, url, algorithm, start_offset, length, n_threads, result, &tmp_err);
+    }
+    else {
+        ret = checksum_serial(context, url, start_offset, data_length, result, &tmp_err);
+    }
+
+    if (ret == 0 && gfal2_checksum_ctx_final(result, checksum_buffer, buffer_length) < 0) {
+        gfal2_set_error(&tmp_err, gfal2_get_core_quark(), ENOBUFS, __func__, "buffer for checksum too short");
+        ret = -1;
+    }
+    gfal2_checksum_ctx_free(result);
+
+    if (ret < 0) {
+        g_prefix_error(&tmp_err, "Error during checksum calculation: ");
+        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
+    }
+    return ret;
+}
@@ -201,3 +201,27 @@ ssize_t gfal2_pwrite(gfal2_context_t handle, int fd, const void *buff, size_t s_
     GFAL2_END_SCOPE_CANCEL(handle);
     G_RETURN_ERR(res, tmp_err, err);
 }
+
+
+ssize_t gfal2_preadv(gfal2_context_t handle, int fd, const struct iovec *iov, const off_t *offsets, int count,
+        GError **err)
+{
+    GError *tmp_err = NULL;
+    ssize_t res = -1;
+    GFAL2_BEGIN_SCOPE_CANCEL(handle, -1, err);
+    if (fd <= 0 || handle == NULL) {
+        g_set_error(&tmp_err, gfal2_get_core_quark(), EBADF, "Incorrect file descriptor or incorrect handle");
+    }
+    else if (count < 0 || (count > 0 && (iov == NULL || offsets == NULL))) {
+        g_set_error(&tmp_err, gfal2_get_core_quark(), EINVAL, "Invalid list of ranges");
+    }
+    else {
+        const int key = fd;
+        gfal_file_handle fh = gfal_file_handle_bind(handle->fdescs, key, &tmp_err);
+        if (fh != NULL) {
+            res = gfal_plugin_preadvG(handle, fh, iov, offsets, count, &tmp_err);
+        }
+    }
+    GFAL2_END_SCOPE_CANCEL(handle);
+    G_RETURN_ERR(res, tmp_err, err);
+}
@@ -25,6 +25,7 @@
 #include <common/gfal_error.h>
 #include <common/gfal_cancel.h>
 #include <common/gfal_config.h>
+#include <common/gfal_metrics_internal.h>
 
 int gfal2_access(gfal2_context_t context, const char *url, int amode, GError **err)
 {
@@ -607,6 +608,39 @@ int gfal2_unlink_list(gfal2_context_t context, int nbfiles, const char *const *u
 }
 
 
+int gfal2_stat_list(gfal2_context_t context, int nbfiles, const char *const *urls, struct stat *buffs, GError **errors)
+{
+    GError *tmp_err = NULL;
+    int res = 0;
+
+    if (nbfiles == 0) {
+        return 0;
+    }
+
+    if (urls == NULL || *urls == NULL || context == NULL || buffs == NULL) {
+        g_set_error(&tmp_err, gfal2_get_core_quark(), EFAULT,
+            "urls or/and buffs or/and context are incorrect arguments");
+        res = -1;
+    }
+    else {
+        res = gfal2_start_scope_cancel(context, &tmp_err);
+        if (res == 0) {
+            res = gfal_plugin_stat_listG(context, nbfiles, urls, buffs, errors);
+            gfal2_end_scope_cancel(context);
+        }
+    }
+
+    if (tmp_err) {
+        int i;
+        for (i = 0; i < nbfiles; ++i) {
+            errors[i] = g_error_copy(tmp_err);
+        }
+        g_error_free(tmp_err);
+    }
+    return res;
+}
+
+
 int gfal2_abort_files(gfal2_context_t context, int nbfiles, const char *const *urls, const char *token, GError **err)
 {
     GError *tmp_err = NULL;
@@ -676,9 +710,11 @@ int gfal2_checksum(gfal2_context_t handle, const char *url, const char *check_ty
     gfal_plugin_interface *p = gfal_find_plugin(handle, url, GFAL_PLUGIN_CHECKSUM, &tmp_err);
 
     if (p) {
+        gint64 start = gfal_metrics_now();
         res = p->checksum_calcG(gfal_get_plugin_handle(p), url, check_type, checksum_buffer, buffer_length,
             start_offset,
             data_length, &tmp_err);
+        gfal_metrics_record(handle, p, GFAL_METRIC_CHECKSUM, start, res < 0, 0);
     }
     GFAL2_END_SCOPE_CANCEL(handle);
 
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifndef GFAL_ASYNC_API_H_
+#define GFAL_ASYNC_API_H_
+
+#if !defined(__GFAL2_H_INSIDE__) && !defined(__GFAL2_BUILD__)
+#   warning "Direct inclusion of gfal2 headers is deprecated. Please, include only gfal_api.h or gfal_plugins_api.h"
+#endif
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <glib.h>
+
+#include <common/gfal_common.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/**
+ * @file gfal_async_api.h
+ * @brief asynchronous variants of some operations of \ref gfal_file_api.h
+ *
+ * The operations are queued and run by a pool of CORE:ASYNC_THREADS threads owned by the context,
+ * with at most CORE:ASYNC_MAX_PER_PLUGIN of them running on the same plugin at a time.
+ * Completion can be notified with a callback, polled with \ref gfal2_request_is_done,
+ * or waited for with \ref gfal2_request_wait.
+ *
+ * \ref gfal2_cancel cancels the running operations, as for the synchronous API, and
+ * the queued ones, which complete with ECANCELED.
+ */
+
+/**
+    \defgroup async_group Asynchronous operations
+    @{
+*/
+
+/// Handle of an asynchronous operation
+typedef struct gfal2_request_s* gfal2_request_t;
+
+/**
+ * Completion callback, called once from one of the threads of the pool.
+ * The request is done: its result can be read with \ref gfal2_request_wait without blocking.
+ */
+typedef void (*gfal2_request_cb)(gfal2_request_t request, void* user_data);
+
+/**
+ * @brief asynchronous \ref gfal2_stat
+ *
+ * @param context : gfal2 handle, see \ref gfal2_context_new
+ * @param url : url of the file
+ * @param buff : stat structure filled on success, must stay valid until the request is done
+ * @param callback : called on completion, may be NULL
+ * @param user_data : passed to the callback
+ * @param err : GError error report
+ * @return the request, NULL if it could not be queued. It must be released with \ref gfal2_request_free
+ */
+gfal2_request_t gfal2_stat_async(gfal2_context_t context, const char* url, struct stat* buff,
+        gfal2_request_cb callback, void* user_data, GError** err);
+
+/**
+ * @brief asynchronous \ref gfal2_open, the result of the request is the file descriptor
+ */
+gfal2_request_t gfal2_open_async(gfal2_context_t context, const char* url, int flag,
+        gfal2_request_cb callback, void* user_data, GError** err);
+
+/**
+ * @brief asynchronous \ref gfal2_pread, the result of the request is the number of bytes read
+ *
+ * The buffer must stay valid until the request is done
+ */
+gfal2_request_t gfal2_pread_async(gfal2_context_t context, int fd, void* buffer, size_t count, off_t offset,
+        gfal2_request_cb callback, void* user_data, GError** err);
+
+/**
+ * @brief asynchronous \ref gfal2_checksum
+ *
+ * The checksum buffer must stay valid until the request is done
+ */
+gfal2_request_t gfal2_checksum_async(gfal2_context_t context, const char* url, const char* check_type,
+        off_t start_offset, size_t data_length, char* checksum_buffer, size_t buffer_length,
+        gfal2_request_cb callback, void* user_data, GError** err);
+
+/**
+ * @brief true if the request is done
+ */
+gboolean gfal2_request_is_done(gfal2_request_t request);
+
+/**
+ * @brief wait for a request to be done
+ *
+ * @param request : the request
+ * @param timeout_ms : maximum time to wait in milliseconds, negative to wait forever
+ * @param err : error of the operation, or ETIMEDOUT if it is still running
+ * @return the result of the operation, as returned by its synchronous version, -1 on error
+ */
+ssize_t gfal2_request_wait(gfal2_request_t request, int timeout_ms, GError** err);
+
+/**
+ * @brief cancel a request that did not start yet
+ *
+ * The request completes with ECANCELED. Running requests are interrupted with \ref gfal2_cancel
+ * @return 0 if the request was canceled, -1 if it is already running or done, or if request is NULL
+ */
+int gfal2_request_cancel(gfal2_request_t request);
+
+/**
+ * @brief release a request
+ *
+ * Can be called at any time, even from the completion callback: a request released before
+ * being done still runs, but its result is discarded
+ */
+void gfal2_request_free(gfal2_request_t request);
+
+/**
+    @}
+    End of the ASYNC group
+*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GFAL_ASYNC_API_H_ */
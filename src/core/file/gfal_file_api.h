@@ -27,6 +27,7 @@
 #endif
 
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <fcntl.h>
 #include <dirent.h>
 #include <sys/stat.h>
@@ -563,6 +564,22 @@ int gfal2_release_file_list(gfal2_context_t context, int nbfiles, const char* co
  */
 int gfal2_unlink_list(gfal2_context_t context, int nbfiles, const char* const* urls, GError ** errors);
 
+/**
+ * @brief Perform a bulk stat
+ *
+ * @param context : gfal2 handle, see \ref gfal2_context_new
+ * @param nbfiles : number of files
+ * @param urls    : paths of the files to stat
+ * @param buffs   : Pre-allocated array of nbfiles stat structures, filled for each successful file
+ * @param errors  : Pre-allocated array with nbfiles pointers to errors.
+ *                  It is the user's responsability to allocate and free.
+ * @return 0 if success, -1 if at least one file failed. Check each individual error
+ * @note The plugin tried will be the one that matches the first url
+ * @note If bulk stat is not supported by the plugin, the files are checked with up to
+ *       CORE:STAT_LIST_THREADS concurrent calls to \ref gfal2_stat
+ */
+int gfal2_stat_list(gfal2_context_t context, int nbfiles, const char* const* urls, struct stat* buffs, GError ** errors);
+
 /**
  * @brief abort a list of files
  * @param context : gfal2 handle, see \ref gfal2_context_new
@@ -744,6 +761,25 @@ ssize_t gfal2_pread(gfal2_context_t context, int fd, void * buffer, size_t count
  */
 ssize_t gfal2_pwrite(gfal2_context_t context, int fd, const void * buffer, size_t count, off_t offset, GError ** err);
 
+/**
+ * @brief read several ranges of a file descriptor
+ *
+ * Reads iov[i].iov_len bytes at offsets[i] into iov[i].iov_base, for each of the count ranges.
+ * Plugins supporting it read the ranges with a single request (i.e. readv for XROOTD, multi-range GET for HTTP),
+ * the others read them concurrently with gfal2_pread, with up to CORE:PREADV_THREADS threads.
+ * Each range is filled completely unless it goes past the end of the file.
+ *
+ * @param context : gfal2 handle, see \ref gfal2_context_new
+ * @param fd : file descriptor
+ * @param iov : buffers to fill
+ * @param offsets : offset of each range
+ * @param count : number of ranges
+ * @param err : GError error report
+ * @return total number of read bytes, -1 on failure, set err properly in case of error.
+ */
+ssize_t gfal2_preadv(gfal2_context_t context, int fd, const struct iovec * iov, const off_t * offsets, int count,
+        GError ** err);
+
 /**
     @}
     End of the FILE group
@@ -42,9 +42,15 @@
 /* main gfal2 API for file operations */
 #include <file/gfal_file_api.h>
 
+/* asynchronous operations */
+#include <file/gfal_async_api.h>
+
 /* operation control API */
 #include <common/gfal_cancel.h>
 
+/* operation metrics */
+#include <common/gfal_metrics.h>
+
 /* posix compatibility layer */
 #include <posix/gfal_posix_api.h>
 
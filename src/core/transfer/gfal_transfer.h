@@ -136,7 +136,11 @@ typedef enum {
     /// Compare user provided checksum vs destination
     GFALT_CHECKSUM_TARGET  = 0x02,
     /// Compare user provided checksum vs both, *or* source checksum vs target checksum
-    GFALT_CHECKSUM_BOTH = (GFALT_CHECKSUM_SOURCE | GFALT_CHECKSUM_TARGET)
+    GFALT_CHECKSUM_BOTH = (GFALT_CHECKSUM_SOURCE | GFALT_CHECKSUM_TARGET),
+    /// Compute the checksum of the data while it is streamed, instead of reading the source again.
+    /// Can be combined with GFALT_CHECKSUM_TARGET. Only streamed copies honour it (ADLER32, CRC32 and MD5);
+    /// plugins doing the copy themselves are asked for GFALT_CHECKSUM_SOURCE instead.
+    GFALT_CHECKSUM_INLINE  = 0x04
 } gfalt_checksum_mode_t;
 
 /**
@@ -281,8 +285,9 @@ GFAL2_DEPRECATED(gfalt_get_checksum) gint gfalt_get_user_defined_checksum(gfalt_
 
 /**
  * Set the checksum configuration to use
- * @param mode      For GFALT_CHECKSUM_SOURCE or GFALT_CHECKSUM_TARGET only, the checksum value is mandatory.
- *                  For GFALT_CHECKSUM_BOTH, the checksum value can be NULL, as the verification can be done end to end.
+ * @param mode      For GFALT_CHECKSUM_SOURCE, GFALT_CHECKSUM_TARGET or GFALT_CHECKSUM_INLINE only, the checksum value is mandatory.
+ *                  For GFALT_CHECKSUM_BOTH or GFALT_CHECKSUM_INLINE | GFALT_CHECKSUM_TARGET, the checksum value can be NULL,
+ *                  as the verification can be done end to end.
  * @param type      Checksum algorithm to use. Support depends on protocol and storage, but ADLER32 and MD5
  *                  are normally safe bets. If NULL, previous type is kept.
  * @param checksum  Expected checksum value. Can be NULL for GFALT_CHECKSUM_BOTH mode. If NULL, clears value.
@@ -18,11 +18,16 @@
  * limitations under the License.
  */
 
+#include <pthread.h>
+
 #include <common/gfal_plugin.h>
 #include <common/gfal_error.h>
 #include <transfer/gfal_transfer_plugins.h>
 #include <transfer/gfal_transfer_internal.h>
 #include <common/gfal_cancel.h>
+#include <common/gfal_metadata_cache.h>
+#include <common/gfal_metrics_internal.h>
+#include <uri/gfal2_uri.h>
 
 static GQuark scope_copy_domain() {
     return g_quark_from_static_string("GFAL2:CORE:COPY");
@@ -32,7 +37,11 @@ static GQuark scope_copy_domain() {
 static gfal_plugin_interface* find_copy_plugin(gfal2_context_t context, gfal_url2_check operation,
         const char* src, const char* dst, void** plugin_data, GError** error)
 {
-    GList* item = g_list_first(context->plugin_opt.sorted_plugin);
+    // The plugins declaring the schemes may not be loaded yet
+    if (gfal_plugins_load_url(context, src, error) < 0 || gfal_plugins_load_url(context, dst, error) < 0)
+        return NULL;
+
+    GList* item = gfal_plugins_sorted(context);
     void* resu = NULL;
 
     while (item != NULL && resu == NULL) {
@@ -54,7 +63,7 @@ static gfal_plugin_interface* find_copy_plugin(gfal2_context_t context, gfal_url
 
 static int trigger_listener_plugins(gfal2_context_t context, gfalt_params_t params, GError** error)
 {
-    GList *item = g_list_first(context->plugin_opt.sorted_plugin);
+    GList *item = gfal_plugins_sorted(context);
 
     while (item != NULL) {
         gfal_plugin_interface* plugin_ifce = (gfal_plugin_interface*)item->data;
@@ -98,6 +107,20 @@ static int notify_copy_list(gfal2_context_t context, gfalt_params_t params,
 }
 
 
+// Plugins doing the copy themselves never see the data, so an inline verification
+// is done against the source instead. Returns NULL if params can be given as they are
+static gfalt_params_t plugin_copy_params(gfalt_params_t params)
+{
+    if (!(params->checksum_mode & GFALT_CHECKSUM_INLINE)) {
+        return NULL;
+    }
+    gfal2_log(G_LOG_LEVEL_DEBUG, "Inline checksum not available for plugin copies, verifying the source");
+    gfalt_params_t copy = gfalt_params_handle_copy(params, NULL);
+    copy->checksum_mode = (params->checksum_mode & ~GFALT_CHECKSUM_INLINE) | GFALT_CHECKSUM_SOURCE;
+    return copy;
+}
+
+
 static int perform_copy(gfal2_context_t context, gfalt_params_t params, const char* src,
         const char* dst, GError** error)
 {
@@ -131,9 +154,17 @@ static int perform_copy(gfal2_context_t context, gfalt_params_t params, const ch
             }
         }
         else {
-            res = plugin->copy_file(plugin_data, context, params, src, dst, &tmp_err);
+            gfalt_params_t plugin_params = plugin_copy_params(params);
+            gint64 start = gfal_metrics_now();
+            res = plugin->copy_file(plugin_data, context, plugin_params ? plugin_params : params,
+                    src, dst, &tmp_err);
+            gfal_metrics_record(context, plugin, GFAL_METRIC_COPY, start, res < 0, 0);
+            if (plugin_params) {
+                gfalt_params_handle_delete(plugin_params, NULL);
+            }
         }
     }
+    gfal_metadata_cache_invalidate(context, dst, FALSE);
 
     gfal2_log(G_LOG_LEVEL_DEBUG, " <- Gfal::Transfer::FileCopy");
 
@@ -167,34 +198,203 @@ static int set_checksum(gfalt_params_t params, const char* checksum, GError **er
 }
 
 
+// Files of a bulk copy done by the core, queued by destination host
+typedef struct {
+    // indexes of the files not started yet, as pointers
+    GQueue files;
+    int running;
+    gboolean ready;
+} bulk_host_t;
+
+
+typedef struct {
+    gfal2_context_t context;
+    gfalt_params_t params;
+    const char* const* srcs;
+    const char* const* dsts;
+    const char* const* checksums;
+    GError** file_errors;
+    int max_per_host;
+
+    pthread_mutex_t lock;
+    pthread_cond_t wakeup;
+    // destination host => bulk_host_t
+    GHashTable* hosts;
+    // hosts with files queued and below max_per_host, served in turn
+    GQueue ready;
+    size_t pending;
+    int failed;
+} bulk_job_t;
+
+
+static void bulk_host_free(gpointer data)
+{
+    bulk_host_t* host = (bulk_host_t*) data;
+    g_queue_clear(&host->files);
+    g_free(host);
+}
+
+
+static gboolean bulk_host_available(bulk_job_t* job, bulk_host_t* host)
+{
+    return !g_queue_is_empty(&host->files) && (job->max_per_host <= 0 || host->running < job->max_per_host);
+}
+
+
+// Each file gets its own copy of the parameters, as the checksum differs
+static int bulk_copy_one(bulk_job_t* job, size_t i)
+{
+    GError** error = &job->file_errors[i];
+    gfalt_params_t params = gfalt_params_handle_copy(job->params, NULL);
+
+    int ret = set_checksum(params, job->checksums ? job->checksums[i] : NULL, error);
+    if (ret == 0) {
+        ret = perform_copy(job->context, params, job->srcs[i], job->dsts[i], error);
+    }
+
+    gfalt_params_handle_delete(params, NULL);
+    return ret;
+}
+
+
+static void* bulk_fallback_worker(void* data)
+{
+    bulk_job_t* job = (bulk_job_t*) data;
+
+    pthread_mutex_lock(&job->lock);
+    while (job->pending > 0 && !gfal2_is_canceled(job->context)) {
+        bulk_host_t* host = (bulk_host_t*) g_queue_pop_head(&job->ready);
+        if (host == NULL) {
+            // All the remaining files go to busy hosts
+            pthread_cond_wait(&job->wakeup, &job->lock);
+            continue;
+        }
+
+        size_t i = GPOINTER_TO_SIZE(g_queue_pop_head(&host->files));
+        host->running += 1;
+        job->pending -= 1;
+        host->ready = bulk_host_available(job, host);
+        if (host->ready) {
+            g_queue_push_tail(&job->ready, host);
+        }
+        pthread_mutex_unlock(&job->lock);
+
+        int ret = bulk_copy_one(job, i);
+
+        pthread_mutex_lock(&job->lock);
+        if (ret < 0) {
+            job->failed += 1;
+        }
+        host->running -= 1;
+        if (!host->ready && bulk_host_available(job, host)) {
+            host->ready = TRUE;
+            g_queue_push_tail(&job->ready, host);
+            pthread_cond_signal(&job->wakeup);
+        }
+    }
+    // Let the waiting workers see the end of the job
+    pthread_cond_broadcast(&job->wakeup);
+    pthread_mutex_unlock(&job->lock);
+    return NULL;
+}
+
+
+static gchar* bulk_destination_host(const char* dst)
+{
+    gchar* host = NULL;
+    gfal2_uri* parsed = gfal2_parse_uri(dst, NULL);
+    if (parsed) {
+        host = g_strdup(parsed->host ? parsed->host : "");
+        gfal2_free_uri(parsed);
+    }
+    else {
+        host = g_strdup("");
+    }
+    return host;
+}
+
+
+// Copy the files one by one, with up to CORE:BULK_COPY_CONCURRENCY copies running at the same time
+// and at most CORE:BULK_COPY_MAX_PER_HOST of them to the same destination host
+// The calling thread is one of the workers
 static int bulk_fallback(gfal2_context_t context, gfalt_params_t params, size_t nbfiles,
         const char* const * srcs, const char* const * dsts, const char* const * checksums,
         GError** op_error, GError*** file_errors)
 {
     *file_errors = g_new0(GError*, nbfiles);
-    int ret = 0;
+
+    bulk_job_t job;
+    memset(&job, 0, sizeof(job));
+    job.context = context;
+    job.params = params;
+    job.srcs = srcs;
+    job.dsts = dsts;
+    job.checksums = checksums;
+    job.file_errors = *file_errors;
+    job.max_per_host = gfal2_get_opt_integer_with_default(context, CORE_CONFIG_GROUP, "BULK_COPY_MAX_PER_HOST", 0);
+    job.pending = nbfiles;
+    pthread_mutex_init(&job.lock, NULL);
+    pthread_cond_init(&job.wakeup, NULL);
+    g_queue_init(&job.ready);
+    job.hosts = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, bulk_host_free);
+
     size_t i;
     for (i = 0; i < nbfiles; ++i) {
-        int subret = 0;
-
-        if (checksums) {
-            const char* checksum = checksums[i];
-            subret = set_checksum(params, checksum, &(*file_errors)[i]);
+        gchar* name = bulk_destination_host(dsts[i]);
+        bulk_host_t* host = (bulk_host_t*) g_hash_table_lookup(job.hosts, name);
+        if (host == NULL) {
+            host = g_new0(bulk_host_t, 1);
+            g_queue_init(&host->files);
+            host->ready = TRUE;
+            g_hash_table_insert(job.hosts, name, host);
+            g_queue_push_tail(&job.ready, host);
         }
         else {
-            subret = set_checksum(params, NULL, &(*file_errors)[i]);
-        }
-        if (subret < 0) {
-            ret -= 1;
-            continue;
+            g_free(name);
         }
+        g_queue_push_tail(&host->files, GSIZE_TO_POINTER(i));
+    }
 
-        subret = perform_copy(context, params, srcs[i], dsts[i], &(*file_errors)[i]);
-        if (subret < 0) {
-            ret -= 1;
+    int n_threads = gfal2_get_opt_integer_with_default(context, CORE_CONFIG_GROUP, "BULK_COPY_CONCURRENCY", 1);
+    n_threads = (int) MIN((size_t) MAX(n_threads, 1), nbfiles);
+    gfal2_log(G_LOG_LEVEL_DEBUG, "Bulk copy of %zu files with %d concurrent copies, %u destination hosts",
+            nbfiles, n_threads, g_hash_table_size(job.hosts));
+
+    pthread_t* threads = g_new0(pthread_t, n_threads);
+    int started;
+    for (started = 0; started < n_threads - 1; ++started) {
+        if (pthread_create(&threads[started], NULL, bulk_fallback_worker, &job) != 0) {
+            gfal2_log(G_LOG_LEVEL_WARNING, "Could not start a bulk copy worker, continuing with %d", started + 1);
+            break;
         }
     }
-    return ret;
+    bulk_fallback_worker(&job);
+    int t;
+    for (t = 0; t < started; ++t) {
+        pthread_join(threads[t], NULL);
+    }
+    g_free(threads);
+
+    // Files never started because of a cancellation
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, job.hosts);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        bulk_host_t* host = (bulk_host_t*) value;
+        while (!g_queue_is_empty(&host->files)) {
+            i = GPOINTER_TO_SIZE(g_queue_pop_head(&host->files));
+            gfal2_set_error(&job.file_errors[i], gfal_cancel_quark(), ECANCELED, __func__,
+                    "Transfer canceled before being started");
+            job.failed += 1;
+        }
+    }
+
+    g_queue_clear(&job.ready);
+    g_hash_table_destroy(job.hosts);
+    pthread_cond_destroy(&job.wakeup);
+    pthread_mutex_destroy(&job.lock);
+
+    return -job.failed;
 }
 
 
@@ -226,10 +426,18 @@ static int perform_bulk_copy(gfal2_context_t context, gfalt_params_t params,
                     file_errors);
         }
         else {
-            res = plugin->copy_bulk(plugin_data, context, params, nbfiles, srcs, dsts, checksums,
-                    op_error, file_errors);
+            gfalt_params_t plugin_params = plugin_copy_params(params);
+            res = plugin->copy_bulk(plugin_data, context, plugin_params ? plugin_params : params,
+                    nbfiles, srcs, dsts, checksums, op_error, file_errors);
+            if (plugin_params) {
+                gfalt_params_handle_delete(plugin_params, NULL);
+            }
         }
     }
+    size_t i;
+    for (i = 0; i < nbfiles; ++i) {
+        gfal_metadata_cache_invalidate(context, dsts[i], FALSE);
+    }
 
     gfal2_log(G_LOG_LEVEL_DEBUG, " <- Gfal::Transfer::BulkFileCopy");
 
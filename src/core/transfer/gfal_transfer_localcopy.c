@@ -19,9 +19,16 @@
  */
 
 #include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
 
 #include <gfal_api.h>
 #include <common/gfal_plugin_interface.h>
+#include <common/gfal_file_handler_container.h>
 #include <checksums/checksums.h>
 #include "gfal_transfer_plugins.h"
 #include "gfal_transfer_internal.h"
@@ -151,8 +158,258 @@ static void send_performance_data(gfalt_params_t params, const char* src, const
 }
 
 
+// Cancellation, timeout and performance markers, checked after each chunk
+static void copy_progress(gfal2_context_t context, gfalt_params_t params,
+        const char* src, const char* dst, struct perf_data_t* perf, time_t timeout, GError** error)
+{
+    // Make sure we don't have to cancel
+    if (gfal2_is_canceled(context)) {
+        if (*error == NULL)
+            g_set_error(error, local_copy_domain(), ECANCELED, "Transfer canceled");
+    }
+    // Timed-out?
+    else {
+        perf->now = time(NULL);
+        if (perf->now >= timeout) {
+            if (*error == NULL)
+                g_set_error(error, local_copy_domain(), ETIMEDOUT, "Transfer canceled because the timeout expired");
+        }
+        else if (perf->now - perf->last_update > 5) {
+            send_performance_data(params, src, dst, perf);
+            perf->done_since_last_update = 0;
+            perf->last_update = perf->now;
+        }
+    }
+}
+
+
+// Return the local file descriptor if the handle belongs to the file plugin, -1 otherwise
+static int local_file_descriptor(gfal_file_handle fh)
+{
+    if (strncmp(fh->module_name, GFAL2_PLUGIN_VERSIONED("file", ""), 5) != 0)
+        return -1;
+    return GPOINTER_TO_INT(gfal_file_handle_get_fdesc(fh));
+}
+
+
+// Copy between two local files without going through user space
+// Returns 0 if the kernel can not do it for this pair of files, so the caller can fall back
+static int kernel_copy(gfal2_context_t context, gfalt_params_t params,
+        const char* src, const char* dst, int fd_src, int fd_dst, size_t chunk,
+        struct perf_data_t* perf, time_t timeout, GError** error)
+{
+    gboolean use_sendfile = FALSE;
+    ssize_t ret = 1;
+
+    while (ret > 0 && *error == NULL) {
+        ret = -1;
+        errno = ENOSYS;
+#ifdef HAVE_COPY_FILE_RANGE
+        if (!use_sendfile)
+            ret = copy_file_range(fd_src, NULL, fd_dst, NULL, chunk, 0);
+#endif
+#ifdef __linux__
+        if (ret < 0 && perf->done == 0 && !use_sendfile &&
+            (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP)) {
+            use_sendfile = TRUE;
+        }
+        if (use_sendfile)
+            ret = sendfile(fd_dst, fd_src, NULL, chunk);
+#endif
+        if (ret < 0) {
+            if (perf->done == 0 && (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP))
+                return 0;
+            gfal2_set_error(error, local_copy_domain(), errno, __func__,
+                "Failed to copy %s into %s: %s", src, dst, strerror(errno));
+            break;
+        }
+
+        perf->done += ret;
+        perf->done_since_last_update += ret;
+        copy_progress(context, params, src, dst, perf, timeout, error);
+    }
+
+    gfal2_log(G_LOG_LEVEL_DEBUG, "  local transfer done by the kernel with %s",
+        use_sendfile ? "sendfile" : "copy_file_range");
+    return 1;
+}
+
+
+static void serial_copy(gfal2_context_t context, gfalt_params_t params,
+        const char* src, const char* dst, gfal_file_handle f_src, gfal_file_handle f_dst,
+        char* buffer, size_t buffersize, gfal2_checksum_ctx* checksum,
+        struct perf_data_t* perf, time_t timeout, GError** error)
+{
+    ssize_t s_file = 1;
+
+    while (s_file > 0 && !*error) {
+        s_file = gfal_plugin_readG(context, f_src, buffer, buffersize, error);
+        if (s_file > 0) {
+            if (checksum)
+                gfal2_checksum_ctx_update(checksum, buffer, s_file);
+            gfal_plugin_writeG(context, f_dst, buffer, s_file, error);
+        }
+
+        perf->done += s_file;
+        perf->done_since_last_update += s_file;
+
+        copy_progress(context, params, src, dst, perf, timeout, error);
+    }
+}
+
+
+// Ring of buffers filled by a reader thread and drained by the caller
+struct copy_pipeline_t {
+    gfal2_context_t context;
+    gfal_file_handle f_src;
+    size_t buffersize;
+    int depth;
+    char** buffers;
+    ssize_t* sizes;
+    // the reader fills at head, the writer drains from tail
+    int head, tail, filled;
+    gboolean stop;
+    GError* error;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+};
+
+
+static void* pipeline_reader(void* data)
+{
+    struct copy_pipeline_t* pipeline = (struct copy_pipeline_t*)data;
+    ssize_t s_file = 1;
+
+    while (s_file > 0) {
+        pthread_mutex_lock(&pipeline->lock);
+        while (pipeline->filled == pipeline->depth && !pipeline->stop)
+            pthread_cond_wait(&pipeline->cond, &pipeline->lock);
+        const int slot = pipeline->head;
+        const gboolean stop = pipeline->stop;
+        pthread_mutex_unlock(&pipeline->lock);
+
+        if (stop)
+            break;
+
+        GError* tmp_err = NULL;
+        s_file = gfal_plugin_readG(pipeline->context, pipeline->f_src,
+            pipeline->buffers[slot], pipeline->buffersize, &tmp_err);
+        if (tmp_err)
+            s_file = -1;
+
+        pthread_mutex_lock(&pipeline->lock);
+        pipeline->sizes[slot] = s_file;
+        pipeline->error = tmp_err;
+        pipeline->head = (slot + 1) % pipeline->depth;
+        ++pipeline->filled;
+        pthread_cond_broadcast(&pipeline->cond);
+        pthread_mutex_unlock(&pipeline->lock);
+    }
+    return NULL;
+}
+
+
+static void pipelined_copy(gfal2_context_t context, gfalt_params_t params,
+        const char* src, const char* dst, gfal_file_handle f_src, gfal_file_handle f_dst,
+        size_t alignment, size_t buffersize, int depth, gfal2_checksum_ctx* checksum,
+        struct perf_data_t* perf, time_t timeout, GError** error)
+{
+    struct copy_pipeline_t pipeline;
+    memset(&pipeline, 0, sizeof(pipeline));
+    pipeline.context = context;
+    pipeline.f_src = f_src;
+    pipeline.buffersize = buffersize;
+    pipeline.depth = depth;
+    pipeline.buffers = g_new0(char*, depth);
+    pipeline.sizes = g_new0(ssize_t, depth);
+
+    int i;
+    for (i = 0; i < depth; ++i) {
+        errno = posix_memalign((void**)&pipeline.buffers[i], alignment, buffersize);
+        if (errno) {
+            g_set_error(error, local_copy_domain(), errno, "Failed to allocate aligned buffer");
+            goto free_buffers;
+        }
+    }
+
+    pthread_mutex_init(&pipeline.lock, NULL);
+    pthread_cond_init(&pipeline.cond, NULL);
+
+    pthread_t reader;
+    errno = pthread_create(&reader, NULL, pipeline_reader, &pipeline);
+    if (errno) {
+        g_set_error(error, local_copy_domain(), errno, "Failed to start the reader thread");
+        goto destroy_pipeline;
+    }
+
+    gfal2_log(G_LOG_LEVEL_DEBUG, "  pipelined local transfer with %d buffers", depth);
+
+    gboolean eof = FALSE;
+    while (!eof && *error == NULL) {
+        int slot = -1;
+        ssize_t s_file = 0;
+
+        pthread_mutex_lock(&pipeline.lock);
+        if (pipeline.filled == 0) {
+            // Wake up periodically to check cancellation and timeout while the source is slow
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += 1;
+            pthread_cond_timedwait(&pipeline.cond, &pipeline.lock, &deadline);
+        }
+        if (pipeline.filled > 0) {
+            slot = pipeline.tail;
+            s_file = pipeline.sizes[slot];
+            if (s_file < 0) {
+                g_propagate_error(error, pipeline.error);
+                pipeline.error = NULL;
+            }
+        }
+        pthread_mutex_unlock(&pipeline.lock);
+
+        if (slot >= 0) {
+            if (s_file == 0) {
+                eof = TRUE;
+            }
+            else if (s_file > 0) {
+                if (checksum)
+                    gfal2_checksum_ctx_update(checksum, pipeline.buffers[slot], s_file);
+                gfal_plugin_writeG(context, f_dst, pipeline.buffers[slot], s_file, error);
+                perf->done += s_file;
+                perf->done_since_last_update += s_file;
+            }
+
+            pthread_mutex_lock(&pipeline.lock);
+            pipeline.tail = (slot + 1) % depth;
+            --pipeline.filled;
+            pthread_cond_broadcast(&pipeline.cond);
+            pthread_mutex_unlock(&pipeline.lock);
+        }
+
+        copy_progress(context, params, src, dst, perf, timeout, error);
+    }
+
+    pthread_mutex_lock(&pipeline.lock);
+    pipeline.stop = TRUE;
+    pthread_cond_broadcast(&pipeline.cond);
+    pthread_mutex_unlock(&pipeline.lock);
+    pthread_join(reader, NULL);
+    g_clear_error(&pipeline.error);
+
+destroy_pipeline:
+    pthread_cond_destroy(&pipeline.cond);
+    pthread_mutex_destroy(&pipeline.lock);
+free_buffers:
+    for (i = 0; i < depth; ++i)
+        free(pipeline.buffers[i]);
+    g_free(pipeline.buffers);
+    g_free(pipeline.sizes);
+}
+
+
+// If checksum is not NULL, the data is folded into it while it is copied
 static int streamed_copy(gfal2_context_t context, gfalt_params_t params,
-        const char* src, const char* dst, GError** error)
+        const char* src, const char* dst, gfal2_checksum_ctx* checksum, GError** error)
 {
     GError *nested_error = NULL;
 
@@ -165,17 +422,13 @@ static int streamed_copy(gfal2_context_t context, gfalt_params_t params,
 
     size_t alignment = gfal2_get_opt_integer_with_default(context, "CORE", "COPY_BUFFER_ALIGNMENT", 512);
     size_t buffersize = gfal2_get_opt_integer_with_default(context, "CORE", "COPY_BUFFERSIZE", DEFAULT_BUFFER_SIZE);
-    char *buffer;
-    errno = posix_memalign((void**)&buffer, alignment, buffersize);
-    if (errno) {
-        g_set_error(error, local_copy_domain(), errno, "Failed to allocate aligned buffer");
-        return -1;
-    }
+    int pipeline_depth = gfal2_get_opt_integer_with_default(context, "CORE", "COPY_PIPELINE_DEPTH", 0);
 
     int src_open_flags = O_RDONLY;
+    gboolean direct_io = FALSE;
 
 #ifdef O_DIRECT
-    gboolean direct_io = gfal2_get_opt_boolean_with_default(context, "CORE", "COPY_DIRECT_IO", FALSE);
+    direct_io = gfal2_get_opt_boolean_with_default(context, "CORE", "COPY_DIRECT_IO", FALSE);
 
     if (direct_io) {
         src_open_flags |= O_DIRECT;
@@ -188,7 +441,6 @@ static int streamed_copy(gfal2_context_t context, gfalt_params_t params,
 
     gfal_file_handle f_src = gfal_plugin_openG(context, src, src_open_flags, 0, &nested_error);
     if (nested_error) {
-        free(buffer);
         gfal2_propagate_prefixed_error_extended(error, nested_error, __func__, "Could not open source: ");
         return -1;
     }
@@ -207,7 +459,6 @@ static int streamed_copy(gfal2_context_t context, gfalt_params_t params,
 
     gfal_file_handle f_dst = gfal_plugin_openG(context, dst, dst_open_flags, 0755, &nested_error);
     if (nested_error) {
-        free(buffer);
         gfal_plugin_closeG(context, f_src, NULL);
         gfal2_propagate_prefixed_error_extended(error, nested_error, __func__, "Could not open destination: ");
         return -1;
@@ -218,39 +469,37 @@ static int streamed_copy(gfal2_context_t context, gfalt_params_t params,
     perf_data.done = perf_data.done_since_last_update = 0;
 
     const time_t timeout = perf_data.start + gfalt_get_timeout(params, NULL);
-    ssize_t s_file = 1;
 
     gfal2_log(G_LOG_LEVEL_DEBUG, "  begin local transfer %s ->  %s with buffer size %ld", src, dst, buffersize);
 
-    while (s_file > 0 && !nested_error) {
-        s_file = gfal_plugin_readG(context, f_src, buffer, buffersize, &nested_error);
-        if (s_file > 0) {
-            gfal_plugin_writeG(context, f_dst, buffer, s_file, &nested_error);
-        }
+    const int fd_src = local_file_descriptor(f_src);
+    const int fd_dst = local_file_descriptor(f_dst);
+    int done = 0;
 
-        perf_data.done += s_file;
-        perf_data.done_since_last_update += s_file;
+    if (!direct_io && !checksum && fd_src >= 0 && fd_dst >= 0) {
+        done = kernel_copy(context, params, src, dst, fd_src, fd_dst, buffersize,
+            &perf_data, timeout, &nested_error);
+    }
 
-        // Make sure we don't have to cancel
-        if (gfal2_is_canceled(context)) {
-            if (nested_error == NULL)
-                g_set_error(&nested_error, local_copy_domain(), ECANCELED, "Transfer canceled");
+    if (done) {
+        // pass
+    }
+    else if (pipeline_depth > 1) {
+        pipelined_copy(context, params, src, dst, f_src, f_dst, alignment, buffersize, pipeline_depth,
+            checksum, &perf_data, timeout, &nested_error);
+    }
+    else {
+        char *buffer;
+        errno = posix_memalign((void**)&buffer, alignment, buffersize);
+        if (errno) {
+            g_set_error(&nested_error, local_copy_domain(), errno, "Failed to allocate aligned buffer");
         }
-        // Timed-out?
         else {
-            perf_data.now = time(NULL);
-            if (perf_data.now >= timeout) {
-                if (nested_error == NULL)
-                    g_set_error(&nested_error, local_copy_domain(), ETIMEDOUT, "Transfer canceled because the timeout expired");
-            }
-            else if (perf_data.now - perf_data.last_update > 5) {
-                send_performance_data(params, src, dst, &perf_data);
-                perf_data.done_since_last_update = 0;
-                perf_data.last_update = perf_data.now;
-            }
+            serial_copy(context, params, src, dst, f_src, f_dst, buffer, buffersize,
+                checksum, &perf_data, timeout, &nested_error);
+            free(buffer);
         }
     }
-    free(buffer);
 
     gfal_plugin_closeG(context, f_dst, (nested_error)?NULL:(&nested_error));
     gfal_plugin_closeG(context, f_src, (nested_error)?NULL:(&nested_error));
@@ -290,8 +539,20 @@ int perform_local_copy(gfal2_context_t context, gfalt_params_t params,
         g_strlcpy(checksum_type, "ADLER32", sizeof(checksum_type));
     }
 
+    // Inline checksum, computed over the streamed data, replaces the source checksum
+    gfal2_checksum_ctx* inline_checksum = NULL;
+    if (checksum_mode & GFALT_CHECKSUM_INLINE) {
+        inline_checksum = gfal2_checksum_ctx_new(checksum_type);
+        if (inline_checksum == NULL) {
+            gfalt_set_error(error, local_copy_domain(), ENOTSUP, __func__,
+                GFALT_ERROR_TRANSFER, GFALT_ERROR_CHECKSUM,
+                "Checksum type %s can not be computed inline", checksum_type);
+            return -1;
+        }
+    }
+
     // Source checksum
-    if (checksum_mode & GFALT_CHECKSUM_SOURCE) {
+    if ((checksum_mode & GFALT_CHECKSUM_SOURCE) && !inline_checksum) {
         plugin_trigger_event(params, local_copy_domain(), GFAL_EVENT_SOURCE, GFAL_EVENT_CHECKSUM_ENTER, "");
         gfal2_checksum(context, src, checksum_type, 0, 0, source_checksum, sizeof(source_checksum), &nested_error);
         if (nested_error != NULL) {
@@ -314,6 +575,7 @@ int perform_local_copy(gfal2_context_t context, gfalt_params_t params,
         // Parent directory
         create_parent(context, params, dst, &nested_error);
         if (nested_error != NULL) {
+            gfal2_checksum_ctx_free(inline_checksum);
             gfal2_propagate_prefixed_error(error, nested_error, __func__);
             return -1;
         }
@@ -322,6 +584,7 @@ int perform_local_copy(gfal2_context_t context, gfalt_params_t params,
         if (!is_strict_mode) {
             unlink_if_exists(context, params, dst, &nested_error);
             if (nested_error != NULL) {
+                gfal2_checksum_ctx_free(inline_checksum);
                 gfal2_propagate_prefixed_error(error, nested_error, __func__);
                 return -1;
             }
@@ -329,12 +592,32 @@ int perform_local_copy(gfal2_context_t context, gfalt_params_t params,
     }
 
     // Do the transfer
-    streamed_copy(context, params, src, dst, &nested_error);
+    streamed_copy(context, params, src, dst, inline_checksum, &nested_error);
     if (nested_error != NULL) {
+        gfal2_checksum_ctx_free(inline_checksum);
         gfal2_propagate_prefixed_error(error, nested_error, __func__);
         return -1;
     }
 
+    if (inline_checksum) {
+        int ret = gfal2_checksum_ctx_final(inline_checksum, source_checksum, sizeof(source_checksum));
+        gfal2_checksum_ctx_free(inline_checksum);
+        if (ret < 0) {
+            gfalt_set_error(error, local_copy_domain(), ENOBUFS, __func__,
+                GFALT_ERROR_TRANSFER, GFALT_ERROR_CHECKSUM, "Buffer too short for the inline checksum");
+            return -1;
+        }
+        gfal2_log(G_LOG_LEVEL_DEBUG, "Inline %s checksum: %s", checksum_type, source_checksum);
+
+        if (user_checksum[0] && gfal_compare_checksums(user_checksum, source_checksum, 1024) != 0) {
+            gfalt_set_error(error, local_copy_domain(), EIO, __func__,
+                    GFALT_ERROR_TRANSFER, GFALT_ERROR_CHECKSUM_MISMATCH,
+                    "Transferred data checksum and user-specified checksum do not match: %s != %s",
+                    source_checksum, user_checksum);
+            return -1;
+        }
+    }
+
     // Destination checksum
     char *compare_against = user_checksum;
     char *compare_side = "User defined";
@@ -442,7 +442,9 @@ gint gfalt_get_user_defined_checksum(gfalt_params_t params, gchar* chktype_buff,
 gint gfalt_set_checksum(gfalt_params_t params, gfalt_checksum_mode_t mode,
     const gchar* type, const gchar *checksum, GError **err)
 {
-    if ((mode == GFALT_CHECKSUM_SOURCE || mode == GFALT_CHECKSUM_TARGET) && (checksum == NULL || checksum[0] == '\0')) {
+    const gboolean end_to_end = (mode & GFALT_CHECKSUM_TARGET) &&
+        (mode & (GFALT_CHECKSUM_SOURCE | GFALT_CHECKSUM_INLINE));
+    if (mode != GFALT_CHECKSUM_NONE && !end_to_end && (checksum == NULL || checksum[0] == '\0')) {
         gfal2_set_error(err, gfal2_get_core_quark(), EINVAL, __func__,
             "Checksum value required if mode is not end to end");
         return -1;
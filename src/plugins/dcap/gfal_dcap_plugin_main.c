@@ -62,6 +62,10 @@ const char* gfal_dcap_getName()
 }
 
 
+// URL schemes handled by this plugin
+static const char* const dcap_schemes[] = {"dcap", "gsidcap", NULL};
+
+
 /*
  * Init function, called before all
  * */
@@ -84,6 +88,7 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError** err)
     dcap_plugin.pwriteG = &gfal_dcap_pwriteG;
     dcap_plugin.lseekG = &gfal_dcap_lseekG;
     dcap_plugin.check_plugin_url = &gfal_dcap_check_url;
+    dcap_plugin.url_schemes = dcap_schemes;
     dcap_plugin.statG = &gfal_dcap_statG;
     dcap_plugin.lstatG = &gfal_dcap_lstatG;
     dcap_plugin.mkdirpG = &gfal_dcap_mkdirG;
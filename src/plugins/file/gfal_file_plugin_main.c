@@ -18,11 +18,13 @@
  * limitations under the License.
  */
 
+#include <limits.h>
 #include <regex.h>
 #include <unistd.h>
 #include <stdio.h>
 #include <string.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <fcntl.h>
 #include <glib.h>
 #include <errno.h>
@@ -35,21 +37,11 @@
 #include <attr/xattr.h>
 #endif
 #endif
-#include <zlib.h>
 
 #include <gfal_plugins_api.h>
-#include <checksums/checksums.h>
 #include <uri/gfal2_uri.h>
 #include <future/glib.h>
 
-typedef struct _chksum_interface{
-    // init checksum handle
-    void*  (*init)(void);
-    // compute checksum chunk
-    ssize_t (*update)(void* chk_handler, const char* buffer, size_t s_size);
-    // return checksum result : > 0 -> success, -1 : buffer to short
-    int (*getResult)(void* chk_handler, char* buffer, size_t s_b);
-} Chksum_interface;
 
 
 static const int FILE_PREFIX_LEN = 7; // file://
@@ -302,6 +294,58 @@ ssize_t gfal_plugin_file_pread(plugin_handle plugin_data, gfal_file_handle fh, v
     return ret;
 }
 
+// Read a run of contiguous ranges starting at offset, from byte done on, until the end of the file
+static ssize_t gfal_plugin_file_pread_run(int fd, const struct iovec *iov, int n, off_t offset, size_t done)
+{
+    int i = 0;
+    size_t skip = done;
+    while (i < n) {
+        if (skip >= iov[i].iov_len) {
+            skip -= iov[i].iov_len;
+            ++i;
+            continue;
+        }
+        const ssize_t ret = pread(fd, (char*)iov[i].iov_base + skip, iov[i].iov_len - skip, offset + done);
+        if (ret < 0)
+            return -1;
+        if (ret == 0)
+            break;
+        done += ret;
+        skip += ret;
+    }
+    return done;
+}
+
+// Contiguous ranges are read with a single preadv
+ssize_t gfal_plugin_file_preadv(plugin_handle plugin_data, gfal_file_handle fh, const struct iovec *iov,
+    const off_t *offsets, int count, GError **err)
+{
+    const int fd = GPOINTER_TO_INT(gfal_file_handle_get_fdesc(fh));
+    ssize_t total = 0;
+    int first = 0;
+
+    while (first < count) {
+        int n = 1;
+        size_t run_size = iov[first].iov_len;
+        while (first + n < count && n < IOV_MAX && offsets[first + n] == offsets[first] + (off_t)run_size) {
+            run_size += iov[first + n].iov_len;
+            ++n;
+        }
+
+        errno = 0;
+        ssize_t ret = preadv(fd, iov + first, n, offsets[first]);
+        if (ret >= 0 && (size_t)ret < run_size)
+            ret = gfal_plugin_file_pread_run(fd, iov + first, n, offsets[first], ret);
+        if (ret < 0) {
+            gfal_plugin_file_report_error(__func__, err);
+            return -1;
+        }
+        total += ret;
+        first += n;
+    }
+    return total;
+}
+
 off_t gfal_plugin_file_lseek(plugin_handle plugin_data, gfal_file_handle fh, off_t offset, int whence, GError **err)
 {
     errno = 0;
@@ -397,171 +441,27 @@ int gfal_plugin_file_symlink(plugin_handle plugin_data, const char *oldpath, con
 }
 
 
-// checksum wrapper
-
-static void *adler_init()
-{
-    unsigned long *lp = malloc(sizeof(unsigned long));
-    *lp = adler32(0L, Z_NULL, 0);
-    return (void *) lp;
-}
-
-static ssize_t adler32_update(void *chk_handler, const char *buffer, size_t s)
-{
-    unsigned long *lp = (unsigned long *) chk_handler;
-    *lp = adler32(*lp, (const Bytef *) buffer, (uInt) s);
-    return (ssize_t) s;
-}
-
-static int adler32_getResult(void *chk_handler, char *resu, size_t s_b)
-{
-    unsigned long *lp = (unsigned long *) chk_handler;
-    snprintf(resu, s_b, "%08lx", *lp);
-    free(lp);
-    return 0;
-}
-
-static void *crc32_init()
-{
-    unsigned long *lp = malloc(sizeof(unsigned long));
-    *lp = crc32(0L, Z_NULL, 0);
-    return (void *) lp;
-}
-
-static ssize_t crc32_update(void *chk_handler, const char *buffer, size_t s)
-{
-    unsigned long *lp = (unsigned long *) chk_handler;
-    *lp = crc32(*lp, (const Bytef *) buffer, s);
-    return (ssize_t) s;
-}
-
-static int crc32_getResult(void *chk_handler, char *resu, size_t s_b)
-{
-    unsigned long *lp = (unsigned long *) chk_handler;
-    snprintf(resu, s_b, "%ld", *lp);
-    free(lp);
-    return 0;
-}
-
-
-static void *md5_init()
-{
-    GFAL_MD5_CTX *ctx = (GFAL_MD5_CTX *) malloc(sizeof(GFAL_MD5_CTX));
-    gfal2_md5_init(ctx);
-    return (void *) ctx;
-}
-
-static ssize_t md5_update(void *chk_handler, const char *buffer, size_t s)
-{
-    GFAL_MD5_CTX *ctx = (GFAL_MD5_CTX *) chk_handler;
-    gfal2_md5_update(ctx, buffer, (unsigned long) s);
-    return (ssize_t) s;
-}
-
-static int md5_getResult(void *chk_handler, char *resu, size_t s_b)
-{
-    GFAL_MD5_CTX *ctx = (GFAL_MD5_CTX *) chk_handler;
-    unsigned char buffer[16];
-    if (s_b < 33) // buffer to short
-        return -1;
-    gfal2_md5_final(buffer, ctx);
-    gfal2_md5_to_hex_string(buffer, resu, sizeof(buffer));
-    free(ctx);
-    return 0;
-}
-
-
 // checksum implem
 
-static int gfal_plugin_file_chk_compute(plugin_handle data, const char *url, const char *check_type,
+int gfal_plugin_filechecksum_calc(plugin_handle data, const char *url, const char *check_type,
     char *checksum_buffer, size_t buffer_length,
     off_t start_offset, size_t data_length,
-    Chksum_interface *i_chk,
     GError **err)
 {
     GError *tmp_err = NULL;
-    const ssize_t chunk_size = 2 << 20;
-    gfal2_context_t handle = (gfal2_context_t) data;
-    int fd;
-    ssize_t ret = 0, remain_bytes = ((data_length > 0) ? (data_length) : (chunk_size));
-
-    if ((fd = gfal2_open(handle, url, O_RDONLY, &tmp_err)) < 0) {
-        g_prefix_error(err, "Error during checksum calculation, open ");
-        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
-        return -1;
-    }
-
-    if (gfal2_lseek(handle, fd, start_offset, SEEK_SET, &tmp_err) < 0) {
-        g_prefix_error(err, "Error during checksum calculation, lseek ");
-        gfal2_propagate_prefixed_error(err, tmp_err, __func__);
-        return -1;
-    }
-
-    void *c_handle = i_chk->init();
-    char *buffer = malloc(chunk_size);
-    do {
-        ret = gfal2_read(handle, fd, buffer, MIN(chunk_size, remain_bytes),  &tmp_err);
-        if (data_length > 0) {
-            remain_bytes -= ret;
-        }
-        if (ret > 0) {
-            i_chk->update(c_handle, buffer, ret);
-        }
-    } while (ret > 0 && remain_bytes > 0);
-    free(buffer);
-    gfal2_close(handle, fd, NULL);
-
-    if (i_chk->getResult(c_handle, checksum_buffer, buffer_length) < 0) {
-        gfal2_set_error(err, gfal2_get_plugin_file_quark(), ENOBUFS, __func__, "buffer for checksum too short");
-        return -1;
-    }
-
-
+    int ret = gfal2_checksum_compute((gfal2_context_t) data, url, check_type,
+        start_offset, data_length, checksum_buffer, buffer_length, &tmp_err);
     if (ret < 0) {
         gfal2_set_error(err, gfal2_get_plugin_file_quark(), tmp_err->code, __func__,
-            "Error during checksum calculation, read: %s", tmp_err->message);
+            "Error during checksum calculation: %s", tmp_err->message);
         g_error_free(tmp_err);
-        return -1;
     }
-    return 0;
+    return ret;
 }
 
 
-int gfal_plugin_filechecksum_calc(plugin_handle data, const char *url, const char *check_type,
-    char *checksum_buffer, size_t buffer_length,
-    off_t start_offset, size_t data_length,
-    GError **err)
-{
-    if (strcasecmp(check_type, "adler32") == 0) {
-        Chksum_interface ie = {.init = &adler_init,
-            .update = &adler32_update,
-            .getResult = &adler32_getResult};
-
-        return gfal_plugin_file_chk_compute(data, url, check_type, checksum_buffer,
-            buffer_length, start_offset, data_length,
-            &ie,
-            err);
-    } else if (strcasecmp(check_type, "crc32") == 0) {
-        Chksum_interface ie = {.init = &crc32_init,
-            .update = &crc32_update,
-            .getResult = &crc32_getResult};
-        return gfal_plugin_file_chk_compute(data, url, check_type, checksum_buffer,
-            buffer_length, start_offset, data_length,
-            &ie,
-            err);
-    } else if (strcasecmp(check_type, "md5") == 0) {
-        Chksum_interface ie = {.init = &md5_init,
-            .update = &md5_update,
-            .getResult = &md5_getResult};
-        return gfal_plugin_file_chk_compute(data, url, check_type, checksum_buffer,
-            buffer_length, start_offset, data_length,
-            &ie,
-            err);
-    }
-    gfal2_set_error(err, gfal2_get_plugin_file_quark(), ENOSYS, __func__,
-        "Checksum type %s not supported for local files", check_type);
-    return -1;
-}
+// URL schemes handled by this plugin
+static const char* const file_schemes[] = {"file", NULL};
 
 
 /*
@@ -574,6 +474,7 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError **err)
 
     file_plugin.plugin_data = handle;
     file_plugin.check_plugin_url = &gfal_file_check_url;
+    file_plugin.url_schemes = file_schemes;
     file_plugin.getName = &gfal_file_plugin_getName;
     file_plugin.plugin_delete = NULL;
     file_plugin.accessG = &gfal_plugin_file_access;
@@ -593,6 +494,7 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError **err)
     file_plugin.closeG = &gfal_plugin_file_close;
     file_plugin.readG = &gfal_plugin_file_read;
     file_plugin.preadG = &gfal_plugin_file_pread;
+    file_plugin.preadvG = &gfal_plugin_file_preadv;
     file_plugin.writeG = &gfal_plugin_file_write;
     file_plugin.pwriteG = &gfal_plugin_file_pwrite;
     file_plugin.chmodG = &gfal_plugin_file_chmod;
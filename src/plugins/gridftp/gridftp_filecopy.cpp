@@ -144,8 +144,7 @@ static std::string resolve_dns_helper(const char* host_uri, const char* msg)
 
         if (resolved) {
             gfal2_log(G_LOG_LEVEL_INFO, "%s: %s => %s", msg, parsed->host, resolved);
-            g_free(parsed->host);
-            parsed->host = resolved;
+            gfal2_uri_replace(parsed, &parsed->host, resolved);
             resolved_str = gfal2_join_uri(parsed);
             gfal2_free_uri(parsed);
         }
@@ -124,6 +124,10 @@ const char *gridftp_plugin_name()
 }
 
 
+// URL schemes handled by this plugin
+static const char* const gridftp_schemes[] = {"gsiftp", "ftp", NULL};
+
+
 /**
  * Map function for the gridftp interface
  * this function provide the generic PLUGIN interface for the gridftp plugin.
@@ -137,6 +141,7 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError** err)
 
     ret.plugin_data = r;
     ret.check_plugin_url = &gridftp_check_url;
+    ret.url_schemes = gridftp_schemes;
     ret.plugin_delete = &gridftp_plugin_unload;
     ret.getName = &gridftp_plugin_name;
     ret.accessG = &gfal_gridftp_accessG;
@@ -25,8 +25,10 @@
 #include <cstring>
 #include <sstream>
 #include <list>
+#include <functional>
 #include <davix.hpp>
 #include <errno.h>
+#include <sys/stat.h>
 #include <json.h>
 #include <davix/utils/davix_gcloud_utils.hpp>
 #include <exceptions/gfalcoreexception.hpp>
@@ -125,9 +127,27 @@ static bool gfal_http_get_x509_cert_pair(gfal2_context_t handle, const Davix::Ur
     return certificate_pair;
 }
 
+// Identity of a credential file, changes when the file is replaced or written
+static std::string file_stamp(const std::string& path)
+{
+    struct stat st;
+    char stamp[128];
+
+    if (stat(path.c_str(), &st) != 0) {
+        return "-;";
+    }
+#ifdef __APPLE__
+    const struct timespec& mtime = st.st_mtimespec;
+#else
+    const struct timespec& mtime = st.st_mtim;
+#endif
+    snprintf(stamp, sizeof(stamp), "%lu:%lu:%lld:%lld.%ld;", (unsigned long) st.st_dev, (unsigned long) st.st_ino,
+             (long long) st.st_size, (long long) mtime.tv_sec, (long) mtime.tv_nsec);
+    return stamp;
+}
+
 char* GfalHttpPluginData::find_se_token(const Davix::Uri& uri, const OP& operation)
 {
-    using credTuple = std::pair<std::string, std::string>;
     bool write_access = writeFlagFromOperation(operation);
     bool extended_search = searchFlagFromOperation(operation);
 
@@ -151,38 +171,30 @@ char* GfalHttpPluginData::find_se_token(const Davix::Uri& uri, const OP& operati
         return false;
     };
 
-    // Helper function to extract all credentials of type "BEARER"
-    auto cred_map_callback = [](const char* url_prefix, const gfal2_cred_t* cred, void* user_data) {
-        auto cred_list = static_cast<std::list<credTuple>*>(user_data);
-
-        if (strcmp(cred->type, GFAL_CRED_BEARER) == 0) {
-            cred_list->emplace_back(url_prefix, cred->value);
-        }
+    // Helper function to pick the first credential of type "BEARER" with the needed access
+    struct TokenSearch {
+        std::function<bool(const char*, const char*, bool)> accept;
+        bool write_access;
+        char* token;
     };
 
-    // Helper function to check whether a path contains the search path
-    auto path_contains = [](const std::string& path, const std::string& search) -> bool {
-        size_t pos = path.find(search);
+    auto cred_match_callback = [](const char* url_prefix, const gfal2_cred_t* cred, void* user_data) -> gboolean {
+        auto search = static_cast<TokenSearch*>(user_data);
 
-        if (pos == 0) {
-            return (path.size() == search.size()) ||
-                   (path.at(search.size() - 1) == '/') ||
-                   (path.at(search.size()) == '/');
+        if (search->accept(cred->value, url_prefix, search->write_access)) {
+            search->token = g_strdup(cred->value);
+            return TRUE;
         }
-
-        return false;
+        return FALSE;
     };
 
-    std::list<credTuple> cred_list;
-    gfal2_cred_foreach(handle, cred_map_callback, &cred_list);
+    // Tokens set for the url or its parents, and for the paths below it on extended search
+    TokenSearch search = {find_in_token_map, write_access, NULL};
+    gfal2_cred_foreach_match(handle, GFAL_CRED_BEARER, uri.getString().c_str(), extended_search,
+                             cred_match_callback, &search);
 
-    for (auto cred = cred_list.begin(); cred != cred_list.end(); cred++) {
-        if (path_contains(uri.getString(), cred->first) ||
-            (extended_search && path_contains(cred->first, uri.getString()))) {
-            if (find_in_token_map(cred->second.c_str(), cred->first.c_str(), write_access)) {
-                return g_strdup(cred->second.c_str());
-            }
-        }
+    if (search.token) {
+        return search.token;
     }
 
     // Search token for the full host (backwards compatibility with FTS)
@@ -195,7 +207,7 @@ char* GfalHttpPluginData::find_se_token(const Davix::Uri& uri, const OP& operati
 
 char* GfalHttpPluginData::retrieve_and_store_se_token(const Davix::Uri& uri, const OP& operation, unsigned validity)
 {
-    bool retrieve_token = gfal2_get_opt_boolean_with_default(handle, "HTTP PLUGIN", "RETRIEVE_BEARER_TOKEN", false);
+    bool retrieve_token = gfal2_opt_get_boolean(handle, opts.retrieve_bearer_token, false);
     GError* error = NULL;
     char* token = NULL;
 
@@ -406,11 +418,10 @@ std::string gfal_http_discover_tape_endpoint(GfalHttpPluginData* davix, const ch
     return tape_endpoint.str();
 }
 
-bool GfalHttpPluginData::get_token(Davix::RequestParams& params, const Davix::Uri& uri,
-                                   const OP& operation, unsigned validity)
+char* GfalHttpPluginData::get_token(const Davix::Uri& uri, const OP& operation, unsigned validity)
 {
     if (isS3SignedURL(uri)) {
-	    return false;
+	    return NULL;
     }
 
     gchar* token = find_se_token(uri, operation);
@@ -420,10 +431,11 @@ bool GfalHttpPluginData::get_token(Davix::RequestParams& params, const Davix::Ur
         token = retrieve_and_store_se_token(uri, operation, validity);
     }
 
-    if (!token) {
-        return false;
-    }
+    return token;
+}
 
+void GfalHttpPluginData::set_token(Davix::RequestParams& params, const std::string& token, const OP& operation)
+{
     std::stringstream ss;
     ss << "Bearer " << token;
 
@@ -437,29 +449,30 @@ bool GfalHttpPluginData::get_token(Davix::RequestParams& params, const Davix::Ur
     } else {
         params.addHeader("Authorization", ss.str());
     }
-
-    g_free(token);
-    return true;
 }
 
 void GfalHttpPluginData::get_certificate(Davix::RequestParams& params, const Davix::Uri& uri)
 {
-    DavixError* daverr = NULL;
     std::string cert, key;
 
-    bool certificate_pair = gfal_http_get_x509_cert_pair(handle, uri, cert, key);
+    if (gfal_http_get_x509_cert_pair(handle, uri, cert, key)) {
+        set_certificate(params, cert, key);
+    }
+}
+
+void GfalHttpPluginData::set_certificate(Davix::RequestParams& params, const std::string& cert, const std::string& key)
+{
+    DavixError* daverr = NULL;
 
-    if (certificate_pair) {
-        gfal2_log(G_LOG_LEVEL_DEBUG, "Using client X509 for HTTPS session authorization");
+    gfal2_log(G_LOG_LEVEL_DEBUG, "Using client X509 for HTTPS session authorization");
 
-        X509Credential cred;
-        if (cred.loadFromFilePEM(key, cert, "", &daverr) < 0 ) {
-            gfal2_log(G_LOG_LEVEL_WARNING, "Could not load the user credentials: %s",
-                      daverr->getErrMsg().c_str());
-            DavixError::clearError(&daverr);
-        } else {
-            params.setClientCertX509(cred);
-        }
+    X509Credential cred;
+    if (cred.loadFromFilePEM(key, cert, "", &daverr) < 0 ) {
+        gfal2_log(G_LOG_LEVEL_WARNING, "Could not load the user credentials: %s",
+                  daverr->getErrMsg().c_str());
+        DavixError::clearError(&daverr);
+    } else {
+        params.setClientCertX509(cred);
     }
 }
 
@@ -652,11 +665,43 @@ void GfalHttpPluginData::get_reva_credentials(Davix::RequestParams &params, cons
 
 void GfalHttpPluginData::get_credentials(Davix::RequestParams& params, const Davix::Uri& uri,
                                          const OP& operation, unsigned token_validity)
+{
+    set_credentials(params, uri, operation, find_credentials(uri, operation, token_validity));
+}
+
+GfalHttpPluginData::RequestCredentials GfalHttpPluginData::find_credentials(const Davix::Uri& uri,
+                                                                            const OP& operation,
+                                                                            unsigned token_validity)
+{
+    RequestCredentials credentials;
+
+    credentials.has_cert = gfal_http_get_x509_cert_pair(handle, uri, credentials.cert, credentials.key);
+    if (credentials.has_cert) {
+        credentials.cert_stamp = file_stamp(credentials.cert) + file_stamp(credentials.key);
+    }
+
+    // Bearer tokens are not used with an explicit request for a cloud storage
+    if (!isCloudStorage(uri)) {
+        char* token = get_token(uri, operation, token_validity);
+        if (token) {
+            credentials.has_token = true;
+            credentials.token = token;
+            g_free(token);
+        }
+    }
+
+    return credentials;
+}
+
+void GfalHttpPluginData::set_credentials(Davix::RequestParams& params, const Davix::Uri& uri,
+                                         const OP& operation, const RequestCredentials& credentials)
 {
     // Setup GSI in case the storage endpoint tries to fall back to GridSite delegation.
     // That does mean that we might contact the endpoint with both X509 and token auth,
     // but seems to be an acceptable compromise
-    get_certificate(params, uri);
+    if (credentials.has_cert) {
+        set_certificate(params, credentials.cert, credentials.key);
+    }
 
     // Explicit request for S3 or GCloud
     if (uri.getProtocol().compare(0, 2, "s3") == 0) {
@@ -669,7 +714,9 @@ void GfalHttpPluginData::get_credentials(Davix::RequestParams& params, const Dav
         get_reva_credentials(params, uri, operation);
     } // Use bearer token (other authentication mechanism should be disabled)
       // Not the case for the moment, as certificates are still used (but should be unset in the future)
-    else if (!get_token(params, uri, operation, token_validity)) {
+    else if (credentials.has_token) {
+        set_token(params, credentials.token, operation);
+    } else {
         // Utilize AWS or GCLOUD tokens if no bearer token is available (to be reviewed)
         get_aws_params(params, uri);
         get_gcloud_credentials(params,uri);
@@ -677,6 +724,23 @@ void GfalHttpPluginData::get_credentials(Davix::RequestParams& params, const Dav
     }
 }
 
+void GfalHttpPluginData::set_davix_log_level()
+{
+    int davix_level = gfal2_opt_get_integer(handle, opts.log_level, 0);
+
+    if (!davix_level)
+        davix_level = get_corresponding_davix_log_level();
+
+    davix_set_log_level(davix_level);
+
+    // Reset sensitive scope mask
+    int davix_scope_mask = Davix::getLogScope() & ~(DAVIX_LOG_SSL | DAVIX_LOG_SENSITIVE);
+    if (gfal2_opt_get_boolean(handle, opts.log_sensitive, false)) {
+        davix_scope_mask |= (DAVIX_LOG_SSL | DAVIX_LOG_SENSITIVE);
+    }
+    Davix::setLogScope(davix_scope_mask);
+}
+
 void GfalHttpPluginData::get_params_internal(Davix::RequestParams& params, const Davix::Uri& uri)
 {
     if (uri.getProtocol().compare(0, 4, "http") == 0) {
@@ -696,13 +760,13 @@ void GfalHttpPluginData::get_params_internal(Davix::RequestParams& params, const
     }
 
     // Insecure flag
-    gboolean insecure_mode = gfal2_get_opt_boolean_with_default(handle, "HTTP PLUGIN", "INSECURE", FALSE);
+    gboolean insecure_mode = gfal2_opt_get_boolean(handle, opts.insecure, FALSE);
     if (insecure_mode) {
         params.setSSLCAcheck(false);
     }
 
     // Metalink mode
-    gboolean metalink = gfal2_get_opt_boolean_with_default(handle, "HTTP PLUGIN", "METALINK", FALSE);
+    gboolean metalink = gfal2_opt_get_boolean(handle, opts.metalink, FALSE);
     params.setMetalinkMode((metalink) ? Davix::MetalinkMode::Auto : Davix::MetalinkMode::Disable);
 
     if (isCloudStorage(uri)) {
@@ -710,23 +774,11 @@ void GfalHttpPluginData::get_params_internal(Davix::RequestParams& params, const
     }
 
     // Keep alive
-    gboolean keep_alive = gfal2_get_opt_boolean_with_default(handle, "HTTP PLUGIN", "KEEP_ALIVE", TRUE);
+    gboolean keep_alive = gfal2_opt_get_boolean(handle, opts.keep_alive, TRUE);
     params.setKeepAlive(keep_alive);
 
     // Reset here the verbosity level
-    int davix_level = gfal2_get_opt_integer_with_default(handle, "HTTP PLUGIN", "LOG_LEVEL", 0);
-
-    if (!davix_level)
-        davix_level = get_corresponding_davix_log_level();
-
-    davix_set_log_level(davix_level);
-
-    // Reset sensitive scope mask
-    int davix_scope_mask = Davix::getLogScope() & ~(DAVIX_LOG_SSL | DAVIX_LOG_SENSITIVE);
-    if (gfal2_get_opt_boolean_with_default(handle, "HTTP PLUGIN", "LOG_SENSITIVE", false)) {
-        davix_scope_mask |= (DAVIX_LOG_SSL | DAVIX_LOG_SENSITIVE);
-    }
-    Davix::setLogScope(davix_scope_mask);
+    set_davix_log_level();
 
     // Avoid retries
     params.setOperationRetry(0);
@@ -750,24 +802,40 @@ void GfalHttpPluginData::get_params_internal(Davix::RequestParams& params, const
     g_free(client_info);
 
     // Custom headers
-    gsize headers_length = 0;
-    char **headers = gfal2_get_opt_string_list_with_default(handle, "HTTP PLUGIN", "HEADERS", &headers_length, NULL);
-    if (headers) {
-        for (char **hi = headers; *hi != NULL; ++hi) {
-            char **kv = g_strsplit(*hi, ":", 2);
-            g_strstrip(kv[0]);
-            g_strstrip(kv[1]);
-            params.addHeader(kv[0], kv[1]);
-            g_strfreev(kv);
-        }
-        g_strfreev(headers);
-    }
+    get_custom_headers(params);
 
     // Operation timeout
     struct timespec opTimeout{get_operation_timeout()};
     params.setOperationTimeout(&opTimeout);
 }
 
+void GfalHttpPluginData::get_custom_headers(Davix::RequestParams& params)
+{
+    std::lock_guard<std::mutex> lock(custom_headers_mutex);
+
+    // Only split again after the configuration changed
+    guint generation = gfal2_get_opt_generation(handle);
+    if (custom_headers_generation != generation) {
+        custom_headers.clear();
+        char **headers = gfal2_opt_get_string_list(handle, opts.headers, NULL, NULL);
+        if (headers) {
+            for (char **hi = headers; *hi != NULL; ++hi) {
+                char **kv = g_strsplit(*hi, ":", 2);
+                if (kv[0] && kv[1]) {
+                    custom_headers.emplace_back(g_strstrip(kv[0]), g_strstrip(kv[1]));
+                }
+                g_strfreev(kv);
+            }
+            g_strfreev(headers);
+        }
+        custom_headers_generation = generation;
+    }
+
+    for (HeaderVec::const_iterator header = custom_headers.begin(); header != custom_headers.end(); ++header) {
+        params.addHeader(header->first, header->second);
+    }
+}
+
 void GfalHttpPluginData::get_tpc_params(Davix::RequestParams* req_params,
                                         const Davix::Uri& src_uri,
                                         const Davix::Uri& dst_uri,
@@ -821,17 +889,55 @@ void GfalHttpPluginData::get_tpc_params(Davix::RequestParams* req_params,
 void GfalHttpPluginData::get_params(Davix::RequestParams* req_params, const Davix::Uri& uri,
                                     const OP& operation)
 {
-    *req_params = reference_params;
+    // Taken before looking for the credentials, which may store a retrieved token
+    guint config_generation = gfal2_get_opt_generation(handle);
+    guint cred_generation = gfal2_cred_get_generation(handle);
+
+    set_davix_log_level();
+
+    // Everything else only depends on the endpoint, the operation and the credentials
+    RequestCredentials credentials = find_credentials(uri, operation);
+
+    std::ostringstream key;
+    key << uri.getProtocol() << "://" << uri.getHost() << ":" << uri.getPort() << "\n"
+        << static_cast<int>(operation) << "\n"
+        << credentials.cert << "\n" << credentials.key << "\n" << credentials.cert_stamp << "\n"
+        << (credentials.has_token ? "+" : "-") << credentials.token;
+
+    {
+        std::lock_guard<std::mutex> lock(params_cache_mutex);
+        if (params_cache_config_generation != config_generation || params_cache_cred_generation != cred_generation) {
+            params_cache.clear();
+            params_cache_config_generation = config_generation;
+            params_cache_cred_generation = cred_generation;
+        }
+
+        RequestParamsCache::const_iterator cached = params_cache.find(key.str());
+        if (cached != params_cache.end()) {
+            *req_params = cached->second;
+            return;
+        }
+    }
 
+    *req_params = reference_params;
     get_params_internal(*req_params, uri);
-    get_credentials(*req_params, uri, operation);
+    set_credentials(*req_params, uri, operation, credentials);
+
+    std::lock_guard<std::mutex> lock(params_cache_mutex);
+    // Parameters built while the configuration changed are not kept
+    if (params_cache_config_generation == config_generation && params_cache_cred_generation == cred_generation &&
+        gfal2_get_opt_generation(handle) == config_generation && gfal2_cred_get_generation(handle) == cred_generation) {
+        if (params_cache.size() >= HTTP_PARAMS_CACHE_MAX_ENTRIES) {
+            params_cache.clear();
+        }
+        params_cache.emplace(key.str(), *req_params);
+    }
 }
 
 int GfalHttpPluginData::get_operation_timeout() const
 {
-    int global_timeout = gfal2_get_opt_integer_with_default(handle, CORE_CONFIG_GROUP,
-                                                            CORE_CONFIG_NAMESPACE_TIMEOUT, 300);
-    return gfal2_get_opt_integer_with_default(handle, "HTTP PLUGIN", HTTP_CONFIG_OP_TIMEOUT, global_timeout);
+    int global_timeout = gfal2_opt_get_integer(handle, opts.namespace_timeout, 300);
+    return gfal2_opt_get_integer(handle, opts.operation_timeout, global_timeout);
 }
 
 void GfalHttpPluginData::set_operation_timeout(int timeout)
@@ -860,10 +966,21 @@ static void log_davix2gfal(void* userdata, int msg_level, const char* msg)
 
 GfalHttpPluginData::GfalHttpPluginData(gfal2_context_t handle):
     context(), posix(&context), handle(handle), reference_params(),
-    token_map(), tape_endpoint_map()
+    token_map(), tape_endpoint_map(), custom_headers(), custom_headers_generation(-1),
+    params_cache(), params_cache_config_generation(0), params_cache_cred_generation(0)
 {
+    opts.insecure = gfal2_register_opt("HTTP PLUGIN", "INSECURE", GFAL_OPT_BOOLEAN);
+    opts.metalink = gfal2_register_opt("HTTP PLUGIN", "METALINK", GFAL_OPT_BOOLEAN);
+    opts.keep_alive = gfal2_register_opt("HTTP PLUGIN", "KEEP_ALIVE", GFAL_OPT_BOOLEAN);
+    opts.log_level = gfal2_register_opt("HTTP PLUGIN", "LOG_LEVEL", GFAL_OPT_INTEGER);
+    opts.log_sensitive = gfal2_register_opt("HTTP PLUGIN", "LOG_SENSITIVE", GFAL_OPT_BOOLEAN);
+    opts.headers = gfal2_register_opt("HTTP PLUGIN", "HEADERS", GFAL_OPT_STRING_LIST);
+    opts.operation_timeout = gfal2_register_opt("HTTP PLUGIN", HTTP_CONFIG_OP_TIMEOUT, GFAL_OPT_INTEGER);
+    opts.namespace_timeout = gfal2_register_opt(CORE_CONFIG_GROUP, CORE_CONFIG_NAMESPACE_TIMEOUT, GFAL_OPT_INTEGER);
+    opts.retrieve_bearer_token = gfal2_register_opt("HTTP PLUGIN", "RETRIEVE_BEARER_TOKEN", GFAL_OPT_BOOLEAN);
+
     davix_set_log_handler(log_davix2gfal, NULL);
-    int davix_level = gfal2_get_opt_integer_with_default(handle, "HTTP PLUGIN", "LOG_LEVEL", 0);
+    int davix_level = gfal2_opt_get_integer(handle, opts.log_level, 0);
 
     if (!davix_level)
         davix_level = get_corresponding_davix_log_level();
@@ -1076,6 +1193,16 @@ void http2gliberr(GError** err, int http, const char* func, const char* msg)
 }
 
 
+// URL schemes handled by this plugin
+static const char* const http_schemes[] = {
+    "http", "https", "dav", "davs",
+    "s3", "s3s", "gcloud", "gclouds",
+    "swift", "swifts", "http+3rd", "https+3rd",
+    "dav+3rd", "davs+3rd", "cs3", "cs3s",
+    NULL
+};
+
+
 /// Init function
 extern "C" gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError** err)
 {
@@ -1086,6 +1213,7 @@ extern "C" gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError
 
     // Bind metadata
     http_plugin.check_plugin_url = &gfal_http_check_url;
+    http_plugin.url_schemes = http_schemes;
     http_plugin.getName = &gfal_http_get_name;
     http_plugin.priority = GFAL_PLUGIN_PRIORITY_DATA
     ;
@@ -1109,6 +1237,9 @@ extern "C" gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError
     http_plugin.writeG = &gfal_http_fwrite;
     http_plugin.lseekG = &gfal_http_fseek;
     http_plugin.closeG = &gfal_http_fclose;
+    http_plugin.preadG = &gfal_http_fpread;
+    http_plugin.pwriteG = &gfal_http_fpwrite;
+    http_plugin.preadvG = &gfal_http_fpreadvec;
 
     // Extended attributes
     http_plugin.getxattrG = &gfal_http_getxattrG;
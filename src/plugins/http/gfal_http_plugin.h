@@ -22,6 +22,9 @@
 #define _GFAL_HTTP_PLUGIN_H
 
 #include <map>
+#include <mutex>
+#include <unordered_map>
+#include <sys/uio.h>
 
 #include <gfal_plugins_api.h>
 #include <davix.hpp>
@@ -29,6 +32,8 @@
 #include "gfal_http_plugin_token.h"
 
 #define HTTP_CONFIG_OP_TIMEOUT     "OPERATION_TIMEOUT"
+// Request parameters kept by get_params, dropped all together when full
+#define HTTP_PARAMS_CACHE_MAX_ENTRIES 256
 
 class GfalHttpPluginData {
 public:
@@ -91,8 +96,19 @@ private:
         tape_endpoint_info() = default;
     } tape_endpoint_info_t;
 
+    /// Credentials found for a URL, the only part of the request parameters depending on its path
+    struct RequestCredentials {
+        bool has_cert = false;
+        std::string cert, key;
+        bool has_token = false;
+        std::string token;
+        /// identity of the certificate files, renewed proxies are loaded again
+        std::string cert_stamp;
+    };
+
     typedef std::map<std::string, bool> TokenAccessMap;
     typedef std::map<std::string, tape_endpoint_info_t> TapeEndpointMap;
+    typedef std::unordered_map<std::string, Davix::RequestParams> RequestParamsCache;
 
     /// baseline Davix Request Parameters
     Davix::RequestParams reference_params;
@@ -102,22 +118,54 @@ private:
     std::unique_ptr<TokenRetriever> token_retriever_chain;
     /// map a url with a tape endpoint info struct
     TapeEndpointMap tape_endpoint_map;
+    /// options read for every request
+    struct {
+        gfal2_opt_t insecure, metalink, keep_alive, log_level, log_sensitive, headers;
+        gfal2_opt_t operation_timeout, namespace_timeout, retrieve_bearer_token;
+    } opts;
+    /// HEADERS option, parsed for the configuration generation custom_headers_generation
+    Davix::HeaderVec custom_headers;
+    gint64 custom_headers_generation;
+    std::mutex custom_headers_mutex;
+    /// request parameters built by get_params, by endpoint, operation and credentials
+    /// valid for the configuration and credential generations they were built for
+    RequestParamsCache params_cache;
+    guint params_cache_config_generation, params_cache_cred_generation;
+    std::mutex params_cache_mutex;
 
     // Set up general request parameters
     void get_params_internal(Davix::RequestParams& params, const Davix::Uri& uri);
 
+    // Apply the log level and scope of the configuration to Davix
+    void set_davix_log_level();
+
+    // Add the headers of the HEADERS option
+    void get_custom_headers(Davix::RequestParams& params);
+
     // Obtain credentials for a given Uri and set those credentials in the Davix request parameters.
     // @param operation the HTTP operation to be performed
     // @param token_validity requested lifetime of the token in minutes
     void get_credentials(Davix::RequestParams& params, const Davix::Uri& uri,
                          const OP& operation, unsigned token_validity = 180);
 
+    // Find the certificate and token to use for a given Uri, retrieving a SE-issued token if allowed
+    // @param operation the HTTP operation to be performed
+    // @param token_validity requested lifetime of the token in minutes
+    RequestCredentials find_credentials(const Davix::Uri& uri, const OP& operation, unsigned token_validity = 180);
+
+    // Set the credentials found by find_credentials in the Davix request parameters
+    void set_credentials(Davix::RequestParams& params, const Davix::Uri& uri,
+                         const OP& operation, const RequestCredentials& credentials);
+
     // Obtain token credentials
     // @param operation the HTTP operation to be performed
     // @param validity requested lifetime of the token in seconds
-    // @return true if a bearer for the provided Uri was set in the request params
-    bool get_token(Davix::RequestParams& params, const Davix::Uri& uri,
-                   const OP& operation, unsigned validity);
+    // @return the token for the provided Uri, or null
+    char* get_token(const Davix::Uri& uri, const OP& operation, unsigned validity);
+
+    // Set a bearer token in the request params
+    // @param operation the HTTP operation to be performed
+    void set_token(Davix::RequestParams& params, const std::string& token, const OP& operation);
 
     // Find SE-issued token in the Gfal2 credential map based on the path.
     // The found token provides either an exact path match or a parent directory path.
@@ -150,6 +198,9 @@ private:
     // Obtain certificate credentials
     void get_certificate(Davix::RequestParams& params, const Davix::Uri& uri);
 
+    // Load a certificate pair in the request params
+    void set_certificate(Davix::RequestParams& params, const std::string& cert, const std::string& key);
+
     // Obtain request parameters + credentials for a Swift endpoint
     void get_swift_params(Davix::RequestParams &params, const Davix::Uri &uri);
 
@@ -191,6 +242,20 @@ void strip_3rd_from_url(const char* url_full, char* url, size_t url_size);
 std::string gfal_http_discover_tape_endpoint(GfalHttpPluginData* davix, const char* url, const char* method,
                                              GError** err);
 
+struct json_object;
+
+namespace tape_rest_api {
+    // Items of a Tape REST API response array, by path with collapsed slashes
+    typedef std::unordered_map<std::string, struct json_object*> PathIndex;
+
+    // Index the items of the response once, instead of searching it for each file
+    // When several items have the same path, the first one is kept
+    PathIndex index_items_by_path(struct json_object* items);
+
+    // Item of the path, or NULL if the response has none
+    struct json_object* get_item_by_path(const PathIndex& index, const std::string& path);
+}
+
 // METADATA OPERATIONS
 void gfal_http_delete(plugin_handle plugin_data);
 
@@ -225,6 +290,15 @@ int gfal_http_fclose(plugin_handle, gfal_file_handle fd, GError ** err);
 
 off_t gfal_http_fseek(plugin_handle, gfal_file_handle fd, off_t offset, int whence, GError** err);
 
+ssize_t gfal_http_fpread(plugin_handle, gfal_file_handle fd, void* buff, size_t count, off_t offset, GError** err);
+
+ssize_t gfal_http_fpwrite(plugin_handle, gfal_file_handle fd, const void* buff, size_t count, off_t offset,
+        GError** err);
+
+// Reads count ranges of iov[i].iov_len bytes at offsets[i], returns the total number of bytes read
+ssize_t gfal_http_fpreadvec(plugin_handle, gfal_file_handle fd, const struct iovec* iov, const off_t* offsets,
+        int count, GError** err);
+
 // Checksum
 int gfal_http_checksum(plugin_handle data, const char* url, const char* check_type,
                        char * checksum_buffer, size_t buffer_length,
@@ -19,6 +19,7 @@
  */
 
 #include <cstring>
+#include <vector>
 #include <glib.h>
 #include <unistd.h>
 #include "gfal_http_plugin.h"
@@ -27,6 +28,8 @@
 struct GfalHTTPFD {
     Davix::RequestParams req_params;
     DAVIX_FD* davix_fd;
+    // Uploads are sequential, so this is the only offset pwrite accepts
+    off_t write_offset;
 };
 
 
@@ -41,6 +44,7 @@ gfal_file_handle gfal_http_fopen(plugin_handle plugin_data, const char* url, int
     Davix::DavixError* daverr = NULL;
 
     GfalHTTPFD* fd = new GfalHTTPFD();
+    fd->write_offset = 0;
     GfalHttpPluginData::OP operation = (flag & O_WRONLY) ?
             GfalHttpPluginData::OP::WRITE : GfalHttpPluginData::OP::READ;
     davix->get_params(&fd->req_params, Davix::Uri(stripped_url), operation);
@@ -100,12 +104,82 @@ ssize_t gfal_http_fwrite(plugin_handle plugin_data, gfal_file_handle fd, const v
         davix2gliberr(daverr, err, __func__);
         Davix::DavixError::clearError(&daverr);
     }
+    else {
+        dfd->write_offset += writes;
+    }
 
     return writes;
 }
 
 
 
+ssize_t gfal_http_fpread(plugin_handle plugin_data, gfal_file_handle fd, void* buff, size_t count,
+        off_t offset, GError** err)
+{
+    GfalHttpPluginData* davix = gfal_http_get_plugin_context(plugin_data);
+    Davix::DavixError* daverr = NULL;
+    GfalHTTPFD* dfd = (GfalHTTPFD*) gfal_file_handle_get_fdesc(fd);
+
+    // Range request, independent of the position of the descriptor
+    ssize_t reads = davix->posix.pread64(dfd->davix_fd, buff, count, static_cast<dav_off_t>(offset), &daverr);
+    if (reads < 0) {
+        davix2gliberr(daverr, err, __func__);
+        Davix::DavixError::clearError(&daverr);
+    }
+
+    return reads;
+}
+
+
+
+ssize_t gfal_http_fpwrite(plugin_handle plugin_data, gfal_file_handle fd, const void* buff, size_t count,
+        off_t offset, GError** err)
+{
+    GfalHTTPFD* dfd = (GfalHTTPFD*) gfal_file_handle_get_fdesc(fd);
+
+    if (offset != dfd->write_offset) {
+        gfal2_set_error(err, http_plugin_domain, ENOTSUP, __func__,
+                "HTTP uploads are sequential, can not write at offset %lld (expected %lld)",
+                (long long) offset, (long long) dfd->write_offset);
+        return -1;
+    }
+    return gfal_http_fwrite(plugin_data, fd, buff, count, err);
+}
+
+
+
+ssize_t gfal_http_fpreadvec(plugin_handle plugin_data, gfal_file_handle fd, const struct iovec* iov,
+        const off_t* offsets, int count, GError** err)
+{
+    GfalHttpPluginData* davix = gfal_http_get_plugin_context(plugin_data);
+    Davix::DavixError* daverr = NULL;
+    GfalHTTPFD* dfd = (GfalHTTPFD*) gfal_file_handle_get_fdesc(fd);
+
+    if (count <= 0) {
+        return 0;
+    }
+
+    // Davix sends the ranges as multi-range GET requests, merging the contiguous ones
+    std::vector<Davix::DavIOVecInput> input(count);
+    std::vector<Davix::DavIOVecOuput> output(count);
+    for (int i = 0; i < count; ++i) {
+        input[i].diov_buffer = iov[i].iov_base;
+        input[i].diov_offset = static_cast<dav_off_t>(offsets[i]);
+        input[i].diov_size = iov[i].iov_len;
+    }
+
+    dav_ssize_t reads = davix->posix.preadVec(dfd->davix_fd, input.data(), output.data(), count, &daverr);
+    if (reads < 0) {
+        davix2gliberr(daverr, err, __func__);
+        Davix::DavixError::clearError(&daverr);
+        return -1;
+    }
+
+    return static_cast<ssize_t>(reads);
+}
+
+
+
 int gfal_http_fclose(plugin_handle plugin_data, gfal_file_handle fd, GError ** err)
 {
     GfalHttpPluginData* davix = gfal_http_get_plugin_context(plugin_data);
@@ -111,30 +111,35 @@ namespace tape_rest_api {
         g_error_free(tmp_err);
     }
 
-    // Run through the full response and identify the JSON item corresponding to our path
-    // Very inefficient O(N^2) complexity but avoids complicated data structures (tape polling is time permissive)
-    struct json_object* polling_get_item_by_path(struct json_object* response, const std::string& surl) {
-        const int len = json_object_array_length(response);
+    PathIndex index_items_by_path(struct json_object* items) {
+        PathIndex index;
+        if (items == NULL || !json_object_is_type(items, json_type_array)) {
+            return index;
+        }
+
+        const int len = json_object_array_length(items);
+        index.reserve(len);
+
         for (int i = 0; i < len; i++) {
-            auto item = json_object_array_get_idx(response, i);
+            auto item = json_object_array_get_idx(items, i);
 
             if (item != NULL) {
                 struct json_object* item_path = 0;
                 json_object_object_get_ex(item, "path", &item_path);
-                std::string path = item_path ? json_object_get_string(item_path) : "";
+                const char* path = item_path ? json_object_get_string(item_path) : NULL;
 
-                if (!path.empty()) {
-                    std::string cpath = collapse_slashes(path);
-                    std::string csurl = collapse_slashes(surl);
-
-                    if (cpath == csurl) {
-                        return item;
-                    }
+                if (path != NULL && path[0] != '\0') {
+                    index.emplace(collapse_slashes(path), item);
                 }
             }
         }
 
-        return NULL;
+        return index;
+    }
+
+    struct json_object* get_item_by_path(const PathIndex& index, const std::string& path) {
+        auto it = index.find(collapse_slashes(path));
+        return (it != index.end()) ? it->second : NULL;
     }
 
     std::string get_archiveinfo(plugin_handle plugin_data, int nbfiles, const char* const* urls, GError** err)
@@ -606,10 +611,11 @@ int gfal_http_bring_online_poll_list(plugin_handle plugin_data, int nbfiles, con
     // Iterate over the "files" list
     int online_count = 0;
     int error_count  = 0;
+    tape_rest_api::PathIndex index = tape_rest_api::index_items_by_path(files);
 
     for (int i = 0; i < nbfiles; ++i) {
         std::string path = Davix::Uri(urls[i]).getPath();
-        struct json_object* file = tape_rest_api::polling_get_item_by_path(files, path);
+        struct json_object* file = tape_rest_api::get_item_by_path(index, path);
 
         if (file == NULL) {
             error_count++;
@@ -725,7 +731,7 @@ ssize_t gfal_http_status_getxattr(plugin_handle plugin_data, const char* url, ch
     }
 
     std::string path = Uri(url).getPath();
-    struct json_object* file = tape_rest_api::polling_get_item_by_path(json_response, path);
+    struct json_object* file = tape_rest_api::get_item_by_path(tape_rest_api::index_items_by_path(json_response), path);
     tape_rest_api::file_locality_t locality = tape_rest_api::get_file_locality(file, path, &tmp_err);
 
     // Free the top JSON object
@@ -794,10 +800,11 @@ int gfal_http_archive_poll_list(plugin_handle plugin_data, int nbfiles, const ch
     // Iterate over the file list
     int ontape_count = 0;
     int error_count = 0;
+    tape_rest_api::PathIndex index = tape_rest_api::index_items_by_path(json_response);
 
     for (int i = 0; i < nbfiles; ++i) {
         std::string path = Davix::Uri(urls[i]).getPath();
-        struct json_object* file = tape_rest_api::polling_get_item_by_path(json_response, path);
+        struct json_object* file = tape_rest_api::get_item_by_path(index, path);
         auto locality = tape_rest_api::get_file_locality(file, path, &tmp_err);
 
         if (tmp_err != NULL) {
@@ -997,6 +997,10 @@ static void internal_stat_copy(gpointer original, gpointer copy)
     memcpy(copy, original, sizeof(struct stat));
 }
 
+// URL schemes handled by this plugin
+static const char* const lfc_schemes[] = {"lfn", "lfc", "guid", NULL};
+
+
 /*
  * Map function for the lfc interface
  * this function provide the generic PLUGIN interface for the LFC plugin.
@@ -1027,6 +1031,7 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError **err)
     lfc_plugin.plugin_data = (void *) ops;
     lfc_plugin.priority = GFAL_PLUGIN_PRIORITY_CATALOG;
     lfc_plugin.check_plugin_url = &gfal_lfc_check_lfn_url;
+    lfc_plugin.url_schemes = lfc_schemes;
     lfc_plugin.plugin_delete = &lfc_destroyG;
     lfc_plugin.accessG = &lfc_accessG;
     lfc_plugin.chmodG = &lfc_chmodG;
@@ -44,6 +44,10 @@ GQuark gfal2_get_plugin_rfio_quark(){
 }
 
 
+// URL schemes handled by this plugin
+static const char* const rfio_schemes[] = {"rfio", NULL};
+
+
 /*
  * Init function, called before all
  * */
@@ -57,6 +61,7 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError** err){
 	gfal_rfio_regex_compile(&h->rex, err);
 	rfio_plugin.plugin_data = (void*) h;
 	rfio_plugin.check_plugin_url = &gfal_rfio_check_url;
+	rfio_plugin.url_schemes = rfio_schemes;
 	rfio_plugin.getName= &gfal_rfio_getName;
 	rfio_plugin.plugin_delete= &gfal_rfio_destroyG;
 	rfio_plugin.openG= &gfal_rfio_openG;
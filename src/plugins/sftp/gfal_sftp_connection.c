@@ -229,7 +229,7 @@ static gfal_sftp_handle_t *gfal_sftp_new_handle(gfal_sftp_context_t *data, gfal2
 {
     int rc;
 
-    gfal_sftp_handle_t *handle = g_malloc(sizeof(gfal_sftp_handle_t));
+    gfal_sftp_handle_t *handle = g_malloc0(sizeof(gfal_sftp_handle_t));
     handle->host = g_strdup(parsed->host);
     handle->port = parsed->port;
     handle->sock = gfal_sftp_socket(parsed, err);
@@ -269,6 +269,13 @@ static gfal_sftp_handle_t *gfal_sftp_new_handle(gfal_sftp_context_t *data, gfal2
     get_handle_failure_ssh:
     gfal_plugin_sftp_translate_error(__func__, handle, err);
     get_handle_failure:
+    if (handle->ssh_session) {
+        libssh2_session_free(handle->ssh_session);
+    }
+    if (handle->sock >= 0) {
+        close(handle->sock);
+    }
+    g_free((char*) handle->host);
     g_free(handle);
     return NULL;
 }
@@ -276,10 +283,13 @@ static gfal_sftp_handle_t *gfal_sftp_new_handle(gfal_sftp_context_t *data, gfal2
 
 static void gfal_sftp_destroy_handle(gfal_sftp_handle_t *handle, gpointer user_data)
 {
-    close(handle->sock);
+    gfal2_log(G_LOG_LEVEL_DEBUG, "Closing SFTP handle for %s:%d", handle->host, handle->port);
     libssh2_sftp_shutdown(handle->sftp_session);
     libssh2_session_disconnect(handle->ssh_session, "");
     libssh2_session_free(handle->ssh_session);
+    close(handle->sock);
+    g_free((char*) handle->host);
+    g_free((char*) handle->path);
     g_free(handle);
 }
 
@@ -296,14 +306,18 @@ gfal_sftp_handle_t *gfal_sftp_connect(gfal_sftp_context_t *context, const char *
         gfal2_log(G_LOG_LEVEL_DEBUG, "Creating new SFTP handle");
         handle = gfal_sftp_new_handle(context, parsed, err);
     } else {
-#if LIBSSH2_VERSION_NUM >= 0x010205
-        int seconds = 10;
         gfal2_log(G_LOG_LEVEL_DEBUG, "Reusing SFTP handle from cache for %s:%d", handle->host, handle->port);
-        int rc = libssh2_keepalive_send(handle->ssh_session, &seconds);
-        if (rc < 0) {
-            gfal2_log(G_LOG_LEVEL_DEBUG, "Recycled SFTP handle failed to send keepalive. Discard and reconnect");
-            gfal_sftp_destroy_handle(handle, NULL);
-            handle = gfal_sftp_new_handle(context, parsed, err);
+#if LIBSSH2_VERSION_NUM >= 0x010205
+        // Only handles idle for a while may have been dropped by the remote
+        const gint64 idle = g_get_monotonic_time() - handle->last_used;
+        if (idle >= (gint64) context->cache->probe_after * G_USEC_PER_SEC) {
+            int seconds = 10;
+            int rc = libssh2_keepalive_send(handle->ssh_session, &seconds);
+            if (rc < 0) {
+                gfal2_log(G_LOG_LEVEL_DEBUG, "Recycled SFTP handle failed to send keepalive. Discard and reconnect");
+                gfal_sftp_destroy_handle(handle, NULL);
+                handle = gfal_sftp_new_handle(context, parsed, err);
+            }
         }
 #endif
     }
@@ -319,60 +333,168 @@ gfal_sftp_handle_t *gfal_sftp_connect(gfal_sftp_context_t *context, const char *
 void gfal_sftp_release(gfal_sftp_context_t *context, gfal_sftp_handle_t *handle)
 {
     gfal2_log(G_LOG_LEVEL_DEBUG, "Pushing SFTP handle into cache for %s:%d", handle->host, handle->port);
+    g_free((char*) handle->path);
+    handle->path = NULL;
     gfal_sftp_cache_push(context->cache, handle);
 }
 
 
-static void gfal_sftpdestroy_key(gpointer p)
+static void gfal_sftp_destroy_queue(gpointer p)
 {
-    g_string_free((GString*)p, TRUE);
+    GQueue *queue = (GQueue*) p;
+    g_list_foreach(queue->head, (GFunc) gfal_sftp_destroy_handle, NULL);
+    g_queue_free(queue);
 }
 
 
-GHashTable *gfal_sftp_cache_new()
+gfal_sftp_handle_cache_t *gfal_sftp_cache_new(gfal2_context_t context)
 {
-    return g_hash_table_new_full((GHashFunc) g_string_hash, (GEqualFunc) g_string_equal,
-        gfal_sftpdestroy_key, NULL);
+    gfal_sftp_handle_cache_t *cache = g_new0(gfal_sftp_handle_cache_t, 1);
+    pthread_mutex_init(&cache->lock, NULL);
+    cache->caches = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, gfal_sftp_destroy_queue);
+    cache->max_per_host = gfal2_get_opt_integer_with_default(context, "SFTP PLUGIN", "POOL_MAX_PER_HOST", 8);
+    cache->max_total = gfal2_get_opt_integer_with_default(context, "SFTP PLUGIN", "POOL_MAX", 64);
+    cache->idle_ttl = gfal2_get_opt_integer_with_default(context, "SFTP PLUGIN", "POOL_IDLE_TTL", 300);
+    cache->probe_after = gfal2_get_opt_integer_with_default(context, "SFTP PLUGIN", "POOL_PROBE_AFTER", 30);
+    return cache;
 }
 
 
-gfal_sftp_handle_t *gfal_sftp_cache_pop(GHashTable *cache, const char *host, int port)
+typedef struct {
+    gint64 deadline;
+    GSList *expired;
+    guint count;
+} gfal_sftp_reap_t;
+
+
+static gboolean gfal_sftp_reap_queue(gpointer key, gpointer value, gpointer user_data)
 {
-    GString *key = g_string_new(NULL);
-    g_string_printf(key, "%s:%d", host, port);
-    GSList *list = (GSList*)g_hash_table_lookup(cache, key);
-    if (!list) {
-        g_string_free(key, TRUE);
-        return NULL;
+    GQueue *queue = (GQueue*) value;
+    gfal_sftp_reap_t *reap = (gfal_sftp_reap_t*) user_data;
+    gfal_sftp_handle_t *oldest;
+
+    while ((oldest = g_queue_peek_tail(queue)) != NULL && oldest->last_used < reap->deadline) {
+        reap->expired = g_slist_prepend(reap->expired, g_queue_pop_tail(queue));
+        ++reap->count;
+    }
+    return g_queue_is_empty(queue);
+}
+
+
+// Move the handles idle for longer than the TTL into expired, to be closed without the lock
+// Must be called with the lock held
+static void gfal_sftp_cache_reap(gfal_sftp_handle_cache_t *cache, GSList **expired)
+{
+    const gint64 now = g_get_monotonic_time();
+    if (now - cache->last_reap < G_USEC_PER_SEC) {
+        return;
+    }
+    cache->last_reap = now;
+
+    gfal_sftp_reap_t reap = {now - (gint64) cache->idle_ttl * G_USEC_PER_SEC, *expired, 0};
+    g_hash_table_foreach_remove(cache->caches, gfal_sftp_reap_queue, &reap);
+    cache->n_idle -= reap.count;
+    *expired = reap.expired;
+}
+
+
+static void gfal_sftp_close_handles(GSList *handles)
+{
+    g_slist_foreach(handles, (GFunc) gfal_sftp_destroy_handle, NULL);
+    g_slist_free(handles);
+}
+
+
+gfal_sftp_handle_t *gfal_sftp_cache_pop(gfal_sftp_handle_cache_t *cache, const char *host, int port)
+{
+    GSList *expired = NULL;
+    gfal_sftp_handle_t *handle = NULL;
+    char *key = g_strdup_printf("%s:%d", host, port);
+
+    pthread_mutex_lock(&cache->lock);
+    gfal_sftp_cache_reap(cache, &expired);
+    GQueue *queue = (GQueue*) g_hash_table_lookup(cache->caches, key);
+    if (queue) {
+        handle = g_queue_pop_head(queue);
+        if (handle) {
+            --cache->n_idle;
+        }
     }
-    gfal_sftp_handle_t *handle = (gfal_sftp_handle_t*)list->data;
-    list = g_slist_delete_link(list, list);
-    // g_hash_table_insert acquires ownership of key
-    g_hash_table_insert(cache, key, list);
+    pthread_mutex_unlock(&cache->lock);
+
+    g_free(key);
+    gfal_sftp_close_handles(expired);
     return handle;
 }
 
 
-void gfal_sftp_cache_push(GHashTable *cache, gfal_sftp_handle_t *handle)
+typedef struct {
+    GQueue *queue;
+    gint64 last_used;
+} gfal_sftp_oldest_t;
+
+
+static void gfal_sftp_find_oldest(gpointer key, gpointer value, gpointer user_data)
 {
-    GString *key = g_string_new(NULL);
-    g_string_printf(key, "%s:%d", handle->host, handle->port);
-    GSList *list = (GSList*)g_hash_table_lookup(cache, key);
-    list = g_slist_prepend(list, handle);
-    // g_hash_table_insert acquires ownership of key
-    g_hash_table_insert(cache, key, list);
+    GQueue *queue = (GQueue*) value;
+    gfal_sftp_oldest_t *oldest = (gfal_sftp_oldest_t*) user_data;
+    gfal_sftp_handle_t *tail = g_queue_peek_tail(queue);
+
+    if (tail && (oldest->queue == NULL || tail->last_used < oldest->last_used)) {
+        oldest->queue = queue;
+        oldest->last_used = tail->last_used;
+    }
 }
 
 
-void gfal_sftp_destroy_cache_entry(gpointer key, gpointer value, gpointer user_data)
+void gfal_sftp_cache_push(gfal_sftp_handle_cache_t *cache, gfal_sftp_handle_t *handle)
 {
-    g_slist_foreach((GSList*)value, (GFunc)gfal_sftp_destroy_handle, NULL);
-    g_slist_free((GSList*)value);
+    GSList *expired = NULL;
+
+    handle->last_used = g_get_monotonic_time();
+
+    pthread_mutex_lock(&cache->lock);
+    gfal_sftp_cache_reap(cache, &expired);
+
+    if (cache->max_per_host == 0 || cache->max_total == 0) {
+        expired = g_slist_prepend(expired, handle);
+    }
+    else {
+        char *key = g_strdup_printf("%s:%d", handle->host, handle->port);
+        GQueue *queue = (GQueue*) g_hash_table_lookup(cache->caches, key);
+        if (!queue) {
+            queue = g_queue_new();
+            // the table takes ownership of key
+            g_hash_table_insert(cache->caches, key, queue);
+        }
+        else {
+            g_free(key);
+        }
+
+        // Make room dropping the oldest handle for this host, or the oldest overall
+        if (g_queue_get_length(queue) >= cache->max_per_host) {
+            expired = g_slist_prepend(expired, g_queue_pop_tail(queue));
+            --cache->n_idle;
+        }
+        else if (cache->n_idle >= cache->max_total) {
+            gfal_sftp_oldest_t oldest = {NULL, 0};
+            g_hash_table_foreach(cache->caches, gfal_sftp_find_oldest, &oldest);
+            expired = g_slist_prepend(expired, g_queue_pop_tail(oldest.queue));
+            --cache->n_idle;
+        }
+
+        g_queue_push_head(queue, handle);
+        ++cache->n_idle;
+    }
+    pthread_mutex_unlock(&cache->lock);
+
+    gfal_sftp_close_handles(expired);
 }
 
 
-void gfal_sftp_cache_destroy(GHashTable *cache)
+void gfal_sftp_cache_destroy(gfal_sftp_handle_cache_t *cache)
 {
-    g_hash_table_foreach(cache, gfal_sftp_destroy_cache_entry, NULL);
-    g_hash_table_destroy(cache);
+    g_hash_table_destroy(cache->caches);
+    pthread_mutex_destroy(&cache->lock);
+    g_free(cache);
 }
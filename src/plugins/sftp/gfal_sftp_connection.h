@@ -17,6 +17,7 @@
 #ifndef GFAL_SFTP_CONNECTION_H
 #define GFAL_SFTP_CONNECTION_H
 
+#include <pthread.h>
 #include "gfal_sftp_plugin.h"
 
 /// Wraps a connection plus a session to a remote SSH server
@@ -27,19 +28,33 @@ struct gfal_sftp_handle_s {
     const char *host;
     int port;
     const char *path;
+    /// Monotonic time at which the handle went back into the pool
+    gint64 last_used;
 };
 typedef struct gfal_sftp_handle_s gfal_sftp_handle_t;
 
-/// SSH session cache
+/// SSH session pool, shared by all the threads using the plugin
+/// Idle handles are kept per host:port, most recently used first
 struct gfal_sftp_handle_cache_s {
+    pthread_mutex_t lock;
+    /// "host:port" => GQueue of idle handles
     GHashTable *caches;
+    guint n_idle;
+    /// Maximum number of idle handles per host:port, and overall
+    guint max_per_host;
+    guint max_total;
+    /// Idle handles older than this (seconds) are closed
+    guint idle_ttl;
+    /// Idle handles older than this (seconds) are probed before being reused
+    guint probe_after;
+    gint64 last_reap;
 };
 typedef struct gfal_sftp_handle_cache_s gfal_sftp_handle_cache_t;
 
 /// Plugin internal data
 struct gfal_sftp_context_s {
     gfal2_context_t gfal2_context;
-    GHashTable *cache;
+    gfal_sftp_handle_cache_t *cache;
 };
 typedef struct gfal_sftp_context_s gfal_sftp_context_t;
 
@@ -61,22 +76,24 @@ gfal_sftp_handle_t *gfal_sftp_connect(gfal_sftp_context_t *context, const char *
 /// @param handle       The handle we are done with
 void gfal_sftp_release(gfal_sftp_context_t *context, gfal_sftp_handle_t *handle);
 
-/// Creates a new GHashTable that models a connection cache
-GHashTable *gfal_sftp_cache_new();
+/// Creates a new connection pool
+/// @param context  The limits are read from the SFTP PLUGIN group of this context
+gfal_sftp_handle_cache_t *gfal_sftp_cache_new(gfal2_context_t context);
 
-/// Gets a handle from the cache
-/// @param cache    An initialized cache
+/// Gets a handle from the pool
+/// @param cache    An initialized pool
 /// @param host     The remote host
 /// @param port     The remote port
-/// @return         NULL if there is no cached entry
-gfal_sftp_handle_t *gfal_sftp_cache_pop(GHashTable *cache, const char *host, int port);
+/// @return         NULL if there is no idle handle for host:port
+gfal_sftp_handle_t *gfal_sftp_cache_pop(gfal_sftp_handle_cache_t *cache, const char *host, int port);
 
-/// Puts a handle back to the cache
+/// Puts a handle back to the pool
+/// If the pool is full, the oldest idle handle is closed
 /// @param handle   The handle to release
-void gfal_sftp_cache_push(GHashTable *cache, gfal_sftp_handle_t *handle);
+void gfal_sftp_cache_push(gfal_sftp_handle_cache_t *cache, gfal_sftp_handle_t *handle);
 
 /// Frees memory and closes connections
-void gfal_sftp_cache_destroy(GHashTable *cache);
+void gfal_sftp_cache_destroy(gfal_sftp_handle_cache_t *cache);
 
 
 #endif // GFAL_SFTP_CONNECTION_H
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <string.h>
 #include "gfal_sftp_plugin.h"
 #include "gfal_sftp_connection.h"
 
@@ -24,9 +25,30 @@
 #endif
 
 
+// libssh2 splits reads and writes in packets of this size, and keeps several of them
+// in flight when it is given a bigger buffer. PIPELINE_DEPTH packets are buffered per file.
+#define GFAL_SFTP_PACKET_SIZE (32 * 1024)
+
+
 struct gfal_sftp_file_s {
     gfal_sftp_handle_t *sftp_handle;
     LIBSSH2_SFTP_HANDLE *file_handle;
+
+    pthread_mutex_t lock;
+    // Position used by read/write, and position of libssh2 on the remote file (-1 if unknown)
+    off_t offset;
+    off_t remote_offset;
+    // Readahead and write-behind buffers of buffer_size bytes, 0 if disabled
+    size_t buffer_size;
+    // Readahead of [rbuf_offset, rbuf_offset + rbuf_len), refilled on sequential reads
+    char *rbuf;
+    off_t rbuf_offset;
+    size_t rbuf_len;
+    off_t last_read_end;
+    // Pending data for [wbuf_offset, wbuf_offset + wbuf_len)
+    char *wbuf;
+    off_t wbuf_offset;
+    size_t wbuf_len;
 };
 typedef struct gfal_sftp_file_s gfal_sftp_file_t;
 
@@ -56,6 +78,156 @@ static unsigned long gfal_sftp_std2ssh2_open_flags(int flag)
 }
 
 
+// Move libssh2 to offset, unless it is already there: seeking discards the readahead of libssh2
+static void gfal_sftp_remote_seek(gfal_sftp_file_t *ssh_fd, off_t offset)
+{
+    if (ssh_fd->remote_offset != offset) {
+        libssh2_sftp_seek64(ssh_fd->file_handle, offset);
+        ssh_fd->remote_offset = offset;
+    }
+}
+
+
+static ssize_t gfal_sftp_remote_read(gfal_sftp_file_t *ssh_fd, char *buffer, size_t count, off_t offset,
+    GError **err)
+{
+    size_t read = 0;
+    gfal_sftp_remote_seek(ssh_fd, offset);
+
+    // libssh2 may need to read in chunks
+    while (read < count) {
+        ssize_t rc = libssh2_sftp_read(ssh_fd->file_handle, buffer + read, count - read);
+        if (rc < 0) {
+            gfal_plugin_sftp_translate_error(__func__, ssh_fd->sftp_handle, err);
+            ssh_fd->remote_offset = -1;
+            return rc;
+        } else if (rc == 0) {
+            break;
+        }
+        read += rc;
+    }
+    ssh_fd->remote_offset += read;
+    return read;
+}
+
+
+static ssize_t gfal_sftp_remote_write(gfal_sftp_file_t *ssh_fd, const char *buffer, size_t count, off_t offset,
+    GError **err)
+{
+    size_t written = 0;
+    gfal_sftp_remote_seek(ssh_fd, offset);
+
+    // libssh2 returns once the first packets are acknowledged, even if more were sent.
+    // It must be called again with the rest of the data.
+    // See https://www.libssh2.org/libssh2_sftp_write.html
+    while (written < count) {
+        ssize_t rc = libssh2_sftp_write(ssh_fd->file_handle, buffer + written, count - written);
+        if (rc < 0) {
+            gfal_plugin_sftp_translate_error(__func__, ssh_fd->sftp_handle, err);
+            ssh_fd->remote_offset = -1;
+            return rc;
+        }
+        written += rc;
+    }
+    ssh_fd->remote_offset += written;
+    return written;
+}
+
+
+// Send the pending writes
+static int gfal_sftp_flush(gfal_sftp_file_t *ssh_fd, GError **err)
+{
+    if (ssh_fd->wbuf_len == 0) {
+        return 0;
+    }
+    ssize_t rc = gfal_sftp_remote_write(ssh_fd, ssh_fd->wbuf, ssh_fd->wbuf_len, ssh_fd->wbuf_offset, err);
+    ssh_fd->wbuf_len = 0;
+    return rc < 0 ? -1 : 0;
+}
+
+
+static ssize_t gfal_sftp_locked_pread(gfal_sftp_file_t *ssh_fd, char *buffer, size_t count, off_t offset,
+    GError **err)
+{
+    size_t done = 0;
+
+    if (gfal_sftp_flush(ssh_fd, err) < 0) {
+        return -1;
+    }
+
+    if (ssh_fd->rbuf_len > 0 && offset >= ssh_fd->rbuf_offset &&
+        offset < ssh_fd->rbuf_offset + (off_t)ssh_fd->rbuf_len) {
+        size_t skip = offset - ssh_fd->rbuf_offset;
+        done = MIN(count, ssh_fd->rbuf_len - skip);
+        memcpy(buffer, ssh_fd->rbuf + skip, done);
+    }
+
+    if (done < count) {
+        off_t remaining_offset = offset + done;
+        size_t remaining = count - done;
+        ssize_t rc;
+
+        // Readahead only pays off for sequential access, and big reads are pipelined anyway
+        if (ssh_fd->buffer_size == 0 || remaining >= ssh_fd->buffer_size ||
+            remaining_offset != ssh_fd->last_read_end) {
+            rc = gfal_sftp_remote_read(ssh_fd, buffer + done, remaining, remaining_offset, err);
+            if (rc < 0) {
+                return rc;
+            }
+            done += rc;
+        }
+        else {
+            if (!ssh_fd->rbuf) {
+                ssh_fd->rbuf = g_malloc(ssh_fd->buffer_size);
+            }
+            ssh_fd->rbuf_len = 0;
+            rc = gfal_sftp_remote_read(ssh_fd, ssh_fd->rbuf, ssh_fd->buffer_size, remaining_offset, err);
+            if (rc < 0) {
+                return rc;
+            }
+            ssh_fd->rbuf_offset = remaining_offset;
+            ssh_fd->rbuf_len = rc;
+            rc = MIN(remaining, (size_t)rc);
+            memcpy(buffer + done, ssh_fd->rbuf, rc);
+            done += rc;
+        }
+    }
+
+    ssh_fd->last_read_end = offset + done;
+    return done;
+}
+
+
+static ssize_t gfal_sftp_locked_pwrite(gfal_sftp_file_t *ssh_fd, const char *buffer, size_t count, off_t offset,
+    GError **err)
+{
+    ssh_fd->rbuf_len = 0;
+
+    // Pending writes are only extended by contiguous ones
+    if (ssh_fd->wbuf_len > 0 &&
+        (offset != ssh_fd->wbuf_offset + (off_t)ssh_fd->wbuf_len ||
+         ssh_fd->wbuf_len + count > ssh_fd->buffer_size)) {
+        if (gfal_sftp_flush(ssh_fd, err) < 0) {
+            return -1;
+        }
+    }
+
+    if (count >= ssh_fd->buffer_size) {
+        return gfal_sftp_remote_write(ssh_fd, buffer, count, offset, err);
+    }
+
+    if (!ssh_fd->wbuf) {
+        ssh_fd->wbuf = g_malloc(ssh_fd->buffer_size);
+    }
+    if (ssh_fd->wbuf_len == 0) {
+        ssh_fd->wbuf_offset = offset;
+    }
+    memcpy(ssh_fd->wbuf + ssh_fd->wbuf_len, buffer, count);
+    ssh_fd->wbuf_len += count;
+    return count;
+}
+
+
 gfal_file_handle gfal_sftp_open(plugin_handle plugin_data, const char *url, int flag, mode_t mode, GError **err)
 {
     gfal_sftp_context_t *data = (gfal_sftp_context_t*)plugin_data;
@@ -64,7 +236,7 @@ gfal_file_handle gfal_sftp_open(plugin_handle plugin_data, const char *url, int
         return NULL;
     }
 
-    gfal_sftp_file_t *fd = g_malloc(sizeof(gfal_sftp_file_t));
+    gfal_sftp_file_t *fd = g_new0(gfal_sftp_file_t, 1);
     fd->sftp_handle = sftp_handle;
 
     fd->file_handle = libssh2_sftp_open(sftp_handle->sftp_session, sftp_handle->path,
@@ -76,6 +248,14 @@ gfal_file_handle gfal_sftp_open(plugin_handle plugin_data, const char *url, int
         return NULL;
     }
 
+    pthread_mutex_init(&fd->lock, NULL);
+    int depth = gfal2_get_opt_integer_with_default(data->gfal2_context, "SFTP PLUGIN", "PIPELINE_DEPTH", 16);
+    if (depth > 1) {
+        fd->buffer_size = (size_t)depth * GFAL_SFTP_PACKET_SIZE;
+    }
+    // Reads start with a readahead
+    fd->last_read_end = 0;
+
     return gfal_file_handle_new2(gfal_sftp_plugin_get_name(), fd, NULL, url);
 }
 
@@ -85,48 +265,69 @@ int gfal_sftp_close(plugin_handle plugin_data, gfal_file_handle fd, GError **err
     gfal_sftp_context_t *data = (gfal_sftp_context_t*)plugin_data;
     gfal_sftp_file_t *ssh_fd = gfal_file_handle_get_fdesc(fd);
 
+    int ret = gfal_sftp_flush(ssh_fd, err);
+
     libssh2_sftp_close(ssh_fd->file_handle);
     gfal_sftp_release(data, ssh_fd->sftp_handle);
+    pthread_mutex_destroy(&ssh_fd->lock);
+    g_free(ssh_fd->rbuf);
+    g_free(ssh_fd->wbuf);
     g_free(ssh_fd);
 
     gfal_file_handle_delete(fd);
-    return 0;
+    return ret;
 }
 
 
 ssize_t gfal_sftp_read(plugin_handle plugin_data, gfal_file_handle fd, void *buff, size_t count, GError **err)
 {
     gfal_sftp_file_t *ssh_fd = gfal_file_handle_get_fdesc(fd);
-    ssize_t read = 0;
 
-    // libssh2 may need to read in chunks
-    char *buffer = (char*)buff;
-    do {
-        ssize_t rc = libssh2_sftp_read(ssh_fd->file_handle, buffer + read, count - read);
-        if (rc < 0) {
-            gfal_plugin_sftp_translate_error(__func__, ssh_fd->sftp_handle, err);
-            return rc;
-        } else if (rc == 0) {
-            break;
-        }
-        read += rc;
-    } while (read < count);
-
-    return read;
+    pthread_mutex_lock(&ssh_fd->lock);
+    ssize_t ret = gfal_sftp_locked_pread(ssh_fd, buff, count, ssh_fd->offset, err);
+    if (ret > 0) {
+        ssh_fd->offset += ret;
+    }
+    pthread_mutex_unlock(&ssh_fd->lock);
+    return ret;
 }
 
 
 ssize_t gfal_sftp_write(plugin_handle plugin_data, gfal_file_handle fd, const void *buff, size_t count, GError **err)
 {
     gfal_sftp_file_t *ssh_fd = gfal_file_handle_get_fdesc(fd);
-    ssize_t rc = libssh2_sftp_write(ssh_fd->file_handle, buff, count);
-    if (rc < 0) {
-        gfal_plugin_sftp_translate_error(__func__, ssh_fd->sftp_handle, err);
+
+    pthread_mutex_lock(&ssh_fd->lock);
+    ssize_t ret = gfal_sftp_locked_pwrite(ssh_fd, buff, count, ssh_fd->offset, err);
+    if (ret > 0) {
+        ssh_fd->offset += ret;
     }
-    // normally, one would expect to return the value from libssh2_sftp_write, but as it happens it may be
-    // shorter, but still the data is cached on the pipe.
-    // See https://www.libssh2.org/libssh2_sftp_write.html
-    return count;
+    pthread_mutex_unlock(&ssh_fd->lock);
+    return ret;
+}
+
+
+ssize_t gfal_sftp_pread(plugin_handle plugin_data, gfal_file_handle fd, void *buff, size_t count, off_t offset,
+    GError **err)
+{
+    gfal_sftp_file_t *ssh_fd = gfal_file_handle_get_fdesc(fd);
+
+    pthread_mutex_lock(&ssh_fd->lock);
+    ssize_t ret = gfal_sftp_locked_pread(ssh_fd, buff, count, offset, err);
+    pthread_mutex_unlock(&ssh_fd->lock);
+    return ret;
+}
+
+
+ssize_t gfal_sftp_pwrite(plugin_handle plugin_data, gfal_file_handle fd, const void *buff, size_t count, off_t offset,
+    GError **err)
+{
+    gfal_sftp_file_t *ssh_fd = gfal_file_handle_get_fdesc(fd);
+
+    pthread_mutex_lock(&ssh_fd->lock);
+    ssize_t ret = gfal_sftp_locked_pwrite(ssh_fd, buff, count, offset, err);
+    pthread_mutex_unlock(&ssh_fd->lock);
+    return ret;
 }
 
 
@@ -136,20 +337,29 @@ off_t gfal_sftp_seek(plugin_handle plugin_data, gfal_file_handle fd, off_t offse
     off_t absolute = 0;
     LIBSSH2_SFTP_ATTRIBUTES attrs;
 
+    pthread_mutex_lock(&ssh_fd->lock);
     switch (whence) {
         case SEEK_SET:
             absolute = offset;
             break;
         case SEEK_CUR:
-            absolute = libssh2_sftp_tell64(ssh_fd->file_handle) + offset;
+            absolute = ssh_fd->offset + offset;
             break;
         case SEEK_END:
+            // The size must account for the pending writes
+            if (gfal_sftp_flush(ssh_fd, err) < 0) {
+                pthread_mutex_unlock(&ssh_fd->lock);
+                return -1;
+            }
             if (libssh2_sftp_fstat(ssh_fd->file_handle, &attrs) < 0) {
                 gfal_plugin_sftp_translate_error(__func__, ssh_fd->sftp_handle, err);
+                pthread_mutex_unlock(&ssh_fd->lock);
                 return -1;
             }
             absolute = attrs.filesize + offset;
     }
-    libssh2_sftp_seek64(ssh_fd->file_handle, absolute);
+    // libssh2 is moved by the next remote read or write, if needed
+    ssh_fd->offset = absolute;
+    pthread_mutex_unlock(&ssh_fd->lock);
     return absolute;
 }
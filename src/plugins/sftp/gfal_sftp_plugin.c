@@ -66,6 +66,10 @@ static void gfal_plugin_sftp_delete(plugin_handle plugin_data)
 }
 
 
+// URL schemes handled by this plugin
+static const char* const sftp_schemes[] = {"sftp", NULL};
+
+
 gfal_plugin_interface gfal_plugin_init(gfal2_context_t context, GError **err)
 {
     gfal_plugin_interface sftp_plugin;
@@ -73,11 +77,12 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t context, GError **err)
 
     gfal_sftp_context_t *data = g_malloc(sizeof(gfal_sftp_context_t));
     data->gfal2_context = context;
-    data->cache = gfal_sftp_cache_new();
+    data->cache = gfal_sftp_cache_new(context);
 
     sftp_plugin.plugin_data = data;
     sftp_plugin.plugin_delete = gfal_plugin_sftp_delete;
     sftp_plugin.check_plugin_url = &gfal_sftp_check_url;
+    sftp_plugin.url_schemes = sftp_schemes;
     sftp_plugin.getName = &gfal_sftp_plugin_get_name;
 
     sftp_plugin.statG = &gfal_sftp_stat;
@@ -100,6 +105,8 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t context, GError **err)
     sftp_plugin.closeG = gfal_sftp_close;
     sftp_plugin.readG = gfal_sftp_read;
     sftp_plugin.writeG = gfal_sftp_write;
+    sftp_plugin.preadG = gfal_sftp_pread;
+    sftp_plugin.pwriteG = gfal_sftp_pwrite;
     sftp_plugin.lseekG = gfal_sftp_seek;
 
     return sftp_plugin;
@@ -79,6 +79,12 @@ ssize_t gfal_sftp_read(plugin_handle plugin_data, gfal_file_handle fd,
 ssize_t gfal_sftp_write(plugin_handle plugin_data, gfal_file_handle fd,
     const void *buff, size_t count, GError **err);
 
+ssize_t gfal_sftp_pread(plugin_handle plugin_data, gfal_file_handle fd,
+    void *buff, size_t count, off_t offset, GError **err);
+
+ssize_t gfal_sftp_pwrite(plugin_handle plugin_data, gfal_file_handle fd,
+    const void *buff, size_t count, off_t offset, GError **err);
+
 int gfal_sftp_close(plugin_handle plugin_data, gfal_file_handle fd, GError **err);
 
 off_t gfal_sftp_seek(plugin_handle plugin_data, gfal_file_handle fd,
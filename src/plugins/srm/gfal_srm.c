@@ -212,6 +212,10 @@ void gfal_srm_opt_initG(gfal_srmv2_opt *opts, gfal2_context_t handle)
 }
 
 
+// URL schemes handled by this plugin
+static const char* const srm_schemes[] = {"srm", NULL};
+
+
 /*
  * Init function, called before all
  * */
@@ -223,6 +227,7 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError **err)
     gfal_srm_opt_initG(opts, handle);
     srm_plugin.plugin_data = (void *) opts;
     srm_plugin.check_plugin_url = &gfal_srm_check_url;
+    srm_plugin.url_schemes = srm_schemes;
     srm_plugin.plugin_delete = &gfal_srm_destroyG;
     srm_plugin.accessG = &gfal_srm_accessG;
     srm_plugin.mkdirpG = &gfal_srm_mkdirG;
@@ -258,6 +263,7 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError **err)
     srm_plugin.abort_files = &gfal_srm2_abort_filesG;
     srm_plugin.renameG = &gfal_srm_renameG;
     srm_plugin.unlink_listG = &gfal_srm_unlink_listG;
+    srm_plugin.stat_listG = &gfal_srm_stat_listG;
     srm_plugin.archive_poll = &gfal_srm_archive_pollG;
     srm_plugin.archive_poll_list = &gfal_srm_archive_poll_listG;
     return srm_plugin;
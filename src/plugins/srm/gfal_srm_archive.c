@@ -17,6 +17,9 @@
 #include "gfal_srm.h"
 #include "gfal_srm_archive.h"
 #include "gfal_srm_namespace.h"
+#include "gfal_srm_internal_layer.h"
+#include "gfal_srm_internal_ls.h"
+#include "gfal_srm_url_check.h"
 
 
 int gfal_srm_archive_pollG(plugin_handle ch, const char* surl, GError** err)
@@ -60,8 +63,7 @@ int gfal_srm_archive_poll_listG(plugin_handle ch, int nbfiles, const char* const
 {
     int error_count = 0;
     int ontape_count = 0;
-    int ret = -1;
-    int i;
+    int i, j;
 
     if (nbfiles <= 0) {
         return 1;
@@ -77,21 +79,72 @@ int gfal_srm_archive_poll_listG(plugin_handle ch, int nbfiles, const char* const
 
     gfal2_log(G_LOG_LEVEL_DEBUG, " gfal_srm_archive_poll_listG ->");
 
+    // The valid surls are polled together, with chunked srmLs to the endpoint of the first one
+    int *pending = g_new(int, nbfiles);
+    int nb_pending = 0;
+
     for (i = 0; i < nbfiles; i++) {
         if (!surls[i]) {
             gfal2_set_error(&errors[i], gfal2_get_plugin_srm_quark(), EINVAL, __func__, "Invalid surl value");
             error_count++;
-            continue;
         }
+        else {
+            pending[nb_pending++] = i;
+        }
+    }
 
-        ret = gfal_srm_archive_pollG(ch, surls[i], &errors[i]);
-
-        if (errors[i] && errors[i]->code != EAGAIN) {
-            error_count++;
-        } else if (ret == 1) {
-            ontape_count++;
+    if (nb_pending > 0) {
+        gfal_srmv2_opt *opts = (gfal_srmv2_opt *) ch;
+        GError *tmp_err = NULL;
+        gfal_srm_easy_t easy = gfal_srm_ifce_easy_context(opts, surls[pending[0]], &tmp_err);
+
+        if (easy != NULL) {
+            char **decoded = g_new(char*, nb_pending + 1);
+            struct stat *stats = g_new0(struct stat, nb_pending);
+            TFileLocality *locs = g_new0(TFileLocality, nb_pending);
+            GError **ls_errors = g_new0(GError*, nb_pending);
+
+            for (j = 0; j < nb_pending; j++) {
+                decoded[j] = gfal2_srm_get_decoded_path(surls[pending[j]]);
+            }
+            decoded[nb_pending] = NULL;
+
+            gfal_statG_srmv2_list_internal(opts, easy->srm_context, nb_pending, decoded, stats, locs, ls_errors);
+
+            for (j = 0; j < nb_pending; j++) {
+                i = pending[j];
+                if (ls_errors[j] != NULL) {
+                    // EAGAIN means the file is still pending, as for the other not yet archived files
+                    if (ls_errors[j]->code != EAGAIN) {
+                        error_count++;
+                    }
+                    gfal2_propagate_prefixed_error(&errors[i], ls_errors[j], __func__);
+                }
+                else if (locs[j] == GFAL_LOCALITY_NEARLINE_ ||
+                         locs[j] == GFAL_LOCALITY_ONLINE_USCOREAND_USCORENEARLINE) {
+                    ontape_count++;
+                }
+                else {
+                    gfal2_set_error(&errors[i], gfal2_get_plugin_srm_quark(), EAGAIN, __func__,
+                                    "File %s is not yet archived", surls[i]);
+                }
+            }
+
+            g_strfreev(decoded);
+            g_free(stats);
+            g_free(locs);
+            g_free(ls_errors);
+        }
+        else {
+            for (j = 0; j < nb_pending; j++) {
+                errors[pending[j]] = g_error_copy(tmp_err);
+            }
+            error_count += nb_pending;
+            g_error_free(tmp_err);
         }
+        gfal_srm_ifce_easy_context_release(opts, easy);
     }
+    g_free(pending);
 
     gfal2_log(G_LOG_LEVEL_DEBUG, " Archive polling: nbfiles=%d ontape_count=%d error_count=%d",
               nbfiles, ontape_count, error_count);
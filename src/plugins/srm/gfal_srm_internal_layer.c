@@ -25,6 +25,7 @@ const char *srm_desired_request_lifetime = "REQUEST_LIFETIME";
 const char *srm_config_turl_protocols = "TURL_PROTOCOLS";
 const char *srm_config_3rd_party_turl_protocols = "TURL_3RD_PARTY_PROTOCOLS";
 const char *srm_config_keep_alive = "KEEP_ALIVE";
+const char *srm_config_ls_chunk_size = "LS_CHUNK_SIZE";
 const char *srm_spacetokendesc = "SPACETOKENDESC";
 
 #include "gfal_srm_internal_layer.h"
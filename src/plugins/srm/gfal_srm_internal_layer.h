@@ -34,6 +34,10 @@ extern const char *srm_config_transfer_checksum;
 extern const char *srm_config_turl_protocols;
 extern const char *srm_config_3rd_party_turl_protocols;
 extern const char *srm_spacetokendesc;
+extern const char *srm_config_ls_chunk_size;
+
+// Maximum number of surls in one srmLs
+#define GFAL_SRM_LS_CHUNK_SIZE_DEFAULT 500
 
 // request type for surl <-> turl translation
 typedef enum _srm_req_type {
@@ -129,6 +129,82 @@ int gfal_statG_srmv2__generic_internal(srm_context_t context, struct stat *buf,
     G_RETURN_ERR(ret, tmp_err, err);
 }
 
+// One srmLs for all the surls
+static int gfal_statG_srmv2_ls_chunk(srm_context_t context, int nbfiles, char **surls,
+    struct stat *bufs, TFileLocality *locs, GError **errors)
+{
+    GError *tmp_err = NULL;
+    struct srm_ls_input input;
+    struct srm_ls_output output;
+    int ret, i;
+
+    input.nbfiles = nbfiles;
+    input.surls = surls;
+    input.numlevels = 0;
+    input.offset = 0;
+    input.count = 0;
+
+    int nb_statuses = gfal_srm_ls_internal(context, &input, &output, &tmp_err);
+    if (nb_statuses < 0) {
+        for (i = 0; i < nbfiles; ++i) {
+            errors[i] = g_error_copy(tmp_err);
+        }
+        g_error_free(tmp_err);
+        return -1;
+    }
+
+    // One status per surl, in the order of the request
+    ret = 0;
+    for (i = 0; i < nbfiles; ++i) {
+        struct srmv2_mdfilestatus *status = &output.statuses[i];
+        if (i >= nb_statuses) {
+            gfal2_set_error(&errors[i], gfal2_get_plugin_srm_quark(), EIO, __func__,
+                "No status returned by srm_ifce for %s", surls[i]);
+            ret = -1;
+        }
+        else if (status->status != 0) {
+            gfal2_set_error(&errors[i], gfal2_get_plugin_srm_quark(), status->status, __func__,
+                "Error reported from srm_ifce : %d %s",
+                status->status, status->explanation);
+            ret = -1;
+        }
+        else {
+            memcpy(&bufs[i], &(status->stat), sizeof(struct stat));
+            locs[i] = status->locality;
+            // SRM returns the time in UTC
+            gfal_srm_adjust_time(&bufs[i]);
+        }
+    }
+
+    gfal_srm_external_call.srm_srmv2_mdfilestatus_delete(output.statuses, nb_statuses);
+    gfal_srm_external_call.srm_srm2__TReturnStatus_delete(output.retstatus);
+    return ret;
+}
+
+
+int gfal_statG_srmv2_list_internal(gfal_srmv2_opt *opts, srm_context_t context, int nbfiles, char **surls,
+    struct stat *bufs, TFileLocality *locs, GError **errors)
+{
+    int chunk_size = gfal2_get_opt_integer_with_default(opts->handle, srm_config_group,
+        srm_config_ls_chunk_size, GFAL_SRM_LS_CHUNK_SIZE_DEFAULT);
+    if (chunk_size <= 0) {
+        chunk_size = nbfiles;
+    }
+
+    int ret = 0, offset;
+    for (offset = 0; offset < nbfiles; offset += chunk_size) {
+        int count = MIN(chunk_size, nbfiles - offset);
+        gfal2_log(G_LOG_LEVEL_DEBUG, "   [gfal_statG_srmv2_list_internal] srmLs of %d files, from %d out of %d",
+            count, offset, nbfiles);
+        if (gfal_statG_srmv2_ls_chunk(context, count, surls + offset,
+                bufs + offset, locs + offset, errors + offset) < 0) {
+            ret = -1;
+        }
+    }
+    return ret;
+}
+
+
 int gfal_srm_cache_stat_add(plugin_handle ch, const char *surl, const struct stat *value, const TFileLocality *loc)
 {
     char buff_key[GFAL_URL_MAX_LEN];
@@ -30,6 +30,10 @@ struct extended_stat {
 int gfal_statG_srmv2__generic_internal(srm_context_t context, struct stat *buf, TFileLocality *loc,
     const char *surl, GError **err);
 
+// Stat nbfiles surls with one srmLs per SRM PLUGIN:LS_CHUNK_SIZE surls, filling bufs[i] and locs[i], or errors[i]
+int gfal_statG_srmv2_list_internal(gfal_srmv2_opt *opts, srm_context_t context, int nbfiles, char **surls,
+    struct stat *bufs, TFileLocality *locs, GError **errors);
+
 int gfal_srm_cache_stat_add(plugin_handle ch, const char *surl, const struct stat *value, const TFileLocality *loc);
 
 void gfal_srm_cache_stat_remove(plugin_handle ch, const char *surl);
@@ -58,6 +58,8 @@ int gfal_srm_unlinkG(plugin_handle ch, const char * path, GError** err);
 
 int gfal_srm_unlink_listG(plugin_handle ch, int nbfiles, const char* const* paths, GError** err);
 
+int gfal_srm_stat_listG(plugin_handle ch, int nbfiles, const char* const* surls, struct stat* buffs, GError** errors);
+
 int gfal_srm_rmdirG(plugin_handle handle, const char* surl, GError** err);
 
 int gfal_srm_statG(plugin_handle handle, const char* surl, struct stat* buf, GError** err);
@@ -23,6 +23,7 @@
 #include "gfal_srm_namespace.h"
 #include "gfal_srm_internal_layer.h"
 #include "gfal_srm_endpoint.h"
+#include "gfal_srm_url_check.h"
 
 
 int gfal_statG_srmv2_internal(srm_context_t context, struct stat *buf, TFileLocality *loc, const char *surl,
@@ -75,3 +76,80 @@ int gfal_srm_statG(plugin_handle ch, const char *surl, struct stat *buf, GError
 
     return ret;
 }
+
+
+/*
+ * bulk stat, the surls missing from the cache are sent in chunked srmLs to the endpoint of the first one
+ *
+ * */
+int gfal_srm_stat_listG(plugin_handle ch, int nbfiles, const char *const *surls, struct stat *buffs, GError **errors)
+{
+    GError *tmp_err = NULL;
+    gfal_srmv2_opt *opts = (gfal_srmv2_opt *) ch;
+    char key_buff[GFAL_URL_MAX_LEN];
+    struct extended_stat xstat;
+    int ret = 0, i, j;
+
+    if (!errors)
+        return -1;
+
+    // Indexes of the surls not found in the cache
+    int *pending = g_new(int, nbfiles);
+    int nb_pending = 0;
+    for (i = 0; i < nbfiles; ++i) {
+        gfal_srm_construct_key(surls[i], GFAL_SRM_LSTAT_PREFIX, key_buff, GFAL_URL_MAX_LEN);
+        if (gsimplecache_take_one_kstr(opts->cache, key_buff, &xstat) == 0) {
+            buffs[i] = xstat.stat;
+        }
+        else {
+            pending[nb_pending++] = i;
+        }
+    }
+
+    gfal2_log(G_LOG_LEVEL_DEBUG, "   [gfal_srm_stat_listG] %d files taken from the cache, %d to ask the server",
+        nbfiles - nb_pending, nb_pending);
+
+    if (nb_pending > 0) {
+        gfal_srm_easy_t easy = gfal_srm_ifce_easy_context(opts, surls[pending[0]], &tmp_err);
+        if (easy != NULL) {
+            char **decoded = g_new(char*, nb_pending + 1);
+            struct stat *stats = g_new0(struct stat, nb_pending);
+            TFileLocality *locs = g_new0(TFileLocality, nb_pending);
+            GError **ls_errors = g_new0(GError*, nb_pending);
+
+            for (j = 0; j < nb_pending; ++j) {
+                decoded[j] = gfal2_srm_get_decoded_path(surls[pending[j]]);
+            }
+            decoded[nb_pending] = NULL;
+
+            ret = gfal_statG_srmv2_list_internal(opts, easy->srm_context, nb_pending, decoded, stats, locs, ls_errors);
+
+            for (j = 0; j < nb_pending; ++j) {
+                i = pending[j];
+                if (ls_errors[j] == NULL) {
+                    buffs[i] = stats[j];
+                    gfal_srm_cache_stat_add(ch, surls[i], &stats[j], &locs[j]);
+                }
+                else {
+                    gfal2_propagate_prefixed_error(&errors[i], ls_errors[j], __func__);
+                }
+            }
+
+            g_strfreev(decoded);
+            g_free(stats);
+            g_free(locs);
+            g_free(ls_errors);
+        }
+        else {
+            for (j = 0; j < nb_pending; ++j) {
+                errors[pending[j]] = g_error_copy(tmp_err);
+            }
+            g_error_free(tmp_err);
+            ret = -1;
+        }
+        gfal_srm_ifce_easy_context_release(opts, easy);
+    }
+
+    g_free(pending);
+    return ret;
+}
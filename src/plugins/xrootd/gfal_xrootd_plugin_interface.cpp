@@ -18,14 +18,19 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <condition_variable>
 #include <iostream>
 #include <mutex>
+#include <vector>
 #include <sys/stat.h>
 
 // This header provides all the required functions except chmod
 #include <XrdPosix/XrdPosixXrootd.hh>
 
+// For vector reads
+#include <XrdOuc/XrdOucIOVec.hh>
+
 // This header is required for chmod
 #include <XrdCl/XrdClFileSystem.hh>
 
@@ -132,6 +137,84 @@ ssize_t gfal_xrootd_writeG(plugin_handle handle, gfal_file_handle fd,
 }
 
 
+ssize_t gfal_xrootd_preadG(plugin_handle handle, gfal_file_handle fd, void *buff,
+        size_t count, off_t offset, GError ** err)
+{
+    int * fdesc = (int*) (gfal_file_handle_get_fdesc(fd));
+    if (!fdesc) {
+        gfal2_xrootd_set_error(err, errno, __func__, "Bad file handle");
+        return -1;
+    }
+    ssize_t l = XrdPosixXrootd::Pread(*fdesc, buff, count, offset);
+    if (l < 0) {
+        gfal2_xrootd_set_error(err, errno, __func__, "Failed while reading from file");
+        return -1;
+    }
+    return l;
+}
+
+
+ssize_t gfal_xrootd_pwriteG(plugin_handle handle, gfal_file_handle fd,
+        const void *buff, size_t count, off_t offset, GError ** err)
+{
+    int * fdesc = (int*) (gfal_file_handle_get_fdesc(fd));
+    if (!fdesc) {
+        gfal2_xrootd_set_error(err, errno, __func__, "Bad file handle");
+        return -1;
+    }
+    ssize_t l = XrdPosixXrootd::Pwrite(*fdesc, buff, count, offset);
+    if (l < 0) {
+        gfal2_xrootd_set_error(err, errno, __func__, "Failed while writing to file");
+        return -1;
+    }
+    return l;
+}
+
+
+// Limits of a kXR_readv request: number of chunks, and size of each chunk
+#define XROOTD_READV_MAX_CHUNKS 1024
+#define XROOTD_READV_MAX_CHUNK_SIZE 2097136
+
+ssize_t gfal_xrootd_preadvG(plugin_handle handle, gfal_file_handle fd,
+        const struct iovec *iov, const off_t *offsets, int count, GError ** err)
+{
+    int * fdesc = (int*) (gfal_file_handle_get_fdesc(fd));
+    if (!fdesc) {
+        gfal2_xrootd_set_error(err, errno, __func__, "Bad file handle");
+        return -1;
+    }
+
+    // Ranges bigger than what kXR_readv accepts are split
+    std::vector<XrdOucIOVec> chunks;
+    chunks.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        char *data = static_cast<char*>(iov[i].iov_base);
+        size_t done = 0;
+        do {
+            XrdOucIOVec chunk;
+            chunk.offset = offsets[i] + done;
+            chunk.size = static_cast<int>(std::min<size_t>(iov[i].iov_len - done, XROOTD_READV_MAX_CHUNK_SIZE));
+            chunk.info = 0;
+            chunk.data = data + done;
+            chunks.push_back(chunk);
+            done += chunk.size;
+        } while (done < iov[i].iov_len);
+    }
+
+    ssize_t total = 0;
+    for (size_t first = 0; first < chunks.size(); first += XROOTD_READV_MAX_CHUNKS) {
+        int n = static_cast<int>(std::min<size_t>(chunks.size() - first, XROOTD_READV_MAX_CHUNKS));
+        ssize_t l = XrdPosixXrootd::VRead(*fdesc, &chunks[first], n);
+        if (l < 0) {
+            gfal2_xrootd_set_error(err, errno, __func__, "Failed while reading from file");
+            return -1;
+        }
+        total += l;
+    }
+    return total;
+}
+
+
 off_t gfal_xrootd_lseekG(plugin_handle handle, gfal_file_handle fd,
         off_t offset, int whence, GError **err)
 {
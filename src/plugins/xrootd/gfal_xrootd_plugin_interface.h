@@ -21,6 +21,7 @@
 #ifndef GFAL_XROOTD_PLUGIN_INTERFACE_H_
 #define GFAL_XROOTD_PLUGIN_INTERFACE_H_
 
+#include <sys/uio.h>
 #include <gfal_plugins_api.h>
 
 #define XROOTD_CONFIG_GROUP     "XROOTD PLUGIN"
@@ -42,6 +43,13 @@ ssize_t gfal_xrootd_writeG(plugin_handle handle, gfal_file_handle fd, const void
 
 off_t gfal_xrootd_lseekG(plugin_handle handle, gfal_file_handle fd, off_t offset, int whence, GError **err);
 
+ssize_t gfal_xrootd_preadG(plugin_handle handle, gfal_file_handle fd, void *buff, size_t count, off_t offset, GError ** err);
+
+ssize_t gfal_xrootd_pwriteG(plugin_handle handle, gfal_file_handle fd, const void *buff, size_t count, off_t offset, GError ** err);
+
+// Reads count ranges of iov[i].iov_len bytes at offsets[i] with kXR_readv, returns the total number of bytes read
+ssize_t gfal_xrootd_preadvG(plugin_handle handle, gfal_file_handle fd, const struct iovec *iov, const off_t *offsets, int count, GError ** err);
+
 int gfal_xrootd_closeG(plugin_handle handle, gfal_file_handle fd, GError ** err);
 
 int gfal_xrootd_mkdirpG(plugin_handle plugin_data, const char *url, mode_t mode, gboolean pflag, GError **err);
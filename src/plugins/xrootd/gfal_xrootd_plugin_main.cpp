@@ -29,6 +29,10 @@ extern "C" {
 
 gboolean gfal_xrootd_check_url(plugin_handle ch, const char* url,  plugin_mode mode, GError** err);
 
+// URL schemes handled by this plugin
+static const char* const xrootd_schemes[] = {"root", "roots", "xroot", "xroots", NULL};
+
+
 gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError** err)
 {
     static XrdPosixXrootd singleXroot;
@@ -43,6 +47,7 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError** err)
 
     xrootd_plugin.getName = &gfal_xrootd_getName;
     xrootd_plugin.check_plugin_url = &gfal_xrootd_check_url;
+    xrootd_plugin.url_schemes = xrootd_schemes;
 
     xrootd_plugin.openG = &gfal_xrootd_openG;
     xrootd_plugin.closeG = &gfal_xrootd_closeG;
@@ -53,8 +58,9 @@ gfal_plugin_interface gfal_plugin_init(gfal2_context_t handle, GError** err)
     xrootd_plugin.statG = &gfal_xrootd_statG;
     xrootd_plugin.lstatG = &gfal_xrootd_statG;
 
-    xrootd_plugin.preadG = NULL; // &gfal_xrootd_preadG;
-    xrootd_plugin.pwriteG = NULL; // &gfal_xrootd_pwriteG;
+    xrootd_plugin.preadG = &gfal_xrootd_preadG;
+    xrootd_plugin.pwriteG = &gfal_xrootd_pwriteG;
+    xrootd_plugin.preadvG = &gfal_xrootd_preadvG;
 
     xrootd_plugin.mkdirpG = &gfal_xrootd_mkdirpG;
     xrootd_plugin.chmodG = &gfal_xrootd_chmodG;
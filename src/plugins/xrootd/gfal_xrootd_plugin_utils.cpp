@@ -154,11 +154,9 @@ static void fill_query(gfal_handle_ *context, const char *url, gfal2_uri *uri)
     std::string args = query_args(context, url);
     if (!args.empty()) {
         if (uri->query != NULL) {
-            char *p = uri->query;
-            uri->query = g_strconcat(uri->query, "&", args.c_str(), NULL);
-            g_free(p);
+            gfal2_uri_replace(uri, &uri->query, g_strconcat(uri->query, "&", args.c_str(), NULL));
         } else {
-            uri->query = g_strdup(args.c_str());
+            gfal2_uri_replace(uri, &uri->query, g_strdup(args.c_str()));
         }
     }
     gfal2_log(G_LOG_LEVEL_DEBUG, "Xrootd Query URI: %s", uri->query);
@@ -170,20 +168,16 @@ static void fill_query(gfal_handle_ *context, const char *url, gfal2_uri *uri)
 static void normalize_path(gfal2_uri *uri)
 {
     if (uri->path == NULL) {
-        uri->path = g_strdup("///");
+        gfal2_uri_replace(uri, &uri->path, g_strdup("///"));
     }
     else if (strncmp(uri->path, "///", 3) == 0) {
         // pass
     }
     else if (strncmp(uri->path, "//", 2) == 0) {
-        char *p = uri->path;
-        uri->path = g_strconcat("/", uri->path, NULL);
-        g_free(p);
+        gfal2_uri_replace(uri, &uri->path, g_strconcat("/", uri->path, NULL));
     }
     else {
-        char *p = uri->path;
-        uri->path = g_strconcat("//", uri->path, NULL);
-        g_free(p);
+        gfal2_uri_replace(uri, &uri->path, g_strconcat("//", uri->path, NULL));
     }
 }
 
@@ -0,0 +1,564 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <pthread.h>
+#include <string.h>
+#include <zlib.h>
+#include "checksum_kernels.h"
+
+// The SIMD kernels need the target attribute to work with intrinsics
+#if defined(__x86_64__) && (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define GFAL2_CHECKSUM_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+#define ADLER_BASE 65521U
+// Largest n such that 255n(n+1)/2 + (n+1)(BASE-1) <= 2^32-1, as in zlib
+#define ADLER_NMAX 5552
+
+// zlib takes the length as uInt
+#define ZLIB_MAX_CHUNK (1U << 30)
+
+
+// ----------------------------------------------------------------------------------------------------
+// Portable
+
+static uint32_t adler32_zlib(uint32_t value, const unsigned char *data, size_t size)
+{
+    while (size > 0) {
+        uInt chunk = size > ZLIB_MAX_CHUNK ? ZLIB_MAX_CHUNK : (uInt) size;
+        value = adler32(value, data, chunk);
+        data += chunk;
+        size -= chunk;
+    }
+    return value;
+}
+
+
+static uint32_t crc32_zlib(uint32_t value, const unsigned char *data, size_t size)
+{
+    while (size > 0) {
+        uInt chunk = size > ZLIB_MAX_CHUNK ? ZLIB_MAX_CHUNK : (uInt) size;
+        value = crc32(value, data, chunk);
+        data += chunk;
+        size -= chunk;
+    }
+    return value;
+}
+
+
+// CRC32C (Castagnoli), reflected polynomial
+#define CRC32C_POLY 0x82F63B78U
+
+static uint32_t crc32c_table[8][256];
+static pthread_once_t crc32c_table_once = PTHREAD_ONCE_INIT;
+
+
+static void crc32c_init_table(void)
+{
+    uint32_t i, j, crc;
+    for (i = 0; i < 256; ++i) {
+        crc = i;
+        for (j = 0; j < 8; ++j) {
+            crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+        }
+        crc32c_table[0][i] = crc;
+    }
+    for (i = 0; i < 256; ++i) {
+        crc = crc32c_table[0][i];
+        for (j = 1; j < 8; ++j) {
+            crc = crc32c_table[0][crc & 0xff] ^ (crc >> 8);
+            crc32c_table[j][i] = crc;
+        }
+    }
+}
+
+
+static uint32_t crc32c_slicing(uint32_t value, const unsigned char *data, size_t size)
+{
+    uint32_t crc = ~value;
+
+    pthread_once(&crc32c_table_once, crc32c_init_table);
+
+    while (size > 0 && ((uintptr_t) data & 7)) {
+        crc = crc32c_table[0][(crc ^ *data++) & 0xff] ^ (crc >> 8);
+        --size;
+    }
+    while (size >= 8) {
+        uint32_t lo, hi;
+        memcpy(&lo, data, 4);
+        memcpy(&hi, data + 4, 4);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        lo = __builtin_bswap32(lo);
+        hi = __builtin_bswap32(hi);
+#endif
+        lo ^= crc;
+        crc = crc32c_table[7][lo & 0xff] ^ crc32c_table[6][(lo >> 8) & 0xff] ^
+              crc32c_table[5][(lo >> 16) & 0xff] ^ crc32c_table[4][lo >> 24] ^
+              crc32c_table[3][hi & 0xff] ^ crc32c_table[2][(hi >> 8) & 0xff] ^
+              crc32c_table[1][(hi >> 16) & 0xff] ^ crc32c_table[0][hi >> 24];
+        data += 8;
+        size -= 8;
+    }
+    while (size > 0) {
+        crc = crc32c_table[0][(crc ^ *data++) & 0xff] ^ (crc >> 8);
+        --size;
+    }
+    return ~crc;
+}
+
+
+// Combination of checksums computed over consecutive ranges
+// zlib has no CRC32C variant, so use the same GF(2) matrix method with the Castagnoli polynomial
+
+static uint32_t gf2_matrix_times(const uint32_t *mat, uint32_t vec)
+{
+    uint32_t sum = 0;
+    while (vec) {
+        if (vec & 1)
+            sum ^= *mat;
+        vec >>= 1;
+        ++mat;
+    }
+    return sum;
+}
+
+
+static void gf2_matrix_square(uint32_t *square, const uint32_t *mat)
+{
+    int n;
+    for (n = 0; n < 32; ++n)
+        square[n] = gf2_matrix_times(mat, mat[n]);
+}
+
+
+uint32_t gfal2_crc32c_combine(uint32_t crc1, uint32_t crc2, uint64_t len2)
+{
+    uint32_t even[32], odd[32], row;
+    int n;
+
+    if (len2 == 0)
+        return crc1;
+
+    // Operator for one zero bit
+    odd[0] = CRC32C_POLY;
+    row = 1;
+    for (n = 1; n < 32; ++n) {
+        odd[n] = row;
+        row <<= 1;
+    }
+    // Two, then four zero bits
+    gf2_matrix_square(even, odd);
+    gf2_matrix_square(odd, even);
+
+    // Apply len2 zero bytes to crc1
+    do {
+        gf2_matrix_square(even, odd);
+        if (len2 & 1)
+            crc1 = gf2_matrix_times(even, crc1);
+        len2 >>= 1;
+        if (len2 == 0)
+            break;
+        gf2_matrix_square(odd, even);
+        if (len2 & 1)
+            crc1 = gf2_matrix_times(odd, crc1);
+        len2 >>= 1;
+    } while (len2 != 0);
+
+    return crc1 ^ crc2;
+}
+
+
+uint32_t gfal2_adler32_combine(uint32_t adler1, uint32_t adler2, uint64_t len2)
+{
+    return adler32_combine(adler1, adler2, (z_off_t) len2);
+}
+
+
+uint32_t gfal2_crc32_combine(uint32_t crc1, uint32_t crc2, uint64_t len2)
+{
+    return crc32_combine(crc1, crc2, (z_off_t) len2);
+}
+
+
+static const gfal2_checksum_kernels scalar_kernels = {
+    "scalar", adler32_zlib, crc32_zlib, crc32c_slicing
+};
+
+
+const gfal2_checksum_kernels *gfal2_checksum_kernels_scalar(void)
+{
+    return &scalar_kernels;
+}
+
+
+#ifdef GFAL2_CHECKSUM_X86
+
+// ----------------------------------------------------------------------------------------------------
+// ADLER32, after the SSSE3 version from Chromium's zlib
+// The data is processed in blocks of 32 bytes: s1 is the sum of the bytes, and each byte contributes
+// to s2 with a weight given by its distance to the end of the block
+
+static uint32_t adler32_finish(uint32_t s1, uint32_t s2, const unsigned char *data, size_t size)
+{
+    while (size--) {
+        s1 += *data++;
+        s2 += s1;
+    }
+    s1 %= ADLER_BASE;
+    s2 %= ADLER_BASE;
+    return s1 | (s2 << 16);
+}
+
+
+__attribute__((target("ssse3")))
+static uint32_t adler32_ssse3(uint32_t value, const unsigned char *data, size_t size)
+{
+    uint32_t s1 = value & 0xffff;
+    uint32_t s2 = value >> 16;
+    size_t blocks = size / 32;
+    size -= blocks * 32;
+
+    const __m128i tap1 = _mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17);
+    const __m128i tap2 = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+
+    while (blocks) {
+        unsigned n = ADLER_NMAX / 32;
+        if (n > blocks)
+            n = (unsigned) blocks;
+        blocks -= n;
+
+        // v_ps accumulates s1 at the start of each block, which contributes 32 times to s2
+        __m128i v_ps = _mm_set_epi32(0, 0, 0, s1 * n);
+        __m128i v_s2 = _mm_set_epi32(0, 0, 0, s2);
+        __m128i v_s1 = _mm_setzero_si128();
+
+        do {
+            const __m128i bytes1 = _mm_loadu_si128((const __m128i *) data);
+            const __m128i bytes2 = _mm_loadu_si128((const __m128i *) (data + 16));
+
+            v_ps = _mm_add_epi32(v_ps, v_s1);
+
+            v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes1, zero));
+            v_s2 = _mm_add_epi32(v_s2, _mm_madd_epi16(_mm_maddubs_epi16(bytes1, tap1), ones));
+            v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes2, zero));
+            v_s2 = _mm_add_epi32(v_s2, _mm_madd_epi16(_mm_maddubs_epi16(bytes2, tap2), ones));
+
+            data += 32;
+        } while (--n);
+
+        v_s2 = _mm_add_epi32(v_s2, _mm_slli_epi32(v_ps, 5));
+
+        v_s1 = _mm_add_epi32(v_s1, _mm_shuffle_epi32(v_s1, _MM_SHUFFLE(2, 3, 0, 1)));
+        v_s1 = _mm_add_epi32(v_s1, _mm_shuffle_epi32(v_s1, _MM_SHUFFLE(1, 0, 3, 2)));
+        s1 += _mm_cvtsi128_si32(v_s1);
+
+        v_s2 = _mm_add_epi32(v_s2, _mm_shuffle_epi32(v_s2, _MM_SHUFFLE(2, 3, 0, 1)));
+        v_s2 = _mm_add_epi32(v_s2, _mm_shuffle_epi32(v_s2, _MM_SHUFFLE(1, 0, 3, 2)));
+        s2 = _mm_cvtsi128_si32(v_s2);
+
+        s1 %= ADLER_BASE;
+        s2 %= ADLER_BASE;
+    }
+
+    return adler32_finish(s1, s2, data, size);
+}
+
+
+__attribute__((target("avx2")))
+static uint32_t adler32_avx2(uint32_t value, const unsigned char *data, size_t size)
+{
+    uint32_t s1 = value & 0xffff;
+    uint32_t s2 = value >> 16;
+    size_t blocks = size / 32;
+    size -= blocks * 32;
+
+    const __m256i tap = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17,
+                                         16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(1);
+
+    while (blocks) {
+        unsigned n = ADLER_NMAX / 32;
+        if (n > blocks)
+            n = (unsigned) blocks;
+        blocks -= n;
+
+        __m256i v_ps = _mm256_setr_epi32(s1 * n, 0, 0, 0, 0, 0, 0, 0);
+        __m256i v_s2 = _mm256_setr_epi32(s2, 0, 0, 0, 0, 0, 0, 0);
+        __m256i v_s1 = _mm256_setzero_si256();
+
+        do {
+            const __m256i bytes = _mm256_loadu_si256((const __m256i *) data);
+
+            v_ps = _mm256_add_epi32(v_ps, v_s1);
+            v_s1 = _mm256_add_epi32(v_s1, _mm256_sad_epu8(bytes, zero));
+            v_s2 = _mm256_add_epi32(v_s2, _mm256_madd_epi16(_mm256_maddubs_epi16(bytes, tap), ones));
+
+            data += 32;
+        } while (--n);
+
+        v_s2 = _mm256_add_epi32(v_s2, _mm256_slli_epi32(v_ps, 5));
+
+        __m128i h_s1 = _mm_add_epi32(_mm256_castsi256_si128(v_s1), _mm256_extracti128_si256(v_s1, 1));
+        h_s1 = _mm_add_epi32(h_s1, _mm_shuffle_epi32(h_s1, _MM_SHUFFLE(2, 3, 0, 1)));
+        h_s1 = _mm_add_epi32(h_s1, _mm_shuffle_epi32(h_s1, _MM_SHUFFLE(1, 0, 3, 2)));
+        s1 += _mm_cvtsi128_si32(h_s1);
+
+        __m128i h_s2 = _mm_add_epi32(_mm256_castsi256_si128(v_s2), _mm256_extracti128_si256(v_s2, 1));
+        h_s2 = _mm_add_epi32(h_s2, _mm_shuffle_epi32(h_s2, _MM_SHUFFLE(2, 3, 0, 1)));
+        h_s2 = _mm_add_epi32(h_s2, _mm_shuffle_epi32(h_s2, _MM_SHUFFLE(1, 0, 3, 2)));
+        s2 = _mm_cvtsi128_si32(h_s2);
+
+        s1 %= ADLER_BASE;
+        s2 %= ADLER_BASE;
+    }
+
+    return adler32_finish(s1, s2, data, size);
+}
+
+
+// ----------------------------------------------------------------------------------------------------
+// CRC32 folding with carry-less multiplication
+// "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction", Intel, 2009
+// Constants for the bit-reflected gzip polynomial
+
+__attribute__((target("pclmul,sse4.1")))
+static uint32_t crc32_fold(uint32_t crc, const unsigned char *data, size_t size)
+{
+    static const uint64_t k1k2[2] __attribute__((aligned(16))) = {0x0154442bd4ULL, 0x01c6e41596ULL};
+    static const uint64_t k3k4[2] __attribute__((aligned(16))) = {0x01751997d0ULL, 0x00ccaa009eULL};
+    static const uint64_t k5k0[2] __attribute__((aligned(16))) = {0x0163cd6124ULL, 0x0000000000ULL};
+    static const uint64_t poly[2] __attribute__((aligned(16))) = {0x01db710641ULL, 0x01f7011641ULL};
+
+    __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+    // size >= 64 and multiple of 16
+    x1 = _mm_loadu_si128((const __m128i *) (data + 0x00));
+    x2 = _mm_loadu_si128((const __m128i *) (data + 0x10));
+    x3 = _mm_loadu_si128((const __m128i *) (data + 0x20));
+    x4 = _mm_loadu_si128((const __m128i *) (data + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(crc));
+    x0 = _mm_load_si128((const __m128i *) k1k2);
+    data += 64;
+    size -= 64;
+
+    // Fold by 4 blocks of 16 bytes
+    while (size >= 64) {
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+        x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+        y5 = _mm_loadu_si128((const __m128i *) (data + 0x00));
+        y6 = _mm_loadu_si128((const __m128i *) (data + 0x10));
+        y7 = _mm_loadu_si128((const __m128i *) (data + 0x20));
+        y8 = _mm_loadu_si128((const __m128i *) (data + 0x30));
+
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+
+        data += 64;
+        size -= 64;
+    }
+
+    // Fold the 4 blocks into one
+    x0 = _mm_load_si128((const __m128i *) k3k4);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+    // Remaining blocks of 16 bytes
+    while (size >= 16) {
+        x2 = _mm_loadu_si128((const __m128i *) data);
+
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+        data += 16;
+        size -= 16;
+    }
+
+    // Fold 128 bits into 64
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+    x1 = _mm_srli_si128(x1, 8);
+    x1 = _mm_xor_si128(x1, x2);
+
+    x0 = _mm_loadl_epi64((const __m128i *) k5k0);
+
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, x3);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    // Barrett reduction to 32 bits
+    x0 = _mm_load_si128((const __m128i *) poly);
+
+    x2 = _mm_and_si128(x1, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2 = _mm_and_si128(x2, x3);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    return (uint32_t) _mm_extract_epi32(x1, 1);
+}
+
+
+static uint32_t crc32_pclmul(uint32_t value, const unsigned char *data, size_t size)
+{
+    if (size >= 64) {
+        size_t chunk = size & ~(size_t) 15;
+        value = ~crc32_fold(~value, data, chunk);
+        data += chunk;
+        size -= chunk;
+    }
+    return crc32_zlib(value, data, size);
+}
+
+
+// ----------------------------------------------------------------------------------------------------
+// CRC32C with the SSE4.2 instruction
+
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_sse42(uint32_t value, const unsigned char *data, size_t size)
+{
+    uint64_t crc = ~value;
+
+    while (size > 0 && ((uintptr_t) data & 7)) {
+        crc = _mm_crc32_u8((uint32_t) crc, *data++);
+        --size;
+    }
+    while (size >= 32) {
+        uint64_t w0, w1, w2, w3;
+        memcpy(&w0, data, 8);
+        memcpy(&w1, data + 8, 8);
+        memcpy(&w2, data + 16, 8);
+        memcpy(&w3, data + 24, 8);
+        crc = _mm_crc32_u64(crc, w0);
+        crc = _mm_crc32_u64(crc, w1);
+        crc = _mm_crc32_u64(crc, w2);
+        crc = _mm_crc32_u64(crc, w3);
+        data += 32;
+        size -= 32;
+    }
+    while (size >= 8) {
+        uint64_t w;
+        memcpy(&w, data, 8);
+        crc = _mm_crc32_u64(crc, w);
+        data += 8;
+        size -= 8;
+    }
+    while (size > 0) {
+        crc = _mm_crc32_u8((uint32_t) crc, *data++);
+        --size;
+    }
+    return ~(uint32_t) crc;
+}
+
+
+// ----------------------------------------------------------------------------------------------------
+// Dispatch
+
+static int cpu_has_avx2(void)
+{
+    unsigned eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_OSXSAVE))
+        return 0;
+    // The OS must save the YMM registers
+    unsigned xcr0_lo, xcr0_hi;
+    __asm__ ("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+    if ((xcr0_lo & 6) != 6)
+        return 0;
+    if (__get_cpuid_max(0, NULL) < 7)
+        return 0;
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    return (ebx & bit_AVX2) != 0;
+}
+
+
+static gfal2_checksum_kernels best_kernels;
+static pthread_once_t best_kernels_once = PTHREAD_ONCE_INIT;
+
+
+static void select_kernels(void)
+{
+    unsigned eax, ebx, ecx, edx;
+    static char name[64];
+
+    best_kernels = scalar_kernels;
+    name[0] = '\0';
+
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        if (ecx & bit_SSSE3) {
+            best_kernels.adler32 = adler32_ssse3;
+            strcat(name, "ssse3 ");
+        }
+        if ((ecx & bit_PCLMUL) && (ecx & bit_SSE4_1)) {
+            best_kernels.crc32 = crc32_pclmul;
+            strcat(name, "pclmul ");
+        }
+        if (ecx & bit_SSE4_2) {
+            best_kernels.crc32c = crc32c_sse42;
+            strcat(name, "sse4.2 ");
+        }
+    }
+    if (cpu_has_avx2()) {
+        best_kernels.adler32 = adler32_avx2;
+        strcat(name, "avx2 ");
+    }
+
+    if (name[0] != '\0') {
+        name[strlen(name) - 1] = '\0';
+        best_kernels.name = name;
+    }
+}
+
+
+const gfal2_checksum_kernels *gfal2_checksum_kernels_best(void)
+{
+    pthread_once(&best_kernels_once, select_kernels);
+    return &best_kernels;
+}
+
+#else
+
+const gfal2_checksum_kernels *gfal2_checksum_kernels_best(void)
+{
+    return &scalar_kernels;
+}
+
+#endif
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Checksum kernels, selected at runtime depending on the CPU
+// The values are the "public" ones (i.e. crc32(0, NULL, 0) == 0, adler32 starts at 1)
+
+typedef uint32_t (*gfal2_checksum_kernel)(uint32_t value, const unsigned char *data, size_t size);
+
+typedef struct {
+    const char *name;
+    gfal2_checksum_kernel adler32;
+    gfal2_checksum_kernel crc32;
+    gfal2_checksum_kernel crc32c;
+} gfal2_checksum_kernels;
+
+/**
+ * Portable implementations: zlib for ADLER32 and CRC32, slicing by 8 for CRC32C
+ */
+const gfal2_checksum_kernels *gfal2_checksum_kernels_scalar(void);
+
+/**
+ * Fastest implementations supported by this CPU
+ */
+const gfal2_checksum_kernels *gfal2_checksum_kernels_best(void);
+
+/**
+ * Checksum of the concatenation of two ranges, from the checksum of each range
+ * and the length of the second one
+ */
+uint32_t gfal2_adler32_combine(uint32_t adler1, uint32_t adler2, uint64_t len2);
+uint32_t gfal2_crc32_combine(uint32_t crc1, uint32_t crc2, uint64_t len2);
+uint32_t gfal2_crc32c_combine(uint32_t crc1, uint32_t crc2, uint64_t len2);
+
+#ifdef __cplusplus
+}
+#endif
@@ -18,8 +18,12 @@
  * limitations under the License.
  */
 
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include "checksums.h"
+#include "checksum_kernels.h"
 
 
 static const char* _no_zeros(const char* str)
@@ -318,3 +322,141 @@ void gfal2_md5_to_hex_string(const unsigned char *bytes, char *hex, size_t hex_s
     }
     *p = '\0';
 }
+
+
+// ----------------------------------------------------------------------------------------------------
+// Streamed checksums
+
+// The data is fed to each algorithm by slices small enough to stay in cache,
+// so computing several checksums costs a single pass over memory
+#define CHECKSUM_SLICE_SIZE (32 * 1024)
+
+struct gfal2_checksum_ctx {
+    unsigned algorithms;
+    const gfal2_checksum_kernels *kernels;
+    uint32_t adler32, crc32, crc32c;
+    GFAL_MD5_CTX md5;
+    uint64_t length;
+};
+
+
+gfal2_checksum_algorithm gfal2_checksum_algorithm_from_name(const char *type)
+{
+    if (strcasecmp(type, "adler32") == 0)
+        return GFAL2_CHECKSUM_ADLER32;
+    else if (strcasecmp(type, "crc32") == 0)
+        return GFAL2_CHECKSUM_CRC32;
+    else if (strcasecmp(type, "crc32c") == 0)
+        return GFAL2_CHECKSUM_CRC32C;
+    else if (strcasecmp(type, "md5") == 0)
+        return GFAL2_CHECKSUM_MD5;
+    return 0;
+}
+
+
+gfal2_checksum_ctx *gfal2_checksum_ctx_new_multi(unsigned algorithms)
+{
+    if (algorithms == 0 || (algorithms & ~GFAL2_CHECKSUM_ALL))
+        return NULL;
+
+    gfal2_checksum_ctx *ctx = calloc(1, sizeof(*ctx));
+    ctx->algorithms = algorithms;
+    ctx->kernels = gfal2_checksum_kernels_best();
+    ctx->adler32 = 1;
+    ctx->crc32 = 0;
+    ctx->crc32c = 0;
+    if (algorithms & GFAL2_CHECKSUM_MD5)
+        gfal2_md5_init(&ctx->md5);
+    return ctx;
+}
+
+
+gfal2_checksum_ctx *gfal2_checksum_ctx_new(const char *type)
+{
+    return gfal2_checksum_ctx_new_multi(gfal2_checksum_algorithm_from_name(type));
+}
+
+
+void gfal2_checksum_ctx_update(gfal2_checksum_ctx *ctx, const void *data, size_t size)
+{
+    const unsigned char *p = (const unsigned char *) data;
+
+    ctx->length += size;
+    while (size > 0) {
+        size_t slice = size < CHECKSUM_SLICE_SIZE ? size : CHECKSUM_SLICE_SIZE;
+
+        if (ctx->algorithms & GFAL2_CHECKSUM_ADLER32)
+            ctx->adler32 = ctx->kernels->adler32(ctx->adler32, p, slice);
+        if (ctx->algorithms & GFAL2_CHECKSUM_CRC32)
+            ctx->crc32 = ctx->kernels->crc32(ctx->crc32, p, slice);
+        if (ctx->algorithms & GFAL2_CHECKSUM_CRC32C)
+            ctx->crc32c = ctx->kernels->crc32c(ctx->crc32c, p, slice);
+        if (ctx->algorithms & GFAL2_CHECKSUM_MD5)
+            gfal2_md5_update(&ctx->md5, p, (unsigned long) slice);
+
+        p += slice;
+        size -= slice;
+    }
+}
+
+
+int gfal2_checksum_ctx_combine(gfal2_checksum_ctx *ctx, const gfal2_checksum_ctx *next)
+{
+    if (ctx->algorithms != next->algorithms || (ctx->algorithms & ~GFAL2_CHECKSUM_COMBINABLE))
+        return -1;
+
+    if (ctx->algorithms & GFAL2_CHECKSUM_ADLER32)
+        ctx->adler32 = gfal2_adler32_combine(ctx->adler32, next->adler32, next->length);
+    if (ctx->algorithms & GFAL2_CHECKSUM_CRC32)
+        ctx->crc32 = gfal2_crc32_combine(ctx->crc32, next->crc32, next->length);
+    if (ctx->algorithms & GFAL2_CHECKSUM_CRC32C)
+        ctx->crc32c = gfal2_crc32c_combine(ctx->crc32c, next->crc32c, next->length);
+    ctx->length += next->length;
+    return 0;
+}
+
+
+int gfal2_checksum_ctx_final_algorithm(gfal2_checksum_ctx *ctx, gfal2_checksum_algorithm algorithm,
+    char *buffer, size_t size)
+{
+    unsigned char md5[16];
+    int ret;
+
+    if (!(ctx->algorithms & algorithm))
+        return -1;
+
+    switch (algorithm) {
+        case GFAL2_CHECKSUM_ADLER32:
+            ret = snprintf(buffer, size, "%08x", ctx->adler32);
+            break;
+        case GFAL2_CHECKSUM_CRC32:
+            ret = snprintf(buffer, size, "%u", ctx->crc32);
+            break;
+        case GFAL2_CHECKSUM_CRC32C:
+            ret = snprintf(buffer, size, "%08x", ctx->crc32c);
+            break;
+        case GFAL2_CHECKSUM_MD5:
+            if (size < 33)
+                return -1;
+            gfal2_md5_final(md5, &ctx->md5);
+            gfal2_md5_to_hex_string(md5, buffer, sizeof(md5));
+            return 0;
+        default:
+            return -1;
+    }
+    return (ret < 0 || (size_t) ret >= size) ? -1 : 0;
+}
+
+
+int gfal2_checksum_ctx_final(gfal2_checksum_ctx *ctx, char *buffer, size_t size)
+{
+    // Lowest algorithm enabled
+    unsigned algorithm = ctx->algorithms & -ctx->algorithms;
+    return gfal2_checksum_ctx_final_algorithm(ctx, (gfal2_checksum_algorithm) algorithm, buffer, size);
+}
+
+
+void gfal2_checksum_ctx_free(gfal2_checksum_ctx *ctx)
+{
+    free(ctx);
+}
@@ -54,6 +54,66 @@ void gfal2_md5_final(unsigned char *result, GFAL_MD5_CTX *ctx);
 
 void gfal2_md5_to_hex_string(const unsigned char *bytes, char *hex, size_t hex_size);
 
+
+// streamed checksum calculation, for ADLER32, CRC32, CRC32C and MD5
+// Several algorithms can be computed in a single pass over the data
+
+typedef enum {
+    GFAL2_CHECKSUM_ADLER32 = 0x01,
+    GFAL2_CHECKSUM_CRC32   = 0x02,
+    GFAL2_CHECKSUM_CRC32C  = 0x04,
+    GFAL2_CHECKSUM_MD5     = 0x08,
+    GFAL2_CHECKSUM_ALL     = 0x0F
+} gfal2_checksum_algorithm;
+
+// Algorithms whose partial results over consecutive ranges can be combined
+#define GFAL2_CHECKSUM_COMBINABLE (GFAL2_CHECKSUM_ADLER32 | GFAL2_CHECKSUM_CRC32 | GFAL2_CHECKSUM_CRC32C)
+
+typedef struct gfal2_checksum_ctx gfal2_checksum_ctx;
+
+/**
+ * Returns the algorithm matching type (case insensitive), or 0 if it is not supported
+ */
+gfal2_checksum_algorithm gfal2_checksum_algorithm_from_name(const char *type);
+
+/**
+ * Allocate a checksum context for the algorithm type (case insensitive)
+ * Returns NULL if the algorithm is not supported
+ */
+gfal2_checksum_ctx *gfal2_checksum_ctx_new(const char *type);
+
+/**
+ * Allocate a checksum context computing all the algorithms set in the mask
+ * Returns NULL if the mask is empty or has unknown algorithms
+ */
+gfal2_checksum_ctx *gfal2_checksum_ctx_new_multi(unsigned algorithms);
+
+void gfal2_checksum_ctx_update(gfal2_checksum_ctx *ctx, const void *data, size_t size);
+
+/**
+ * Append to ctx the state of next, computed over the range that immediately follows
+ * Both contexts must compute the same algorithms, all of them in GFAL2_CHECKSUM_COMBINABLE
+ * Returns -1 otherwise
+ */
+int gfal2_checksum_ctx_combine(gfal2_checksum_ctx *ctx, const gfal2_checksum_ctx *next);
+
+/**
+ * Write the checksum into buffer, formatted as the file plugin does
+ * For a context with several algorithms, the one with the lowest value is used
+ * Returns -1 if the buffer is too short
+ */
+int gfal2_checksum_ctx_final(gfal2_checksum_ctx *ctx, char *buffer, size_t size);
+
+/**
+ * Write the checksum of one of the algorithms of the context into buffer
+ * Each algorithm can be finalized only once
+ * Returns -1 if the buffer is too short, or the algorithm is not computed by this context
+ */
+int gfal2_checksum_ctx_final_algorithm(gfal2_checksum_ctx *ctx, gfal2_checksum_algorithm algorithm,
+    char *buffer, size_t size);
+
+void gfal2_checksum_ctx_free(gfal2_checksum_ctx *ctx);
+
 #ifdef __cplusplus
 }
 #endif
@@ -26,93 +26,197 @@
 #include <pthread.h>
 #include "gcachemain.h"
 
-static const guint64 max_list_len = MAX_LIST_LEN;
+// Shards only pay off for caches big enough to keep a useful LRU per shard
+#define GSIMPLECACHE_SHARDS 16
+#define GSIMPLECACHE_SHARD_MIN_ITEMS 64
 
 
+typedef struct _Internal_item Internal_item;
 
+struct _Internal_item{
+    char* key;
+    int ref_count;
+    // monotonic time (usec) after which the item is stale, 0 never
+    gint64 expires;
+    // LRU list of the shard, most recently used first
+    Internal_item* prev;
+    Internal_item* next;
+    char item[];
+};
 
-typedef struct _Internal_item{
-	int ref_count;
-	char item[];
-} Internal_item;
+typedef struct {
+    pthread_mutex_t mux;
+    GHashTable* table;
+    Internal_item* head;
+    Internal_item* tail;
+    size_t max_number_item;
+    GSimpleCacheStats stats;
+} GSimpleCache_Shard;
 
 struct _GSimpleCache_Handle{
-	GHashTable*  table;
-	GSimpleCache_CopyConstructor do_copy;
-	size_t size_item;
+    GSimpleCache_CopyConstructor do_copy;
+    size_t size_item;
     size_t max_number_item;
-	pthread_mutex_t mux;
+    // default time to live for new items, in seconds, 0 never expire
+    volatile guint ttl;
+    guint n_shards;
+    GSimpleCache_Shard shards[];
 };
 
+
 static void gsimplecache_destroy_item_internal(gpointer a){
-	Internal_item* i = (Internal_item*) a;
-	g_free(i);
+    Internal_item* i = (Internal_item*) a;
+    free(i->key);
+    free(i);
 }
 
 
 static gboolean hash_strings_are_equals(gconstpointer a, gconstpointer b){
-	return (strcmp((char*) a, (char*) b)== 0);
+    return (strcmp((char*) a, (char*) b)== 0);
+}
+
+
+static GSimpleCache_Shard* gsimplecache_shard(GSimpleCache* cache, const char* key){
+    if (cache->n_shards == 1)
+        return &cache->shards[0];
+    return &cache->shards[g_str_hash(key) % cache->n_shards];
+}
+
+
+static void gsimplecache_lru_unlink(GSimpleCache_Shard* shard, Internal_item* i){
+    if (i->prev)
+        i->prev->next = i->next;
+    else
+        shard->head = i->next;
+    if (i->next)
+        i->next->prev = i->prev;
+    else
+        shard->tail = i->prev;
+    i->prev = i->next = NULL;
+}
+
+
+static void gsimplecache_lru_push_head(GSimpleCache_Shard* shard, Internal_item* i){
+    i->prev = NULL;
+    i->next = shard->head;
+    if (shard->head)
+        shard->head->prev = i;
+    shard->head = i;
+    if (shard->tail == NULL)
+        shard->tail = i;
+}
+
+
+static void gsimplecache_remove_item_internal(GSimpleCache_Shard* shard, Internal_item* i){
+    gsimplecache_lru_unlink(shard, i);
+    // the table owns the item, and frees it
+    g_hash_table_remove(shard->table, i->key);
+}
+
+
+static gboolean gsimplecache_is_expired(Internal_item* i, gint64 now){
+    return i->expires != 0 && now >= i->expires;
 }
 
 /**
- * Construct a new cache with a capacity of max_size bytes
+ * Construct a new cache holding at most max_number_item items
  * */
 GSimpleCache* gsimplecache_new(guint64 max_number_item, GSimpleCache_CopyConstructor value_copy, size_t size_item){
-	GSimpleCache* ret = (GSimpleCache*) g_new(struct _GSimpleCache_Handle,1);
-	ret->table = g_hash_table_new_full(&g_str_hash, &hash_strings_are_equals, &free, &gsimplecache_destroy_item_internal );
-	ret->do_copy = value_copy;
-	ret->size_item = size_item;
+    guint n_shards = 1;
+    if (max_number_item >= GSIMPLECACHE_SHARDS * GSIMPLECACHE_SHARD_MIN_ITEMS)
+        n_shards = GSIMPLECACHE_SHARDS;
+
+    GSimpleCache* ret = (GSimpleCache*) g_malloc0(sizeof(struct _GSimpleCache_Handle) +
+        n_shards * sizeof(GSimpleCache_Shard));
+    ret->do_copy = value_copy;
+    ret->size_item = size_item;
     ret->max_number_item = max_number_item;
-	pthread_mutex_init(&ret->mux,NULL);
-	return ret;
+    ret->ttl = 0;
+    ret->n_shards = n_shards;
+
+    guint s;
+    for (s = 0; s < n_shards; ++s) {
+        GSimpleCache_Shard* shard = &ret->shards[s];
+        shard->table = g_hash_table_new_full(&g_str_hash, &hash_strings_are_equals,
+            NULL, &gsimplecache_destroy_item_internal);
+        // the shard capacities add up to max_number_item
+        shard->max_number_item = max_number_item / n_shards + (s < max_number_item % n_shards ? 1 : 0);
+        if (shard->max_number_item == 0)
+            shard->max_number_item = 1;
+        pthread_mutex_init(&shard->mux, NULL);
+    }
+    return ret;
 }
 
 /**
  *  delete a cache object, all internals object are free
  * */
 void gsimplecache_delete(GSimpleCache* cache){
-	if(cache != NULL){
-		pthread_mutex_lock(&cache->mux);
-		g_hash_table_destroy (cache->table);
-		pthread_mutex_unlock(&cache->mux);
-		pthread_mutex_destroy(&cache->mux);
-		g_free(cache);
-	}
+    if(cache != NULL){
+        guint s;
+        for (s = 0; s < cache->n_shards; ++s) {
+            GSimpleCache_Shard* shard = &cache->shards[s];
+            pthread_mutex_lock(&shard->mux);
+            g_hash_table_destroy(shard->table);
+            pthread_mutex_unlock(&shard->mux);
+            pthread_mutex_destroy(&shard->mux);
+        }
+        g_free(cache);
+    }
 }
 
-Internal_item* gsimplecache_find_kstr_internal(GSimpleCache* cache, const char* key){
-	Internal_item* ret = (Internal_item*) g_hash_table_lookup(cache->table, (gconstpointer) key);
-	if(ret != NULL ){
-		return ret;
-	}
-	return NULL;
+
+void gsimplecache_set_ttl(GSimpleCache* cache, guint ttl){
+    cache->ttl = ttl;
 }
 
-static gboolean gsimplecache_remove_internal_kstr(GSimpleCache* cache, const char* key){
-		return g_hash_table_remove(cache->table, (gconstpointer) key);
+// Lookup key, dropping it if it is stale
+static Internal_item* gsimplecache_find_kstr_internal(GSimpleCache_Shard* shard, const char* key, gint64 now){
+    Internal_item* ret = (Internal_item*) g_hash_table_lookup(shard->table, (gconstpointer) key);
+    if(ret != NULL && gsimplecache_is_expired(ret, now)){
+        gsimplecache_remove_item_internal(shard, ret);
+        shard->stats.expirations++;
+        ret = NULL;
+    }
+    return ret;
 }
 
-// simple lazy space maker, can be improved
-static void gsimplecache_manage_space(GSimpleCache* cache){
-    size_t len = (size_t) g_hash_table_size (cache->table);
-    if(len >= cache->max_number_item){
-        g_hash_table_remove_all(cache->table);
+// Make room for one item, dropping the least recently used one
+static void gsimplecache_manage_space(GSimpleCache_Shard* shard, gint64 now){
+    while (shard->tail != NULL && g_hash_table_size(shard->table) >= shard->max_number_item) {
+        Internal_item* victim = shard->tail;
+        if (gsimplecache_is_expired(victim, now))
+            shard->stats.expirations++;
+        else
+            shard->stats.evictions++;
+        gsimplecache_remove_item_internal(shard, victim);
     }
 }
 
 
+static void gsimplecache_add_item_internal(GSimpleCache* cache, const char* key, void* item, guint ttl,
+    gboolean replace){
+    GSimpleCache_Shard* shard = gsimplecache_shard(cache, key);
+    const gint64 now = g_get_monotonic_time();
 
-void gsimplecache_add_item_internal(GSimpleCache* cache, const char* key, void* item){
-	Internal_item* ret = gsimplecache_find_kstr_internal(cache, key);
-	if(ret == NULL){
-        gsimplecache_manage_space(cache);
-		ret = malloc(sizeof(struct _Internal_item) + cache->size_item);
-		ret->ref_count = 2;
-		cache->do_copy(item, ret->item);
-		g_hash_table_insert(cache->table, strdup(key), ret);
-	}else{
-		(ret->ref_count)++;
-	}
+    pthread_mutex_lock(&shard->mux);
+    Internal_item* ret = gsimplecache_find_kstr_internal(shard, key, now);
+    if(ret == NULL){
+        gsimplecache_manage_space(shard, now);
+        ret = malloc(sizeof(struct _Internal_item) + cache->size_item);
+        ret->key = strdup(key);
+        ret->ref_count = 2;
+        cache->do_copy(item, ret->item);
+        g_hash_table_insert(shard->table, ret->key, ret);
+    }else{
+        (ret->ref_count)++;
+        if (replace)
+            cache->do_copy(item, ret->item);
+        gsimplecache_lru_unlink(shard, ret);
+    }
+    ret->expires = (ttl > 0) ? now + (gint64) ttl * G_USEC_PER_SEC : 0;
+    gsimplecache_lru_push_head(shard, ret);
+    pthread_mutex_unlock(&shard->mux);
 }
 
 
@@ -120,22 +224,54 @@ void gsimplecache_add_item_internal(GSimpleCache* cache, const char* key, void*
  * Add an item to the cache or increment the reference of this item of one if already exist
  * */
 void gsimplecache_add_item_kstr(GSimpleCache* cache, const char* key, void* item){
-	pthread_mutex_lock(&cache->mux);
-	gsimplecache_add_item_internal(cache, key, item);
-	pthread_mutex_unlock(&cache->mux);
+    gsimplecache_add_item_internal(cache, key, item, cache->ttl, FALSE);
 }
 
 
+void gsimplecache_add_item_kstr_ttl(GSimpleCache* cache, const char* key, void* item, guint ttl){
+    gsimplecache_add_item_internal(cache, key, item, ttl, FALSE);
+}
+
+
+void gsimplecache_replace_item_kstr_ttl(GSimpleCache* cache, const char* key, void* item, guint ttl){
+    gsimplecache_add_item_internal(cache, key, item, ttl, TRUE);
+}
+
 
 /**
  * remove the item in the cache, return TRUE if removed else FALSE
  * destroy the internal item automatically
  * */
 gboolean gsimplecache_remove_kstr(GSimpleCache* cache, const char* key){
-	pthread_mutex_lock(&cache->mux);
-	gboolean ret = gsimplecache_remove_internal_kstr(cache, key);
-	pthread_mutex_unlock(&cache->mux);
-	return ret;
+    GSimpleCache_Shard* shard = gsimplecache_shard(cache, key);
+    pthread_mutex_lock(&shard->mux);
+    Internal_item* ret = (Internal_item*) g_hash_table_lookup(shard->table, (gconstpointer) key);
+    if (ret)
+        gsimplecache_remove_item_internal(shard, ret);
+    pthread_mutex_unlock(&shard->mux);
+    return ret != NULL;
+}
+
+
+guint gsimplecache_remove_prefix_kstr(GSimpleCache* cache, const char* prefix){
+    const size_t prefix_len = strlen(prefix);
+    guint removed = 0;
+    guint s;
+    for (s = 0; s < cache->n_shards; ++s) {
+        GSimpleCache_Shard* shard = &cache->shards[s];
+        pthread_mutex_lock(&shard->mux);
+        Internal_item* i = shard->head;
+        while (i != NULL) {
+            Internal_item* next = i->next;
+            if (strncmp(i->key, prefix, prefix_len) == 0) {
+                gsimplecache_remove_item_internal(shard, i);
+                ++removed;
+            }
+            i = next;
+        }
+        pthread_mutex_unlock(&shard->mux);
+    }
+    return removed;
 }
 
 /**
@@ -144,15 +280,58 @@ gboolean gsimplecache_remove_kstr(GSimpleCache* cache, const char* key){
  *
  * */
 int gsimplecache_take_one_kstr(GSimpleCache* cache, const char* key, void* res){
-	pthread_mutex_lock(&cache->mux);
-	Internal_item* ret = gsimplecache_find_kstr_internal(cache, key);
-	if(ret){
-		(ret->ref_count)--;
-		cache->do_copy(ret->item, res);
-		if(ret->ref_count <= 0)
-			gsimplecache_remove_internal_kstr(cache, key);
-	}
-	pthread_mutex_unlock(&cache->mux);
-	return (ret)?0:-1;
+    GSimpleCache_Shard* shard = gsimplecache_shard(cache, key);
+    pthread_mutex_lock(&shard->mux);
+    Internal_item* ret = gsimplecache_find_kstr_internal(shard, key, g_get_monotonic_time());
+    if(ret){
+        shard->stats.hits++;
+        (ret->ref_count)--;
+        cache->do_copy(ret->item, res);
+        if(ret->ref_count <= 0) {
+            gsimplecache_remove_item_internal(shard, ret);
+        }
+        else {
+            gsimplecache_lru_unlink(shard, ret);
+            gsimplecache_lru_push_head(shard, ret);
+        }
+    }
+    else {
+        shard->stats.misses++;
+    }
+    pthread_mutex_unlock(&shard->mux);
+    return (ret)?0:-1;
 }
 
+
+int gsimplecache_get_kstr(GSimpleCache* cache, const char* key, void* res){
+    GSimpleCache_Shard* shard = gsimplecache_shard(cache, key);
+    pthread_mutex_lock(&shard->mux);
+    Internal_item* ret = gsimplecache_find_kstr_internal(shard, key, g_get_monotonic_time());
+    if(ret){
+        shard->stats.hits++;
+        cache->do_copy(ret->item, res);
+        gsimplecache_lru_unlink(shard, ret);
+        gsimplecache_lru_push_head(shard, ret);
+    }
+    else {
+        shard->stats.misses++;
+    }
+    pthread_mutex_unlock(&shard->mux);
+    return (ret)?0:-1;
+}
+
+
+void gsimplecache_get_stats(GSimpleCache* cache, GSimpleCacheStats* stats){
+    memset(stats, 0, sizeof(*stats));
+    guint s;
+    for (s = 0; s < cache->n_shards; ++s) {
+        GSimpleCache_Shard* shard = &cache->shards[s];
+        pthread_mutex_lock(&shard->mux);
+        stats->hits += shard->stats.hits;
+        stats->misses += shard->stats.misses;
+        stats->evictions += shard->stats.evictions;
+        stats->expirations += shard->stats.expirations;
+        stats->size += g_hash_table_size(shard->table);
+        pthread_mutex_unlock(&shard->mux);
+    }
+}
@@ -22,6 +22,9 @@
 
 #include <glib.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 #define MAX_LIST_LEN 20000
 
@@ -32,13 +35,57 @@ typedef void (*GSimpleCache_CopyConstructor)(gpointer original, gpointer copy);
 
 typedef struct _GSimpleCache_Handle GSimpleCache;
 
+typedef struct {
+    guint64 hits;
+    guint64 misses;
+    // items dropped to make room for new ones
+    guint64 evictions;
+    // items dropped because their time to live had passed
+    guint64 expirations;
+    guint64 size;
+} GSimpleCacheStats;
+
+/**
+ * Create a cache of at most max_number_item items
+ * When full, the least recently used item is dropped
+ */
 GSimpleCache* gsimplecache_new(guint64 max_number_item, GSimpleCache_CopyConstructor value_copy, size_t size_item);
 
 void gsimplecache_delete(GSimpleCache* cache);
 
+/**
+ * Default time to live, in seconds, of the items added from now on. 0 (the default) never expire
+ */
+void gsimplecache_set_ttl(GSimpleCache* cache, guint ttl);
+
 void gsimplecache_add_item_kstr(GSimpleCache* cache, const char* key, void* item);
 
+/**
+ * Same as gsimplecache_add_item_kstr, with a time to live specific to this item
+ */
+void gsimplecache_add_item_kstr_ttl(GSimpleCache* cache, const char* key, void* item, guint ttl);
+
+/**
+ * Same as gsimplecache_add_item_kstr_ttl, but an existing item takes the new value
+ */
+void gsimplecache_replace_item_kstr_ttl(GSimpleCache* cache, const char* key, void* item, guint ttl);
+
 int gsimplecache_take_one_kstr(GSimpleCache* cache, const char* key, void* res);
 
+/**
+ * Same as gsimplecache_take_one_kstr, but the item stays in the cache whatever its reference count
+ */
+int gsimplecache_get_kstr(GSimpleCache* cache, const char* key, void* res);
+
 gboolean gsimplecache_remove_kstr(GSimpleCache* cache, const char* key);
 
+/**
+ * Remove all the items whose key starts with prefix, return the number of items removed
+ */
+guint gsimplecache_remove_prefix_kstr(GSimpleCache* cache, const char* prefix);
+
+void gsimplecache_get_stats(GSimpleCache* cache, GSimpleCacheStats* stats);
+
+#ifdef __cplusplus
+}
+#endif
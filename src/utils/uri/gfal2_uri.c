@@ -18,105 +18,187 @@
  * limitations under the License.
  */
 
-#include <assert.h>
 #include <ctype.h>
 #include <errno.h>
-#include <regex.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include "gfal2_uri.h"
 
 
-// From RFC3986, appendix B
-#define URI_REGEX "^(([^:/?#]+):)?(//([^/?#]*))?([^?#]*)(\\?([^#]*))?(#(.*))?"
-//                  12            3  4          5       6  7        8 9
-#define AUTHORITY_REGEX "^(([^@]*)@)?(([[:alnum:]][-_[:alnum:]]*(\\.[-_[:alnum:]]+)*)|(\\[[a-zA-Z0-9:]+\\]))?(:[[:digit:]]+)?"
-//                        12         34                         5                    6                  3 7
+// Single pass parser following RFC3986, appendix B
+//  ^(([^:/?#]+):)?(//([^/?#]*))?([^?#]*)(\?([^#]*))?(#(.*))?
+// with the authority split as
+//  ^(([^@]*)@)?(([[:alnum:]][-_[:alnum:]]*(\.[-_[:alnum:]]+)*)|(\[[a-zA-Z0-9:]+\]))?(:[[:digit:]]+)?
+// Each component is then copied into its own allocation, owned by the struct
+
+// start == NULL means undefined
+typedef struct {
+    const char *start;
+    size_t len;
+} gfal2_uri_span;
+
 
 static GQuark scope_uri(){
 	return g_quark_from_static_string("Gfal::Uri_util");
 }
 
 
-static char *_strdupmatch(const char *str, regmatch_t *match)
+static gboolean _is_host_char(char c)
 {
-    if (match->rm_so < 0)
-        return NULL;
+    return g_ascii_isalnum(c) || c == '-' || c == '_';
+}
+
+
+// Length of the host at the beginning of str, 0 if there is none
+static size_t _host_len(const char *str, size_t len)
+{
+    size_t i;
+
+    if (len > 0 && str[0] == '[') {
+        for (i = 1; i < len && (g_ascii_isalnum(str[i]) || str[i] == ':'); ++i)
+            ;
+        if (i > 1 && i < len && str[i] == ']') {
+            return i + 1;
+        }
+        return 0;
+    }
+
+    if (len == 0 || !g_ascii_isalnum(str[0])) {
+        return 0;
+    }
+    for (i = 1; i < len && _is_host_char(str[i]); ++i)
+        ;
+    while (i + 1 < len && str[i] == '.' && _is_host_char(str[i + 1])) {
+        for (i += 2; i < len && _is_host_char(str[i]); ++i)
+            ;
+    }
+    return i;
+}
+
+
+static const char *_skip_until(const char *p, const char *end, const char *stop)
+{
+    while (p < end && strchr(stop, *p) == NULL) {
+        ++p;
+    }
+    return p;
+}
+
+
+static void _parse_authority(const gfal2_uri_span *authority, gfal2_uri_span *userinfo,
+    gfal2_uri_span *host, unsigned *port)
+{
+    const char *p = authority->start;
+    const char *end = p + authority->len;
+
+    // Authority defined but empty
+    if (p == end) {
+        host->start = p;
+        return;
+    }
+
+    const char *at = memchr(p, '@', end - p);
+    if (at) {
+        userinfo->start = p;
+        userinfo->len = at - p;
+        p = at + 1;
+    }
 
-    size_t match_len = match->rm_eo - match->rm_so;
-    return g_strndup(str + match->rm_so, match_len);
+    size_t host_len = _host_len(p, end - p);
+    if (host_len > 0) {
+        host->start = p;
+        host->len = host_len;
+        p += host_len;
+    }
+
+    if (p + 1 < end && *p == ':' && g_ascii_isdigit(p[1])) {
+        *port = atol(p + 1);
+    }
+}
+
+
+static char *_span_dup(const gfal2_uri_span *span)
+{
+    if (span->start == NULL) {
+        return NULL;
+    }
+    return g_strndup(span->start, span->len);
 }
 
 
 gfal2_uri *gfal2_parse_uri(const char *uri, GError **err)
 {
-    char buffer[128];
-
-    regex_t preg;
-    int ret = regcomp(&preg, URI_REGEX, REG_EXTENDED | REG_ICASE);
-    assert(ret == 0);
-
-    regmatch_t pmatch[10];
-    ret = regexec(&preg, uri, 10, pmatch, 0);
-    if (ret != 0) {
-        regerror(ret, &preg, buffer, sizeof(buffer));
-        regfree(&preg);
-        gfal2_set_error(err, scope_uri(), EINVAL, __func__, "Could not match the uri: %s", buffer);
+    if (uri == NULL) {
+        gfal2_set_error(err, scope_uri(), EINVAL, __func__, "Could not match the uri: NULL uri");
         return NULL;
     }
 
-    // URI
-    gfal2_uri *parsed = g_malloc0(sizeof(*parsed));
-    parsed->scheme = _strdupmatch(uri, &pmatch[2]);
-    parsed->path = _strdupmatch(uri, &pmatch[5]);
-    parsed->query = _strdupmatch(uri, &pmatch[7]);
-    parsed->fragment = _strdupmatch(uri, &pmatch[9]);
-    parsed->original = uri;
+    gfal2_uri_span scheme = {NULL, 0}, authority = {NULL, 0}, path = {NULL, 0};
+    gfal2_uri_span query = {NULL, 0}, fragment = {NULL, 0};
+    gfal2_uri_span userinfo = {NULL, 0}, host = {NULL, 0};
+    unsigned port = 0;
 
+    const char *p = uri;
+    const char *end = uri + strlen(uri);
+    const char *q;
 
-    // Authority not defined
-    if (pmatch[4].rm_so < 0) {
-        parsed->userinfo = parsed->host = NULL;
-        parsed->port = 0;
+    q = _skip_until(p, end, ":/?#");
+    if (q > p && q < end && *q == ':') {
+        scheme.start = p;
+        scheme.len = q - p;
+        p = q + 1;
     }
-    // Authority defined but empty
-    else if (pmatch[4].rm_so == pmatch[4].rm_eo) {
-        parsed->host = g_strdup("");
-    }
-    // Authority has content
-    if (pmatch[4].rm_so != pmatch[4].rm_eo) {
-        char *authority = _strdupmatch(uri, &pmatch[4]);
-
-        regex_t authreg;
-        ret = regcomp(&authreg, AUTHORITY_REGEX, REG_EXTENDED | REG_ICASE);
-        assert(ret == 0);
-
-        regmatch_t authmatch[8];
-        ret = regexec(&authreg, authority, 8, authmatch, 0);
-        if (ret != 0) {
-            regerror(ret, &preg, buffer, sizeof(buffer));
-            regfree(&preg);
-            gfal2_free_uri(parsed);
-            gfal2_set_error(err, scope_uri(), EINVAL, __func__, "Could not match the authority: %s", buffer);
-            return NULL;
-        }
 
-        parsed->userinfo = _strdupmatch(authority, &authmatch[2]);
-        parsed->host = _strdupmatch(authority, &authmatch[3]);
-        if (authmatch[7].rm_so > -1) {
-            parsed->port = atol(authority + authmatch[7].rm_so + 1);
-        }
+    if (end - p >= 2 && p[0] == '/' && p[1] == '/') {
+        p += 2;
+        q = _skip_until(p, end, "/?#");
+        authority.start = p;
+        authority.len = q - p;
+        p = q;
+        _parse_authority(&authority, &userinfo, &host, &port);
+    }
+
+    q = _skip_until(p, end, "?#");
+    path.start = p;
+    path.len = q - p;
+    p = q;
+
+    if (p < end && *p == '?') {
+        ++p;
+        q = _skip_until(p, end, "#");
+        query.start = p;
+        query.len = q - p;
+        p = q;
+    }
 
-        regfree(&authreg);
-        g_free(authority);
+    if (p < end && *p == '#') {
+        ++p;
+        fragment.start = p;
+        fragment.len = end - p;
     }
 
-    regfree(&preg);
+    gfal2_uri *parsed = g_new0(gfal2_uri, 1);
+    parsed->scheme = _span_dup(&scheme);
+    parsed->userinfo = _span_dup(&userinfo);
+    parsed->host = _span_dup(&host);
+    parsed->port = port;
+    parsed->path = _span_dup(&path);
+    parsed->query = _span_dup(&query);
+    parsed->fragment = _span_dup(&fragment);
+    parsed->original = uri;
 
     return parsed;
 }
 
 
+void gfal2_uri_replace(gfal2_uri *uri, char **component, char *value)
+{
+    g_free(*component);
+    *component = value;
+}
+
+
 void gfal2_free_uri(gfal2_uri* uri)
 {
     if (uri) {
@@ -140,7 +222,7 @@ int _push_component(gchar **str_array, int i, gchar *component)
 
 char *gfal2_join_uri(gfal2_uri* uri)
 {
-    gchar *str_array[11];
+    gchar *str_array[12];
     char port[12];
     int i = 0;
 
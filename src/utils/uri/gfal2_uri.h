@@ -35,6 +35,7 @@ extern "C"
 // and being the empty string.
 // i.e. empty = separator was present, but value missing
 //      undefined = separator was not present
+// Each component is allocated with g_malloc, and released by gfal2_free_uri.
 typedef struct gfal2_uri {
     char *scheme;
     char *userinfo;
@@ -52,6 +53,12 @@ typedef struct gfal2_uri {
  */
 gfal2_uri* gfal2_parse_uri(const char *uri, GError **err);
 
+/*
+ * Replace a component (i.e. &uri->path) with value, releasing the previous one.
+ * The uri takes ownership of value, which must be allocated with g_malloc, or be NULL.
+ */
+void gfal2_uri_replace(gfal2_uri *uri, char **component, char *value);
+
 /*
  * Free an URI. It is safe to call if uri is NULL.
  */
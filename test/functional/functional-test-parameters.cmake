@@ -287,6 +287,16 @@ ENDIF()
 #    test_rwt_seek("SFTP" "${sftp_prefix}" 100 4560)
 #ENDIF ()
 
+# Read/write tests against a local sshd, e.g. -DSFTP_LOCAL_PREFIX=sftp://localhost/tmp/gfal2-tests
+SET(SFTP_LOCAL_PREFIX "" CACHE STRING "SFTP directory used for the read/write tests")
+IF (PLUGIN_SFTP AND SFTP_LOCAL_PREFIX)
+    test_rwt_all("SFTP_LOCAL" "${SFTP_LOCAL_PREFIX}" 4578)
+    test_rwt_all("SFTP_LOCAL_single" "${SFTP_LOCAL_PREFIX}" 1)
+    test_rwt_all("SFTP_LOCAL_pipelined" "${SFTP_LOCAL_PREFIX}" 10000000)
+    test_rwt_seq("SFTP_LOCAL" "${SFTP_LOCAL_PREFIX}" 100 4560)
+    test_rwt_seek("SFTP_LOCAL" "${SFTP_LOCAL_PREFIX}" 100 4560)
+ENDIF ()
+
 IF (MAIN_TRANSFER)
         test_copy_file_full("GRIDFTP_TO_GRIDFTP"        ${gsiftp_prefix_dpm} ${gsiftp_prefix_dpm})
         test_copy_file_full("SRM_DPM_TO_DCACHE"         ${srm_prefix_dpm} ${srm_prefix_dcache})
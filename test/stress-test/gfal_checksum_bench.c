@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <glib.h>
+#include <utils/checksums/checksums.h>
+#include <utils/checksums/checksum_kernels.h>
+
+//
+// Checksum throughput of the portable kernels against the ones selected for this CPU,
+// and of a single pass computing every algorithm against one pass per algorithm
+//
+
+#define BUFFER_SIZE (64 * 1024 * 1024)
+
+
+static double bench_kernel(gfal2_checksum_kernel kernel, uint32_t seed,
+    const unsigned char* buffer, int rounds)
+{
+    uint32_t value = seed;
+    int i;
+    gint64 start = g_get_monotonic_time();
+    for (i = 0; i < rounds; ++i)
+        value = kernel(value, buffer, BUFFER_SIZE);
+    gint64 elapsed = g_get_monotonic_time() - start;
+    // Keep the result alive
+    if (value == 0x5a5a5a5a)
+        printf(" ");
+    return ((double) BUFFER_SIZE * rounds) / (elapsed * 1000.0);
+}
+
+
+static double bench_context(unsigned algorithms, const unsigned char* buffer, int rounds)
+{
+    char result[64];
+    int i;
+    gint64 start = g_get_monotonic_time();
+    for (i = 0; i < rounds; ++i) {
+        gfal2_checksum_ctx* ctx = gfal2_checksum_ctx_new_multi(algorithms);
+        gfal2_checksum_ctx_update(ctx, buffer, BUFFER_SIZE);
+        gfal2_checksum_ctx_final(ctx, result, sizeof(result));
+        gfal2_checksum_ctx_free(ctx);
+    }
+    gint64 elapsed = g_get_monotonic_time() - start;
+    return ((double) BUFFER_SIZE * rounds) / (elapsed * 1000.0);
+}
+
+
+int main(int argc, char** argv)
+{
+    int rounds = 8;
+    if (argc > 1)
+        rounds = atoi(argv[1]);
+
+    unsigned char* buffer = g_malloc(BUFFER_SIZE);
+    size_t i;
+    for (i = 0; i < BUFFER_SIZE; ++i)
+        buffer[i] = (unsigned char) rand();
+
+    const gfal2_checksum_kernels* scalar = gfal2_checksum_kernels_scalar();
+    const gfal2_checksum_kernels* best = gfal2_checksum_kernels_best();
+
+    printf("%d rounds over %d MiB\n", rounds, BUFFER_SIZE / (1024 * 1024));
+    printf("A: %s\nB: %s\n", scalar->name, best->name);
+    printf("%-10s %9s %9s\n", "", "A", "B");
+    printf("%-10s %4.2f GB/s %4.2f GB/s\n", "adler32",
+        bench_kernel(scalar->adler32, 1, buffer, rounds), bench_kernel(best->adler32, 1, buffer, rounds));
+    printf("%-10s %4.2f GB/s %4.2f GB/s\n", "crc32",
+        bench_kernel(scalar->crc32, 0, buffer, rounds), bench_kernel(best->crc32, 0, buffer, rounds));
+    printf("%-10s %4.2f GB/s %4.2f GB/s\n", "crc32c",
+        bench_kernel(scalar->crc32c, 0, buffer, rounds), bench_kernel(best->crc32c, 0, buffer, rounds));
+
+    const unsigned algorithms[] = {
+        GFAL2_CHECKSUM_ADLER32, GFAL2_CHECKSUM_CRC32, GFAL2_CHECKSUM_CRC32C, GFAL2_CHECKSUM_MD5
+    };
+    double separate = 0;
+    for (i = 0; i < sizeof(algorithms) / sizeof(algorithms[0]); ++i)
+        separate += 1.0 / bench_context(algorithms[i], buffer, rounds);
+
+    printf("all algorithms, one pass each: %7.2f GB/s\n", 1.0 / separate);
+    printf("all algorithms, single pass:   %7.2f GB/s\n", bench_context(GFAL2_CHECKSUM_ALL, buffer, rounds));
+
+    g_free(buffer);
+    return 0;
+}
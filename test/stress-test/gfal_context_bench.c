@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <gfal_api.h>
+
+//
+// Cost of a context per operation, as done by the FTS style agents:
+// a first context, the following ones, and clones of a template context
+//
+
+static gfal2_context_t bench_new_context(void)
+{
+    GError* tmp_err = NULL;
+    gfal2_context_t context = gfal2_context_new(&tmp_err);
+    if (context == NULL) {
+        fprintf(stderr, "Could not create the context: %s\n", tmp_err->message);
+        exit(1);
+    }
+    return context;
+}
+
+
+static double bench_contexts(gfal2_context_t template, long iterations)
+{
+    GError* tmp_err = NULL;
+    long i;
+    gint64 start = g_get_monotonic_time();
+    for (i = 0; i < iterations; ++i) {
+        gfal2_context_t context;
+        if (template) {
+            context = gfal2_context_clone(template, &tmp_err);
+            if (context == NULL) {
+                fprintf(stderr, "Could not clone the context: %s\n", tmp_err->message);
+                exit(1);
+            }
+        }
+        else {
+            context = bench_new_context();
+        }
+        gfal2_context_free(context);
+    }
+    gint64 elapsed = g_get_monotonic_time() - start;
+    return (double) elapsed / iterations;
+}
+
+
+int main(int argc, char** argv)
+{
+    long iterations = 1000;
+    if (argc > 1)
+        iterations = atol(argv[1]);
+
+    gint64 start = g_get_monotonic_time();
+    gfal2_context_t template = bench_new_context();
+    double first = g_get_monotonic_time() - start;
+
+    gchar** plugins = gfal2_get_plugin_names(template);
+    printf("%ld contexts with %u plugins\n", iterations, g_strv_length(plugins));
+    g_strfreev(plugins);
+
+    printf("first context:   %10.1f us\n", first);
+    printf("new context:     %10.1f us/context\n", bench_contexts(NULL, iterations));
+    printf("cloned context:  %10.1f us/context\n", bench_contexts(template, iterations));
+
+    gfal2_context_free(template);
+    return 0;
+}
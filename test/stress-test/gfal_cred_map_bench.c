@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <gfal_api.h>
+
+//
+// Cost of the credential map operations as it grows,
+// with one token per file, as stored by the HTTP plugin for the transfers of large jobs
+// The time per operation should not depend on the number of credentials
+//
+
+#define BENCH_FILES_PER_DIR 100
+
+static char* bench_url(long i)
+{
+    return g_strdup_printf("davs://storage.example.org:443/eos/experiment/run%ld/dir%ld/file%ld",
+        i % 10, i / BENCH_FILES_PER_DIR, i);
+}
+
+
+static char* bench_dir(long i)
+{
+    return g_strdup_printf("davs://storage.example.org:443/eos/experiment/run%ld/dir%ld",
+        i % 10, i / BENCH_FILES_PER_DIR);
+}
+
+
+static gboolean bench_first_match(const char* url_prefix, const gfal2_cred_t* cred, void* user_data)
+{
+    return TRUE;
+}
+
+
+static void bench_map(long entries, long lookups)
+{
+    GError* tmp_err = NULL;
+    gfal2_context_t context = gfal2_context_new(&tmp_err);
+    if (context == NULL) {
+        fprintf(stderr, "Could not create the context: %s\n", tmp_err->message);
+        exit(1);
+    }
+    long i;
+
+    gint64 start = g_get_monotonic_time();
+    for (i = 0; i < entries; ++i) {
+        char* url = bench_url(i);
+        char* value = g_strdup_printf("token%ld", i);
+        gfal2_cred_t* cred = gfal2_cred_new(GFAL_CRED_BEARER, value);
+        gfal2_cred_set(context, url, cred, NULL);
+        gfal2_cred_free(cred);
+        g_free(value);
+        g_free(url);
+    }
+    double set = (double) (g_get_monotonic_time() - start) / entries;
+
+    char** urls = g_new0(char*, lookups);
+    char** dirs = g_new0(char*, lookups);
+    for (i = 0; i < lookups; ++i) {
+        long n = random() % entries;
+        urls[i] = bench_url(n);
+        dirs[i] = bench_dir(n);
+    }
+
+    start = g_get_monotonic_time();
+    for (i = 0; i < lookups; ++i) {
+        g_free(gfal2_cred_get(context, GFAL_CRED_BEARER, urls[i], NULL, NULL));
+    }
+    double get = (double) (g_get_monotonic_time() - start) / lookups;
+
+    start = g_get_monotonic_time();
+    for (i = 0; i < lookups; ++i) {
+        gfal2_cred_foreach_match(context, GFAL_CRED_BEARER, dirs[i], TRUE, bench_first_match, NULL);
+    }
+    double subpaths = (double) (g_get_monotonic_time() - start) / lookups;
+
+    start = g_get_monotonic_time();
+    for (i = 0; i < lookups; ++i) {
+        gfal2_cred_del(context, GFAL_CRED_BEARER, urls[i], NULL);
+    }
+    double del = (double) (g_get_monotonic_time() - start) / lookups;
+
+    printf("%8ld credentials: set %8.2f us  get %8.2f us  sub-paths %8.2f us  del %8.2f us\n",
+        entries, set, get, subpaths, del);
+
+    for (i = 0; i < lookups; ++i) {
+        g_free(urls[i]);
+        g_free(dirs[i]);
+    }
+    g_free(urls);
+    g_free(dirs);
+    gfal2_context_free(context);
+}
+
+
+int main(int argc, char** argv)
+{
+    long max_entries = 100000;
+    long lookups = 10000;
+    long entries;
+
+    if (argc > 1)
+        max_entries = atol(argv[1]);
+
+    for (entries = 1000; entries <= max_entries; entries *= 10) {
+        bench_map(entries, lookups);
+    }
+    return 0;
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <gfal_api.h>
+
+//
+// N threads doing read/pread on distinct descriptors of the same context
+// Measures the cost of the descriptor table under contention
+//
+
+#define BLOCK_SIZE 4096
+#define FILE_SIZE (1024 * BLOCK_SIZE)
+
+typedef struct {
+    gfal2_context_t context;
+    int fd;
+    long iterations;
+} bench_worker_t;
+
+
+static void* bench_worker(void* data)
+{
+    bench_worker_t* worker = (bench_worker_t*) data;
+    char buffer[BLOCK_SIZE];
+    GError* tmp_err = NULL;
+    long i;
+
+    for (i = 0; i < worker->iterations; ++i) {
+        off_t offset = (i % (FILE_SIZE / BLOCK_SIZE)) * BLOCK_SIZE;
+        ssize_t ret;
+        if (i % 2)
+            ret = gfal2_pread(worker->context, worker->fd, buffer, sizeof(buffer), offset, &tmp_err);
+        else
+            ret = gfal2_read(worker->context, worker->fd, buffer, sizeof(buffer), &tmp_err);
+        if (ret < 0) {
+            fprintf(stderr, "Read failed: %s\n", tmp_err->message);
+            exit(1);
+        }
+        if (ret == 0)
+            gfal2_lseek(worker->context, worker->fd, 0, SEEK_SET, NULL);
+    }
+    return NULL;
+}
+
+
+int main(int argc, char** argv)
+{
+    int n_threads = 64;
+    long iterations = 100000;
+    if (argc > 1)
+        n_threads = atoi(argv[1]);
+    if (argc > 2)
+        iterations = atol(argv[2]);
+
+    char path[] = "/tmp/gfal2_fd_bench_XXXXXX";
+    int local_fd = mkstemp(path);
+    if (local_fd < 0 || ftruncate(local_fd, FILE_SIZE) != 0) {
+        perror("Could not create the test file");
+        return 1;
+    }
+    close(local_fd);
+
+    GError* tmp_err = NULL;
+    gfal2_context_t context = gfal2_context_new(&tmp_err);
+    if (context == NULL) {
+        fprintf(stderr, "Could not create the context: %s\n", tmp_err->message);
+        return 1;
+    }
+
+    char* url = g_strconcat("file://", path, NULL);
+    bench_worker_t* workers = g_new0(bench_worker_t, n_threads);
+    pthread_t* threads = g_new0(pthread_t, n_threads);
+    int i;
+
+    for (i = 0; i < n_threads; ++i) {
+        workers[i].context = context;
+        workers[i].iterations = iterations;
+        workers[i].fd = gfal2_open(context, url, O_RDONLY, &tmp_err);
+        if (workers[i].fd < 0) {
+            fprintf(stderr, "Could not open %s: %s\n", url, tmp_err->message);
+            return 1;
+        }
+    }
+
+    gint64 start = g_get_monotonic_time();
+    for (i = 0; i < n_threads; ++i)
+        pthread_create(&threads[i], NULL, bench_worker, &workers[i]);
+    for (i = 0; i < n_threads; ++i)
+        pthread_join(threads[i], NULL);
+    gint64 elapsed = g_get_monotonic_time() - start;
+
+    const double total_ops = (double) n_threads * iterations;
+    printf("%d threads, %ld reads each\n", n_threads, iterations);
+    printf("%.0f ops/s, %.1f ns/op\n", total_ops * G_USEC_PER_SEC / elapsed, (elapsed * 1000.0) / total_ops);
+
+    for (i = 0; i < n_threads; ++i)
+        gfal2_close(context, workers[i].fd, NULL);
+    gfal2_context_free(context);
+    unlink(path);
+    g_free(url);
+    g_free(workers);
+    g_free(threads);
+    return 0;
+}
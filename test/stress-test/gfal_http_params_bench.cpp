@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <gfal_api.h>
+
+#include "plugins/http/gfal_http_plugin.h"
+
+//
+// Allocations and time spent reading the configuration for each HTTP request:
+// lookups by group and key, as done before the options were declared,
+// then the declared options, then the whole preparation of the request parameters,
+// served from the cache of the plugin once built for the endpoint
+//
+
+// Every allocation goes through the allocator of the C library, g_malloc and new included
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* ptr, size_t size);
+
+static volatile long allocations = 0;
+
+extern "C" void* malloc(size_t size)
+{
+    __sync_fetch_and_add(&allocations, 1);
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size)
+{
+    __sync_fetch_and_add(&allocations, 1);
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* ptr, size_t size)
+{
+    __sync_fetch_and_add(&allocations, 1);
+    return __libc_realloc(ptr, size);
+}
+
+
+// What GfalHttpPluginData::get_params_internal read for each request
+static void lookups_by_key(gfal2_context_t context)
+{
+    gfal2_get_opt_boolean_with_default(context, "HTTP PLUGIN", "INSECURE", FALSE);
+    gfal2_get_opt_boolean_with_default(context, "HTTP PLUGIN", "METALINK", FALSE);
+    gfal2_get_opt_boolean_with_default(context, "HTTP PLUGIN", "KEEP_ALIVE", TRUE);
+    gfal2_get_opt_integer_with_default(context, "HTTP PLUGIN", "LOG_LEVEL", 0);
+    gfal2_get_opt_boolean_with_default(context, "HTTP PLUGIN", "LOG_SENSITIVE", FALSE);
+
+    char** headers = gfal2_get_opt_string_list_with_default(context, "HTTP PLUGIN", "HEADERS", NULL, NULL);
+    if (headers) {
+        for (char** hi = headers; *hi != NULL; ++hi) {
+            char** kv = g_strsplit(*hi, ":", 2);
+            g_strfreev(kv);
+        }
+        g_strfreev(headers);
+    }
+
+    int global_timeout = gfal2_get_opt_integer_with_default(context, CORE_CONFIG_GROUP,
+        CORE_CONFIG_NAMESPACE_TIMEOUT, 300);
+    gfal2_get_opt_integer_with_default(context, "HTTP PLUGIN", HTTP_CONFIG_OP_TIMEOUT, global_timeout);
+}
+
+
+struct DeclaredOptions {
+    gfal2_opt_t insecure, metalink, keep_alive, log_level, log_sensitive;
+    gfal2_opt_t operation_timeout, namespace_timeout;
+
+    DeclaredOptions() {
+        insecure = gfal2_register_opt("HTTP PLUGIN", "INSECURE", GFAL_OPT_BOOLEAN);
+        metalink = gfal2_register_opt("HTTP PLUGIN", "METALINK", GFAL_OPT_BOOLEAN);
+        keep_alive = gfal2_register_opt("HTTP PLUGIN", "KEEP_ALIVE", GFAL_OPT_BOOLEAN);
+        log_level = gfal2_register_opt("HTTP PLUGIN", "LOG_LEVEL", GFAL_OPT_INTEGER);
+        log_sensitive = gfal2_register_opt("HTTP PLUGIN", "LOG_SENSITIVE", GFAL_OPT_BOOLEAN);
+        operation_timeout = gfal2_register_opt("HTTP PLUGIN", HTTP_CONFIG_OP_TIMEOUT, GFAL_OPT_INTEGER);
+        namespace_timeout = gfal2_register_opt(CORE_CONFIG_GROUP, CORE_CONFIG_NAMESPACE_TIMEOUT, GFAL_OPT_INTEGER);
+    }
+};
+
+
+// The same values, the headers being split again only when the generation changes
+static void declared_lookups(gfal2_context_t context, const DeclaredOptions& opts)
+{
+    gfal2_opt_get_boolean(context, opts.insecure, FALSE);
+    gfal2_opt_get_boolean(context, opts.metalink, FALSE);
+    gfal2_opt_get_boolean(context, opts.keep_alive, TRUE);
+    gfal2_opt_get_integer(context, opts.log_level, 0);
+    gfal2_opt_get_boolean(context, opts.log_sensitive, FALSE);
+    gfal2_get_opt_generation(context);
+
+    int global_timeout = gfal2_opt_get_integer(context, opts.namespace_timeout, 300);
+    gfal2_opt_get_integer(context, opts.operation_timeout, global_timeout);
+}
+
+
+static void report(const char* step, int nrequests, long n_allocations, gint64 elapsed)
+{
+    printf("%-24s %8.1f allocations/request %8.2f us/request\n", step,
+        n_allocations / (double) nrequests, elapsed / (double) nrequests);
+}
+
+
+int main(int argc, char** argv)
+{
+    int nrequests = 100000;
+    if (argc > 1)
+        nrequests = atoi(argv[1]);
+
+    GError* error = NULL;
+    gfal2_context_t context = gfal2_context_new(&error);
+    if (context == NULL) {
+        fprintf(stderr, "Could not create the context: %s\n", error->message);
+        return 1;
+    }
+
+    const gchar* headers[] = {"X-Bench-One: 1", "X-Bench-Two: 2"};
+    gfal2_set_opt_string_list(context, "HTTP PLUGIN", "HEADERS", headers, 2, NULL);
+
+    GfalHttpPluginData* davix = new GfalHttpPluginData(context);
+    DeclaredOptions opts;
+    Davix::Uri uri("https://storage.example.org:443/path/to/file");
+    int i;
+
+    long start_allocations = allocations;
+    gint64 start = g_get_monotonic_time();
+    for (i = 0; i < nrequests; ++i) {
+        lookups_by_key(context);
+    }
+    report("lookups by key", nrequests, allocations - start_allocations, g_get_monotonic_time() - start);
+
+    start_allocations = allocations;
+    start = g_get_monotonic_time();
+    for (i = 0; i < nrequests; ++i) {
+        declared_lookups(context, opts);
+    }
+    report("declared options", nrequests, allocations - start_allocations, g_get_monotonic_time() - start);
+
+    start_allocations = allocations;
+    start = g_get_monotonic_time();
+    for (i = 0; i < nrequests; ++i) {
+        Davix::RequestParams params;
+        davix->get_params(&params, uri, GfalHttpPluginData::OP::HEAD);
+    }
+    report("request parameters", nrequests, allocations - start_allocations, g_get_monotonic_time() - start);
+
+    delete davix;
+    gfal2_context_free(context);
+    return 0;
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gfal_api.h>
+#include <gfal_plugins_api.h>
+#include <common/gfal_plugin.h>
+
+//
+// Compare the plugin lookup cost when the plugins declare their URL schemes
+// (scheme index) and when they do not (checker walk over every plugin)
+//
+
+#define N_PLUGINS 10
+
+static char plugin_prefixes[N_PLUGINS][32];
+static const char* plugin_schemes[N_PLUGINS][2];
+
+
+static const char* bench_plugin_get_name(void)
+{
+    return "BENCH PLUGIN";
+}
+
+
+static gboolean bench_plugin_url(plugin_handle plugin_data, const char* url,
+    plugin_mode operation, GError** err)
+{
+    const char* prefix = (const char*) plugin_data;
+    return strncmp(url, prefix, strlen(prefix)) == 0 && operation == GFAL_PLUGIN_STAT;
+}
+
+
+static gfal2_context_t bench_context(gboolean declare_schemes)
+{
+    GError* tmp_err = NULL;
+    gfal2_context_t context = gfal2_context_new(&tmp_err);
+    if (context == NULL) {
+        fprintf(stderr, "Could not create the context: %s\n", tmp_err->message);
+        exit(1);
+    }
+
+    int i;
+    for (i = 0; i < N_PLUGINS; ++i) {
+        gfal_plugin_interface plugin;
+        memset(&plugin, 0, sizeof(plugin));
+        plugin.plugin_data = plugin_prefixes[i];
+        plugin.getName = bench_plugin_get_name;
+        plugin.check_plugin_url = bench_plugin_url;
+        if (declare_schemes)
+            plugin.url_schemes = plugin_schemes[i];
+        if (gfal2_register_plugin(context, &plugin, &tmp_err) != 0) {
+            fprintf(stderr, "Could not register the plugin: %s\n", tmp_err->message);
+            exit(1);
+        }
+    }
+    return context;
+}
+
+
+static double bench_lookups(gfal2_context_t context, const char* url, long iterations)
+{
+    GError* tmp_err = NULL;
+    long i;
+    gint64 start = g_get_monotonic_time();
+    for (i = 0; i < iterations; ++i) {
+        if (gfal_find_plugin(context, url, GFAL_PLUGIN_STAT, &tmp_err) == NULL) {
+            fprintf(stderr, "Lookup failed: %s\n", tmp_err->message);
+            exit(1);
+        }
+    }
+    gint64 elapsed = g_get_monotonic_time() - start;
+    return (elapsed * 1000.0) / iterations;
+}
+
+
+int main(int argc, char** argv)
+{
+    long iterations = 1000000;
+    if (argc > 1)
+        iterations = atol(argv[1]);
+
+    int i;
+    for (i = 0; i < N_PLUGINS; ++i) {
+        snprintf(plugin_prefixes[i], sizeof(plugin_prefixes[i]), "bench%d://", i);
+        plugin_schemes[i][0] = g_strndup(plugin_prefixes[i], strlen(plugin_prefixes[i]) - 3);
+        plugin_schemes[i][1] = NULL;
+    }
+
+    gfal2_context_t legacy = bench_context(FALSE);
+    gfal2_context_t indexed = bench_context(TRUE);
+
+    char url[64];
+    snprintf(url, sizeof(url), "%shost.cern.ch/path/to/file", plugin_prefixes[N_PLUGINS - 1]);
+
+    printf("%ld lookups of %s among %d plugins\n", iterations, url, N_PLUGINS);
+    printf("checker walk: %8.1f ns/lookup\n", bench_lookups(legacy, url, iterations));
+    printf("scheme index: %8.1f ns/lookup\n", bench_lookups(indexed, url, iterations));
+
+    gfal2_context_free(legacy);
+    gfal2_context_free(indexed);
+    return 0;
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gfal_api.h>
+
+//
+// Startup cost of a process using gfal2: time and resident memory to create the first
+// context, then to run a first stat on each given URL
+// Run it once as is, and once with PLUGIN_LAZY_LOADING=false in the CORE group of the
+// configuration, to compare with all the plugins loaded upfront
+//
+
+// Resident set size of the process, in kB
+static long bench_rss(void)
+{
+    char line[256];
+    long rss = -1;
+    FILE* status = fopen("/proc/self/status", "r");
+    if (status == NULL)
+        return -1;
+    while (fgets(line, sizeof(line), status) != NULL) {
+        if (strncmp(line, "VmRSS:", 6) == 0) {
+            rss = atol(line + 6);
+            break;
+        }
+    }
+    fclose(status);
+    return rss;
+}
+
+
+static void bench_report(gfal2_context_t context, const char* step, gint64 start)
+{
+    gint64 elapsed = g_get_monotonic_time() - start;
+    gchar** loaded = gfal2_get_plugin_names(context);
+    gchar** available = gfal2_get_available_plugin_names(context);
+    printf("%-40s %10.1f ms %8ld kB RSS %3u loaded %3u available\n", step, elapsed / 1000.0, bench_rss(),
+        g_strv_length(loaded), g_strv_length(available));
+    g_strfreev(loaded);
+    g_strfreev(available);
+}
+
+
+int main(int argc, char** argv)
+{
+    GError* tmp_err = NULL;
+    int i;
+
+    printf("%-40s %10s    %8ld kB RSS\n", "process", "", bench_rss());
+
+    gint64 start = g_get_monotonic_time();
+    gfal2_context_t context = gfal2_context_new(&tmp_err);
+    if (context == NULL) {
+        fprintf(stderr, "Could not create the context: %s\n", tmp_err->message);
+        return 1;
+    }
+    bench_report(context, "context", start);
+
+    for (i = 1; i < argc; ++i) {
+        struct stat st;
+        start = g_get_monotonic_time();
+        if (gfal2_stat(context, argv[i], &st, &tmp_err) < 0) {
+            // Only the loading matters, the URL may not exist
+            g_clear_error(&tmp_err);
+        }
+        bench_report(context, argv[i], start);
+    }
+
+    gfal2_context_free(context);
+    return 0;
+}
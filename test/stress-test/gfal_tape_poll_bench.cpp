@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <json.h>
+#include <gfal_api.h>
+#include <uri/gfal2_parsing.h>
+
+#include "plugins/http/gfal_http_plugin.h"
+
+//
+// Match the files of a synthetic Tape REST API poll response
+// with the path index, and with the linear search it replaced
+//
+
+static std::string file_path(int i)
+{
+    // The server may not return the paths with the same slashes as the request
+    std::stringstream path;
+    path << "/eos/tape/dir" << (i % 100) << ((i % 2) ? "//" : "/") << "file" << i;
+    return path.str();
+}
+
+
+static std::string synthetic_response(int nbfiles)
+{
+    std::stringstream body;
+    body << "[";
+    for (int i = 0; i < nbfiles; ++i) {
+        if (i != 0) {
+            body << ", ";
+        }
+        body << "{\"path\": \"" << file_path(i) << "\", \"locality\": \"DISK_AND_TAPE\"}";
+    }
+    body << "]";
+    return body.str();
+}
+
+
+static std::string collapse_slashes(const std::string& path)
+{
+    char* collapsed_ptr = gfal2_path_collapse_slashes(path.c_str());
+    std::string collapsed(collapsed_ptr);
+    g_free(collapsed_ptr);
+    return collapsed;
+}
+
+
+// Previous implementation: scan the response for each file
+static struct json_object* linear_get_item_by_path(struct json_object* response, const std::string& surl)
+{
+    const int len = json_object_array_length(response);
+    for (int i = 0; i < len; i++) {
+        auto item = json_object_array_get_idx(response, i);
+        struct json_object* item_path = 0;
+        json_object_object_get_ex(item, "path", &item_path);
+        std::string path = item_path ? json_object_get_string(item_path) : "";
+        if (!path.empty() && collapse_slashes(path) == collapse_slashes(surl)) {
+            return item;
+        }
+    }
+    return NULL;
+}
+
+
+static void check_item(struct json_object* item, const std::string& path)
+{
+    struct json_object* item_path = 0;
+    if (item == NULL || !json_object_object_get_ex(item, "path", &item_path) ||
+        collapse_slashes(json_object_get_string(item_path)) != collapse_slashes(path)) {
+        fprintf(stderr, "Wrong item for %s\n", path.c_str());
+        exit(1);
+    }
+}
+
+
+int main(int argc, char** argv)
+{
+    int nbfiles = 100000;
+    if (argc > 1)
+        nbfiles = atoi(argv[1]);
+    // The linear search is quadratic, only time a sample of it
+    int linear_sample = std::min(nbfiles, 200);
+
+    std::string response = synthetic_response(nbfiles);
+
+    // Ask for the files in a different order, with single slashes
+    std::vector<std::string> paths;
+    for (int i = 0; i < nbfiles; ++i) {
+        paths.push_back(collapse_slashes(file_path(i)));
+    }
+    std::shuffle(paths.begin(), paths.end(), std::mt19937(42));
+
+    gint64 start = g_get_monotonic_time();
+    struct json_object* json_response = json_tokener_parse(response.c_str());
+    gint64 parse_elapsed = g_get_monotonic_time() - start;
+    if (!json_response) {
+        fprintf(stderr, "Could not parse the response\n");
+        return 1;
+    }
+
+    start = g_get_monotonic_time();
+    tape_rest_api::PathIndex index = tape_rest_api::index_items_by_path(json_response);
+    for (int i = 0; i < nbfiles; ++i) {
+        check_item(tape_rest_api::get_item_by_path(index, paths[i]), paths[i]);
+    }
+    gint64 index_elapsed = g_get_monotonic_time() - start;
+
+    start = g_get_monotonic_time();
+    for (int i = 0; i < linear_sample; ++i) {
+        check_item(linear_get_item_by_path(json_response, paths[i]), paths[i]);
+    }
+    gint64 linear_elapsed = g_get_monotonic_time() - start;
+
+    json_object_put(json_response);
+
+    printf("%d files, %zu bytes of response\n", nbfiles, response.size());
+    printf("parse:  %10.3f s\n", parse_elapsed / (double) G_USEC_PER_SEC);
+    printf("index:  %10.3f s for all the files\n", index_elapsed / (double) G_USEC_PER_SEC);
+    printf("linear: %10.3f s estimated for all the files (%d timed)\n",
+        linear_elapsed / (double) G_USEC_PER_SEC * nbfiles / linear_sample, linear_sample);
+    return 0;
+}
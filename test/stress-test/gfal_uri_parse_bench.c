@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <regex.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gfal_api.h>
+#include <utils/uri/gfal2_uri.h>
+
+//
+// Compare gfal2_parse_uri with the regex based parser it replaced
+// Both must produce the same components
+//
+
+#define URI_REGEX "^(([^:/?#]+):)?(//([^/?#]*))?([^?#]*)(\\?([^#]*))?(#(.*))?"
+#define AUTHORITY_REGEX "^(([^@]*)@)?(([[:alnum:]][-_[:alnum:]]*(\\.[-_[:alnum:]]+)*)|(\\[[a-zA-Z0-9:]+\\]))?(:[[:digit:]]+)?"
+
+static const char* bench_urls[] = {
+    "gsiftp://dcache-door-desy09.desy.de:2811/pnfs/desy.de/dteam/gfal2-tests/testread0011",
+    "https://some.domain.com/path",
+    "gsiftp://user:patata@[2001:1458:301:a8ae::100:24]:1234/path",
+    "root://eospublic.cern.ch//eos/opendata/file.root?xrd.wantprot=gsi#frag",
+    "sftp://user@host.example.org:22/home/user/file",
+    "file:///tmp/file",
+    "file:/tmp/file",
+    "malformed",
+    NULL
+};
+
+
+static char *regex_dupmatch(const char *str, regmatch_t *match)
+{
+    if (match->rm_so < 0)
+        return NULL;
+    return g_strndup(str + match->rm_so, match->rm_eo - match->rm_so);
+}
+
+
+static gfal2_uri *regex_parse_uri(const char *uri)
+{
+    regex_t preg;
+    regmatch_t pmatch[10];
+    regcomp(&preg, URI_REGEX, REG_EXTENDED | REG_ICASE);
+    if (regexec(&preg, uri, 10, pmatch, 0) != 0) {
+        regfree(&preg);
+        return NULL;
+    }
+
+    gfal2_uri *parsed = g_malloc0(sizeof(*parsed));
+    parsed->scheme = regex_dupmatch(uri, &pmatch[2]);
+    parsed->path = regex_dupmatch(uri, &pmatch[5]);
+    parsed->query = regex_dupmatch(uri, &pmatch[7]);
+    parsed->fragment = regex_dupmatch(uri, &pmatch[9]);
+    parsed->original = uri;
+
+    if (pmatch[4].rm_so >= 0 && pmatch[4].rm_so == pmatch[4].rm_eo) {
+        parsed->host = g_strdup("");
+    }
+    if (pmatch[4].rm_so != pmatch[4].rm_eo) {
+        char *authority = regex_dupmatch(uri, &pmatch[4]);
+        regex_t authreg;
+        regmatch_t authmatch[8];
+        regcomp(&authreg, AUTHORITY_REGEX, REG_EXTENDED | REG_ICASE);
+        if (regexec(&authreg, authority, 8, authmatch, 0) == 0) {
+            parsed->userinfo = regex_dupmatch(authority, &authmatch[2]);
+            parsed->host = regex_dupmatch(authority, &authmatch[3]);
+            if (authmatch[7].rm_so > -1) {
+                parsed->port = atol(authority + authmatch[7].rm_so + 1);
+            }
+        }
+        regfree(&authreg);
+        g_free(authority);
+    }
+
+    regfree(&preg);
+    return parsed;
+}
+
+
+static void regex_free_uri(gfal2_uri *uri)
+{
+    g_free(uri->scheme);
+    g_free(uri->userinfo);
+    g_free(uri->host);
+    g_free(uri->path);
+    g_free(uri->query);
+    g_free(uri->fragment);
+    g_free(uri);
+}
+
+
+static gboolean same_component(const char *a, const char *b)
+{
+    if (a == NULL || b == NULL)
+        return a == b;
+    return strcmp(a, b) == 0;
+}
+
+
+static void check_equivalence(const char *url)
+{
+    gfal2_uri *expected = regex_parse_uri(url);
+    gfal2_uri *parsed = gfal2_parse_uri(url, NULL);
+
+    if (!same_component(expected->scheme, parsed->scheme) ||
+        !same_component(expected->userinfo, parsed->userinfo) ||
+        !same_component(expected->host, parsed->host) ||
+        expected->port != parsed->port ||
+        !same_component(expected->path, parsed->path) ||
+        !same_component(expected->query, parsed->query) ||
+        !same_component(expected->fragment, parsed->fragment)) {
+        fprintf(stderr, "The parsers disagree on %s\n", url);
+        exit(1);
+    }
+
+    regex_free_uri(expected);
+    gfal2_free_uri(parsed);
+}
+
+
+int main(int argc, char** argv)
+{
+    long iterations = 1000000;
+    if (argc > 1)
+        iterations = atol(argv[1]);
+
+    int n_urls, i;
+    for (n_urls = 0; bench_urls[n_urls] != NULL; ++n_urls)
+        check_equivalence(bench_urls[n_urls]);
+
+    gint64 start = g_get_monotonic_time();
+    for (i = 0; i < iterations; ++i)
+        regex_free_uri(regex_parse_uri(bench_urls[i % n_urls]));
+    gint64 regex_elapsed = g_get_monotonic_time() - start;
+
+    start = g_get_monotonic_time();
+    for (i = 0; i < iterations; ++i)
+        gfal2_free_uri(gfal2_parse_uri(bench_urls[i % n_urls], NULL));
+    gint64 parser_elapsed = g_get_monotonic_time() - start;
+
+    printf("%ld parses over %d urls\n", iterations, n_urls);
+    printf("regex:  %8.0f parses/s\n", iterations * (double) G_USEC_PER_SEC / regex_elapsed);
+    printf("parser: %8.0f parses/s\n", iterations * (double) G_USEC_PER_SEC / parser_elapsed);
+    return 0;
+}
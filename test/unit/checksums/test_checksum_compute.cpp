@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <unit/fake_plugin.h>
+#include <utils/checksums/checksums.h>
+
+// Checksums computed by gfal2_checksum_compute over an in-memory plugin implementing preadG
+
+
+#define FILE_SIZE (9 * 1024 * 1024 + 123)
+
+static GQuark domain = g_quark_from_static_string("TEST");
+
+struct pread_plugin_data {
+    std::vector<char> content;
+    // fail the reads at or after this offset, -1 never
+    ssize_t fail_at;
+};
+
+
+static gfal_file_handle pread_plugin_open(plugin_handle plugin_data, const char* url,
+    int flag, mode_t mode, GError** err)
+{
+    return gfal_file_handle_new(fake_plugin_name(), NULL);
+}
+
+
+static ssize_t pread_plugin_pread(plugin_handle plugin_data, gfal_file_handle fd,
+    void* buff, size_t count, off_t offset, GError** err)
+{
+    pread_plugin_data* data = (pread_plugin_data*)plugin_data;
+
+    if (data->fail_at >= 0 && offset >= data->fail_at) {
+        gfal2_set_error(err, domain, EIO, __func__, "Read failure");
+        return -1;
+    }
+    if ((size_t)offset >= data->content.size()) {
+        return 0;
+    }
+
+    // Short reads, the helper must loop
+    size_t size = std::min(count, std::min(data->content.size() - offset, (size_t)700000));
+    memcpy(buff, data->content.data() + offset, size);
+    return size;
+}
+
+
+static int pread_plugin_stat(plugin_handle plugin_data, const char* url, struct stat* buf, GError** err)
+{
+    pread_plugin_data* data = (pread_plugin_data*)plugin_data;
+    memset(buf, 0, sizeof(*buf));
+    buf->st_mode = S_IFREG | 0644;
+    buf->st_size = data->content.size();
+    return 0;
+}
+
+
+static int pread_plugin_close(plugin_handle plugin_data, gfal_file_handle fd, GError** err)
+{
+    gfal_file_handle_delete(fd);
+    return 0;
+}
+
+
+class ChecksumComputeTest: public FakePluginTest {
+protected:
+    pread_plugin_data data;
+
+    void SetUp() {
+        data.content.resize(FILE_SIZE);
+        for (size_t i = 0; i < data.content.size(); ++i) {
+            data.content[i] = (char)(rand() % 256);
+        }
+        data.fail_at = -1;
+
+        ASSERT_NO_FATAL_FAILURE(FakePluginTest::SetUp());
+        plugin.openG = pread_plugin_open;
+        plugin.preadG = pread_plugin_pread;
+        plugin.statG = pread_plugin_stat;
+        plugin.closeG = pread_plugin_close;
+        registerFakePlugin(&data);
+    }
+
+    std::string expected(const char* type, size_t offset, size_t length) {
+        char buffer[64];
+        gfal2_checksum_ctx* ctx = gfal2_checksum_ctx_new(type);
+        gfal2_checksum_ctx_update(ctx, data.content.data() + offset, length);
+        gfal2_checksum_ctx_final(ctx, buffer, sizeof(buffer));
+        gfal2_checksum_ctx_free(ctx);
+        return buffer;
+    }
+};
+
+
+TEST_F(ChecksumComputeTest, threads)
+{
+    const char* types[] = {"ADLER32", "CRC32", "CRC32C", "MD5"};
+    const int threads[] = {1, 3, 8};
+
+    for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); ++t) {
+        gfal2_set_opt_integer(context, "CORE", "CHECKSUM_THREADS", threads[t], NULL);
+        for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); ++i) {
+            char buffer[64];
+            GError* error = NULL;
+
+            // Whole file
+            ASSERT_EQ(0, gfal2_checksum_compute(context, "fake://file", types[i], 0, 0,
+                buffer, sizeof(buffer), &error));
+            ASSERT_EQ(expected(types[i], 0, FILE_SIZE), buffer) << types[i] << " " << threads[t];
+
+            // Partial
+            ASSERT_EQ(0, gfal2_checksum_compute(context, "fake://file", types[i], 1000, 5 * 1024 * 1024,
+                buffer, sizeof(buffer), &error));
+            ASSERT_EQ(expected(types[i], 1000, 5 * 1024 * 1024), buffer) << types[i] << " " << threads[t];
+
+            // Length past the end of the file
+            ASSERT_EQ(0, gfal2_checksum_compute(context, "fake://file", types[i], 4 * 1024 * 1024, FILE_SIZE,
+                buffer, sizeof(buffer), &error));
+            ASSERT_EQ(expected(types[i], 4 * 1024 * 1024, FILE_SIZE - 4 * 1024 * 1024), buffer)
+                << types[i] << " " << threads[t];
+        }
+    }
+}
+
+
+TEST_F(ChecksumComputeTest, staleCachedSize)
+{
+    char buffer[64];
+    GError* error = NULL;
+    struct stat st;
+
+    gfal2_set_opt_integer(context, "CORE", "METADATA_CACHE_TTL", 60, NULL);
+    gfal2_set_opt_integer(context, "CORE", "CHECKSUM_THREADS", 4, NULL);
+    ASSERT_EQ(0, gfal2_stat(context, "fake://file", &st, &error));
+    ASSERT_EQ(FILE_SIZE, st.st_size);
+
+    // The file grows after its size was cached
+    data.content.resize(FILE_SIZE + 3 * 1024 * 1024, 'x');
+    ASSERT_EQ(0, gfal2_checksum_compute(context, "fake://file", "ADLER32", 0, 0,
+        buffer, sizeof(buffer), &error));
+    ASSERT_EQ(expected("ADLER32", 0, data.content.size()), buffer);
+}
+
+
+TEST_F(ChecksumComputeTest, readError)
+{
+    char buffer[64];
+    GError* error = NULL;
+
+    data.fail_at = 7 * 1024 * 1024;
+    gfal2_set_opt_integer(context, "CORE", "CHECKSUM_THREADS", 4, NULL);
+    ASSERT_EQ(-1, gfal2_checksum_compute(context, "fake://file", "ADLER32", 0, 0,
+        buffer, sizeof(buffer), &error));
+    ASSERT_TRUE(error != NULL);
+    ASSERT_EQ(EIO, error->code);
+    g_error_free(error);
+}
+
+
+TEST_F(ChecksumComputeTest, notSupported)
+{
+    char buffer[64];
+    GError* error = NULL;
+
+    ASSERT_EQ(-1, gfal2_checksum_compute(context, "fake://file", "SHA1", 0, 0,
+        buffer, sizeof(buffer), &error));
+    ASSERT_TRUE(error != NULL);
+    ASSERT_EQ(ENOSYS, error->code);
+    g_error_free(error);
+}
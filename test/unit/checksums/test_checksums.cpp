@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+#include <zlib.h>
+#include <utils/checksums/checksums.h>
+#include <utils/checksums/checksum_kernels.h>
+
+
+class ChecksumKernelsTest: public testing::Test {
+protected:
+    std::vector<unsigned char> data;
+    const gfal2_checksum_kernels *best, *scalar;
+
+    void SetUp() {
+        data.resize(1024 * 1024 + 64);
+        srand(42);
+        for (size_t i = 0; i < data.size(); ++i) {
+            data[i] = rand() % 256;
+        }
+        best = gfal2_checksum_kernels_best();
+        scalar = gfal2_checksum_kernels_scalar();
+    }
+};
+
+
+TEST_F(ChecksumKernelsTest, knownValues)
+{
+    const unsigned char* check = (const unsigned char*)"123456789";
+    ASSERT_EQ(0x091e01deU, best->adler32(1, check, 9));
+    ASSERT_EQ(0xcbf43926U, best->crc32(0, check, 9));
+    ASSERT_EQ(0xe3069283U, best->crc32c(0, check, 9));
+    ASSERT_EQ(0xe3069283U, scalar->crc32c(0, check, 9));
+}
+
+
+TEST_F(ChecksumKernelsTest, matchZlib)
+{
+    // All small sizes, to cover every tail, then random sizes and alignments
+    for (size_t i = 0; i < 2000; ++i) {
+        size_t offset = rand() % 64;
+        size_t size = (i < 1000) ? i : rand() % (data.size() - 64);
+        const unsigned char* p = data.data() + offset;
+        uint32_t seed = rand();
+
+        ASSERT_EQ(adler32(seed % 65521, p, size), best->adler32(seed % 65521, p, size)) << size;
+        ASSERT_EQ(crc32(seed, p, size), best->crc32(seed, p, size)) << size;
+        ASSERT_EQ(scalar->crc32c(seed, p, size), best->crc32c(seed, p, size)) << size;
+    }
+}
+
+
+TEST_F(ChecksumKernelsTest, adler32WorstCase)
+{
+    // All bytes at 0xff maximize the sums before the modulo
+    std::vector<unsigned char> ones(data.size(), 0xff);
+    const uint32_t seed = 0xfff0fff0;
+    ASSERT_EQ(adler32(seed, ones.data(), ones.size()), best->adler32(seed, ones.data(), ones.size()));
+}
+
+
+TEST(ChecksumContext, singleAlgorithm)
+{
+    char buffer[64];
+    const char* check = "123456789";
+    struct {
+        const char* type;
+        const char* expected;
+    } cases[] = {
+        {"ADLER32", "091e01de"},
+        {"crc32", "3421780262"},
+        {"CRC32C", "e3069283"},
+        {"md5", "25f9e794323b453885f5181f1b624d0b"},
+    };
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+        gfal2_checksum_ctx* ctx = gfal2_checksum_ctx_new(cases[i].type);
+        ASSERT_NE((void*)NULL, ctx);
+        gfal2_checksum_ctx_update(ctx, check, 4);
+        gfal2_checksum_ctx_update(ctx, check + 4, 5);
+        ASSERT_EQ(0, gfal2_checksum_ctx_final(ctx, buffer, sizeof(buffer)));
+        ASSERT_STREQ(cases[i].expected, buffer);
+        gfal2_checksum_ctx_free(ctx);
+    }
+
+    ASSERT_EQ(NULL, gfal2_checksum_ctx_new("SHA1"));
+}
+
+
+TEST(ChecksumContext, multiAlgorithm)
+{
+    std::vector<unsigned char> data(3 * 1024 * 1024 + 17);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = rand() % 256;
+    }
+
+    gfal2_checksum_ctx* multi = gfal2_checksum_ctx_new_multi(GFAL2_CHECKSUM_ALL);
+    gfal2_checksum_ctx_update(multi, data.data(), data.size());
+
+    const gfal2_checksum_algorithm algorithms[] = {
+        GFAL2_CHECKSUM_ADLER32, GFAL2_CHECKSUM_CRC32, GFAL2_CHECKSUM_CRC32C, GFAL2_CHECKSUM_MD5
+    };
+    for (size_t i = 0; i < sizeof(algorithms) / sizeof(algorithms[0]); ++i) {
+        char expected[64], got[64];
+
+        gfal2_checksum_ctx* single = gfal2_checksum_ctx_new_multi(algorithms[i]);
+        gfal2_checksum_ctx_update(single, data.data(), data.size());
+        ASSERT_EQ(0, gfal2_checksum_ctx_final(single, expected, sizeof(expected)));
+        gfal2_checksum_ctx_free(single);
+
+        ASSERT_EQ(0, gfal2_checksum_ctx_final_algorithm(multi, algorithms[i], got, sizeof(got)));
+        ASSERT_STREQ(expected, got);
+    }
+
+    // The MD5 computed through the context matches the plain implementation
+    GFAL_MD5_CTX md5;
+    unsigned char digest[16];
+    char hex[33], got[33];
+    gfal2_md5_init(&md5);
+    gfal2_md5_update(&md5, data.data(), data.size());
+    gfal2_md5_final(digest, &md5);
+    gfal2_md5_to_hex_string(digest, hex, sizeof(digest));
+
+    gfal2_checksum_ctx* single = gfal2_checksum_ctx_new("MD5");
+    gfal2_checksum_ctx_update(single, data.data(), data.size());
+    gfal2_checksum_ctx_final(single, got, sizeof(got));
+    gfal2_checksum_ctx_free(single);
+    ASSERT_STREQ(hex, got);
+
+    gfal2_checksum_ctx_free(multi);
+}
+
+
+TEST(ChecksumContext, combine)
+{
+    std::vector<unsigned char> data(5 * 1024 * 1024 + 3);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = rand() % 256;
+    }
+
+    const unsigned algorithms[] = {
+        GFAL2_CHECKSUM_ADLER32, GFAL2_CHECKSUM_CRC32, GFAL2_CHECKSUM_CRC32C, GFAL2_CHECKSUM_COMBINABLE
+    };
+    for (size_t i = 0; i < sizeof(algorithms) / sizeof(algorithms[0]); ++i) {
+        gfal2_checksum_ctx* whole = gfal2_checksum_ctx_new_multi(algorithms[i]);
+        gfal2_checksum_ctx_update(whole, data.data(), data.size());
+
+        // Random ranges, including empty ones
+        gfal2_checksum_ctx* combined = gfal2_checksum_ctx_new_multi(algorithms[i]);
+        size_t offset = 0;
+        while (offset < data.size()) {
+            size_t size = std::min(data.size() - offset, (size_t)(rand() % (1024 * 1024)));
+            gfal2_checksum_ctx* range = gfal2_checksum_ctx_new_multi(algorithms[i]);
+            gfal2_checksum_ctx_update(range, data.data() + offset, size);
+            ASSERT_EQ(0, gfal2_checksum_ctx_combine(combined, range));
+            gfal2_checksum_ctx_free(range);
+            offset += size;
+        }
+
+        for (unsigned algorithm = GFAL2_CHECKSUM_ADLER32; algorithm <= GFAL2_CHECKSUM_CRC32C; algorithm <<= 1) {
+            char expected[64], got[64];
+            if (!(algorithms[i] & algorithm)) {
+                continue;
+            }
+            gfal2_checksum_ctx_final_algorithm(whole, (gfal2_checksum_algorithm)algorithm, expected, sizeof(expected));
+            gfal2_checksum_ctx_final_algorithm(combined, (gfal2_checksum_algorithm)algorithm, got, sizeof(got));
+            ASSERT_STREQ(expected, got);
+        }
+        gfal2_checksum_ctx_free(whole);
+        gfal2_checksum_ctx_free(combined);
+    }
+}
+
+
+TEST(ChecksumContext, combineNotSupported)
+{
+    gfal2_checksum_ctx* md5 = gfal2_checksum_ctx_new("MD5");
+    gfal2_checksum_ctx* md5_next = gfal2_checksum_ctx_new("MD5");
+    ASSERT_EQ(-1, gfal2_checksum_ctx_combine(md5, md5_next));
+
+    gfal2_checksum_ctx* adler32 = gfal2_checksum_ctx_new("ADLER32");
+    gfal2_checksum_ctx* crc32 = gfal2_checksum_ctx_new("CRC32");
+    ASSERT_EQ(-1, gfal2_checksum_ctx_combine(adler32, crc32));
+
+    gfal2_checksum_ctx_free(md5);
+    gfal2_checksum_ctx_free(md5_next);
+    gfal2_checksum_ctx_free(adler32);
+    gfal2_checksum_ctx_free(crc32);
+}
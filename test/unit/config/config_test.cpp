@@ -22,6 +22,7 @@
 #include <gtest/gtest.h>
 #include <common/gfal_gtest_asserts.h>
 #include <utils/exceptions/gerror_to_cpp.h>
+#include <unit/fake_plugin.h>
 
 
 class ConfigFixture: public testing::Test {
@@ -119,4 +120,185 @@ TEST_F(ConfigFixture, KeyList)
     EXPECT_EQ(NULL, keys[2]);
 
     g_strfreev(keys);
-}
\ No newline at end of file
+}
+
+TEST_F(ConfigFixture, Clone)
+{
+    GError *error = NULL;
+    int ret = 0;
+
+    ret = gfal2_set_opt_string(context, "GROUP1", "KEY1", "ORIGINAL", &error);
+    EXPECT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    ret = gfal2_set_user_agent(context, "agent", "1.0", &error);
+    EXPECT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    ret = gfal2_add_client_info(context, "TEST", "VALUE", &error);
+    EXPECT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+
+    gfal2_context_t clone = gfal2_context_clone(context, &error);
+    ASSERT_TRUE(clone != NULL);
+
+    gchar *value = gfal2_get_opt_string(clone, "GROUP1", "KEY1", &error);
+    EXPECT_PRED_FORMAT2(AssertGfalSuccess, 0, error);
+    EXPECT_STREQ("ORIGINAL", value);
+    g_free(value);
+
+    const char *agent, *version;
+    gfal2_get_user_agent(clone, &agent, &version);
+    EXPECT_STREQ("agent", agent);
+    EXPECT_STREQ("1.0", version);
+
+    const char *info;
+    ret = gfal2_get_client_info_value(clone, "TEST", &info, &error);
+    EXPECT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    EXPECT_STREQ("VALUE", info);
+
+    // Both contexts change independently
+    gfal2_set_opt_string(clone, "GROUP1", "KEY1", "CHANGED", NULL);
+    gfal2_set_opt_integer(context, "GROUP1", "KEY2", 42, NULL);
+
+    value = gfal2_get_opt_string(context, "GROUP1", "KEY1", NULL);
+    EXPECT_STREQ("ORIGINAL", value);
+    g_free(value);
+    EXPECT_EQ(-1, gfal2_get_opt_integer_with_default(clone, "GROUP1", "KEY2", -1));
+
+    gchar **names = gfal2_get_plugin_names(clone);
+    gchar **original_names = gfal2_get_plugin_names(context);
+    EXPECT_EQ(g_strv_length(original_names), g_strv_length(names));
+    g_strfreev(names);
+    g_strfreev(original_names);
+
+    gfal2_context_free(clone);
+}
+
+
+static int clone_plugin_stat(plugin_handle plugin_data, const char* url, struct stat* buf, GError** err)
+{
+    memset(buf, 0, sizeof(*buf));
+    buf->st_size = 42;
+    return 0;
+}
+
+
+class CloneFixture: public FakePluginTest {
+};
+
+
+TEST_F(CloneFixture, RegisteredPlugins)
+{
+    GError *error = NULL;
+    plugin.statG = clone_plugin_stat;
+    registerFakePlugin(NULL);
+
+    // Plugins registered by the application are kept by the clone
+    gfal2_context_t clone = gfal2_context_clone(context, &error);
+    ASSERT_TRUE(clone != NULL);
+
+    struct stat st;
+    int ret = gfal2_stat(clone, "fake://host/file", &st, &error);
+    EXPECT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    EXPECT_EQ(42, st.st_size);
+
+    gchar **names = gfal2_get_plugin_names(clone);
+    bool found = false;
+    for (int i = 0; names[i] != NULL; ++i)
+        found = found || strcmp(names[i], fake_plugin_name()) == 0;
+    EXPECT_TRUE(found);
+    g_strfreev(names);
+
+    gfal2_context_free(clone);
+}
+
+
+TEST_F(ConfigFixture, SharedConfiguration)
+{
+    GError *error = NULL;
+    gsize count = 0, n_core = 0;
+
+    // The same files are seen by every context
+    gfal2_context_t other = gfal2_context_new(&error);
+    ASSERT_TRUE(other != NULL);
+
+    gchar **keys = gfal2_get_opt_keys(context, "CORE", &n_core, NULL);
+    g_strfreev(keys);
+    keys = gfal2_get_opt_keys(other, "CORE", &count, NULL);
+    g_strfreev(keys);
+    EXPECT_EQ(n_core, count);
+
+    // A new key is added after the ones of the files
+    gfal2_set_opt_string(context, "CORE", "UNIT_TEST_KEY", "value", NULL);
+    keys = gfal2_get_opt_keys(context, "CORE", &count, NULL);
+    ASSERT_EQ(n_core + 1, count);
+    EXPECT_STREQ("UNIT_TEST_KEY", keys[count - 1]);
+    g_strfreev(keys);
+
+    keys = gfal2_get_opt_keys(other, "CORE", &count, NULL);
+    EXPECT_EQ(n_core, count);
+    g_strfreev(keys);
+
+    // Removing a key of the files only affects this context
+    if (n_core > 0) {
+        keys = gfal2_get_opt_keys(other, "CORE", &count, NULL);
+        EXPECT_TRUE(gfal2_remove_opt(context, "CORE", keys[0], NULL));
+        gchar *value = gfal2_get_opt_string(context, "CORE", keys[0], &error);
+        EXPECT_EQ(NULL, value);
+        g_clear_error(&error);
+        value = gfal2_get_opt_string(other, "CORE", keys[0], &error);
+        EXPECT_PRED_FORMAT2(AssertGfalSuccess, 0, error);
+        g_free(value);
+        g_strfreev(keys);
+    }
+
+    gfal2_context_free(other);
+}
+
+
+TEST_F(ConfigFixture, RegisteredOptions)
+{
+    gfal2_opt_t opt_int = gfal2_register_opt("GROUP1", "INT", GFAL_OPT_INTEGER);
+    gfal2_opt_t opt_bool = gfal2_register_opt("GROUP1", "BOOL", GFAL_OPT_BOOLEAN);
+    gfal2_opt_t opt_list = gfal2_register_opt("GROUP1", "LIST", GFAL_OPT_STRING_LIST);
+    EXPECT_EQ(opt_int, gfal2_register_opt("GROUP1", "INT", GFAL_OPT_INTEGER));
+    EXPECT_NE(opt_int, gfal2_register_opt("GROUP1", "INT", GFAL_OPT_STRING));
+
+    // Not set
+    EXPECT_EQ(-1, gfal2_opt_get_integer(context, opt_int, -1));
+    EXPECT_TRUE(gfal2_opt_get_boolean(context, opt_bool, TRUE));
+    gsize length = 1;
+    gchar **list = gfal2_opt_get_string_list(context, opt_list, &length, NULL);
+    EXPECT_EQ(NULL, list);
+    EXPECT_EQ(0, length);
+
+    // Each change of the context is seen
+    guint generation = gfal2_get_opt_generation(context);
+    gfal2_set_opt_integer(context, "GROUP1", "INT", 42, NULL);
+    EXPECT_NE(generation, gfal2_get_opt_generation(context));
+    EXPECT_EQ(42, gfal2_opt_get_integer(context, opt_int, -1));
+    gfal2_set_opt_integer(context, "GROUP1", "INT", 43, NULL);
+    EXPECT_EQ(43, gfal2_opt_get_integer(context, opt_int, -1));
+
+    gfal2_set_opt_boolean(context, "GROUP1", "BOOL", FALSE, NULL);
+    EXPECT_FALSE(gfal2_opt_get_boolean(context, opt_bool, TRUE));
+
+    const gchar *values[] = {"a", "b"};
+    gfal2_set_opt_string_list(context, "GROUP1", "LIST", values, 2, NULL);
+    list = gfal2_opt_get_string_list(context, opt_list, &length, NULL);
+    ASSERT_EQ(2, length);
+    EXPECT_STREQ("b", list[1]);
+    g_strfreev(list);
+
+    gfal2_remove_opt(context, "GROUP1", "INT", NULL);
+    EXPECT_EQ(-1, gfal2_opt_get_integer(context, opt_int, -1));
+
+    // Values that can not be parsed give the default
+    gfal2_set_opt_string(context, "GROUP1", "BOOL", "not a boolean", NULL);
+    EXPECT_TRUE(gfal2_opt_get_boolean(context, opt_bool, TRUE));
+
+    // The handle is the same for other contexts, not the values
+    gfal2_context_t other = gfal2_context_new(NULL);
+    ASSERT_TRUE(other != NULL);
+    EXPECT_EQ(-1, gfal2_opt_get_integer(other, opt_int, -1));
+    gfal2_set_opt_integer(other, "GROUP1", "INT", 5, NULL);
+    EXPECT_EQ(5, gfal2_opt_get_integer(other, opt_int, -1));
+    EXPECT_EQ(-1, gfal2_opt_get_integer(context, opt_int, -1));
+    gfal2_context_free(other);
+}
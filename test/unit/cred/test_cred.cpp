@@ -17,6 +17,8 @@
 #include <gfal_api.h>
 #include <gtest/gtest.h>
 #include "common/gfal_gtest_asserts.h"
+#include <string>
+#include <vector>
 
 class CredTest: public testing::Test {
 protected:
@@ -258,3 +260,43 @@ TEST_F(CredTest, set_get_prefix)
     ASSERT_EQ(resp, (void*) NULL);
     ASSERT_STREQ("", baseurl);
 }
+
+static gboolean collect_callback(const char *url_prefix, const gfal2_cred_t *cred, void *user_data)
+{
+    std::vector<std::string> *prefixes = static_cast<std::vector<std::string>*>(user_data);
+    prefixes->push_back(url_prefix);
+    return FALSE;
+}
+
+TEST_F(CredTest, foreach_match)
+{
+    const char* root_base = "https://host.com/path";
+    const char* dir_base = "https://host.com/path/subpath";
+    const char* file_base = "https://host.com/path/subpath/file";
+    const char* sibling_base = "https://host.com/path/subpath_sibling/file";
+    GError* error = NULL;
+
+    int ret = gfal2_cred_set(context, root_base, token, &error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    ret = gfal2_cred_set(context, dir_base, token_2, &error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    ret = gfal2_cred_set(context, file_base, token, &error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+    ret = gfal2_cred_set(context, sibling_base, token, &error);
+    ASSERT_PRED_FORMAT2(AssertGfalSuccess, ret, error);
+
+    // Parents, the longest first
+    std::vector<std::string> prefixes;
+    gfal2_cred_foreach_match(context, GFAL_CRED_BEARER, "https://host.com/path/subpath/other", FALSE,
+        collect_callback, &prefixes);
+    ASSERT_EQ(prefixes, std::vector<std::string>({dir_base, root_base}));
+
+    // Sub-paths before the url itself and its parents
+    prefixes.clear();
+    gfal2_cred_foreach_match(context, GFAL_CRED_BEARER, dir_base, TRUE, collect_callback, &prefixes);
+    ASSERT_EQ(prefixes, std::vector<std::string>({file_base, dir_base, root_base}));
+
+    prefixes.clear();
+    gfal2_cred_foreach_match(context, GFAL_CRED_X509_CERT, dir_base, TRUE, collect_callback, &prefixes);
+    ASSERT_TRUE(prefixes.empty());
+}
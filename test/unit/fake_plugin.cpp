@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+#include "fake_plugin.h"
+
+
+const char* fake_plugin_name()
+{
+    return "FAKE-PLUGIN";
+}
+
+
+static gboolean fake_plugin_check_url(plugin_handle plugin_data, const char* url,
+    plugin_mode operation, GError** err)
+{
+    return g_ascii_strncasecmp(url, "fake://", 7) == 0;
+}
+
+
+void FakePluginTest::SetUp()
+{
+    GError* error = NULL;
+    context = gfal2_context_new(&error);
+    ASSERT_TRUE(context != NULL);
+
+    memset(&plugin, 0, sizeof(plugin));
+    plugin.getName = fake_plugin_name;
+    plugin.check_plugin_url = fake_plugin_check_url;
+}
+
+
+void FakePluginTest::TearDown()
+{
+    gfal2_context_free(context);
+}
+
+
+void FakePluginTest::registerFakePlugin(plugin_handle plugin_data)
+{
+    GError* error = NULL;
+    plugin.plugin_data = plugin_data;
+    ASSERT_EQ(0, gfal2_register_plugin(context, &plugin, &error));
+}
@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <gtest/gtest.h>
+#include <gfal_api.h>
+#include <gfal_plugins_api.h>
+
+// Fake plugin shared by the unit tests of the core
+
+
+/// Name of the fake plugin, to be given to the file handles it creates
+const char* fake_plugin_name();
+
+
+/// Fixture with a context and a fake plugin handling the fake:// urls.
+/// The tests set the callbacks they need on plugin, then call registerFakePlugin
+class FakePluginTest: public testing::Test {
+protected:
+    gfal2_context_t context;
+    gfal_plugin_interface plugin;
+
+    virtual void SetUp();
+    virtual void TearDown();
+
+    /// Register the plugin with plugin_data as its handle
+    void registerFakePlugin(plugin_handle plugin_data);
+};
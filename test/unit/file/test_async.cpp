@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <unistd.h>
+#include <vector>
+#include <unit/fake_plugin.h>
+
+// Asynchronous operations over an in-memory plugin
+
+
+struct async_plugin_data {
+    // time spent in each stat, in microseconds
+    useconds_t stat_delay;
+    // stat calls running at the same time
+    volatile gint running;
+    volatile gint max_running;
+};
+
+
+static int async_plugin_stat(plugin_handle plugin_data, const char* url, struct stat* buf, GError** err)
+{
+    async_plugin_data* data = (async_plugin_data*)plugin_data;
+
+    gint running = g_atomic_int_add(&data->running, 1) + 1;
+    gint max_running;
+    do {
+        max_running = g_atomic_int_get(&data->max_running);
+    } while (running > max_running && !g_atomic_int_compare_and_exchange(&data->max_running, max_running, running));
+
+    usleep(data->stat_delay);
+    memset(buf, 0, sizeof(*buf));
+    buf->st_size = strlen(url);
+
+    g_atomic_int_add(&data->running, -1);
+    return 0;
+}
+
+
+static gfal_file_handle async_plugin_open(plugin_handle plugin_data, const char* url,
+    int flag, mode_t mode, GError** err)
+{
+    return gfal_file_handle_new(fake_plugin_name(), NULL);
+}
+
+
+static int async_plugin_close(plugin_handle plugin_data, gfal_file_handle fd, GError** err)
+{
+    gfal_file_handle_delete(fd);
+    return 0;
+}
+
+
+static ssize_t async_plugin_pread(plugin_handle plugin_data, gfal_file_handle fd,
+    void* buff, size_t count, off_t offset, GError** err)
+{
+    memset(buff, 'a' + (offset % 26), count);
+    return count;
+}
+
+
+static void count_callback(gfal2_request_t request, void* user_data)
+{
+    g_atomic_int_inc((gint*)user_data);
+}
+
+
+class AsyncTest: public FakePluginTest {
+protected:
+    async_plugin_data data;
+
+    void SetUp() {
+        memset(&data, 0, sizeof(data));
+        data.stat_delay = 1000;
+
+        ASSERT_NO_FATAL_FAILURE(FakePluginTest::SetUp());
+        gfal2_set_opt_integer(context, "CORE", "ASYNC_THREADS", 8, NULL);
+        gfal2_set_opt_integer(context, "CORE", "ASYNC_MAX_PER_PLUGIN", 4, NULL);
+
+        plugin.statG = async_plugin_stat;
+        plugin.openG = async_plugin_open;
+        plugin.closeG = async_plugin_close;
+        plugin.preadG = async_plugin_pread;
+        registerFakePlugin(&data);
+    }
+};
+
+
+TEST_F(AsyncTest, stat)
+{
+    const int n = 200;
+    std::vector<gfal2_request_t> requests(n);
+    std::vector<struct stat> st(n);
+    std::vector<std::string> urls(n);
+    gint callbacks = 0;
+    GError* error = NULL;
+
+    for (int i = 0; i < n; ++i) {
+        urls[i] = "fake://host/" + std::to_string(i);
+        requests[i] = gfal2_stat_async(context, urls[i].c_str(), &st[i], count_callback, &callbacks, &error);
+        ASSERT_TRUE(requests[i] != NULL);
+    }
+    for (int i = 0; i < n; ++i) {
+        ASSERT_EQ(0, gfal2_request_wait(requests[i], -1, &error));
+        ASSERT_TRUE(gfal2_request_is_done(requests[i]));
+        ASSERT_EQ(urls[i].size(), (size_t)st[i].st_size);
+        gfal2_request_free(requests[i]);
+    }
+
+    // Bounded by the limit per plugin
+    ASSERT_LE(data.max_running, 4);
+    ASSERT_GE(data.max_running, 2);
+    while (g_atomic_int_get(&callbacks) < n) {
+        usleep(1000);
+    }
+}
+
+
+TEST_F(AsyncTest, openAndRead)
+{
+    GError* error = NULL;
+    gfal2_request_t request = gfal2_open_async(context, "fake://host/file", O_RDONLY, NULL, NULL, &error);
+    ASSERT_TRUE(request != NULL);
+    int fd = gfal2_request_wait(request, -1, &error);
+    gfal2_request_free(request);
+    ASSERT_GT(fd, 0);
+
+    char buffer[16];
+    request = gfal2_pread_async(context, fd, buffer, sizeof(buffer), 2, NULL, NULL, &error);
+    ASSERT_TRUE(request != NULL);
+    ASSERT_EQ((ssize_t)sizeof(buffer), gfal2_request_wait(request, -1, &error));
+    ASSERT_EQ('c', buffer[0]);
+    gfal2_request_free(request);
+
+    ASSERT_EQ(0, gfal2_close(context, fd, &error));
+}
+
+
+TEST_F(AsyncTest, badArguments)
+{
+    GError* error = NULL;
+    struct stat st;
+    char buffer[16];
+
+    ASSERT_TRUE(gfal2_stat_async(context, "unknown://host/file", &st, NULL, NULL, &error) == NULL);
+    ASSERT_TRUE(error != NULL);
+    g_clear_error(&error);
+
+    ASSERT_TRUE(gfal2_pread_async(context, 12345, buffer, sizeof(buffer), 0, NULL, NULL, &error) == NULL);
+    ASSERT_TRUE(error != NULL);
+    g_clear_error(&error);
+
+    ASSERT_EQ(-1, gfal2_request_wait(NULL, 0, &error));
+    ASSERT_EQ(EFAULT, error->code);
+    g_clear_error(&error);
+    ASSERT_EQ(-1, gfal2_request_cancel(NULL));
+    gfal2_request_free(NULL);
+}
+
+
+TEST_F(AsyncTest, cancel)
+{
+    const int n = 50;
+    std::vector<gfal2_request_t> requests(n);
+    struct stat st;
+    GError* error = NULL;
+
+    data.stat_delay = 100000;
+    for (int i = 0; i < n; ++i) {
+        requests[i] = gfal2_stat_async(context, "fake://host/file", &st, NULL, NULL, &error);
+        ASSERT_TRUE(requests[i] != NULL);
+    }
+
+    // Still queued behind the running ones
+    ASSERT_EQ(-1, gfal2_request_wait(requests[n - 1], 10, &error));
+    ASSERT_EQ(ETIMEDOUT, error->code);
+    g_clear_error(&error);
+
+    ASSERT_EQ(0, gfal2_request_cancel(requests[n - 1]));
+    ASSERT_EQ(-1, gfal2_request_wait(requests[n - 1], -1, &error));
+    ASSERT_EQ(ECANCELED, error->code);
+    g_clear_error(&error);
+
+    // The rest of the queue
+    gfal2_cancel(context);
+    int canceled = 0;
+    for (int i = 0; i < n; ++i) {
+        if (gfal2_request_wait(requests[i], -1, &error) < 0) {
+            ASSERT_EQ(ECANCELED, error->code);
+            g_clear_error(&error);
+            ++canceled;
+        }
+        gfal2_request_free(requests[i]);
+    }
+    ASSERT_GE(canceled, n - 4);
+}
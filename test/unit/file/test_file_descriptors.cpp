@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <errno.h>
+#include <set>
+#include <gfal_api.h>
+
+#define __GFAL2_H_INSIDE__
+#include <common/gfal_file_handler_container.h>
+#undef __GFAL2_H_INSIDE__
+
+// Descriptors of closed files must not resolve to the handles opened after them
+
+
+class FileDescriptorTest: public testing::Test {
+protected:
+    gfal_file_handle_container container;
+    int values[4];
+
+    void SetUp() {
+        container = gfal_file_descriptor_handle_create(NULL);
+    }
+
+    void TearDown() {
+        gfal_file_descriptor_handle_destroy(container);
+    }
+
+    int add(gpointer data) {
+        GError* error = NULL;
+        int fd = gfal_add_new_file_desc(container, data, &error);
+        EXPECT_EQ(NULL, error);
+        EXPECT_GT(fd, 0);
+        return fd;
+    }
+
+    void remove(int fd) {
+        GError* error = NULL;
+        EXPECT_TRUE(gfal_remove_file_desc(container, fd, &error));
+        EXPECT_EQ(NULL, error);
+    }
+
+    void expectStale(int fd) {
+        GError* error = NULL;
+        EXPECT_EQ(NULL, gfal_file_handle_bind(container, fd, &error));
+        ASSERT_NE((GError*) NULL, error);
+        EXPECT_EQ(EBADF, error->code);
+        g_clear_error(&error);
+    }
+};
+
+
+TEST_F(FileDescriptorTest, Bind)
+{
+    int fd = add(&values[0]);
+    GError* error = NULL;
+    EXPECT_EQ((gpointer) &values[0], (gpointer) gfal_file_handle_bind(container, fd, &error));
+    EXPECT_EQ(NULL, error);
+    remove(fd);
+}
+
+
+TEST_F(FileDescriptorTest, StaleDescriptor)
+{
+    int fd = add(&values[0]);
+    remove(fd);
+    expectStale(fd);
+
+    GError* error = NULL;
+    EXPECT_FALSE(gfal_remove_file_desc(container, fd, &error));
+    ASSERT_NE((GError*) NULL, error);
+    EXPECT_EQ(EBADF, error->code);
+    g_clear_error(&error);
+
+    expectStale(0);
+    expectStale(-1);
+}
+
+
+TEST_F(FileDescriptorTest, ReleasedSlotsAreNotReusedAtOnce)
+{
+    std::set<int> slots;
+    int fd = add(&values[0]);
+    slots.insert(fd & GFAL_FDESC_SLOT_MASK);
+    remove(fd);
+
+    // A new slot is taken while only a few are free
+    for (int i = 1; i < GFAL_FDESC_MIN_FREE; ++i) {
+        int other = add(&values[1]);
+        EXPECT_TRUE(slots.insert(other & GFAL_FDESC_SLOT_MASK).second);
+        remove(other);
+    }
+
+    // Then the oldest released one comes back, with a new generation
+    int reused = add(&values[2]);
+    EXPECT_EQ(fd & GFAL_FDESC_SLOT_MASK, reused & GFAL_FDESC_SLOT_MASK);
+    EXPECT_NE(fd, reused);
+    expectStale(fd);
+    remove(reused);
+}
+
+
+TEST_F(FileDescriptorTest, StaleDescriptorAfterManyReuses)
+{
+    int stale = add(&values[0]);
+    remove(stale);
+
+    // More cycles than generations, the stale descriptor must never come back
+    const int cycles = 4 * (GFAL_FDESC_GENERATION_MASK + 1);
+    for (int i = 0; i < cycles; ++i) {
+        int fd = add(&values[1]);
+        ASSERT_NE(stale, fd);
+        remove(fd);
+    }
+    expectStale(stale);
+}
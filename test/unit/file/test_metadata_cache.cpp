@@ -0,0 +1,406 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <map>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <unit/fake_plugin.h>
+
+// Metadata cache of the context, in front of the stat of a plugin
+
+
+#define META_ROOT "fake://host"
+
+struct meta_plugin_data {
+    // path -> mode
+    std::map<std::string, mode_t> files;
+    int stat_calls;
+    int access_calls;
+    // added to the size of the files, as if they were written
+    off_t growth;
+};
+
+
+struct meta_plugin_dir {
+    std::map<std::string, mode_t>::iterator next;
+    std::string prefix;
+    struct dirent ent;
+};
+
+
+static int meta_plugin_stat(plugin_handle plugin_data, const char* url, struct stat* buf, GError** err)
+{
+    meta_plugin_data* data = (meta_plugin_data*)plugin_data;
+    data->stat_calls++;
+
+    std::map<std::string, mode_t>::iterator i = data->files.find(url);
+    if (i == data->files.end()) {
+        gfal2_set_error(err, g_quark_from_static_string("meta"), ENOENT, __func__, "No such file %s", url);
+        return -1;
+    }
+    memset(buf, 0, sizeof(*buf));
+    buf->st_mode = i->second;
+    buf->st_size = strlen(url) + data->growth;
+    return 0;
+}
+
+
+static int meta_plugin_access(plugin_handle plugin_data, const char* url, int mode, GError** err)
+{
+    meta_plugin_data* data = (meta_plugin_data*)plugin_data;
+    data->access_calls++;
+
+    if (data->files.count(url) == 0) {
+        gfal2_set_error(err, g_quark_from_static_string("meta"), ENOENT, __func__, "No such file %s", url);
+        return -1;
+    }
+    return 0;
+}
+
+
+static int meta_plugin_unlink(plugin_handle plugin_data, const char* url, GError** err)
+{
+    meta_plugin_data* data = (meta_plugin_data*)plugin_data;
+    data->files.erase(url);
+    return 0;
+}
+
+
+static int meta_plugin_mkdir(plugin_handle plugin_data, const char* url, mode_t mode, gboolean rec_flag, GError** err)
+{
+    meta_plugin_data* data = (meta_plugin_data*)plugin_data;
+    std::string path(url);
+    data->files[path] = S_IFDIR | mode;
+
+    // Create the missing parents, as mkdir -p
+    size_t slash;
+    while (rec_flag && (slash = path.rfind('/')) > strlen(META_ROOT)) {
+        path.resize(slash);
+        data->files.insert(std::make_pair(path, S_IFDIR | mode));
+    }
+    return 0;
+}
+
+
+static gfal_file_handle meta_plugin_open(plugin_handle plugin_data, const char* url, int flag, mode_t mode,
+    GError** err)
+{
+    meta_plugin_data* data = (meta_plugin_data*)plugin_data;
+    if (flag & O_CREAT)
+        data->files[url] = S_IFREG | mode;
+    return gfal_file_handle_new2(fake_plugin_name(), NULL, NULL, url);
+}
+
+
+static int meta_plugin_close(plugin_handle plugin_data, gfal_file_handle fd, GError** err)
+{
+    gfal_file_handle_delete(fd);
+    return 0;
+}
+
+
+static int meta_plugin_rename(plugin_handle plugin_data, const char* oldurl, const char* newurl, GError** err)
+{
+    meta_plugin_data* data = (meta_plugin_data*)plugin_data;
+    std::map<std::string, mode_t> renamed;
+    std::string prefix = std::string(oldurl) + "/";
+
+    for (std::map<std::string, mode_t>::iterator i = data->files.begin(); i != data->files.end(); ++i) {
+        if (i->first == oldurl)
+            renamed[newurl] = i->second;
+        else if (i->first.compare(0, prefix.size(), prefix) == 0)
+            renamed[std::string(newurl) + "/" + i->first.substr(prefix.size())] = i->second;
+        else
+            renamed[i->first] = i->second;
+    }
+    data->files.swap(renamed);
+    return 0;
+}
+
+
+static gfal_file_handle meta_plugin_opendir(plugin_handle plugin_data, const char* url, GError** err)
+{
+    meta_plugin_data* data = (meta_plugin_data*)plugin_data;
+    meta_plugin_dir* dir = new meta_plugin_dir;
+    dir->prefix = std::string(url) + "/";
+    dir->next = data->files.lower_bound(dir->prefix);
+    return gfal_file_handle_new2(fake_plugin_name(), dir, NULL, url);
+}
+
+
+static struct dirent* meta_plugin_readdirpp(plugin_handle plugin_data, gfal_file_handle dir_desc,
+    struct stat* st, GError** err)
+{
+    meta_plugin_data* data = (meta_plugin_data*)plugin_data;
+    meta_plugin_dir* dir = (meta_plugin_dir*)gfal_file_handle_get_fdesc(dir_desc);
+
+    for (; dir->next != data->files.end(); ++dir->next) {
+        const std::string& path = dir->next->first;
+        if (path.compare(0, dir->prefix.size(), dir->prefix) != 0)
+            break;
+        std::string name = path.substr(dir->prefix.size());
+        if (name.find('/') != std::string::npos)
+            continue;
+
+        memset(st, 0, sizeof(*st));
+        st->st_mode = dir->next->second;
+        st->st_size = path.size() + data->growth;
+        g_strlcpy(dir->ent.d_name, name.c_str(), sizeof(dir->ent.d_name));
+        ++dir->next;
+        return &dir->ent;
+    }
+    return NULL;
+}
+
+
+static int meta_plugin_closedir(plugin_handle plugin_data, gfal_file_handle dir_desc, GError** err)
+{
+    delete (meta_plugin_dir*)gfal_file_handle_get_fdesc(dir_desc);
+    gfal_file_handle_delete(dir_desc);
+    return 0;
+}
+
+
+class MetadataCacheTest: public FakePluginTest {
+protected:
+    meta_plugin_data data;
+
+    void SetUp() {
+        data.stat_calls = data.access_calls = 0;
+        data.growth = 0;
+        data.files[META_ROOT "/dir"] = S_IFDIR | 0755;
+        data.files[META_ROOT "/dir/file1"] = S_IFREG | 0644;
+        data.files[META_ROOT "/dir/file2"] = S_IFREG | 0644;
+        data.files[META_ROOT "/dir/sub"] = S_IFDIR | 0755;
+        data.files[META_ROOT "/dir/sub/file3"] = S_IFREG | 0644;
+
+        ASSERT_NO_FATAL_FAILURE(FakePluginTest::SetUp());
+        plugin.statG = meta_plugin_stat;
+        plugin.lstatG = meta_plugin_stat;
+        plugin.accessG = meta_plugin_access;
+        plugin.unlinkG = meta_plugin_unlink;
+        plugin.mkdirpG = meta_plugin_mkdir;
+        plugin.renameG = meta_plugin_rename;
+        plugin.opendirG = meta_plugin_opendir;
+        plugin.readdirppG = meta_plugin_readdirpp;
+        plugin.closedirG = meta_plugin_closedir;
+        plugin.openG = meta_plugin_open;
+        plugin.closeG = meta_plugin_close;
+        registerFakePlugin(&data);
+    }
+
+    void enable(int ttl, int negative_ttl) {
+        gfal2_set_opt_integer(context, "CORE", "METADATA_CACHE_TTL", ttl, NULL);
+        gfal2_set_opt_integer(context, "CORE", "METADATA_CACHE_NEGATIVE_TTL", negative_ttl, NULL);
+    }
+
+    int stat(const char* url, struct stat* st = NULL) {
+        struct stat buf;
+        GError* error = NULL;
+        int ret = gfal2_stat(context, url, st ? st : &buf, &error);
+        if (ret < 0) {
+            EXPECT_EQ(ENOENT, error->code);
+            g_error_free(error);
+        }
+        return ret;
+    }
+};
+
+
+TEST_F(MetadataCacheTest, disabledByDefault)
+{
+    ASSERT_EQ(0, stat(META_ROOT "/dir/file1"));
+    ASSERT_EQ(0, stat(META_ROOT "/dir/file1"));
+    ASSERT_EQ(2, data.stat_calls);
+}
+
+
+TEST_F(MetadataCacheTest, positive)
+{
+    enable(60, 0);
+
+    struct stat st1, st2;
+    ASSERT_EQ(0, stat(META_ROOT "/dir/file1", &st1));
+    ASSERT_EQ(0, stat(META_ROOT "/dir/file1", &st2));
+    ASSERT_EQ(1, data.stat_calls);
+    ASSERT_EQ(st1.st_size, st2.st_size);
+
+    // Same file once normalized
+    ASSERT_EQ(0, stat("FAKE://HOST//dir///file1/"));
+    ASSERT_EQ(1, data.stat_calls);
+
+    // Existence told from the cache
+    ASSERT_EQ(0, gfal2_access(context, META_ROOT "/dir/file1", F_OK, NULL));
+    ASSERT_EQ(0, data.access_calls);
+    ASSERT_EQ(0, gfal2_access(context, META_ROOT "/dir/file1", R_OK, NULL));
+    ASSERT_EQ(1, data.access_calls);
+
+    // Failures are not kept without a negative time to live
+    ASSERT_EQ(-1, stat(META_ROOT "/dir/missing"));
+    ASSERT_EQ(-1, stat(META_ROOT "/dir/missing"));
+    ASSERT_EQ(3, data.stat_calls);
+}
+
+
+TEST_F(MetadataCacheTest, negative)
+{
+    enable(60, 60);
+
+    ASSERT_EQ(-1, stat(META_ROOT "/dir/missing"));
+    ASSERT_EQ(-1, stat(META_ROOT "/dir/missing"));
+    ASSERT_EQ(1, data.stat_calls);
+
+    ASSERT_EQ(-1, gfal2_access(context, META_ROOT "/dir/missing", F_OK, NULL));
+    ASSERT_EQ(0, data.access_calls);
+}
+
+
+TEST_F(MetadataCacheTest, expiration)
+{
+    enable(1, 0);
+
+    ASSERT_EQ(0, stat(META_ROOT "/dir/file1"));
+    ASSERT_EQ(0, stat(META_ROOT "/dir/file1"));
+    ASSERT_EQ(1, data.stat_calls);
+
+    sleep(2);
+    ASSERT_EQ(0, stat(META_ROOT "/dir/file1"));
+    ASSERT_EQ(2, data.stat_calls);
+}
+
+
+TEST_F(MetadataCacheTest, readdirpp)
+{
+    enable(60, 0);
+
+    GError* error = NULL;
+    DIR* dir = gfal2_opendir(context, META_ROOT "/dir", &error);
+    ASSERT_TRUE(dir != NULL);
+    struct stat st;
+    int entries = 0;
+    while (gfal2_readdirpp(context, dir, &st, &error) != NULL)
+        ++entries;
+    ASSERT_TRUE(error == NULL);
+    ASSERT_EQ(0, gfal2_closedir(context, dir, NULL));
+    ASSERT_EQ(3, entries);
+
+    ASSERT_EQ(0, stat(META_ROOT "/dir/file1", &st));
+    ASSERT_TRUE(S_ISREG(st.st_mode));
+    ASSERT_EQ(0, stat(META_ROOT "/dir/file2"));
+    ASSERT_EQ(0, stat(META_ROOT "/dir/sub", &st));
+    ASSERT_TRUE(S_ISDIR(st.st_mode));
+    ASSERT_EQ(0, data.stat_calls);
+}
+
+
+TEST_F(MetadataCacheTest, readdirppRefresh)
+{
+    enable(60, 0);
+
+    struct stat st;
+    ASSERT_EQ(0, stat(META_ROOT "/dir/file1", &st));
+    const off_t size = st.st_size;
+
+    // A listing after the file changed replaces the cached entry
+    data.growth = 100;
+    GError* error = NULL;
+    DIR* dir = gfal2_opendir(context, META_ROOT "/dir", &error);
+    ASSERT_TRUE(dir != NULL);
+    while (gfal2_readdirpp(context, dir, &st, &error) != NULL)
+        ;
+    ASSERT_TRUE(error == NULL);
+    ASSERT_EQ(0, gfal2_closedir(context, dir, NULL));
+
+    ASSERT_EQ(0, stat(META_ROOT "/dir/file1", &st));
+    ASSERT_EQ(size + 100, st.st_size);
+    ASSERT_EQ(1, data.stat_calls);
+}
+
+
+TEST_F(MetadataCacheTest, invalidation)
+{
+    enable(60, 60);
+
+    // unlink
+    ASSERT_EQ(0, stat(META_ROOT "/dir/file1"));
+    ASSERT_EQ(0, gfal2_unlink(context, META_ROOT "/dir/file1", NULL));
+    ASSERT_EQ(-1, stat(META_ROOT "/dir/file1"));
+    ASSERT_EQ(2, data.stat_calls);
+
+    // mkdir drops the negative entry, and the parent
+    ASSERT_EQ(0, stat(META_ROOT "/dir"));
+    ASSERT_EQ(-1, stat(META_ROOT "/dir/new"));
+    ASSERT_EQ(0, gfal2_mkdir(context, META_ROOT "/dir/new", 0755, NULL));
+    ASSERT_EQ(0, stat(META_ROOT "/dir/new"));
+    ASSERT_EQ(0, stat(META_ROOT "/dir"));
+    ASSERT_EQ(6, data.stat_calls);
+
+    // rename drops everything below the old and the new names
+    ASSERT_EQ(0, stat(META_ROOT "/dir/sub/file3"));
+    ASSERT_EQ(-1, stat(META_ROOT "/dir/moved/file3"));
+    ASSERT_EQ(8, data.stat_calls);
+    ASSERT_EQ(0, gfal2_rename(context, META_ROOT "/dir/sub", META_ROOT "/dir/moved", NULL));
+    ASSERT_EQ(-1, stat(META_ROOT "/dir/sub/file3"));
+    ASSERT_EQ(0, stat(META_ROOT "/dir/moved/file3"));
+    ASSERT_EQ(10, data.stat_calls);
+}
+
+
+TEST_F(MetadataCacheTest, mkdirParents)
+{
+    enable(60, 60);
+
+    // Every missing directory created by mkdir -p is dropped, not only the last one and its parent
+    ASSERT_EQ(-1, stat(META_ROOT "/dir/a"));
+    ASSERT_EQ(-1, stat(META_ROOT "/dir/a/b"));
+    ASSERT_EQ(-1, stat(META_ROOT "/dir/a/b/c"));
+    ASSERT_EQ(3, data.stat_calls);
+
+    ASSERT_EQ(0, gfal2_mkdir_rec(context, META_ROOT "/dir/a/b/c/d", 0755, NULL));
+    ASSERT_EQ(0, stat(META_ROOT "/dir/a"));
+    ASSERT_EQ(0, stat(META_ROOT "/dir/a/b"));
+    ASSERT_EQ(0, stat(META_ROOT "/dir/a/b/c"));
+    ASSERT_EQ(6, data.stat_calls);
+}
+
+
+TEST_F(MetadataCacheTest, closeAfterWrite)
+{
+    enable(60, 60);
+    GError* error = NULL;
+
+    int fd = gfal2_open(context, META_ROOT "/dir/file1", O_WRONLY, &error);
+    ASSERT_GT(fd, 0);
+
+    // Taken while the file is being written
+    ASSERT_EQ(0, stat(META_ROOT "/dir/file1"));
+    ASSERT_EQ(0, stat(META_ROOT "/dir/file1"));
+    ASSERT_EQ(1, data.stat_calls);
+
+    ASSERT_EQ(0, gfal2_close(context, fd, &error));
+    ASSERT_EQ(0, stat(META_ROOT "/dir/file1"));
+    ASSERT_EQ(2, data.stat_calls);
+
+    // Closing a file opened for reading keeps the cache
+    fd = gfal2_open(context, META_ROOT "/dir/file1", O_RDONLY, &error);
+    ASSERT_GT(fd, 0);
+    ASSERT_EQ(0, gfal2_close(context, fd, &error));
+    ASSERT_EQ(0, stat(META_ROOT "/dir/file1"));
+    ASSERT_EQ(2, data.stat_calls);
+}
@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <unit/fake_plugin.h>
+
+// Metrics of the operations dispatched to a plugin
+
+
+static int metrics_plugin_stat(plugin_handle plugin_data, const char* url, struct stat* buf, GError** err)
+{
+    if (strstr(url, "missing") != NULL) {
+        gfal2_set_error(err, g_quark_from_static_string("metrics"), ENOENT, __func__, "No such file %s", url);
+        return -1;
+    }
+    memset(buf, 0, sizeof(*buf));
+    buf->st_mode = S_IFREG | 0644;
+    return 0;
+}
+
+
+static gfal_file_handle metrics_plugin_open(plugin_handle plugin_data, const char* url, int flag, mode_t mode,
+    GError** err)
+{
+    return gfal_file_handle_new2(fake_plugin_name(), NULL, NULL, url);
+}
+
+
+static ssize_t metrics_plugin_read(plugin_handle plugin_data, gfal_file_handle fd, void* buff, size_t count,
+    GError** err)
+{
+    memset(buff, 'x', count);
+    return count;
+}
+
+
+static int metrics_plugin_close(plugin_handle plugin_data, gfal_file_handle fd, GError** err)
+{
+    gfal_file_handle_delete(fd);
+    return 0;
+}
+
+
+class MetricsTest: public FakePluginTest {
+protected:
+    void SetUp() {
+        ASSERT_NO_FATAL_FAILURE(FakePluginTest::SetUp());
+        plugin.statG = metrics_plugin_stat;
+        plugin.openG = metrics_plugin_open;
+        plugin.readG = metrics_plugin_read;
+        plugin.closeG = metrics_plugin_close;
+        registerFakePlugin(NULL);
+    }
+
+    // Metric of the operation on the fake plugin, NULL if never called
+    const gfal2_metric_t* find(const gfal2_metric_t* metrics, size_t n_metrics, const char* operation) {
+        for (size_t i = 0; i < n_metrics; ++i) {
+            if (strcmp(metrics[i].plugin, fake_plugin_name()) == 0 &&
+                strcmp(metrics[i].operation, operation) == 0)
+                return &metrics[i];
+        }
+        return NULL;
+    }
+};
+
+
+TEST(MetricsBucketsTest, bounds)
+{
+    ASSERT_EQ(1u, gfal2_metrics_bucket_bound(0));
+    ASSERT_EQ(4u, gfal2_metrics_bucket_bound(3));
+    ASSERT_EQ(5u, gfal2_metrics_bucket_bound(4));
+    ASSERT_EQ(8u, gfal2_metrics_bucket_bound(7));
+    ASSERT_EQ(10u, gfal2_metrics_bucket_bound(8));
+    ASSERT_EQ(G_MAXUINT64, gfal2_metrics_bucket_bound(GFAL2_METRICS_BUCKETS - 1));
+
+    for (int i = 1; i < GFAL2_METRICS_BUCKETS; ++i) {
+        ASSERT_LT(gfal2_metrics_bucket_bound(i - 1), gfal2_metrics_bucket_bound(i));
+    }
+}
+
+
+TEST_F(MetricsTest, counters)
+{
+    GError* error = NULL;
+    size_t n_metrics = 0;
+    struct stat st;
+
+    gfal2_metric_t* metrics = gfal2_get_metrics(context, &n_metrics, &error);
+    ASSERT_TRUE(metrics != NULL);
+    ASSERT_TRUE(find(metrics, n_metrics, "stat") == NULL);
+    g_free(metrics);
+
+    ASSERT_EQ(0, gfal2_stat(context, "fake://host/file", &st, NULL));
+    ASSERT_EQ(0, gfal2_stat(context, "fake://host/file", &st, NULL));
+    ASSERT_EQ(-1, gfal2_stat(context, "fake://host/missing", &st, &error));
+    g_clear_error(&error);
+
+    char buffer[128];
+    int fd = gfal2_open(context, "fake://host/file", O_RDONLY, &error);
+    ASSERT_GT(fd, 0);
+    ASSERT_EQ(100, gfal2_read(context, fd, buffer, 100, &error));
+    ASSERT_EQ(28, gfal2_read(context, fd, buffer, 28, &error));
+    ASSERT_EQ(0, gfal2_close(context, fd, &error));
+
+    metrics = gfal2_get_metrics(context, &n_metrics, &error);
+    ASSERT_TRUE(metrics != NULL);
+
+    const gfal2_metric_t* stat_metric = find(metrics, n_metrics, "stat");
+    ASSERT_TRUE(stat_metric != NULL);
+    ASSERT_EQ(3u, stat_metric->count);
+    ASSERT_EQ(1u, stat_metric->errors);
+    ASSERT_EQ(0u, stat_metric->bytes);
+
+    guint64 in_buckets = 0;
+    for (int i = 0; i < GFAL2_METRICS_BUCKETS; ++i)
+        in_buckets += stat_metric->latency_buckets[i];
+    ASSERT_EQ(3u, in_buckets);
+
+    const gfal2_metric_t* read_metric = find(metrics, n_metrics, "read");
+    ASSERT_TRUE(read_metric != NULL);
+    ASSERT_EQ(2u, read_metric->count);
+    ASSERT_EQ(0u, read_metric->errors);
+    ASSERT_EQ(128u, read_metric->bytes);
+
+    ASSERT_EQ(1u, find(metrics, n_metrics, "open")->count);
+    ASSERT_EQ(1u, find(metrics, n_metrics, "close")->count);
+    ASSERT_TRUE(find(metrics, n_metrics, "write") == NULL);
+    g_free(metrics);
+}
+
+
+TEST_F(MetricsTest, prometheus)
+{
+    GError* error = NULL;
+    struct stat st;
+
+    ASSERT_EQ(0, gfal2_stat(context, "fake://host/file", &st, NULL));
+    ASSERT_EQ(-1, gfal2_stat(context, "fake://host/missing", &st, &error));
+    g_clear_error(&error);
+
+    char* text = gfal2_get_metrics_prometheus(context, &error);
+    ASSERT_TRUE(text != NULL);
+    std::string out(text);
+    g_free(text);
+
+    ASSERT_NE(std::string::npos, out.find("# TYPE gfal2_plugin_operations_total counter\n"));
+    ASSERT_NE(std::string::npos,
+        out.find("gfal2_plugin_operations_total{plugin=\"FAKE-PLUGIN\",operation=\"stat\"} 2\n"));
+    ASSERT_NE(std::string::npos,
+        out.find("gfal2_plugin_operation_errors_total{plugin=\"FAKE-PLUGIN\",operation=\"stat\"} 1\n"));
+    ASSERT_NE(std::string::npos, out.find("# TYPE gfal2_plugin_operation_duration_seconds histogram\n"));
+    ASSERT_NE(std::string::npos,
+        out.find("gfal2_plugin_operation_duration_seconds_bucket{plugin=\"FAKE-PLUGIN\",operation=\"stat\",le=\"+Inf\"} 2\n"));
+    ASSERT_NE(std::string::npos,
+        out.find("gfal2_plugin_operation_duration_seconds_count{plugin=\"FAKE-PLUGIN\",operation=\"stat\"} 2\n"));
+
+    // Buckets hold latencies below their bound, the inclusive le is one microsecond less
+    ASSERT_NE(std::string::npos,
+        out.find("gfal2_plugin_operation_duration_seconds_bucket{plugin=\"FAKE-PLUGIN\",operation=\"stat\",le=\"0\"} "));
+    ASSERT_NE(std::string::npos,
+        out.find("gfal2_plugin_operation_duration_seconds_bucket{plugin=\"FAKE-PLUGIN\",operation=\"stat\",le=\"7e-06\"} "));
+    ASSERT_EQ(std::string::npos, out.find("le=\"8e-06\""));
+}
@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <unit/fake_plugin.h>
+
+// gfal2_preadv over in-memory plugins, with and without native support
+
+
+#define FILE_SIZE (1024 * 1024 + 17)
+
+static GQuark domain = g_quark_from_static_string("TEST");
+
+struct memory_plugin_data {
+    std::vector<char> content;
+    // fail the reads at or after this offset, -1 never
+    ssize_t fail_at;
+    // number of calls to preadvG
+    int preadv_calls;
+};
+
+struct memory_file {
+    off_t offset;
+};
+
+
+static gfal_file_handle memory_plugin_open(plugin_handle plugin_data, const char* url,
+    int flag, mode_t mode, GError** err)
+{
+    return gfal_file_handle_new(fake_plugin_name(), new memory_file());
+}
+
+
+static int memory_plugin_close(plugin_handle plugin_data, gfal_file_handle fd, GError** err)
+{
+    delete (memory_file*)gfal_file_handle_get_fdesc(fd);
+    gfal_file_handle_delete(fd);
+    return 0;
+}
+
+
+static ssize_t memory_plugin_pread(plugin_handle plugin_data, gfal_file_handle fd,
+    void* buff, size_t count, off_t offset, GError** err)
+{
+    memory_plugin_data* data = (memory_plugin_data*)plugin_data;
+
+    if (data->fail_at >= 0 && offset + (off_t)count > data->fail_at) {
+        gfal2_set_error(err, domain, EIO, __func__, "Read failure");
+        return -1;
+    }
+    if ((size_t)offset >= data->content.size()) {
+        return 0;
+    }
+
+    // Short reads, the core must loop
+    size_t size = std::min(count, std::min(data->content.size() - offset, (size_t)1000));
+    memcpy(buff, data->content.data() + offset, size);
+    return size;
+}
+
+
+static ssize_t memory_plugin_read(plugin_handle plugin_data, gfal_file_handle fd,
+    void* buff, size_t count, GError** err)
+{
+    memory_file* file = (memory_file*)gfal_file_handle_get_fdesc(fd);
+    ssize_t ret = memory_plugin_pread(plugin_data, fd, buff, count, file->offset, err);
+    if (ret > 0) {
+        file->offset += ret;
+    }
+    return ret;
+}
+
+
+static off_t memory_plugin_lseek(plugin_handle plugin_data, gfal_file_handle fd,
+    off_t offset, int whence, GError** err)
+{
+    memory_file* file = (memory_file*)gfal_file_handle_get_fdesc(fd);
+    file->offset = offset;
+    return offset;
+}
+
+
+static ssize_t memory_plugin_preadv(plugin_handle plugin_data, gfal_file_handle fd,
+    const struct iovec* iov, const off_t* offsets, int count, GError** err)
+{
+    memory_plugin_data* data = (memory_plugin_data*)plugin_data;
+    data->preadv_calls++;
+
+    ssize_t total = 0;
+    for (int i = 0; i < count; ++i) {
+        if ((size_t)offsets[i] >= data->content.size()) {
+            continue;
+        }
+        size_t size = std::min(iov[i].iov_len, data->content.size() - offsets[i]);
+        memcpy(iov[i].iov_base, data->content.data() + offsets[i], size);
+        total += size;
+    }
+    return total;
+}
+
+
+class PreadvTest: public FakePluginTest {
+protected:
+    memory_plugin_data data;
+
+    void SetUp() {
+        data.content.resize(FILE_SIZE);
+        for (size_t i = 0; i < data.content.size(); ++i) {
+            data.content[i] = (char)(rand() % 256);
+        }
+        data.fail_at = -1;
+        data.preadv_calls = 0;
+
+        ASSERT_NO_FATAL_FAILURE(FakePluginTest::SetUp());
+    }
+
+    void registerPlugin(bool with_pread, bool with_preadv) {
+        plugin.openG = memory_plugin_open;
+        plugin.closeG = memory_plugin_close;
+        plugin.readG = memory_plugin_read;
+        plugin.lseekG = memory_plugin_lseek;
+        if (with_pread) {
+            plugin.preadG = memory_plugin_pread;
+        }
+        if (with_preadv) {
+            plugin.preadvG = memory_plugin_preadv;
+        }
+        registerFakePlugin(&data);
+    }
+
+    // Read scattered ranges, some of them going past the end of the file, and check the content
+    void checkRanges(int count) {
+        GError* error = NULL;
+        int fd = gfal2_open(context, "fake://file", O_RDONLY, &error);
+        ASSERT_GT(fd, 0);
+
+        std::vector<std::vector<char> > buffers(count);
+        std::vector<struct iovec> iov(count);
+        std::vector<off_t> offsets(count);
+        ssize_t expected = 0;
+        for (int i = 0; i < count; ++i) {
+            buffers[i].resize(1 + rand() % 5000);
+            iov[i].iov_base = buffers[i].data();
+            iov[i].iov_len = buffers[i].size();
+            offsets[i] = rand() % (FILE_SIZE + 100);
+            if ((size_t)offsets[i] < data.content.size()) {
+                expected += std::min(buffers[i].size(), data.content.size() - offsets[i]);
+            }
+        }
+
+        ASSERT_EQ(expected, gfal2_preadv(context, fd, iov.data(), offsets.data(), count, &error));
+        for (int i = 0; i < count; ++i) {
+            if ((size_t)offsets[i] >= data.content.size()) {
+                continue;
+            }
+            size_t size = std::min(buffers[i].size(), data.content.size() - offsets[i]);
+            ASSERT_EQ(0, memcmp(buffers[i].data(), data.content.data() + offsets[i], size)) << i;
+        }
+
+        ASSERT_EQ(0, gfal2_close(context, fd, &error));
+    }
+};
+
+
+TEST_F(PreadvTest, concurrentFallback)
+{
+    registerPlugin(true, false);
+    gfal2_set_opt_integer(context, "CORE", "PREADV_THREADS", 4, NULL);
+    checkRanges(500);
+    checkRanges(1);
+}
+
+
+TEST_F(PreadvTest, serialFallback)
+{
+    registerPlugin(true, false);
+    gfal2_set_opt_integer(context, "CORE", "PREADV_THREADS", 1, NULL);
+    checkRanges(100);
+}
+
+
+TEST_F(PreadvTest, seekFallback)
+{
+    registerPlugin(false, false);
+    checkRanges(100);
+}
+
+
+TEST_F(PreadvTest, native)
+{
+    registerPlugin(true, true);
+    checkRanges(500);
+    ASSERT_EQ(1, data.preadv_calls);
+}
+
+
+TEST_F(PreadvTest, empty)
+{
+    registerPlugin(true, false);
+
+    GError* error = NULL;
+    int fd = gfal2_open(context, "fake://file", O_RDONLY, &error);
+    ASSERT_GT(fd, 0);
+    ASSERT_EQ(0, gfal2_preadv(context, fd, NULL, NULL, 0, &error));
+    ASSERT_EQ(0, gfal2_close(context, fd, &error));
+}
+
+
+TEST_F(PreadvTest, readError)
+{
+    registerPlugin(true, false);
+    data.fail_at = FILE_SIZE / 2;
+
+    GError* error = NULL;
+    int fd = gfal2_open(context, "fake://file", O_RDONLY, &error);
+    ASSERT_GT(fd, 0);
+
+    std::vector<char> buffer(1000 * 100);
+    std::vector<struct iovec> iov(100);
+    std::vector<off_t> offsets(100);
+    for (int i = 0; i < 100; ++i) {
+        iov[i].iov_base = buffer.data() + i * 1000;
+        iov[i].iov_len = 1000;
+        offsets[i] = i * 10000;
+    }
+    ASSERT_EQ(-1, gfal2_preadv(context, fd, iov.data(), offsets.data(), 100, &error));
+    ASSERT_TRUE(error != NULL);
+    ASSERT_EQ(EIO, error->code);
+    g_clear_error(&error);
+
+    ASSERT_EQ(0, gfal2_close(context, fd, &error));
+}
+
+
+TEST_F(PreadvTest, badDescriptor)
+{
+    GError* error = NULL;
+    struct iovec iov = {NULL, 0};
+    off_t offset = 0;
+    ASSERT_EQ(-1, gfal2_preadv(context, 12345, &iov, &offset, 1, &error));
+    ASSERT_TRUE(error != NULL);
+    g_clear_error(&error);
+}
@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unit/fake_plugin.h>
+
+// Bulk stat, natively or with the concurrent fallback
+
+
+struct list_plugin_data {
+    volatile gint stat_calls;
+    volatile gint stat_list_calls;
+};
+
+
+// Files named "missing..." do not exist, the others have the length of their url as size
+static int list_plugin_stat(plugin_handle plugin_data, const char* url, struct stat* buf, GError** err)
+{
+    list_plugin_data* data = (list_plugin_data*)plugin_data;
+    g_atomic_int_inc(&data->stat_calls);
+
+    if (strstr(url, "/missing")) {
+        gfal2_set_error(err, g_quark_from_static_string("list"), ENOENT, __func__, "No such file %s", url);
+        return -1;
+    }
+    memset(buf, 0, sizeof(*buf));
+    buf->st_size = strlen(url);
+    return 0;
+}
+
+
+static int list_plugin_stat_list(plugin_handle plugin_data, int nbfiles, const char* const* urls,
+    struct stat* buffs, GError** errors)
+{
+    list_plugin_data* data = (list_plugin_data*)plugin_data;
+    g_atomic_int_inc(&data->stat_list_calls);
+
+    int ret = 0;
+    for (int i = 0; i < nbfiles; ++i) {
+        if (list_plugin_stat(plugin_data, urls[i], &buffs[i], &errors[i]) < 0) {
+            ret = -1;
+        }
+    }
+    return ret;
+}
+
+
+// The whole call fails, without filling the results
+static int list_plugin_stat_list_unavailable(plugin_handle plugin_data, int nbfiles, const char* const* urls,
+    struct stat* buffs, GError** errors)
+{
+    list_plugin_data* data = (list_plugin_data*)plugin_data;
+    g_atomic_int_inc(&data->stat_list_calls);
+    return -1;
+}
+
+
+class StatListTest: public FakePluginTest {
+protected:
+    list_plugin_data data;
+
+    std::vector<std::string> urls;
+    std::vector<const char*> url_ptrs;
+
+    void SetUp() {
+        memset(&data, 0, sizeof(data));
+
+        ASSERT_NO_FATAL_FAILURE(FakePluginTest::SetUp());
+        plugin.statG = list_plugin_stat;
+    }
+
+    // Every tenth file is missing
+    void makeUrls(int n) {
+        for (int i = 0; i < n; ++i) {
+            if (i % 10 == 9)
+                urls.push_back("fake://host/missing" + std::to_string(i));
+            else
+                urls.push_back("fake://host/file" + std::to_string(i));
+        }
+        for (size_t i = 0; i < urls.size(); ++i) {
+            url_ptrs.push_back(urls[i].c_str());
+        }
+    }
+
+    void checkResults(const std::vector<struct stat>& buffs, std::vector<GError*>& errors) {
+        for (size_t i = 0; i < urls.size(); ++i) {
+            if (i % 10 == 9) {
+                ASSERT_TRUE(errors[i] != NULL);
+                ASSERT_EQ(ENOENT, errors[i]->code);
+                g_clear_error(&errors[i]);
+            }
+            else {
+                ASSERT_TRUE(errors[i] == NULL) << errors[i]->message;
+                ASSERT_EQ(urls[i].size(), (size_t)buffs[i].st_size);
+            }
+        }
+    }
+};
+
+
+TEST_F(StatListTest, fallback)
+{
+    registerFakePlugin(&data);
+    gfal2_set_opt_integer(context, "CORE", "STAT_LIST_THREADS", 4, NULL);
+    makeUrls(100);
+
+    std::vector<struct stat> buffs(urls.size());
+    std::vector<GError*> errors(urls.size(), NULL);
+    ASSERT_EQ(-1, gfal2_stat_list(context, urls.size(), url_ptrs.data(), buffs.data(), errors.data()));
+    checkResults(buffs, errors);
+    ASSERT_EQ(100, data.stat_calls);
+}
+
+
+TEST_F(StatListTest, fallbackAllFound)
+{
+    registerFakePlugin(&data);
+    makeUrls(5);
+
+    std::vector<struct stat> buffs(urls.size());
+    std::vector<GError*> errors(urls.size(), NULL);
+    ASSERT_EQ(0, gfal2_stat_list(context, urls.size(), url_ptrs.data(), buffs.data(), errors.data()));
+    checkResults(buffs, errors);
+}
+
+
+TEST_F(StatListTest, native)
+{
+    plugin.stat_listG = list_plugin_stat_list;
+    registerFakePlugin(&data);
+    makeUrls(100);
+
+    std::vector<struct stat> buffs(urls.size());
+    std::vector<GError*> errors(urls.size(), NULL);
+    ASSERT_EQ(-1, gfal2_stat_list(context, urls.size(), url_ptrs.data(), buffs.data(), errors.data()));
+    checkResults(buffs, errors);
+    ASSERT_EQ(1, data.stat_list_calls);
+}
+
+
+TEST_F(StatListTest, unknownPlugin)
+{
+    registerFakePlugin(&data);
+    const char* unknown[] = {"unknown://host/file1", "unknown://host/file2"};
+    struct stat buffs[2];
+    GError* errors[2] = {NULL, NULL};
+
+    ASSERT_EQ(-1, gfal2_stat_list(context, 2, unknown, buffs, errors));
+    ASSERT_TRUE(errors[0] != NULL);
+    ASSERT_TRUE(errors[1] != NULL);
+    g_clear_error(&errors[0]);
+    g_clear_error(&errors[1]);
+}
+
+
+TEST_F(StatListTest, nativeCached)
+{
+    plugin.stat_listG = list_plugin_stat_list;
+    registerFakePlugin(&data);
+    gfal2_set_opt_integer(context, "CORE", "METADATA_CACHE_TTL", 60, NULL);
+    makeUrls(5);
+
+    std::vector<struct stat> buffs(urls.size());
+    std::vector<GError*> errors(urls.size(), NULL);
+    ASSERT_EQ(0, gfal2_stat_list(context, urls.size(), url_ptrs.data(), buffs.data(), errors.data()));
+
+    struct stat st;
+    for (size_t i = 0; i < urls.size(); ++i) {
+        ASSERT_EQ(0, gfal2_stat(context, url_ptrs[i], &st, NULL));
+        ASSERT_EQ(urls[i].size(), (size_t)st.st_size);
+    }
+    ASSERT_EQ(5, data.stat_calls);
+}
+
+
+TEST_F(StatListTest, nativeFailureNotCached)
+{
+    plugin.stat_listG = list_plugin_stat_list_unavailable;
+    registerFakePlugin(&data);
+    gfal2_set_opt_integer(context, "CORE", "METADATA_CACHE_TTL", 60, NULL);
+    makeUrls(5);
+
+    std::vector<struct stat> buffs(urls.size());
+    std::vector<GError*> errors(urls.size(), NULL);
+    ASSERT_EQ(-1, gfal2_stat_list(context, urls.size(), url_ptrs.data(), buffs.data(), errors.data()));
+
+    // The results left unfilled are not served from the cache
+    struct stat st;
+    for (size_t i = 0; i < urls.size(); ++i) {
+        ASSERT_EQ(0, gfal2_stat(context, url_ptrs[i], &st, NULL));
+        ASSERT_EQ(urls[i].size(), (size_t)st.st_size);
+    }
+    ASSERT_EQ(5, data.stat_calls);
+}
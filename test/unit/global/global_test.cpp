@@ -22,6 +22,8 @@
 #include <gfal_plugins_api.h>
 #include <utils/uri/gfal2_uri.h>
 #include <gtest/gtest.h>
+#include <string>
+#include <unistd.h>
 
 
 TEST(gfalGlobal, testVerbose)
@@ -100,3 +102,132 @@ TEST(gfalGlobal, registerPlugin)
 
     gfal2_context_free(c);
 }
+
+
+static int scheme_plugin_checks = 0;
+
+
+static const char *scheme_plugin_get_name(void)
+{
+    return "SCHEME PLUGIN";
+}
+
+
+static gboolean scheme_plugin_url(plugin_handle plugin_data, const char *url,
+    plugin_mode operation, GError **err)
+{
+    ++scheme_plugin_checks;
+    return operation == GFAL_PLUGIN_STAT;
+}
+
+
+static int scheme_plugin_stat(plugin_handle plugin_data, const char *url, struct stat *buf, GError **err)
+{
+    buf->st_mode = 54321;
+    return 0;
+}
+
+
+TEST(gfalGlobal, schemeDispatch)
+{
+    static const char* const schemes[] = {"scheme", "scheme+3rd", NULL};
+
+    GError *tmp_err = NULL;
+    gfal2_context_t c = gfal2_context_new(&tmp_err);
+    ASSERT_NE((void *) NULL, c);
+
+    gfal_plugin_interface scheme_plugin;
+    memset(&scheme_plugin, 0, sizeof(scheme_plugin));
+
+    scheme_plugin.getName = scheme_plugin_get_name;
+    scheme_plugin.check_plugin_url = scheme_plugin_url;
+    scheme_plugin.statG = scheme_plugin_stat;
+    scheme_plugin.url_schemes = schemes;
+
+    int ret = gfal2_register_plugin(c, &scheme_plugin, &tmp_err);
+    ASSERT_EQ(0, ret);
+
+    struct stat st;
+    ret = gfal2_stat(c, "scheme://host/path", &st, &tmp_err);
+    ASSERT_EQ(0, ret);
+    ASSERT_EQ(54321, st.st_mode);
+
+    ret = gfal2_stat(c, "SCHEME+3rd://host/path", &st, &tmp_err);
+    ASSERT_EQ(0, ret);
+    ASSERT_EQ(54321, st.st_mode);
+    ASSERT_EQ(2, scheme_plugin_checks);
+
+    // The checker accepts anything, but must not be consulted for other schemes
+    ret = gfal2_stat(c, "other://host/path", &st, &tmp_err);
+    ASSERT_NE(0, ret);
+    ASSERT_EQ(EPROTONOSUPPORT, tmp_err->code);
+    g_clear_error(&tmp_err);
+
+    ret = gfal2_stat(c, "not a url", &st, &tmp_err);
+    ASSERT_NE(0, ret);
+    g_clear_error(&tmp_err);
+    ASSERT_EQ(2, scheme_plugin_checks);
+
+    gfal2_context_free(c);
+}
+
+
+static bool strv_contains(gchar **strv, const char *value)
+{
+    for (int i = 0; strv[i] != NULL; ++i) {
+        if (strcmp(strv[i], value) == 0)
+            return true;
+    }
+    return false;
+}
+
+
+TEST(gfalGlobal, manifestPlugins)
+{
+    char plugin_dir[] = "/tmp/gfal2_manifest_XXXXXX";
+    ASSERT_NE((char*) NULL, mkdtemp(plugin_dir));
+
+    // The library is not even valid, it must only be opened on demand
+    std::string library = std::string(plugin_dir) + "/libgfal_plugin_fake.so";
+    std::string manifest = library + ".manifest";
+    ASSERT_TRUE(g_file_set_contents(library.c_str(), "not a library", -1, NULL));
+    ASSERT_TRUE(g_file_set_contents(manifest.c_str(),
+        "[PLUGIN]\nNAME=FAKE PLUGIN\nSCHEMES=fake;FAKES\nPRIORITY=0\nCAPABILITIES=namespace\n", -1, NULL));
+
+    const char *previous_dir = g_getenv("GFAL_PLUGIN_DIR");
+    std::string saved_dir = previous_dir ? previous_dir : "";
+    setenv("GFAL_PLUGIN_DIR", plugin_dir, 1);
+
+    GError *tmp_err = NULL;
+    gfal2_context_t c = gfal2_context_new(&tmp_err);
+    ASSERT_NE((void *) NULL, c);
+
+    gchar **loaded = gfal2_get_plugin_names(c);
+    EXPECT_FALSE(strv_contains(loaded, "FAKE PLUGIN"));
+    g_strfreev(loaded);
+
+    gchar **available = gfal2_get_available_plugin_names(c);
+    EXPECT_TRUE(strv_contains(available, "FAKE PLUGIN"));
+    g_strfreev(available);
+
+    // Opening the library fails, so the scheme is not supported, and it is not tried again
+    struct stat st;
+    int ret = gfal2_stat(c, "FAKES://host/path", &st, &tmp_err);
+    ASSERT_NE(0, ret);
+    ASSERT_EQ(EPROTONOSUPPORT, tmp_err->code);
+    g_clear_error(&tmp_err);
+
+    available = gfal2_get_available_plugin_names(c);
+    EXPECT_FALSE(strv_contains(available, "FAKE PLUGIN"));
+    g_strfreev(available);
+
+    gfal2_context_free(c);
+
+    if (previous_dir)
+        setenv("GFAL_PLUGIN_DIR", saved_dir.c_str(), 1);
+    else
+        unsetenv("GFAL_PLUGIN_DIR");
+    unlink(manifest.c_str());
+    unlink(library.c_str());
+    rmdir(plugin_dir);
+}
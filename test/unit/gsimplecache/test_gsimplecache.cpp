@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <pthread.h>
+#include <unistd.h>
+#include <utils/gsimplecache/gcachemain.h>
+
+
+static void copy_int(gpointer original, gpointer copy)
+{
+    *(int*)copy = *(int*)original;
+}
+
+
+TEST(GSimpleCache, refCount)
+{
+    GSimpleCache* cache = gsimplecache_new(10, copy_int, sizeof(int));
+    int value = 42, result = 0;
+
+    // An added item can be taken twice
+    gsimplecache_add_item_kstr(cache, "key", &value);
+    ASSERT_EQ(0, gsimplecache_take_one_kstr(cache, "key", &result));
+    ASSERT_EQ(42, result);
+    ASSERT_EQ(0, gsimplecache_take_one_kstr(cache, "key", &result));
+    ASSERT_EQ(-1, gsimplecache_take_one_kstr(cache, "key", &result));
+
+    gsimplecache_add_item_kstr(cache, "key", &value);
+    ASSERT_TRUE(gsimplecache_remove_kstr(cache, "key"));
+    ASSERT_FALSE(gsimplecache_remove_kstr(cache, "key"));
+    ASSERT_EQ(-1, gsimplecache_take_one_kstr(cache, "key", &result));
+
+    gsimplecache_delete(cache);
+}
+
+
+TEST(GSimpleCache, leastRecentlyUsed)
+{
+    GSimpleCache* cache = gsimplecache_new(3, copy_int, sizeof(int));
+    int a = 1, b = 2, c = 3, d = 4, result = 0;
+
+    gsimplecache_add_item_kstr(cache, "a", &a);
+    gsimplecache_add_item_kstr(cache, "b", &b);
+    gsimplecache_add_item_kstr(cache, "c", &c);
+
+    // "a" becomes the most recently used, so "b" goes away
+    ASSERT_EQ(0, gsimplecache_take_one_kstr(cache, "a", &result));
+    gsimplecache_add_item_kstr(cache, "d", &d);
+
+    ASSERT_EQ(-1, gsimplecache_take_one_kstr(cache, "b", &result));
+    ASSERT_EQ(0, gsimplecache_take_one_kstr(cache, "a", &result));
+    ASSERT_EQ(1, result);
+    ASSERT_EQ(0, gsimplecache_take_one_kstr(cache, "c", &result));
+    ASSERT_EQ(3, result);
+    ASSERT_EQ(0, gsimplecache_take_one_kstr(cache, "d", &result));
+    ASSERT_EQ(4, result);
+
+    GSimpleCacheStats stats;
+    gsimplecache_get_stats(cache, &stats);
+    ASSERT_EQ(4u, stats.hits);
+    ASSERT_EQ(1u, stats.misses);
+    ASSERT_EQ(1u, stats.evictions);
+    ASSERT_EQ(0u, stats.expirations);
+    // "a" has been taken twice
+    ASSERT_EQ(2u, stats.size);
+
+    gsimplecache_delete(cache);
+}
+
+
+TEST(GSimpleCache, timeToLive)
+{
+    GSimpleCache* cache = gsimplecache_new(10, copy_int, sizeof(int));
+    int value = 42, result = 0;
+
+    gsimplecache_set_ttl(cache, 1);
+    gsimplecache_add_item_kstr(cache, "default", &value);
+    gsimplecache_add_item_kstr_ttl(cache, "forever", &value, 0);
+    gsimplecache_add_item_kstr_ttl(cache, "long", &value, 60);
+
+    usleep(1100000);
+
+    ASSERT_EQ(-1, gsimplecache_take_one_kstr(cache, "default", &result));
+    ASSERT_EQ(0, gsimplecache_take_one_kstr(cache, "forever", &result));
+    ASSERT_EQ(0, gsimplecache_take_one_kstr(cache, "long", &result));
+
+    GSimpleCacheStats stats;
+    gsimplecache_get_stats(cache, &stats);
+    ASSERT_EQ(1u, stats.expirations);
+    ASSERT_EQ(1u, stats.misses);
+
+    gsimplecache_delete(cache);
+}
+
+
+TEST(GSimpleCache, boundedSize)
+{
+    const int max_items = 5000;
+    GSimpleCache* cache = gsimplecache_new(max_items, copy_int, sizeof(int));
+    char key[64];
+
+    for (int i = 0; i < max_items * 3; ++i) {
+        snprintf(key, sizeof(key), "/path/to/file/%d", i);
+        gsimplecache_add_item_kstr(cache, key, &i);
+    }
+
+    GSimpleCacheStats stats;
+    gsimplecache_get_stats(cache, &stats);
+    ASSERT_EQ((guint64)max_items, stats.size);
+    ASSERT_EQ((guint64)max_items * 2, stats.evictions);
+
+    // The most recent entries survive
+    int result = -1;
+    snprintf(key, sizeof(key), "/path/to/file/%d", max_items * 3 - 1);
+    ASSERT_EQ(0, gsimplecache_take_one_kstr(cache, key, &result));
+    ASSERT_EQ(max_items * 3 - 1, result);
+
+    gsimplecache_delete(cache);
+}
+
+
+TEST(GSimpleCache, getKeepsItem)
+{
+    GSimpleCache* cache = gsimplecache_new(10, copy_int, sizeof(int));
+    int value = 42, result = 0;
+
+    gsimplecache_add_item_kstr(cache, "key", &value);
+    for (int i = 0; i < 5; ++i) {
+        result = 0;
+        ASSERT_EQ(0, gsimplecache_get_kstr(cache, "key", &result));
+        ASSERT_EQ(42, result);
+    }
+    ASSERT_EQ(-1, gsimplecache_get_kstr(cache, "other", &result));
+
+    gsimplecache_delete(cache);
+}
+
+
+TEST(GSimpleCache, replace)
+{
+    GSimpleCache* cache = gsimplecache_new(10, copy_int, sizeof(int));
+    int value = 42, result = 0;
+
+    // Adding again keeps the first value, replacing stores the new one
+    gsimplecache_add_item_kstr_ttl(cache, "key", &value, 60);
+    value = 43;
+    gsimplecache_add_item_kstr_ttl(cache, "key", &value, 60);
+    ASSERT_EQ(0, gsimplecache_get_kstr(cache, "key", &result));
+    ASSERT_EQ(42, result);
+
+    gsimplecache_replace_item_kstr_ttl(cache, "key", &value, 60);
+    ASSERT_EQ(0, gsimplecache_get_kstr(cache, "key", &result));
+    ASSERT_EQ(43, result);
+
+    value = 44;
+    gsimplecache_replace_item_kstr_ttl(cache, "other", &value, 60);
+    ASSERT_EQ(0, gsimplecache_get_kstr(cache, "other", &result));
+    ASSERT_EQ(44, result);
+
+    gsimplecache_delete(cache);
+}
+
+
+TEST(GSimpleCache, removePrefix)
+{
+    // Big enough to be sharded
+    GSimpleCache* cache = gsimplecache_new(5000, copy_int, sizeof(int));
+    char key[64];
+    int result;
+
+    for (int i = 0; i < 100; ++i) {
+        snprintf(key, sizeof(key), "/dir/%d", i);
+        gsimplecache_add_item_kstr(cache, key, &i);
+        snprintf(key, sizeof(key), "/dir2/%d", i);
+        gsimplecache_add_item_kstr(cache, key, &i);
+    }
+
+    ASSERT_EQ(100u, gsimplecache_remove_prefix_kstr(cache, "/dir/"));
+    ASSERT_EQ(0u, gsimplecache_remove_prefix_kstr(cache, "/dir/"));
+    ASSERT_EQ(-1, gsimplecache_get_kstr(cache, "/dir/10", &result));
+    ASSERT_EQ(0, gsimplecache_get_kstr(cache, "/dir2/10", &result));
+
+    GSimpleCacheStats stats;
+    gsimplecache_get_stats(cache, &stats);
+    ASSERT_EQ(100u, stats.size);
+
+    gsimplecache_delete(cache);
+}
+
+
+struct worker_data {
+    GSimpleCache* cache;
+    int id;
+};
+
+
+static void* cache_worker(void* data)
+{
+    worker_data* worker = (worker_data*)data;
+    char key[64];
+    int result;
+
+    for (int i = 0; i < 20000; ++i) {
+        snprintf(key, sizeof(key), "/path/%d", (i * 7 + worker->id) % 3000);
+        if (i % 3 == 0) {
+            gsimplecache_add_item_kstr(worker->cache, key, &i);
+        }
+        else if (i % 17 == 0) {
+            gsimplecache_remove_kstr(worker->cache, key);
+        }
+        else {
+            gsimplecache_take_one_kstr(worker->cache, key, &result);
+        }
+    }
+    return NULL;
+}
+
+
+TEST(GSimpleCache, concurrent)
+{
+    const int n_threads = 8;
+    GSimpleCache* cache = gsimplecache_new(2000, copy_int, sizeof(int));
+    pthread_t threads[n_threads];
+    worker_data workers[n_threads];
+
+    for (int i = 0; i < n_threads; ++i) {
+        workers[i].cache = cache;
+        workers[i].id = i;
+        pthread_create(&threads[i], NULL, cache_worker, &workers[i]);
+    }
+    for (int i = 0; i < n_threads; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+
+    GSimpleCacheStats stats;
+    gsimplecache_get_stats(cache, &stats);
+    ASSERT_LE(stats.size, 2000u);
+    ASSERT_GT(stats.hits, 0u);
+
+    gsimplecache_delete(cache);
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <json.h>
+
+#include <davix.hpp>
+#include "plugins/http/gfal_http_plugin.h"
+
+
+static std::string item_locality(struct json_object* item)
+{
+    struct json_object* locality = NULL;
+    if (item == NULL || !json_object_object_get_ex(item, "locality", &locality)) {
+        return "";
+    }
+    return json_object_get_string(locality);
+}
+
+
+TEST(TapeIndexTest, CollapsedSlashes)
+{
+    struct json_object* response = json_tokener_parse(
+        "[{\"path\": \"/eos//tape/file1\", \"locality\": \"TAPE\"},"
+        " {\"path\": \"/eos/tape/file2\", \"locality\": \"DISK\"},"
+        " {\"locality\": \"DISK\"}]");
+    ASSERT_TRUE(response != NULL);
+
+    tape_rest_api::PathIndex index = tape_rest_api::index_items_by_path(response);
+    ASSERT_EQ(2u, index.size());
+
+    ASSERT_EQ("TAPE", item_locality(tape_rest_api::get_item_by_path(index, "/eos/tape/file1")));
+    ASSERT_EQ("DISK", item_locality(tape_rest_api::get_item_by_path(index, "//eos/tape//file2")));
+    ASSERT_TRUE(tape_rest_api::get_item_by_path(index, "/eos/tape/file3") == NULL);
+
+    json_object_put(response);
+}
+
+
+TEST(TapeIndexTest, FirstItemWins)
+{
+    struct json_object* response = json_tokener_parse(
+        "[{\"path\": \"/eos/tape/file\", \"locality\": \"TAPE\"},"
+        " {\"path\": \"/eos//tape/file\", \"locality\": \"DISK\"}]");
+    ASSERT_TRUE(response != NULL);
+
+    tape_rest_api::PathIndex index = tape_rest_api::index_items_by_path(response);
+    ASSERT_EQ("TAPE", item_locality(tape_rest_api::get_item_by_path(index, "/eos/tape/file")));
+
+    json_object_put(response);
+}
+
+
+TEST(TapeIndexTest, NotAnArray)
+{
+    struct json_object* response = json_tokener_parse("{\"path\": \"/eos/tape/file\"}");
+    ASSERT_TRUE(response != NULL);
+
+    ASSERT_TRUE(tape_rest_api::index_items_by_path(response).empty());
+    ASSERT_TRUE(tape_rest_api::index_items_by_path(NULL).empty());
+
+    json_object_put(response);
+}
@@ -253,3 +253,29 @@ TEST_F(TokenMapTest, CopyTestFTSCompatibility)
     ASSERT_STREQ(findInTokenMap(source, OP::HEAD), "token_source");
     ASSERT_STREQ(findInTokenMap(dest, OP::HEAD), "token_dest_host");
 }
+
+TEST_F(TokenMapTest, CachedParams)
+{
+    const char* path = "davs://example.cern.ch:443/path/subpath/file";
+    const char* host = "example.cern.ch";
+
+    auto authorization = [this, path]() -> std::string {
+        Davix::RequestParams params;
+        httpData->get_params(&params, Davix::Uri(path), OP::READ);
+
+        for (const auto& header: params.getHeaders()) {
+            if (header.first == "Authorization") {
+                return header.second;
+            }
+        }
+        return std::string();
+    };
+
+    storeInTokenMap(host, "token_first", OP::READ, true);
+    ASSERT_EQ(authorization(), "Bearer token_first");
+    ASSERT_EQ(authorization(), "Bearer token_first");
+
+    // The parameters built for the previous token must not be reused
+    storeInTokenMap(host, "token_second", OP::READ, true);
+    ASSERT_EQ(authorization(), "Bearer token_second");
+}
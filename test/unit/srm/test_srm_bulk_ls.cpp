@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <gfal_api.h>
+
+extern "C" {
+#include "plugins/srm/gfal_srm.h"
+#include "plugins/srm/gfal_srm_archive.h"
+#include "plugins/srm/gfal_srm_internal_layer.h"
+#include "plugins/srm/gfal_srm_namespace.h"
+}
+
+// Bulk srmLs (stat list and archive polling) against a mocked srm_ls
+
+
+#define SRM_ENDPOINT "srm://srm.example.org:8446/srm/managerv2?SFN="
+
+// Surls of each srmLs received by the mock
+static std::vector<std::vector<std::string> > ls_calls;
+
+
+// Files named "missing..." do not exist, "busy..." fail with EAGAIN, "tape..." are NEARLINE,
+// the others ONLINE
+static int mock_srm_ls(struct srm_context* context, struct srm_ls_input* input, struct srm_ls_output* output)
+{
+    ls_calls.push_back(std::vector<std::string>(input->surls, input->surls + input->nbfiles));
+
+    output->statuses = (struct srmv2_mdfilestatus*) calloc(input->nbfiles, sizeof(struct srmv2_mdfilestatus));
+    output->retstatus = NULL;
+
+    for (int i = 0; i < input->nbfiles; ++i) {
+        struct srmv2_mdfilestatus* status = &output->statuses[i];
+        const char* name = strrchr(input->surls[i], '/') + 1;
+        if (strncmp(name, "missing", 7) == 0) {
+            status->status = ENOENT;
+            status->explanation = strdup("No such file");
+        }
+        else if (strncmp(name, "busy", 4) == 0) {
+            status->status = EAGAIN;
+            status->explanation = strdup("File is busy");
+        }
+        else {
+            status->stat.st_size = strlen(input->surls[i]);
+            status->stat.st_mode = S_IFREG | 0644;
+            status->locality = (strncmp(name, "tape", 4) == 0) ? GFAL_LOCALITY_NEARLINE_ : GFAL_LOCALITY_ONLINE_;
+        }
+    }
+    return input->nbfiles;
+}
+
+
+static void mock_srmv2_mdfilestatus_delete(struct srmv2_mdfilestatus* statuses, int n)
+{
+    for (int i = 0; i < n; ++i) {
+        free(statuses[i].explanation);
+    }
+    free(statuses);
+}
+
+
+static void mock_srm2__TReturnStatus_delete(struct srm2__TReturnStatus* status)
+{
+}
+
+
+class SrmBulkLsTest: public testing::Test {
+protected:
+    gfal2_context_t context;
+    gfal_srmv2_opt* opts;
+    struct _gfal_srm_external_call original_calls;
+
+    std::vector<std::string> surls;
+    std::vector<const char*> surl_ptrs;
+
+    void SetUp() {
+        GError* error = NULL;
+        context = gfal2_context_new(&error);
+        ASSERT_TRUE(context != NULL);
+
+        opts = g_new0(gfal_srmv2_opt, 1);
+        gfal_srm_opt_initG(opts, context);
+
+        original_calls = gfal_srm_external_call;
+        gfal_srm_external_call.srm_ls = mock_srm_ls;
+        gfal_srm_external_call.srm_srmv2_mdfilestatus_delete = mock_srmv2_mdfilestatus_delete;
+        gfal_srm_external_call.srm_srm2__TReturnStatus_delete = mock_srm2__TReturnStatus_delete;
+        ls_calls.clear();
+    }
+
+    void TearDown() {
+        gfal_srm_external_call = original_calls;
+        gfal_srm_destroyG(opts);
+        gfal2_context_free(context);
+    }
+
+    void addFile(const std::string& name) {
+        surls.push_back(SRM_ENDPOINT "/dpm/example.org/home/dteam/" + name);
+    }
+
+    const char* const* surlArray() {
+        surl_ptrs.clear();
+        for (size_t i = 0; i < surls.size(); ++i) {
+            surl_ptrs.push_back(surls[i].c_str());
+        }
+        return surl_ptrs.data();
+    }
+};
+
+
+TEST_F(SrmBulkLsTest, ArchivePollChunks)
+{
+    gfal2_set_opt_integer(context, "SRM PLUGIN", "LS_CHUNK_SIZE", 3, NULL);
+    for (int i = 0; i < 8; ++i) {
+        addFile("tape" + std::to_string(i));
+    }
+
+    std::vector<GError*> errors(surls.size(), NULL);
+    ASSERT_EQ(1, gfal_srm_archive_poll_listG(opts, surls.size(), surlArray(), errors.data()));
+
+    // 3 + 3 + 2
+    ASSERT_EQ(3u, ls_calls.size());
+    ASSERT_EQ(3u, ls_calls[0].size());
+    ASSERT_EQ(2u, ls_calls[2].size());
+    ASSERT_EQ("srm://srm.example.org/dpm/example.org/home/dteam/tape7", ls_calls[2][1]);
+
+    for (size_t i = 0; i < errors.size(); ++i) {
+        ASSERT_TRUE(errors[i] == NULL);
+    }
+}
+
+
+TEST_F(SrmBulkLsTest, ArchivePollPerFileResults)
+{
+    addFile("tape0");
+    addFile("disk1");
+    addFile("missing2");
+    addFile("tape3");
+
+    std::vector<GError*> errors(surls.size(), NULL);
+    ASSERT_EQ(0, gfal_srm_archive_poll_listG(opts, surls.size(), surlArray(), errors.data()));
+    ASSERT_EQ(1u, ls_calls.size());
+
+    ASSERT_TRUE(errors[0] == NULL);
+    ASSERT_TRUE(errors[1] != NULL);
+    ASSERT_EQ(EAGAIN, errors[1]->code);
+    ASSERT_TRUE(errors[2] != NULL);
+    ASSERT_EQ(ENOENT, errors[2]->code);
+    ASSERT_TRUE(errors[3] == NULL);
+
+    g_clear_error(&errors[1]);
+    g_clear_error(&errors[2]);
+}
+
+
+// EAGAIN from srmLs means the file is still pending, not failed
+TEST_F(SrmBulkLsTest, ArchivePollEagainPending)
+{
+    addFile("busy0");
+    addFile("disk1");
+    addFile("tape2");
+
+    std::vector<GError*> errors(surls.size(), NULL);
+    ASSERT_EQ(0, gfal_srm_archive_poll_listG(opts, surls.size(), surlArray(), errors.data()));
+    ASSERT_EQ(1u, ls_calls.size());
+
+    ASSERT_TRUE(errors[0] != NULL);
+    ASSERT_EQ(EAGAIN, errors[0]->code);
+    ASSERT_TRUE(errors[1] != NULL);
+    ASSERT_EQ(EAGAIN, errors[1]->code);
+    ASSERT_TRUE(errors[2] == NULL);
+
+    g_clear_error(&errors[0]);
+    g_clear_error(&errors[1]);
+
+    // Even next to an archived file only, the busy one keeps the poll pending
+    surls.erase(surls.begin() + 1);
+    errors.assign(surls.size(), NULL);
+    ASSERT_EQ(0, gfal_srm_archive_poll_listG(opts, surls.size(), surlArray(), errors.data()));
+    ASSERT_EQ(EAGAIN, errors[0]->code);
+    ASSERT_TRUE(errors[1] == NULL);
+    g_clear_error(&errors[0]);
+}
+
+
+TEST_F(SrmBulkLsTest, ArchivePollAllFailed)
+{
+    addFile("missing0");
+    addFile("missing1");
+
+    std::vector<GError*> errors(surls.size(), NULL);
+    ASSERT_EQ(-1, gfal_srm_archive_poll_listG(opts, surls.size(), surlArray(), errors.data()));
+    for (size_t i = 0; i < errors.size(); ++i) {
+        ASSERT_TRUE(errors[i] != NULL);
+        g_clear_error(&errors[i]);
+    }
+}
+
+
+TEST_F(SrmBulkLsTest, StatListUsesCache)
+{
+    addFile("file0");
+    addFile("missing1");
+    addFile("file2");
+
+    std::vector<struct stat> buffs(surls.size());
+    std::vector<GError*> errors(surls.size(), NULL);
+    ASSERT_EQ(-1, gfal_srm_stat_listG(opts, surls.size(), surlArray(), buffs.data(), errors.data()));
+    ASSERT_EQ(1u, ls_calls.size());
+    ASSERT_EQ(3u, ls_calls[0].size());
+
+    ASSERT_TRUE(errors[0] == NULL);
+    ASSERT_TRUE(S_ISREG(buffs[0].st_mode));
+    ASSERT_EQ(ENOENT, errors[1]->code);
+    ASSERT_TRUE(errors[2] == NULL);
+    g_clear_error(&errors[1]);
+
+    // Only the missing file is asked again
+    ASSERT_EQ(-1, gfal_srm_stat_listG(opts, surls.size(), surlArray(), buffs.data(), errors.data()));
+    ASSERT_EQ(2u, ls_calls.size());
+    ASSERT_EQ(1u, ls_calls[1].size());
+    g_clear_error(&errors[1]);
+}
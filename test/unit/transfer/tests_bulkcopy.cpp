@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <unistd.h>
+#include <unit/fake_plugin.h>
+
+// Bulk copies done by the core for plugins without copy_bulk
+
+
+static GQuark domain = g_quark_from_static_string("TEST");
+
+struct tpc_plugin_data {
+    gfal2_context_t context;
+    pthread_mutex_t lock;
+    int running;
+    int max_running;
+    std::map<std::string, int> running_per_host;
+    std::map<std::string, int> max_running_per_host;
+    int copies;
+    gfalt_checksum_mode_t checksum_mode;
+};
+
+
+static int tpc_plugin_check_transfer(plugin_handle plugin_data, gfal2_context_t context,
+    const char* src, const char* dst, gfal_url2_check check)
+{
+    return check == GFAL_FILE_COPY && strncmp(src, "fake://", 7) == 0 && strncmp(dst, "fake://", 7) == 0;
+}
+
+
+// The destination is fake://<host>/<index>, and the checksum of each file is its index
+// Files with "fail" in the destination fail, the others complete unless canceled
+static int tpc_plugin_copy(plugin_handle plugin_data, gfal2_context_t context, gfalt_params_t params,
+    const char* src, const char* dst, GError** err)
+{
+    tpc_plugin_data* data = (tpc_plugin_data*)plugin_data;
+    std::string host(dst + 7, strchr(dst + 7, '/'));
+
+    pthread_mutex_lock(&data->lock);
+    data->copies += 1;
+    data->running += 1;
+    data->max_running = std::max(data->max_running, data->running);
+    int per_host = ++data->running_per_host[host];
+    data->max_running_per_host[host] = std::max(data->max_running_per_host[host], per_host);
+    pthread_mutex_unlock(&data->lock);
+
+    char checksum[64];
+    gfalt_checksum_mode_t checksum_mode = gfalt_get_checksum(params, NULL, 0, checksum, sizeof(checksum), NULL);
+
+    int ret = 0;
+    for (int i = 0; i < 10 && !gfal2_is_canceled(context); ++i) {
+        usleep(1000);
+    }
+    if (gfal2_is_canceled(context)) {
+        gfal2_set_error(err, domain, ECANCELED, __func__, "Canceled");
+        ret = -1;
+    }
+    else if (strstr(dst, "fail")) {
+        gfal2_set_error(err, domain, EIO, __func__, "Failed %s", dst);
+        ret = -1;
+    }
+    else if (strcmp(checksum, strrchr(dst, '/') + 1) != 0) {
+        gfal2_set_error(err, domain, EINVAL, __func__, "Unexpected checksum %s for %s", checksum, dst);
+        ret = -1;
+    }
+
+    pthread_mutex_lock(&data->lock);
+    data->checksum_mode = checksum_mode;
+    data->running -= 1;
+    data->running_per_host[host] -= 1;
+    pthread_mutex_unlock(&data->lock);
+    return ret;
+}
+
+
+class BulkCopyTest: public FakePluginTest {
+protected:
+    tpc_plugin_data data;
+
+    std::vector<std::string> srcs, dsts, checksums;
+    std::vector<const char*> src_ptrs, dst_ptrs, checksum_ptrs;
+
+    void SetUp() {
+        ASSERT_NO_FATAL_FAILURE(FakePluginTest::SetUp());
+
+        data.context = context;
+        pthread_mutex_init(&data.lock, NULL);
+        data.running = data.max_running = data.copies = 0;
+        data.checksum_mode = GFALT_CHECKSUM_NONE;
+
+        plugin.check_plugin_url_transfer = tpc_plugin_check_transfer;
+        plugin.copy_file = tpc_plugin_copy;
+        registerFakePlugin(&data);
+    }
+
+    void TearDown() {
+        FakePluginTest::TearDown();
+        pthread_mutex_destroy(&data.lock);
+    }
+
+    // Spread over n_hosts destination hosts, every failure_every file fails
+    void makeFiles(int n, int n_hosts, int failure_every) {
+        for (int i = 0; i < n; ++i) {
+            const char* name = (failure_every > 0 && i % failure_every == 0) ? "fail" : "file";
+            srcs.push_back("fake://source/" + std::to_string(i));
+            dsts.push_back("fake://host" + std::to_string(i % n_hosts) + "/" + name + "/" + std::to_string(i));
+            checksums.push_back("ADLER32:" + std::to_string(i));
+        }
+        for (int i = 0; i < n; ++i) {
+            src_ptrs.push_back(srcs[i].c_str());
+            dst_ptrs.push_back(dsts[i].c_str());
+            checksum_ptrs.push_back(checksums[i].c_str());
+        }
+    }
+
+    int copy(GError*** file_errors) {
+        GError* op_error = NULL;
+        int ret = gfalt_copy_bulk(context, NULL, srcs.size(), src_ptrs.data(), dst_ptrs.data(),
+            checksum_ptrs.data(), &op_error, file_errors);
+        EXPECT_TRUE(op_error == NULL);
+        return ret;
+    }
+};
+
+
+TEST_F(BulkCopyTest, serial)
+{
+    makeFiles(20, 2, 5);
+
+    GError** file_errors = NULL;
+    ASSERT_EQ(-4, copy(&file_errors));
+    ASSERT_EQ(1, data.max_running);
+    ASSERT_EQ(20, data.copies);
+
+    for (size_t i = 0; i < srcs.size(); ++i) {
+        if (i % 5 == 0) {
+            ASSERT_TRUE(file_errors[i] != NULL);
+            ASSERT_EQ(EIO, file_errors[i]->code);
+            g_error_free(file_errors[i]);
+        }
+        else {
+            ASSERT_TRUE(file_errors[i] == NULL) << file_errors[i]->message;
+        }
+    }
+    g_free(file_errors);
+}
+
+
+TEST_F(BulkCopyTest, concurrent)
+{
+    gfal2_set_opt_integer(context, "CORE", "BULK_COPY_CONCURRENCY", 8, NULL);
+    gfal2_set_opt_integer(context, "CORE", "BULK_COPY_MAX_PER_HOST", 3, NULL);
+    makeFiles(100, 2, 7);
+
+    GError** file_errors = NULL;
+    ASSERT_EQ(-15, copy(&file_errors));
+    ASSERT_EQ(100, data.copies);
+    ASSERT_LE(data.max_running, 6);
+    ASSERT_GE(data.max_running, 2);
+    ASSERT_LE(data.max_running_per_host["host0"], 3);
+    ASSERT_LE(data.max_running_per_host["host1"], 3);
+
+    // Errors stay in the order of the files
+    for (size_t i = 0; i < srcs.size(); ++i) {
+        if (i % 7 == 0) {
+            ASSERT_TRUE(file_errors[i] != NULL);
+            ASSERT_TRUE(strstr(file_errors[i]->message, dsts[i].c_str()) != NULL);
+            g_error_free(file_errors[i]);
+        }
+        else {
+            ASSERT_TRUE(file_errors[i] == NULL) << file_errors[i]->message;
+        }
+    }
+    g_free(file_errors);
+}
+
+
+static void* cancel_thread(void* data)
+{
+    tpc_plugin_data* plugin_data = (tpc_plugin_data*)data;
+    while (true) {
+        pthread_mutex_lock(&plugin_data->lock);
+        int copies = plugin_data->copies;
+        pthread_mutex_unlock(&plugin_data->lock);
+        if (copies >= 4) {
+            break;
+        }
+        usleep(100);
+    }
+    gfal2_cancel(plugin_data->context);
+    return NULL;
+}
+
+
+TEST_F(BulkCopyTest, cancel)
+{
+    gfal2_set_opt_integer(context, "CORE", "BULK_COPY_CONCURRENCY", 4, NULL);
+    makeFiles(50, 5, 0);
+
+    pthread_t canceler;
+    pthread_create(&canceler, NULL, cancel_thread, &data);
+
+    GError** file_errors = NULL;
+    int ret = copy(&file_errors);
+    pthread_join(canceler, NULL);
+
+    ASSERT_LT(data.copies, 50);
+    ASSERT_EQ(-50, ret);
+    for (size_t i = 0; i < srcs.size(); ++i) {
+        ASSERT_TRUE(file_errors[i] != NULL);
+        ASSERT_EQ(ECANCELED, file_errors[i]->code);
+        g_error_free(file_errors[i]);
+    }
+    g_free(file_errors);
+}
+
+
+// The plugin copy does not go through the core, so the source is verified instead
+TEST_F(BulkCopyTest, inlineChecksumPluginCopy)
+{
+    GError* error = NULL;
+    gfalt_params_t params = gfalt_params_handle_new(NULL);
+    gfalt_set_checksum(params, GFALT_CHECKSUM_INLINE, "ADLER32", "7", NULL);
+
+    ASSERT_EQ(0, gfalt_copy_file(context, params, "fake://source/7", "fake://host0/file/7", &error));
+    ASSERT_EQ(NULL, error);
+    EXPECT_EQ(GFALT_CHECKSUM_SOURCE, data.checksum_mode);
+
+    gfalt_set_checksum(params, (gfalt_checksum_mode_t)(GFALT_CHECKSUM_INLINE | GFALT_CHECKSUM_TARGET),
+        "ADLER32", "7", NULL);
+    ASSERT_EQ(0, gfalt_copy_file(context, params, "fake://source/7", "fake://host0/file/7", &error));
+    ASSERT_EQ(NULL, error);
+    EXPECT_EQ(GFALT_CHECKSUM_BOTH, data.checksum_mode);
+
+    // The parameters of the caller are left as they were
+    EXPECT_EQ(GFALT_CHECKSUM_INLINE | GFALT_CHECKSUM_TARGET, gfalt_get_checksum_mode(params, NULL));
+    gfalt_params_handle_delete(params, NULL);
+}
@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) CERN 2022
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <algorithm>
+#include <cstring>
+#include <pthread.h>
+#include <unistd.h>
+#include <gfal_api.h>
+#include <gfal_plugins_api.h>
+#include <utils/checksums/checksums.h>
+
+// Streamed copy between two in-memory endpoints
+
+
+#define SOURCE_SIZE (1024 * 1024 + 123)
+
+static GQuark domain = g_quark_from_static_string("TEST");
+
+struct mem_plugin_data {
+    char source[SOURCE_SIZE];
+    GByteArray* destination;
+    // fail the read once this many bytes have been read, -1 never
+    ssize_t fail_at;
+    // cancel the transfer once this many bytes have been read, -1 never
+    ssize_t cancel_at;
+    gfal2_context_t context;
+    pthread_t cancel_thread;
+};
+
+struct mem_file {
+    gboolean is_source;
+    size_t offset;
+};
+
+
+static const char* mem_plugin_name()
+{
+    return "MEM-PLUGIN";
+}
+
+
+static gboolean mem_plugin_check_url(plugin_handle plugin_data, const char* url,
+    plugin_mode operation, GError** err)
+{
+    return strncmp(url, "mem://", 6) == 0;
+}
+
+
+static gfal_file_handle mem_plugin_open(plugin_handle plugin_data, const char* url,
+    int flag, mode_t mode, GError** err)
+{
+    mem_file* f = g_new0(mem_file, 1);
+    f->is_source = (strcmp(url, "mem://source") == 0);
+    return gfal_file_handle_new(mem_plugin_name(), f);
+}
+
+
+static void* cancel_thread(void* context)
+{
+    gfal2_cancel((gfal2_context_t)context);
+    return NULL;
+}
+
+
+static ssize_t mem_plugin_read(plugin_handle plugin_data, gfal_file_handle fd,
+    void* buff, size_t count, GError** err)
+{
+    mem_plugin_data* data = (mem_plugin_data*)plugin_data;
+    mem_file* f = (mem_file*)gfal_file_handle_get_fdesc(fd);
+
+    if (data->fail_at >= 0 && f->offset >= (size_t)data->fail_at) {
+        gfal2_set_error(err, domain, EIO, __func__, "Read failure");
+        return -1;
+    }
+
+    if (data->cancel_at >= 0 && f->offset >= (size_t)data->cancel_at) {
+        data->cancel_at = -1;
+        pthread_create(&data->cancel_thread, NULL, cancel_thread, data->context);
+        for (int i = 0; i < 500 && !gfal2_is_canceled(data->context); ++i) {
+            usleep(10000);
+        }
+    }
+
+    // Short reads, to exercise the partially filled buffers
+    size_t remaining = SOURCE_SIZE - f->offset;
+    size_t size = std::min(count, std::min(remaining, (size_t)(rand() % 65536 + 1)));
+    memcpy(buff, data->source + f->offset, size);
+    f->offset += size;
+    return size;
+}
+
+
+static ssize_t mem_plugin_write(plugin_handle plugin_data, gfal_file_handle fd,
+    const void* buff, size_t count, GError** err)
+{
+    mem_plugin_data* data = (mem_plugin_data*)plugin_data;
+    g_byte_array_append(data->destination, (const guint8*)buff, count);
+    return count;
+}
+
+
+static int mem_plugin_stat(plugin_handle plugin_data, const char* url, struct stat* buf, GError** err)
+{
+    gfal2_set_error(err, domain, ENOENT, __func__, "No such file");
+    return -1;
+}
+
+
+static int mem_plugin_close(plugin_handle plugin_data, gfal_file_handle fd, GError** err)
+{
+    g_free(gfal_file_handle_get_fdesc(fd));
+    gfal_file_handle_delete(fd);
+    return 0;
+}
+
+
+class LocalCopyTest: public testing::Test {
+protected:
+    gfal2_context_t context;
+    gfalt_params_t params;
+    mem_plugin_data data;
+
+    void SetUp() {
+        for (int i = 0; i < SOURCE_SIZE; ++i) {
+            data.source[i] = (char)(rand() % 256);
+        }
+        data.destination = g_byte_array_new();
+        data.fail_at = -1;
+        data.cancel_at = -1;
+
+        gfal_plugin_interface mem_plugin;
+        memset(&mem_plugin, 0, sizeof(mem_plugin));
+        mem_plugin.getName = mem_plugin_name;
+        mem_plugin.plugin_data = &data;
+        mem_plugin.check_plugin_url = mem_plugin_check_url;
+        mem_plugin.openG = mem_plugin_open;
+        mem_plugin.readG = mem_plugin_read;
+        mem_plugin.writeG = mem_plugin_write;
+        mem_plugin.closeG = mem_plugin_close;
+        mem_plugin.statG = mem_plugin_stat;
+
+        context = gfal2_context_new(NULL);
+        data.context = context;
+        gfal2_register_plugin(context, &mem_plugin, NULL);
+        gfal2_set_opt_integer(context, "CORE", "COPY_BUFFERSIZE", 100000, NULL);
+
+        params = gfalt_params_handle_new(NULL);
+        gfalt_set_strict_copy_mode(params, TRUE, NULL);
+    }
+
+    void TearDown() {
+        gfalt_params_handle_delete(params, NULL);
+        gfal2_context_free(context);
+        g_byte_array_free(data.destination, TRUE);
+    }
+};
+
+
+TEST_F(LocalCopyTest, serial)
+{
+    GError* error = NULL;
+    gfalt_copy_file(context, params, "mem://source", "mem://destination", &error);
+    ASSERT_EQ(NULL, error);
+    ASSERT_EQ(SOURCE_SIZE, data.destination->len);
+    ASSERT_EQ(0, memcmp(data.source, data.destination->data, SOURCE_SIZE));
+}
+
+
+TEST_F(LocalCopyTest, pipelined)
+{
+    GError* error = NULL;
+    gfal2_set_opt_integer(context, "CORE", "COPY_PIPELINE_DEPTH", 4, NULL);
+    gfalt_copy_file(context, params, "mem://source", "mem://destination", &error);
+    ASSERT_EQ(NULL, error);
+    ASSERT_EQ(SOURCE_SIZE, data.destination->len);
+    ASSERT_EQ(0, memcmp(data.source, data.destination->data, SOURCE_SIZE));
+}
+
+
+TEST_F(LocalCopyTest, pipelinedReadError)
+{
+    GError* error = NULL;
+    data.fail_at = SOURCE_SIZE / 2;
+    gfal2_set_opt_integer(context, "CORE", "COPY_PIPELINE_DEPTH", 4, NULL);
+    gfalt_copy_file(context, params, "mem://source", "mem://destination", &error);
+    ASSERT_NE((void*)NULL, error);
+    ASSERT_EQ(EIO, error->code);
+    ASSERT_LE(data.destination->len, (guint)SOURCE_SIZE / 2);
+    g_error_free(error);
+}
+
+
+TEST_F(LocalCopyTest, pipelinedCancel)
+{
+    GError* error = NULL;
+    data.cancel_at = SOURCE_SIZE / 2;
+    gfal2_set_opt_integer(context, "CORE", "COPY_PIPELINE_DEPTH", 4, NULL);
+    gfalt_copy_file(context, params, "mem://source", "mem://destination", &error);
+    pthread_join(data.cancel_thread, NULL);
+    ASSERT_NE((void*)NULL, error);
+    ASSERT_EQ(ECANCELED, error->code);
+    g_error_free(error);
+}
+
+
+static std::string expected_checksum(const char* data, size_t size, const char* type)
+{
+    char buffer[64];
+    gfal2_checksum_ctx* ctx = gfal2_checksum_ctx_new(type);
+    gfal2_checksum_ctx_update(ctx, data, size);
+    gfal2_checksum_ctx_final(ctx, buffer, sizeof(buffer));
+    gfal2_checksum_ctx_free(ctx);
+    return buffer;
+}
+
+
+TEST_F(LocalCopyTest, inlineChecksum)
+{
+    GError* error = NULL;
+    const char* types[] = {"ADLER32", "CRC32", "MD5"};
+
+    gfalt_set_strict_copy_mode(params, FALSE, NULL);
+
+    for (int depth = 0; depth <= 4; depth += 4) {
+        gfal2_set_opt_integer(context, "CORE", "COPY_PIPELINE_DEPTH", depth, NULL);
+        for (size_t i = 0; i < G_N_ELEMENTS(types); ++i) {
+            std::string checksum = expected_checksum(data.source, SOURCE_SIZE, types[i]);
+            g_byte_array_set_size(data.destination, 0);
+            gfalt_set_checksum(params, GFALT_CHECKSUM_INLINE, types[i], checksum.c_str(), NULL);
+            gfalt_copy_file(context, params, "mem://source", "mem://destination", &error);
+            ASSERT_EQ(NULL, error) << error->message;
+            ASSERT_EQ(SOURCE_SIZE, data.destination->len);
+        }
+    }
+}
+
+
+TEST_F(LocalCopyTest, inlineChecksumMismatch)
+{
+    GError* error = NULL;
+    gfalt_set_strict_copy_mode(params, FALSE, NULL);
+    gfalt_set_checksum(params, GFALT_CHECKSUM_INLINE, "ADLER32", "12345678", NULL);
+    gfalt_copy_file(context, params, "mem://source", "mem://destination", &error);
+    ASSERT_NE((void*)NULL, error);
+    ASSERT_EQ(EIO, error->code);
+    g_error_free(error);
+}
+
+
+TEST_F(LocalCopyTest, inlineChecksumUnsupported)
+{
+    GError* error = NULL;
+    gfalt_set_strict_copy_mode(params, FALSE, NULL);
+    gfalt_set_checksum(params, GFALT_CHECKSUM_INLINE, "SHA1", "12345678", NULL);
+    gfalt_copy_file(context, params, "mem://source", "mem://destination", &error);
+    ASSERT_NE((void*)NULL, error);
+    ASSERT_EQ(ENOTSUP, error->code);
+    ASSERT_EQ(0, data.destination->len);
+    g_error_free(error);
+}
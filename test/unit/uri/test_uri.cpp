@@ -229,3 +229,75 @@ TEST(gfalURI, special)
 
     gfal2_free_uri(parsed);
 }
+
+
+TEST(gfalURI, authority)
+{
+    GError* tmp_err = NULL;
+
+    // Port without host
+    gfal2_uri *parsed = gfal2_parse_uri("gsiftp://:2811/path", &tmp_err);
+    ASSERT_NE(parsed, (void*)NULL);
+    ASSERT_EQ(NULL, parsed->host);
+    ASSERT_EQ(2811, parsed->port);
+    ASSERT_STREQ("/path", parsed->path);
+    gfal2_free_uri(parsed);
+
+    // Userinfo without host
+    parsed = gfal2_parse_uri("sftp://user@/path", &tmp_err);
+    ASSERT_NE(parsed, (void*)NULL);
+    ASSERT_STREQ("user", parsed->userinfo);
+    ASSERT_EQ(NULL, parsed->host);
+    gfal2_free_uri(parsed);
+
+    // Trailing garbage in the authority is dropped
+    parsed = gfal2_parse_uri("https://host.:443/path", &tmp_err);
+    ASSERT_NE(parsed, (void*)NULL);
+    ASSERT_STREQ("host", parsed->host);
+    ASSERT_EQ(0, parsed->port);
+    ASSERT_STREQ("/path", parsed->path);
+    gfal2_free_uri(parsed);
+}
+
+
+TEST(gfalURI, replace)
+{
+    const char *URI = "root://host//path?a=b";
+    GError* tmp_err = NULL;
+
+    gfal2_uri *parsed = gfal2_parse_uri(URI, &tmp_err);
+    ASSERT_NE(parsed, (void*)NULL);
+
+    gfal2_uri_replace(parsed, &parsed->query, g_strconcat(parsed->query, "&c=d", NULL));
+    gfal2_uri_replace(parsed, &parsed->fragment, g_strdup("fragment"));
+    gfal2_uri_replace(parsed, &parsed->fragment, NULL);
+    gfal2_uri_replace(parsed, &parsed->host, g_strdup("other"));
+
+    char *rebuilt = gfal2_join_uri(parsed);
+    ASSERT_STREQ("root://other//path?a=b&c=d", rebuilt);
+
+    g_free(rebuilt);
+    gfal2_free_uri(parsed);
+}
+
+
+TEST(gfalURI, ownedComponents)
+{
+    const char *URI = "root://user@host:1094//path?a=b#frag";
+    GError* tmp_err = NULL;
+
+    gfal2_uri *parsed = gfal2_parse_uri(URI, &tmp_err);
+    ASSERT_NE(parsed, (void*)NULL);
+
+    // Callers may still release and swap the components themselves
+    g_free(parsed->host);
+    parsed->host = g_strdup("other");
+    g_free(parsed->query);
+    parsed->query = g_strdup("c=d");
+
+    char *rebuilt = gfal2_join_uri(parsed);
+    ASSERT_STREQ("root://user@other:1094//path?c=d#frag", rebuilt);
+
+    g_free(rebuilt);
+    gfal2_free_uri(parsed);
+}